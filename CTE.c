@@ -48,6 +48,23 @@
  */
 
 
+#define _POSIX_C_SOURCE 200112L /* posix_fallocate, ftruncate */
+
+#include <string.h>
+
+#include <errno.h>
+#include <unistd.h>
+
+#ifndef CTE_NO_THREADS
+#include <pthread.h>
+#endif
+
+#ifndef CTE_NO_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #include "CTE.h"
 #include "ASCII.h"
 #include "hash.h"
@@ -55,6 +72,15 @@
 #include "common.h"
 #include "bailout.h"
 #include "cte_stack.h"
+#include "cte_table.h"
+#include "cte_digest.h"
+#include "cte_alloc.h"
+#include "cte_clock.h"
+#include "cte_trace.h"
+#include "cte_escape.h"
+#include "cte_histogram.h"
+#include "cte_metrics.h"
+#include "cte_capture.h"
 
 
 // ---------------------------------------------------------------------------
@@ -73,6 +99,12 @@
 #warning CTE_MAX_NESTING_LEVEL is unreasonably high, factory setting is 65535
 #endif
 
+#if (CTE_RENDER_STACK_SIZE < 1)
+#error CTE_RENDER_STACK_SIZE must not be zero, recommended minimum is 8
+#elif (CTE_RENDER_STACK_SIZE > 256)
+#warning CTE_RENDER_STACK_SIZE is unreasonably high, factory setting is 16
+#endif
+
 
 // ---------------------------------------------------------------------------
 // Size and growth parameters for target string
@@ -84,31 +116,85 @@
 
 
 // ---------------------------------------------------------------------------
-// Prefix for lines to ignore "%%"
+// Minimum output size for rendering into a memory mapped file
+// ---------------------------------------------------------------------------
+//
+// Smaller output is written to the file  through a chunk buffer,  for which
+// mapping the file is not worth the system calls involved.
+
+#define CTE_FILE_MAP_MIN_SIZE (64*1024) /* 64 KBytes */
+
+
+// ---------------------------------------------------------------------------
+// Parameters for parallel rendering
+// ---------------------------------------------------------------------------
+//
+// Expansions smaller than CTE_PARALLEL_MIN_SIZE  are filled in by the calling
+// thread alone,  thread start-up would cost more than it saves.
+
+#define CTE_PARALLEL_MAX_THREADS 64
+
+#define CTE_PARALLEL_MIN_SIZE (256*1024) /* 256 KBytes */
+
+
+// ---------------------------------------------------------------------------
+// Lookahead for chunked rendering
+// ---------------------------------------------------------------------------
+//
+// A delimiter closer than this to the end of the bytes available  may start a
+// placeholder or section opening  that continues in the next chunk.
+
+#define CTE_CHUNK_LOOKAHEAD (CTE_MAX_PLACEHOLDER_LENGTH + 6)
+
+
+// ---------------------------------------------------------------------------
+// Default prefix for lines to ignore "%%"
 // ---------------------------------------------------------------------------
 
 #define CTE_IGNORE_PFX_CHAR_1 PERCENT
 #define CTE_IGNORE_PFX_CHAR_2 PERCENT
 
-static const char _cte_ignore_prefix[] = {
-    CTE_IGNORE_PFX_CHAR_1,
-    CTE_IGNORE_PFX_CHAR_2,
-    CSTRING_TERMINATOR
-} /* _cte_ignore_prefix */ ;
-
 
 // ---------------------------------------------------------------------------
-// Delimiter for placeholders "@@"
+// Default delimiter for placeholders "@@"
 // ---------------------------------------------------------------------------
 
 #define CTE_DELIMITER_CHAR_1 AT_SIGN
 #define CTE_DELIMITER_CHAR_2 AT_SIGN
 
-static const char _cte_delimiter[] = {
-    CTE_DELIMITER_CHAR_1,
-    CTE_DELIMITER_CHAR_2,
-    CSTRING_TERMINATOR
-} /* _cte_delimiter */ ;
+
+// ---------------------------------------------------------------------------
+// Section tags following the opening delimiter "#" and "/"
+// ---------------------------------------------------------------------------
+
+#define CTE_SECTION_OPENING NUMBER_SIGN
+#define CTE_SECTION_CLOSING FORWARD_SLASH
+
+
+// ---------------------------------------------------------------------------
+// Initial size of per-render resolver cache, must be a power of two
+// ---------------------------------------------------------------------------
+
+#define CTE_RESOLVER_CACHE_SIZE_INITIAL 16 /* entries */
+
+#if ((CTE_RESOLVER_CACHE_SIZE_INITIAL < 4) || \
+     ((CTE_RESOLVER_CACHE_SIZE_INITIAL & \
+      (CTE_RESOLVER_CACHE_SIZE_INITIAL - 1)) != 0))
+#error CTE_RESOLVER_CACHE_SIZE_INITIAL must be a power of two, minimum 4
+#endif
+
+
+// ---------------------------------------------------------------------------
+// Initial size of placeholder sets, must be a power of two
+// ---------------------------------------------------------------------------
+
+#define CTE_PLACEHOLDER_SET_SIZE_INITIAL 16 /* entries */
+
+#if ((CTE_PLACEHOLDER_SET_SIZE_INITIAL < 4) || \
+     ((CTE_PLACEHOLDER_SET_SIZE_INITIAL & \
+      (CTE_PLACEHOLDER_SET_SIZE_INITIAL - 1)) != 0))
+#error CTE_PLACEHOLDER_SET_SIZE_INITIAL must be a power of two, minimum 4
+#endif
 
 
 // ---------------------------------------------------------------------------
@@ -118,501 +204,6890 @@ static const char _cte_delimiter[] = {
 static cte_notification_f _cte_notify = NULL;
 
 
-// ===========================================================================
-// P R I V A T E   F U N C T I O N   P R O T O T Y P E S   A N D   M A C R O S
-// ===========================================================================
+// ---------------------------------------------------------------------------
+// Diagnostic handler
+// ---------------------------------------------------------------------------
 
-static fmacro char *_update_target(char char_to_add, char *initial_str,
-                        cardinal index, cardinal *size, cte_status_t *status);
+static cte_diagnostic_f _cte_diagnose = NULL;
 
-#define CTE_NOTIFY( _notification, _str, _index_or_size) \
-    { if (_cte_notify != NULL) \
-    _cte_notify( _notification, _str, _index_or_size); }
 
-#define CTE_START_OF_LINE(_str, _index) \
-    ((_index == 0) || (_str[_index-1] == NEWLINE))
+// ---------------------------------------------------------------------------
+// Last compiled template identity issued
+// ---------------------------------------------------------------------------
 
+static uint64_t _cte_template_identity = 0;
 
-// ===========================================================================
-// P U B L I C   F U N C T I O N   I M P L E M E N T A T I O N S
-// ===========================================================================
 
 // ---------------------------------------------------------------------------
-// function:  cte_delimiter()
+// Character classes for template scanning
 // ---------------------------------------------------------------------------
-//
-// Returns a pointer to a constant C string  containing the library's built-in
-// placeholder delimiter.  The placeholder delimiter may be changed at compile
-// time only.  The factory setting is "@@".
 
-inline const char *cte_delimiter(void) {
-    return (const char *) &_cte_delimiter;
-} // end cte_delimiter
+typedef enum /* cte_char_class_t */ {
+    CTE_CHAR_ORDINARY = 0,
+    CTE_CHAR_ESCAPE,
+    CTE_CHAR_DELIMITER,
+    CTE_CHAR_IGNORE_PREFIX,
+    CTE_CHAR_TERMINATOR
+} cte_char_class_t;
 
 
 // ---------------------------------------------------------------------------
-// function:  cte_ignore_prefix()
+// Template syntax type
 // ---------------------------------------------------------------------------
 //
-// Returns a pointer to a constant C string  containing the library's built-in
-// ignore prefix.  The ignore prefix may be changed at compile time only.  The
-// factory setting is "%%".
+// A syntax holds the opening and closing placeholder delimiters,  the ignore
+// prefix and a table with the character class  of every character value.  The
+// table is built when the syntax is created.  Scanners classify each charac-
+// ter with a single lookup  and only compare against the delimiters  and the
+// ignore prefix  where the class indicates  a character of special meaning.
 
-inline const char *cte_ignore_prefix(void) {
-    return (const char *) &_cte_ignore_prefix;
-} // end cte_ignore_prefix
+typedef struct /* cte_syntax_s */ {
+       char delimiter[3];
+       char closing_delimiter[3];
+       char ignore_prefix[3];
+    uint8_t char_class[256];
+    uint8_t escape;
+} cte_syntax_s;
 
 
 // ---------------------------------------------------------------------------
-// function:  cte_install_notification_handler( handler )
+// Built-in template syntax
 // ---------------------------------------------------------------------------
-//
-// Installs function <handler>  as  notification handler.  If  a  notification
-// handler is installed,  the template engine calls the handler when a notifi-
-// able event occurs while expanding a template.  Notifiable events are either
-// informational or warnings or errors.  By default no handler is installed.
-//
-// The template engine passes the following parameters to the handler:
-//
-// o  notification code describing the notified event
-// o  pointer to the template being expanded when the event occurred
-// o  index to the character in the template when the event occurred
-//
-// A notification handler may be uninstalled by passing in NULL for <handler>.
 
-inline void cte_install_notification_handler(cte_notification_f handler) {
-    _cte_notify = handler;
-    return;
-} // end cte_install_notification_handler
+static const cte_syntax_s _cte_default_syntax = {
+    { CTE_DELIMITER_CHAR_1, CTE_DELIMITER_CHAR_2, CSTRING_TERMINATOR },
+    { CTE_DELIMITER_CHAR_1, CTE_DELIMITER_CHAR_2, CSTRING_TERMINATOR },
+    { CTE_IGNORE_PFX_CHAR_1, CTE_IGNORE_PFX_CHAR_2, CSTRING_TERMINATOR },
+    {
+        [CSTRING_TERMINATOR] = CTE_CHAR_TERMINATOR,
+        [BACKSLASH] = CTE_CHAR_ESCAPE,
+        [CTE_DELIMITER_CHAR_1] = CTE_CHAR_DELIMITER,
+        [CTE_IGNORE_PFX_CHAR_1] = CTE_CHAR_IGNORE_PREFIX
+    },
+    CTE_ESCAPE_NONE
+} /* _cte_default_syntax */ ;
 
 
 // ---------------------------------------------------------------------------
-// function:  cte_string_from_template( tmplate, placeholders, status )
+// Resolver cache entry type
+// ---------------------------------------------------------------------------
+
+typedef struct /* cte_resolver_cache_entry_s */ {
+     kvs_key_t key;
+    const char *value;
+        size_t length;
+          char identifier[CTE_MAX_PLACEHOLDER_LENGTH + 1];
+} cte_resolver_cache_entry_s;
+
+
+// ---------------------------------------------------------------------------
+// Resolver cache type
+// ---------------------------------------------------------------------------
+
+typedef struct /* cte_resolver_cache_s */ {
+    cte_resolver_cache_entry_s *entry;
+                      cardinal size;
+                      cardinal count;
+} cte_resolver_cache_s;
+
+
+// ---------------------------------------------------------------------------
+// Placeholder value source type
 // ---------------------------------------------------------------------------
 //
-// Recursively expands  all placeholder strings  in template string <template>
-// and  returns a pointer to a new dynamically allocated string containing the
-// resulting string.  The function fails  if NULL is passed in  for <template>
-// or <placeholders>  or if allocation fails  or the template nesting limit is
-// exceeded.  The function returns NULL if it fails.
-//
-// When a placeholder string is found in the template, a key is calculated for
-// its identifier.  The key is then looked up in the placeholder table  passed
-// in <placeholders>.  If the key is found in the placeholder table,  then its
-// value is retrieved and the respective placeholder string in the template is
-// replaced with the string pointed to by the retrieved value.
-//
-// The function recognises templates according to the following EBNF grammar:
-//
-//  template :
-//    ( template-comment | escape-sequence | placeholder-string | character )*
-//
-//  template-comment :
-//    '%%' character* end-of-line
-//
-//  placeholder-string :
-//    '@@' identifier '@@'
-//
-//  identifier :
-//    letter ( letter | digit | '_' )*
-//
-//  letter :
-//    'A' .. 'Z' | 'a' .. 'z'
-//
-//  digit :
-//    '0' .. '9'
+// A value source is either a placeholder table, a key value table or a re-
+// solver function with its context and its per-render cache of resolved va-
+// lues.  Only one of placeholder table,  key value table and resolver is set.
+// While a section row is expanded,  the value source is the row's table  and
+// <outer> links to the value source of the enclosing section or render.
+
+typedef struct cte_values_s /* cte_values_s */ {
+             cte_table_t table;
+             kvs_table_t kvs;
+          cte_resolver_f resolver;
+                    void *context;
+    cte_resolver_cache_s cache;
+    struct cte_values_s *outer;
+} cte_values_s;
+
+
+// ---------------------------------------------------------------------------
+// Compiled template segment kinds
+// ---------------------------------------------------------------------------
+
+typedef enum /* cte_segment_kind_t */ {
+    CTE_SEGMENT_LITERAL,
+    CTE_SEGMENT_PLACEHOLDER,
+    CTE_SEGMENT_SECTION
+} cte_segment_kind_t;
+
+
+// ---------------------------------------------------------------------------
+// Compiled template segment type
+// ---------------------------------------------------------------------------
 //
-//  end-of-line :
-//    ASCII(10)
+// The offset of a literal segment indexes the compiled template's text,  the
+// offset of a placeholder or section segment  indexes the opening delimiter
+// in its source.  The length of a placeholder or section segment is the length
+// of its identifier.  A section segment covers the entire section,  its body
+// is expanded from the source.
+
+typedef struct /* cte_segment_s */ {
+     cardinal kind;
+     cardinal offset;
+     cardinal length;
+    kvs_key_t key;
+} cte_segment_s;
+
+
+// ---------------------------------------------------------------------------
+// Compiled template type
+// ---------------------------------------------------------------------------
 //
-//  escape-sequence :
-//    '\' ( '\' | '%' | '@' )
+// The line end index holds the offsets of all newline characters in the source
+// in ascending order.  It is only used to locate events for diagnostics.  The
+// histogram set is NULL unless the library is built with CTE_WITH_HISTOGRAMS.
+
+typedef struct /* cte_template_s */ {
+         uint64_t identity;
+    cte_histogram_set_t histograms;
+         cardinal segment_count;
+    cte_segment_s *segment;
+             char *source;
+           size_t source_length;
+             char *text;
+         cardinal line_end_count;
+         cardinal *line_end;
+     cte_syntax_s syntax;
+} cte_template_s;
+
+
+// ---------------------------------------------------------------------------
+// Internal status of an expansion suspended by a full step buffer
+// or stopped at the end of a chunk
+// ---------------------------------------------------------------------------
+
+#define CTE_STATUS_SUSPENDED ((cte_status_t) 0)
+
+
+// ---------------------------------------------------------------------------
+// Step frame type
+// ---------------------------------------------------------------------------
 //
-//  character :
-//    ASCII(0) .. ASCII(127)
+// A step frame holds the state of one invocation of the expansion engine  at
+// the time a step render was suspended,  one frame per section depth.  If the
+// invocation was suspended within a section,  the source index is that of the
+// section's opening delimiter and <row> is the index of the row being expanded.
+
+typedef struct /* cte_step_frame_s */ {
+    const char *source;
+        size_t s_length;
+        size_t s_index;
+      cardinal nesting_level;
+      cardinal base_level;
+      cardinal row;
+          bool in_section;
+} cte_step_frame_s;
+
+
+// ---------------------------------------------------------------------------
+// Step state type
+// ---------------------------------------------------------------------------
 //
-// Static semantics:
+// Output that did not fit into the step buffer is held back as a reference to
+// the remaining characters  of the source or value being appended,  together
+// with the escaping mode to apply to them.  Only the remainder of an escape
+// sequence is copied,  into the stash,  and is written before the reference.
+// If a step stopped at a placeholder whose value is pending,  the identifier
+// of the placeholder is held in <hole>.
+
+typedef struct /* cte_step_s */ {
+    cte_step_frame_s frame[CTE_MAX_SECTION_DEPTH + 1];
+            cardinal depth;
+                bool resuming;
+                char stash[CTE_ESCAPE_MAX_LENGTH];
+            cardinal stash_index;
+            cardinal stash_length;
+          const char *pending;
+              size_t p_length;
+             uint8_t p_escape;
+          const char *hole;
+            cardinal h_length;
+} cte_step_s;
+
+
+// ---------------------------------------------------------------------------
+// Chunk state type
+// ---------------------------------------------------------------------------
 //
-// o  template comments are  ONLY  recognised in coloumn #1 of any line,  that
-//    is to say,  the prefix "%%" must either occur at index 0 of the top most
-//    template,  or it must immediately follow a newline control character.
+// An expansion of carried bytes and chunk  stops at the source index <stop>
+// of a construct that may continue in the next chunk.  If the chunk ended in
+// a comment line,  <skipping> is set and the next chunk is skipped up to the
+// end of the line.
+
+typedef struct /* cte_chunk_s */ {
+    size_t stop;
+      bool skipping;
+} cte_chunk_s;
+
+
+// ---------------------------------------------------------------------------
+// Render state type
+// ---------------------------------------------------------------------------
 //
-// o  identifiers must not exceed the value of cte_max_placeholder_length().
+// A sizing render only determines the size of the output of a render that is
+// performed in two passes,  it is not recorded in the template's histograms
+// and its notifications are suppressed.
+// The budget of a render is NULL unless the render is limited,  a limited
+// render counts its expansions and has a deadline of zero if its time is not
+// limited.
+// The escaping mode of a render is DEFAULT  unless one was requested by the
+// caller.  The mode in which the value being expanded is escaped  is chosen
+// when it is entered from the template  and is held in <v_escape>.
+// The capture record of a render is NULL  unless the render was sampled for
+// capture,  in which case the template being rendered is held in <c_template>.
+
+typedef struct /* cte_render_s */ {
+            char *target;
+          size_t t_index;
+          size_t t_size;
+            bool bounded;
+     cte_stack_t stack;
+    cte_values_s *values;
+    cte_digest_state_t *digest;
+      cte_sink_f sink;
+            void *sink_context;
+          size_t emitted;
+    const cte_syntax_s *syntax;
+         uint8_t escape;
+         uint8_t v_escape;
+  cte_template_s *compiled;
+   cte_segment_s *segment;
+        cardinal section_depth;
+      cte_step_s *step;
+            bool suspended;
+     cte_chunk_s *chunk;
+            bool sizing;
+    const cte_budget_t *budget;
+        uint64_t expansions;
+        uint64_t deadline;
+    cte_capture_record_t capture;
+      const char *c_template;
+          size_t c_length;
+            void *stack_storage[CTE_STACK_STORAGE_SIZE(CTE_RENDER_STACK_SIZE)
+                                / sizeof(void *)];
+} cte_render_s;
+
+
+// ---------------------------------------------------------------------------
+// Resumable render state type
+// ---------------------------------------------------------------------------
+
+typedef struct /* cte_render_state_s */ {
+    cte_render_s render;
+      cte_step_s step;
+    cte_values_s values;
+      const char *source;
+          size_t s_length;
+            bool done;
+    cte_status_t r_status;
+} cte_render_state_s;
+
+
+// ---------------------------------------------------------------------------
+// Chunked render type
+// ---------------------------------------------------------------------------
 //
-// o  template nesting must not exceed the value of cte_max_nesting_level().
+// The buffer holds the bytes carried over from the previous chunk  followed by
+// the current chunk,  preceded by the character before them at index 0.
+
+typedef struct /* cte_chunked_render_s */ {
+    cte_render_s render;
+     cte_chunk_s chunk;
+    cte_values_s values;
+            char *buffer;
+          size_t b_length;
+          size_t b_size;
+    cte_status_t r_status;
+            bool finished;
+} cte_chunked_render_s;
+
+
+// ---------------------------------------------------------------------------
+// Placeholder set entry type
+// ---------------------------------------------------------------------------
+
+typedef struct /* cte_placeholder_entry_s */ {
+    kvs_key_t key;
+         char identifier[CTE_MAX_PLACEHOLDER_LENGTH + 1];
+} cte_placeholder_entry_s;
+
+
+// ---------------------------------------------------------------------------
+// Placeholder set type
+// ---------------------------------------------------------------------------
+
+typedef struct /* cte_placeholder_set_s */ {
+    cte_placeholder_entry_s *entry;
+                   cardinal *slot;
+                   cardinal size;
+                   cardinal count;
+} cte_placeholder_set_s;
+
+
+// ---------------------------------------------------------------------------
+// Parallel render work unit type
+// ---------------------------------------------------------------------------
 //
-// o  escape sequences are reproduced as follows:
-//    "\\" produces "\\" in the expanded result string
-//    "\@" produces "@" in the expanded result string
-//    "\%" at coloumn #1 produces "%" in the expanded result string
-//    "\%" at coloumns > 1 produces "\%" in the expanded result string
-//    
-// The status of the operation  is passed back in <status>,  unless  NULL  was
-// passed in for <status>.
+// A work unit covers the segments from index <first> up to but not including
+// index <end> of a compiled template.  In the sizing pass,  the expanded size
+// of each segment is recorded in <size>  and <stop> receives the index of the
+// first undefined placeholder  in the range or <end> if there is none.  In the
+// fill pass,  the range is expanded into the <t_size> bytes at <target>.
 
-char *cte_string_from_template(const char *template,
-                               kvs_table_t placeholders,
-                               cte_status_t *status) {
+typedef struct /* cte_work_unit_s */ {
+    cte_template_s *compiled;
+      cte_values_s *values;
+          cardinal first;
+          cardinal end;
+          cardinal stop;
+            size_t *size;
+              char *target;
+            size_t t_size;
+      cte_status_t r_status;
+} cte_work_unit_s;
+
+
+// ===========================================================================
+// P R I V A T E   F U N C T I O N   P R O T O T Y P E S   A N D   M A C R O S
+// ===========================================================================
+
+static char *_string_from_template(const char *tmplate, cte_syntax_t syntax,
+                         kvs_table_t placeholders, cte_escape_t escape,
+                         cte_status_t *status);
+
+static cte_status_t _begin_render(cte_render_s *render,
+                         cte_values_s *values, const char *tmplate);
+
+static char *_finish_render(cte_render_s *render,
+                         cte_status_t r_status, cte_status_t *status);
+
+static void _begin_render_into(cte_render_s *render, cte_values_s *values,
+                         char *buffer, size_t capacity);
+
+static size_t _finish_render_into(cte_render_s *render,
+                         cte_status_t r_status, cte_status_t *status);
+
+static cte_status_t _begin_render_to_sink(cte_render_s *render,
+                         cte_values_s *values, cte_sink_f sink, void *context,
+                         size_t chunk_size, const char *tmplate);
+
+static size_t _finish_render_to_sink(cte_render_s *render,
+                         cte_status_t r_status, cte_status_t *status);
+
+static cte_status_t _flush_to_sink(cte_render_s *render);
+
+static void _begin_budget(cte_render_s *render, const cte_budget_t *budget);
+
+static cte_status_t _charge_budget(cte_render_s *render);
+
+static cte_status_t _settle_budget(cte_render_s *render,
+                         const char *source, size_t s_length,
+                         cte_status_t r_status);
+
+static cte_status_t _append_to_sink(cte_render_s *render,
+                         const char *str, size_t length);
+
+static cte_status_t _expand_template(cte_render_s *render,
+                         const char *tmplate, cte_template_s *compiled);
+
+static void _report_sizing(cte_values_s *values,
+                         const char *tmplate, cte_template_s *compiled);
+
+static size_t _render_to_file(int fd, cte_values_s *values,
+                         const char *tmplate, cte_template_s *compiled,
+                         cte_status_t *status);
+
+static bool _write_to_file(const char *data, size_t length, void *fd);
+
+static cte_status_t _expand_source(cte_render_s *render,
+                         const char *source_str, size_t s_length,
+                         size_t s_index, cardinal nesting_level);
+
+static cte_render_state_s *_new_render_state(const char *source,
+                         size_t s_length, const cte_syntax_s *syntax,
+                         cte_status_t *status);
     
-    char *source; // source string pointer
-    char *target; // target string pointer
-    cardinal s_index; // source string index
-    cardinal t_index; // target string index
-    cardinal t_size; // allocated size of target string
+static fmacro void _save_frame(cte_render_s *render, const char *source,
+                         size_t s_length, size_t s_index,
+                         cardinal nesting_level, cardinal base_level,
+                         bool in_section);
     
-    cte_stack_t stack; // template context stack
-    cardinal nesting_level; // template nesting level
+static cte_chunked_render_s *_new_chunked_render(cte_table_t table,
+                         kvs_table_t kvs, cte_sink_f sink, void *context,
+                         cte_status_t *status);
     
-    kvs_key_t key; // placeholder key
-    cardinal ident_len; // identifier length
-    cte_status_t r_status; // intermediate status
+static fmacro bool _chunk_stop(cte_render_s *render, const char *source,
+                         size_t s_length, size_t s_index);
     
+static cte_status_t _expand_compiled(cte_render_s *render,
+                         cte_template_s *compiled);
     
-    // bail out if template string is NULL
-    if (template == NULL) {
-        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
-        return NULL;
-    } // end if
+static cte_status_t _expand_segments(cte_render_s *render,
+                         cte_template_s *compiled, cardinal first,
+                         cardinal end, cardinal *stop);
     
-    // bail out if placeholders is NULL
-    if (placeholders == NULL) {
-        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
-        return NULL;
-    } // end if
+static cte_status_t _expand_remainder(cte_render_s *render,
+                         cte_template_s *compiled, cardinal index);
     
-    // allocate new target string
-    t_size = CTE_TARGET_SIZE_INITIAL;
-    target = ALLOCATE(t_size);
+static void *_size_segments(void *unit);
     
-    // bail out if target allocation failed
-    if (target == NULL) {
-        CTE_NOTIFY(CTE_NOTIFICATION_TARGET_ALLOCATION_FAILED, template, 0);
-        ASSIGN_BY_REF(status, CTE_STATUS_ALLOCATION_FAILED);
-        return NULL;
-    } // end if
+static void *_fill_segments(void *unit);
     
-    // allocate new recursion stack
-    stack = cte_new_stack(CTE_MAX_NESTING_LEVEL, NULL);
+static void _run_work_units(cte_work_unit_s *unit, cardinal count,
+                         void *(*work)(void *));
     
-    // bail out if stack allocation failed
-    if (stack == NULL) {
-        CTE_NOTIFY(CTE_NOTIFICATION_STACK_ALLOCATION_FAILED, template, 0);
-        DEALLOCATE(target);
-        ASSIGN_BY_REF(status, CTE_STATUS_ALLOCATION_FAILED);
-        return NULL;
+static void _capture_parallel(cte_capture_record_t capture,
+                         cte_template_s *compiled, kvs_table_t placeholders,
+                         const char *result, size_t total);
+    
+static void _compile(const char *source, cardinal s_length,
+                         const cte_syntax_s *syntax, cte_template_s *compiled,
+                         cardinal *segment_count, cardinal *text_length);
+    
+static bool _next_placeholder(const cte_syntax_s *syntax,
+                         const char *source, size_t *s_index,
+                         cardinal *ident_len, kvs_key_t *key);
+    
+static cte_status_t _expand_section(cte_render_s *render,
+                         const char *source, size_t s_length,
+                         size_t s_index, cardinal nesting_level,
+                         size_t *next);
+    
+static cte_status_t _expand_rows(cte_render_s *render,
+                         const char *source, size_t body_start,
+                         size_t body_end, const cte_table_t *row,
+                         cardinal count, cardinal nesting_level);
+    
+static bool _section_at(const cte_syntax_s *syntax,
+                         const char *source, size_t s_length,
+                         size_t s_index, cardinal *ident_len, kvs_key_t *key);
+    
+static bool _section_end(const cte_syntax_s *syntax,
+                         const char *source, size_t s_length,
+                         size_t s_index, const char *ident,
+                         cardinal ident_len, size_t *body_end);
+    
+static fmacro char _section_tag_at(const cte_syntax_s *syntax,
+                         const char *source, size_t s_length,
+                         size_t s_index, const char *ident,
+                         cardinal ident_len);
+    
+static cte_status_t _collect_placeholders(cte_placeholder_set_s *set,
+                         const cte_syntax_s *syntax, const char *source,
+                         size_t s_index, kvs_table_t table);
+    
+static cte_placeholder_set_s *_new_placeholder_set(void);
+    
+static cte_status_t _add_to_placeholder_set(cte_placeholder_set_s *set,
+                         const char *ident, cardinal length, kvs_key_t key,
+                         bool *added);
+    
+static fmacro cte_status_t _append_to_target(cte_render_s *render,
+                         const char *str, size_t length);
+    
+static cte_status_t _append_to_step(cte_render_s *render,
+                         const char *str, size_t length);
+    
+static fmacro void _init_values(cte_values_s *values, cte_table_t table,
+                         kvs_table_t kvs, cte_resolver_f resolver,
+                         void *context);
+    
+static fmacro const char *_value_for_placeholder(cte_values_s *values,
+                         const char *ident, cardinal length, kvs_key_t key,
+                         size_t *v_length, cte_escape_t *escape);
+    
+static const char *_resolve_placeholder(cte_values_s *values,
+                         const char *ident, cardinal length, kvs_key_t key,
+                         size_t *v_length);
+    
+static const cte_table_t *_rows_for_placeholder(cte_values_s *values,
+                         kvs_key_t key, cardinal *count);
+    
+static cte_resolver_cache_entry_s *_new_resolver_cache(cardinal size);
+    
+static void _enlarge_resolver_cache(cte_resolver_cache_s *cache);
+    
+static fmacro cte_status_t _append_char_to_target(cte_render_s *render,
+                         char ch);
+    
+static cte_status_t _append_escaped(cte_render_s *render, cte_escape_t escape,
+                         const char *str, size_t length);
+    
+static fmacro uint8_t _value_escape(cte_render_s *render, cte_escape_t escape);
+    
+static fmacro bool _is_syntax_string(const char *str);
+    
+static void _init_syntax(cte_syntax_s *syntax, const char *delimiter,
+                         const char *closing_delimiter, const char *prefix);
+    
+static void _diagnose(cte_render_s *render, cte_notification_t notification,
+                         const char *str, size_t index);
+    
+static long_file_pos_t _position_of(const char *str, size_t index,
+                         cte_template_s *compiled);
+    
+static const char *_identifier_before(const char *str, size_t end,
+                         cardinal *length);
+    
+static fmacro bool _is_metered(const cte_render_s *render);
+    
+#ifdef CTE_WITH_CAPTURE
+static void _capture_value(cte_render_s *render, const char *ident,
+                         cardinal length, kvs_key_t key, const char *value,
+                         size_t v_length, cte_escape_t escape);
+    
+static void _end_capture(cte_render_s *render, cte_status_t r_status);
+    
+#endif
+    
+#define CTE_NOTIFY( _notification, _str, _index_or_size) \
+    CTE_NOTIFY_RENDER( NULL, _notification, _str, _index_or_size)
+    
+#define CTE_NOTIFY_RENDER( _render, _notification, _str, _index_or_size) \
+    { if (_is_metered(_render)) { \
+    if (_cte_notify != NULL) \
+    _cte_notify( _notification, _str, _index_or_size); \
+    if (_cte_diagnose != NULL) \
+    _diagnose( _render, _notification, _str, _index_or_size); \
+    CTE_METRIC_NOTIFY( _notification); } }
+    
+#define CTE_METER(_render, _metric, _amount) \
+    { if (_is_metered(_render)) CTE_METRIC_ADD(_metric, _amount); }
+    
+#define CTE_BUDGET_EXCEEDED(_render, _r_status) \
+    (((_render)->budget != NULL) && \
+     ((_r_status = _charge_budget(_render)) != CTE_STATUS_SUCCESS))
+    
+#ifdef CTE_WITH_CAPTURE
+#define CTE_CAPTURE_BEGIN(_render, _tmplate, _length) \
+    { if (((_render)->capture = cte_capture_begin()) != NULL) { \
+    (_render)->c_template = (_tmplate); \
+    (_render)->c_length = (_length); } }
+    
+#define CTE_CAPTURE_VALUE(_render, _ident, _length, _key, _value, \
+                          _v_length, _escape) \
+    { if ((_render)->capture != NULL) \
+    _capture_value(_render, _ident, _length, _key, _value, \
+                   _v_length, _escape); }
+    
+#define CTE_CAPTURE_OUTPUT(_render, _str, _length) \
+    { if ((_render)->capture != NULL) \
+    cte_capture_output((_render)->capture, _str, _length); }
+    
+#define CTE_CAPTURE_END(_render, _r_status) \
+    { if ((_render)->capture != NULL) _end_capture(_render, _r_status); }
+    
+#define CTE_CAPTURE_DISCARD(_render) \
+    { cte_capture_discard((_render)->capture); (_render)->capture = NULL; }
+#else
+#define CTE_CAPTURE_BEGIN(_render, _tmplate, _length) ((void) 0)
+    
+#define CTE_CAPTURE_VALUE(_render, _ident, _length, _key, _value, \
+                          _v_length, _escape) ((void) 0)
+    
+#define CTE_CAPTURE_OUTPUT(_render, _str, _length) ((void) 0)
+    
+#define CTE_CAPTURE_END(_render, _r_status) ((void) 0)
+    
+#define CTE_CAPTURE_DISCARD(_render) ((void) 0)
+#endif
+    
+#define CTE_START_OF_LINE(_str, _index) \
+    ((_index == 0) || (_str[_index-1] == NEWLINE))
+    
+#define CTE_CHAR_CLASS(_syntax, _ch) \
+    ((_syntax)->char_class[(uint8_t) (_ch)])
+    
+#define CTE_RESOLVER_CACHE_FULL(_cache) \
+    ((_cache)->count >= ((_cache)->size - ((_cache)->size >> 2)))
+    
+    
+// ===========================================================================
+// P U B L I C   F U N C T I O N   I M P L E M E N T A T I O N S
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// function:  cte_delimiter()
+// ---------------------------------------------------------------------------
+//
+// Returns a pointer to a constant C string  containing the library's built-in
+// placeholder delimiter.  The built-in delimiter may be changed  at compile
+// time only,  other delimiters may be used with a syntax  created at runtime
+// by cte_new_syntax().  The factory setting is "@@".
+
+inline const char *cte_delimiter(void) {
+    return (const char *) &_cte_default_syntax.delimiter;
+} // end cte_delimiter
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_ignore_prefix()
+// ---------------------------------------------------------------------------
+//
+// Returns a pointer to a constant C string  containing the library's built-in
+// ignore prefix.  The built-in ignore prefix may be changed at compile time
+// only,  other prefixes may be used with a syntax created at runtime by func-
+// tion cte_new_syntax().  The factory setting is "%%".
+
+inline const char *cte_ignore_prefix(void) {
+    return (const char *) &_cte_default_syntax.ignore_prefix;
+} // end cte_ignore_prefix
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_new_syntax( delimiter, closing_delimiter, prefix, status )
+// ---------------------------------------------------------------------------
+//
+// Creates and returns a new template syntax  with opening placeholder delimi-
+// ter <delimiter>,  closing placeholder delimiter <closing_delimiter>  and
+// ignore prefix <prefix>.  If NULL is passed in for <delimiter> or <prefix>,
+// the built-in delimiter or ignore prefix is used.  If NULL is passed in for
+// <closing_delimiter>,  the closing delimiter is the same as the opening de-
+// limiter.  The function returns NULL if it fails.
+//
+// Delimiters and prefix must consist of exactly two printable characters that
+// are neither whitespace,  backslash,  underscore,  letter nor digit,  and the
+// first character of the opening delimiter must differ from the first charac-
+// ter of the ignore prefix.  Otherwise the function fails with status
+// CTE_STATUS_INVALID_SYNTAX.
+//
+// A syntax  replaces '@@' and '%%' in the grammar described for function
+// cte_string_from_template(),  with the first character of the opening deli-
+// miter  and  the first character of the ignore prefix  taking the place of
+// '@' and '%' in escape sequences.  The character classification used by the
+// template scanners is built when the syntax is created,  so that templates
+// of any syntax are scanned as fast as those of the built-in syntax.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_syntax_t cte_new_syntax(const char *delimiter,
+                            const char *closing_delimiter,
+                            const char *prefix,
+                            cte_status_t *status) {
+    
+    cte_syntax_s *syntax;
+    
+    // use built-in delimiter and prefix for NULL
+    if (delimiter == NULL)
+        delimiter = _cte_default_syntax.delimiter;
+    
+    if (closing_delimiter == NULL)
+        closing_delimiter = delimiter;
+    
+    if (prefix == NULL)
+        prefix = _cte_default_syntax.ignore_prefix;
+    
+    // bail out if delimiters or prefix are invalid
+    if ((NOT(_is_syntax_string(delimiter))) ||
+        (NOT(_is_syntax_string(closing_delimiter))) ||
+        (NOT(_is_syntax_string(prefix))) ||
+        (delimiter[0] == prefix[0])) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_SYNTAX);
+        return NULL;
+    } // end if
+    
+    syntax = ALLOCATE(sizeof(cte_syntax_s));
+    
+    // bail out if allocation failed
+    if (syntax == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_ALLOCATION_FAILED);
+        return NULL;
+    } // end if
+    
+    _init_syntax(syntax, delimiter, closing_delimiter, prefix);
+    
+    ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
+    return (cte_syntax_t) syntax;
+} // end cte_new_syntax
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_syntax_set_escape( syntax, escape, status )
+// ---------------------------------------------------------------------------
+//
+// Sets the output escaping mode of template syntax <syntax> to <escape>.  All
+// output  that originates from placeholder values,  including nested values,
+// is escaped while it is copied to the target,  the text of the template it-
+// self is copied as it is.  Values need therefore not be escaped before they
+// are stored.  Runs of characters that need no escaping are found several
+// bytes at a time where SSE2 or NEON is available,  so that escaping costs
+// little more than copying  for typical values.  The function fails  if NULL
+// is passed in for <syntax> or if <escape> is not a valid escaping mode.  The
+// escaping mode of a new syntax is CTE_ESCAPE_NONE.  Templates compiled with
+// the syntax before the call are not affected.  The mode is overridden by the
+// escaping mode of a render,  see cte_string_from_template_escaped(),  and by
+// that of a value,  see cte_table_store_escaped_value().
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_syntax_set_escape(cte_syntax_t syntax,
+                           cte_escape_t escape,
+                           cte_status_t *status) {
+    
+    // bail out if syntax is NULL or escaping mode is invalid
+    if ((syntax == NULL) || (escape > CTE_ESCAPE_URL)) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_SYNTAX);
+        return;
+    } // end if
+    
+    ((cte_syntax_s *) syntax)->escape = escape;
+    
+    ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
+    return;
+} // end cte_syntax_set_escape
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_dispose_syntax( syntax )
+// ---------------------------------------------------------------------------
+//
+// Disposes of template syntax <syntax>.  Templates compiled with the syntax
+// hold their own copy of it and are not affected.  Returns NULL.
+
+cte_syntax_t cte_dispose_syntax(cte_syntax_t syntax) {
+    
+    if (syntax != NULL)
+        DEALLOCATE(syntax);
+    
+    return NULL;
+} // end cte_dispose_syntax
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_install_notification_handler( handler )
+// ---------------------------------------------------------------------------
+//
+// Installs function <handler>  as  notification handler.  If  a  notification
+// handler is installed,  the template engine calls the handler when a notifi-
+// able event occurs while expanding a template.  Notifiable events are either
+// informational or warnings or errors.  By default no handler is installed.
+//
+// The template engine passes the following parameters to the handler:
+//
+// o  notification code describing the notified event
+// o  pointer to the template being expanded when the event occurred
+// o  index to the character in the template when the event occurred
+//
+// A notification handler may be uninstalled by passing in NULL for <handler>.
+
+inline void cte_install_notification_handler(cte_notification_f handler) {
+    _cte_notify = handler;
+    return;
+} // end cte_install_notification_handler
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_install_diagnostic_handler( handler )
+// ---------------------------------------------------------------------------
+//
+// Installs function <handler>  as  diagnostic handler.  If a diagnostic hand-
+// ler is installed,  the template engine calls the handler  for the same events
+// as a notification handler,  passing a diagnostic that describes the event.
+// Line, coloumn and nesting information is only determined when an event occurs
+// and does not slow down expansion otherwise.  Compiled templates hold an index
+// of their line ends  so that positions within them are found by binary search.
+// Diagnostics and their placeholder names are only valid during the call.
+// By default no handler is installed.
+//
+// A diagnostic handler may be uninstalled by passing in NULL for <handler>.
+
+void cte_install_diagnostic_handler(cte_diagnostic_f handler) {
+    _cte_diagnose = handler;
+    return;
+} // end cte_install_diagnostic_handler
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_diagnostic_placeholder( diagnostic, level, length )
+// ---------------------------------------------------------------------------
+//
+// Returns a pointer to the name of the placeholder being expanded at nesting
+// level <level>  when the event described by <diagnostic> occurred  and passes
+// back the length of the name in <length>.  Level one is the outermost place-
+// holder within the template.  The name is not terminated.  Returns NULL if
+// NULL is passed in for <diagnostic> or <length>  or if <level> is zero or ex-
+// ceeds the nesting level of the diagnostic.
+
+const char *cte_diagnostic_placeholder(const cte_diagnostic_t *diagnostic,
+                                       cardinal level,
+                                       cardinal *length) {
+    
+    #define this_render ((cte_render_s *)diagnostic->context)
+    const char *str;
+    size_t s_length, s_index;
+    
+    // bail out if diagnostic or length is NULL or level is out of range
+    if ((diagnostic == NULL) || (length == NULL) ||
+        (level == 0) || (level > diagnostic->nesting_level))
+        return NULL;
+    
+    // outermost placeholder of a compiled template is that of its segment
+    if (this_render->segment != NULL) {
+        if (level == 1) {
+            *length = this_render->segment->length;
+            return &this_render->compiled->source[
+                        this_render->segment->offset + 2];
+        } // end if
+        
+        level--;
+    } // end if
+    
+    // saved contexts resume past the closing delimiter of their placeholder
+    str = cte_stack_context_at(this_render->stack,
+                               level - 1, &s_length, &s_index, NULL);
+    
+    return _identifier_before(str, s_index - 2, length);
+    
+    #undef this_render
+} // end cte_diagnostic_placeholder
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_string_from_template( tmplate, placeholders, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in template string <tmplate>
+// and  returns a pointer to a new dynamically allocated string containing the
+// resulting string.  The function fails  if NULL is passed in  for <tmplate>
+// or <placeholders>  or if allocation fails  or the template nesting limit or
+// the section depth limit is exceeded.  The function returns NULL if it fails.
+//
+// When a placeholder string is found in the template, a key is calculated for
+// its identifier.  The key is then looked up in the placeholder table  passed
+// in <placeholders>.  If the key is found in the placeholder table,  then its
+// value is retrieved and the respective placeholder string in the template is
+// replaced with the string pointed to by the retrieved value.
+//
+// The function recognises templates according to the following EBNF grammar:
+//
+//  template :
+//    ( template-comment | escape-sequence | placeholder-string | section |
+//      character )*
+//
+//  template-comment :
+//    '%%' character* end-of-line
+//
+//  placeholder-string :
+//    '@@' identifier '@@'
+//
+//  section :
+//    '@@#' identifier '@@' template '@@/' identifier '@@'
+//
+//  identifier :
+//    letter ( letter | digit | '_' )*
+//
+//  letter :
+//    'A' .. 'Z' | 'a' .. 'z'
+//
+//  digit :
+//    '0' .. '9'
+//
+//  end-of-line :
+//    ASCII(10)
+//
+//  escape-sequence :
+//    '\' ( '\' | '%' | '@' )
+//
+//  character :
+//    ASCII(0) .. ASCII(127)
+//
+// Static semantics:
+//
+// o  template comments are  ONLY  recognised in coloumn #1 of any line,  that
+//    is to say,  the prefix "%%" must either occur at index 0 of the top most
+//    template,  or it must immediately follow a newline control character.
+//
+// o  identifiers must not exceed the value of cte_max_placeholder_length().
+//
+// o  template nesting must not exceed the value of cte_max_nesting_level().
+//
+// o  a section is  ONLY  recognised  if rows have been stored for its identi-
+//    fier with cte_table_store_rows()  and its body is closed by a section end
+//    with the same identifier,  sections of the same name may be nested.  The
+//    body is expanded once per row,  placeholders are looked up in the row's
+//    table first,  then in the tables of enclosing sections,  then in the
+//    value source of the render.  Section identifiers are looked up the same
+//    way:  a section nested in a row that has no rows of its own name expands
+//    the rows found in an enclosing scope.  With rows A and B stored for r,
+//    each setting x to its name,  @@#r@@(@@x@@@@#r@@{@@x@@}@@/r@@)@@/r@@
+//    expands to (A{A}{B})(B{A}{B}).  Sections with no rows produce no output.
+//    Otherwise the section opening is copied like an undefined placeholder.
+//
+// o  sections must not be nested deeper than CTE_MAX_SECTION_DEPTH,  other-
+//    wise the render fails with status CTE_STATUS_NESTING_LIMIT_EXCEEDED.
+//
+// o  escape sequences are reproduced as follows:
+//    "\\" produces "\\" in the expanded result string
+//    "\@" produces "@" in the expanded result string
+//    "\%" at coloumn #1 produces "%" in the expanded result string
+//    "\%" at coloumns > 1 produces "\%" in the expanded result string
+//    
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_template(const char *tmplate,
+                               kvs_table_t placeholders,
+                               cte_status_t *status) {
+    
+    return cte_string_from_template_with_syntax(tmplate,
+                                                NULL, placeholders, status);
+} // end cte_string_from_template
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_string_from_template_with_syntax( tmplate, syntax, placeholders, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in template string <tmplate>
+// exactly like cte_string_from_template(),  except that the template and its
+// placeholder values are recognised according to template syntax <syntax>.
+// If NULL is passed in for <syntax>,  the built-in syntax is used.  The func-
+// tion fails for the same reasons as cte_string_from_template().  It returns
+// NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_template_with_syntax(const char *tmplate,
+                                           cte_syntax_t syntax,
+                                           kvs_table_t placeholders,
+                                           cte_status_t *status) {
+    
+    return _string_from_template(tmplate, syntax,
+                                 placeholders, CTE_ESCAPE_DEFAULT, status);
+} // end cte_string_from_template_with_syntax
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_string_from_template_escaped( tmplate, placeholders, escape, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in template string <tmplate>
+// exactly like cte_string_from_template(),  except that all output that ori-
+// ginates from placeholder values  is escaped in escaping mode <escape> while
+// it is copied to the target,  the text of the template itself is copied as
+// it is.  The mode applies to the expansion of a value entered from the tem-
+// plate as a whole,  including any values nested in it.  If CTE_ESCAPE_DEFAULT
+// is passed in for <escape>,  the mode of the built-in syntax is used.  The
+// function fails for the same reasons as cte_string_from_template()  and with
+// status CTE_STATUS_INVALID_SYNTAX  if <escape> is not a valid escaping mode.
+// It returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_template_escaped(const char *tmplate,
+                                       kvs_table_t placeholders,
+                                       cte_escape_t escape,
+                                       cte_status_t *status) {
+    
+    return _string_from_template(tmplate, NULL,
+                                 placeholders, escape, status);
+} // end cte_string_from_template_escaped
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_string_from_resolver( tmplate, resolver, context, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in template string <tmplate>
+// and  returns a pointer to a new dynamically allocated string containing the
+// resulting string.  Unlike cte_string_from_template(),  placeholder values
+// are not looked up in a placeholder table but obtained on demand by calling
+// resolver function <resolver>.  The function fails if NULL is passed in for
+// <tmplate> or <resolver> or if allocation fails or the template nesting limit
+// is exceeded.  The function returns NULL if it fails.
+//
+// The resolver is only called for placeholders  actually encountered  during
+// expansion,  and at most once per distinct identifier and render.  Resolved
+// values are cached for the duration of the render,  this includes undefined
+// placeholders for which the resolver returned NULL.  The resolver is passed
+// the identifier as a terminated string, its key and the pointer passed in
+// <context>.  Strings returned by the resolver must remain valid  until this
+// function returns.  They are never modified nor deallocated by the engine.
+//
+// Templates  and  resolved values  are recognised  according to the grammar
+// and static semantics described for function cte_string_from_template().
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_resolver(const char *tmplate,
+                               cte_resolver_f resolver,
+                               void *context,
+                               cte_status_t *status) {
+    
+    cte_render_s render;
+    cte_values_s values;
+    cte_status_t r_status;
+    char *result;
+    
+    // bail out if template string is NULL
+    if (tmplate == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return NULL;
+    } // end if
+    
+    // bail out if resolver is NULL
+    if (resolver == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
+        return NULL;
+    } // end if
+    
+    _init_values(&values, NULL, NULL, resolver, context);
+    
+    r_status = _begin_render(&render, &values, tmplate);
+    
+    // bail out if allocation failed
+    if (r_status != CTE_STATUS_SUCCESS) {
+        ASSIGN_BY_REF(status, r_status);
+        return NULL;
+    } // end if
+    
+    CTE_CAPTURE_BEGIN(&render, tmplate, strlen(tmplate));
+    
+    r_status = _expand_source(&render, tmplate, strlen(tmplate), 0, 0);
+    result = _finish_render(&render, r_status, status);
+    
+    // dispose of per-render resolver cache
+    if (values.cache.entry != NULL)
+        DEALLOCATE(values.cache.entry);
+    
+    return result;
+} // cte_string_from_resolver
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_string_from_table( tmplate, table, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in template string <tmplate>
+// and  returns a pointer to a new dynamically allocated string containing the
+// resulting string.  Unlike cte_string_from_template(),  placeholder values
+// are looked up in placeholder table <table>,  which is optimised for the
+// small number of placeholders typical of templates.  The function fails if
+// NULL is passed in for <tmplate> or <table> or if allocation fails or the
+// template nesting limit is exceeded.  The function returns NULL if it fails.
+//
+// Values in the table need not be terminated,  their lengths are taken from
+// the table.  Templates and values are recognised  according to the grammar
+// and static semantics described for function cte_string_from_template().
+// Placeholders whose value is pending are treated as undefined.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_table(const char *tmplate,
+                            cte_table_t table,
+                            cte_status_t *status) {
+    
+    return cte_string_from_table_escaped(tmplate,
+                                         table, CTE_ESCAPE_DEFAULT, status);
+} // end cte_string_from_table
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_string_from_table_escaped( tmplate, table, escape, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in template string <tmplate>
+// exactly like cte_string_from_table(),  except that all output that origin-
+// ates from placeholder values is escaped as described for function cte_str-
+// ing_from_template_escaped().  Values stored in <table>  with a mode of their
+// own are escaped in their own mode instead.  The function fails for the same
+// reasons as cte_string_from_table()  and with status CTE_STATUS_INVALID_SYN-
+// TAX  if <escape> is not a valid escaping mode.  It returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_table_escaped(const char *tmplate,
+                                    cte_table_t table,
+                                    cte_escape_t escape,
+                                    cte_status_t *status) {
+    
+    cte_render_s render;
+    cte_values_s values;
+    cte_status_t r_status;
+    
+    // bail out if template string is NULL
+    if (tmplate == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return NULL;
+    } // end if
+    
+    // bail out if table is NULL
+    if (table == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
+        return NULL;
+    } // end if
+    
+    // bail out if escaping mode is invalid
+    if (escape > CTE_ESCAPE_DEFAULT) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_SYNTAX);
+        return NULL;
+    } // end if
+    
+    _init_values(&values, table, NULL, NULL, NULL);
+    
+    r_status = _begin_render(&render, &values, tmplate);
+    
+    // bail out if allocation failed
+    if (r_status != CTE_STATUS_SUCCESS) {
+        ASSIGN_BY_REF(status, r_status);
+        return NULL;
+    } // end if
+    
+    CTE_CAPTURE_BEGIN(&render, tmplate, strlen(tmplate));
+    
+    render.escape = escape;
+    
+    r_status = _expand_source(&render, tmplate, strlen(tmplate), 0, 0);
+    
+    return _finish_render(&render, r_status, status);
+} // end cte_string_from_table_escaped
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_string_from_template_with_budget( tmplate, placeholders, budget, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in template string <tmplate>
+// exactly like cte_string_from_template(),  except that the render is aborted
+// as soon as it exceeds a limit of budget <budget>.  If NULL is passed in for
+// <budget>,  the render is unlimited.  The function fails for the same reasons
+// as cte_string_from_template()  and with status CTE_STATUS_OUTPUT_LIMIT_EX-
+// CEEDED,  CTE_STATUS_EXPANSION_LIMIT_EXCEEDED or CTE_STATUS_DEADLINE_EXCEEDED
+// if the respective limit is exceeded.  It returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_template_with_budget(const char *tmplate,
+                                           kvs_table_t placeholders,
+                                           const cte_budget_t *budget,
+                                           cte_status_t *status) {
+    
+    cte_render_s render;
+    cte_values_s values;
+    cte_status_t r_status;
+    size_t length;
+    
+    // bail out if template string is NULL
+    if (tmplate == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return NULL;
+    } // end if
+    
+    // bail out if placeholders is NULL
+    if (placeholders == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
+        return NULL;
+    } // end if
+    
+    _init_values(&values, NULL, placeholders, NULL, NULL);
+    
+    r_status = _begin_render(&render, &values, tmplate);
+    
+    // bail out if allocation failed
+    if (r_status != CTE_STATUS_SUCCESS) {
+        ASSIGN_BY_REF(status, r_status);
+        return NULL;
+    } // end if
+    
+    CTE_CAPTURE_BEGIN(&render, tmplate, strlen(tmplate));
+    
+    _begin_budget(&render, budget);
+    
+    length = strlen(tmplate);
+    r_status = _expand_source(&render, tmplate, length, 0, 0);
+    r_status = _settle_budget(&render, tmplate, length, r_status);
+    
+    return _finish_render(&render, r_status, status);
+} // end cte_string_from_template_with_budget
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_render_into( buffer, capacity, tmplate, placeholders, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in template string <tmplate>
+// into caller owned buffer <buffer> of <capacity> bytes and returns the num-
+// ber of characters of the full expansion,  not counting the terminator.  The
+// semantics follow those of snprintf():  At most <capacity> - 1 characters are
+// written and the buffer is always terminated unless <capacity> is zero.  The
+// result was truncated if the return value is not less than <capacity>,  in
+// which case a buffer of return value + 1 bytes will hold the full result.
+// NULL may be passed in for <buffer> if zero is passed in for <capacity>,  to
+// obtain the required size without writing anything.
+//
+// Placeholder values are looked up in <placeholders>  as described for func-
+// tion cte_string_from_template().  No memory is allocated  unless template
+// nesting exceeds CTE_RENDER_STACK_SIZE levels.
+//
+// The function fails if NULL is passed in for <tmplate> or <placeholders>,  or
+// for <buffer> while <capacity> is not zero,  or if allocation fails or the
+// template nesting limit is exceeded.  If the function fails,  it returns zero
+// and the buffer holds the empty string.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_render_into(char *buffer,
+                       size_t capacity,
+                       const char *tmplate,
+                       kvs_table_t placeholders,
+                       cte_status_t *status) {
+    
+    cte_render_s render;
+    cte_values_s values;
+    cte_status_t r_status;
+    
+    // bail out if buffer is NULL but capacity is not zero
+    if ((buffer == NULL) && (capacity > 0)) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TARGET);
+        return 0;
+    } // end if
+    
+    // bail out if template string is NULL
+    if (tmplate == NULL) {
+        if (capacity > 0)
+            buffer[0] = CSTRING_TERMINATOR;
+        
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return 0;
+    } // end if
+    
+    // bail out if placeholders is NULL
+    if (placeholders == NULL) {
+        if (capacity > 0)
+            buffer[0] = CSTRING_TERMINATOR;
+        
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
+        return 0;
+    } // end if
+    
+    _init_values(&values, NULL, placeholders, NULL, NULL);
+    
+    _begin_render_into(&render, &values, buffer, capacity);
+    
+    CTE_CAPTURE_BEGIN(&render, tmplate, strlen(tmplate));
+    
+    r_status = _expand_source(&render, tmplate, strlen(tmplate), 0, 0);
+    
+    return _finish_render_into(&render, r_status, status);
+} // cte_render_into
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_render_table_into( buffer, capacity, tmplate, t_length, table, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in template string <tmplate>
+// of length <t_length> into caller owned buffer <buffer> of <capacity> bytes,
+// with the same semantics as cte_render_into(),  except that placeholder va-
+// lues are looked up in placeholder table <table>  as described for function
+// cte_string_from_table().  Neither the template nor the values need to be
+// terminated,  which permits rendering from and into storage managed by other
+// languages without copying.
+//
+// The function fails if NULL is passed in for <tmplate> or <table>,  or for
+// <buffer> while <capacity> is not zero,  or if allocation fails or the tem-
+// plate nesting limit is exceeded.  If the function fails,  it returns zero
+// and the buffer holds the empty string.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_render_table_into(char *buffer,
+                             size_t capacity,
+                             const char *tmplate,
+                             size_t t_length,
+                             cte_table_t table,
+                             cte_status_t *status) {
+    
+    cte_render_s render;
+    cte_values_s values;
+    cte_status_t r_status;
+    
+    // bail out if buffer is NULL but capacity is not zero
+    if ((buffer == NULL) && (capacity > 0)) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TARGET);
+        return 0;
+    } // end if
+    
+    // bail out if template string is NULL
+    if (tmplate == NULL) {
+        if (capacity > 0)
+            buffer[0] = CSTRING_TERMINATOR;
+        
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return 0;
+    } // end if
+    
+    // bail out if table is NULL
+    if (table == NULL) {
+        if (capacity > 0)
+            buffer[0] = CSTRING_TERMINATOR;
+        
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
+        return 0;
+    } // end if
+    
+    _init_values(&values, table, NULL, NULL, NULL);
+    
+    _begin_render_into(&render, &values, buffer, capacity);
+    
+    CTE_CAPTURE_BEGIN(&render, tmplate, t_length);
+    
+    r_status = _expand_source(&render, tmplate, t_length, 0, 0);
+    
+    return _finish_render_into(&render, r_status, status);
+} // cte_render_table_into
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_render_table_length( tmplate, t_length, table, status )
+// ---------------------------------------------------------------------------
+//
+// Returns the number of characters  that cte_render_table_into() produces for
+// template string <tmplate> of length <t_length>  with placeholder values from
+// placeholder table <table>,  not counting the terminator,  without writing
+// anything.  The sizing render is silent:  its notifications and diagnostics
+// are not passed to the handlers and it is not counted in the engine metrics,
+// so that the render that follows it reports every event once.  If it fails,
+// the events of the failed render are reported,  since no render follows.
+//
+// The function fails for the same reasons as cte_render_table_into()  and re-
+// turns zero if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_render_table_length(const char *tmplate,
+                               size_t t_length,
+                               cte_table_t table,
+                               cte_status_t *status) {
+    
+    cte_render_s render;
+    cte_values_s values;
+    cte_status_t r_status;
+    size_t length;
+    
+    // bail out if template string is NULL
+    if (tmplate == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return 0;
+    } // end if
+    
+    // bail out if table is NULL
+    if (table == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
+        return 0;
+    } // end if
+    
+    _init_values(&values, table, NULL, NULL, NULL);
+    
+    _begin_render_into(&render, &values, NULL, 0);
+    render.sizing = true;
+    r_status = _expand_source(&render, tmplate, t_length, 0, 0);
+    length = _finish_render_into(&render, r_status, &r_status);
+    
+    // repeat a failed sizing render to report its events
+    if (r_status != CTE_STATUS_SUCCESS) {
+        _begin_render_into(&render, &values, NULL, 0);
+        _expand_source(&render, tmplate, t_length, 0, 0);
+        cte_dispose_stack(render.stack);
+    } // end if
+    
+    ASSIGN_BY_REF(status, r_status);
+    return length;
+} // cte_render_table_length
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_string_and_digest_from_template( tmplate, placeholders,
+//                                                  kinds, digest, status )
+// ---------------------------------------------------------------------------
+//
+// Expands template string <tmplate>  exactly like cte_string_from_template()
+// and returns the result,  additionally computing the digests requested in bit
+// set <kinds>  of the result  and passing them back in <digest>.  The digests
+// are computed incrementally as the result is produced,  without a further
+// pass over the result.  The terminator is not included in the digests.  The
+// function fails for the same reasons as cte_string_from_template() and if
+// NULL is passed in for <digest>.  The function returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_and_digest_from_template(const char *tmplate,
+                                          kvs_table_t placeholders,
+                                          cardinal kinds,
+                                          cte_digest_t *digest,
+                                          cte_status_t *status) {
+    
+    cte_render_s render;
+    cte_values_s values;
+    cte_digest_state_t state;
+    cte_status_t r_status;
+    
+    // bail out if template string is NULL
+    if (tmplate == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return NULL;
+    } // end if
+    
+    // bail out if placeholders or digest is NULL
+    if ((placeholders == NULL) || (digest == NULL)) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
+        return NULL;
+    } // end if
+    
+    _init_values(&values, NULL, placeholders, NULL, NULL);
+    
+    r_status = _begin_render(&render, &values, tmplate);
+    
+    // bail out if allocation failed
+    if (r_status != CTE_STATUS_SUCCESS) {
+        ASSIGN_BY_REF(status, r_status);
+        return NULL;
+    } // end if
+    
+    CTE_CAPTURE_BEGIN(&render, tmplate, strlen(tmplate));
+    
+    cte_digest_init(&state, kinds);
+    render.digest = &state;
+    
+    r_status = _expand_source(&render, tmplate, strlen(tmplate), 0, 0);
+    
+    cte_digest_final(&state, digest);
+    
+    return _finish_render(&render, r_status, status);
+} // cte_string_and_digest_from_template
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_render_to_sink( tmplate, placeholders, sink, context,
+//                                chunk_size, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in template string <tmplate>
+// and passes the result to sink <sink>,  together with <context>,  in chunks
+// of up to <chunk_size> bytes,  as it is produced.  Returns the number of bytes
+// passed to the sink.  If zero is passed in for <chunk_size>,  chunks are of up
+// to CTE_SINK_CHUNK_SIZE bytes.  Memory use is bounded by the chunk size,  the
+// result is never held in full.  Values that fill a whole chunk by themselves
+// are passed to the sink without copying,  the sink must therefore accept
+// chunks larger than <chunk_size>.  No terminator is passed to the sink.
+//
+// Placeholder values are looked up in <placeholders>  as described for func-
+// tion cte_string_from_template().  The function fails if NULL is passed in
+// for <tmplate>,  <placeholders> or <sink>  or if allocation fails or the tem-
+// plate nesting limit is exceeded or the sink returns false.  Output passed to
+// the sink before the failure is not retracted.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_render_to_sink(const char *tmplate,
+                          kvs_table_t placeholders,
+                          cte_sink_f sink,
+                          void *context,
+                          size_t chunk_size,
+                          cte_status_t *status) {
+    
+    return cte_render_to_sink_escaped(tmplate, placeholders, sink, context,
+                                      chunk_size, CTE_ESCAPE_DEFAULT, status);
+} // end cte_render_to_sink
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_render_to_sink_escaped( tmplate, placeholders, sink, context,
+//                              chunk_size, escape, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in template string <tmplate>
+// and passes the result to sink <sink>  exactly like cte_render_to_sink(),
+// except that all output that originates from placeholder values is escaped
+// as described for function cte_string_from_template_escaped().  The function
+// fails for the same reasons as cte_render_to_sink()  and with status CTE_ST-
+// ATUS_INVALID_SYNTAX  if <escape> is not a valid escaping mode.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_render_to_sink_escaped(const char *tmplate,
+                                  kvs_table_t placeholders,
+                                  cte_sink_f sink,
+                                  void *context,
+                                  size_t chunk_size,
+                                  cte_escape_t escape,
+                                  cte_status_t *status) {
+    
+    cte_render_s render;
+    cte_values_s values;
+    cte_status_t r_status;
+    
+    // bail out if template string is NULL
+    if (tmplate == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return 0;
+    } // end if
+    
+    // bail out if placeholders is NULL
+    if (placeholders == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
+        return 0;
+    } // end if
+    
+    // bail out if sink is NULL
+    if (sink == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TARGET);
+        return 0;
+    } // end if
+    
+    // bail out if escaping mode is invalid
+    if (escape > CTE_ESCAPE_DEFAULT) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_SYNTAX);
+        return 0;
+    } // end if
+    
+    // zero chunk size means default
+    if (chunk_size == 0)
+        chunk_size = CTE_SINK_CHUNK_SIZE;
+    
+    _init_values(&values, NULL, placeholders, NULL, NULL);
+    
+    r_status = _begin_render_to_sink(&render, &values,
+                                     sink, context, chunk_size, tmplate);
+    
+    // bail out if allocation failed
+    if (r_status != CTE_STATUS_SUCCESS) {
+        ASSIGN_BY_REF(status, r_status);
+        return 0;
+    } // end if
+    
+    CTE_CAPTURE_BEGIN(&render, tmplate, strlen(tmplate));
+    
+    render.escape = escape;
+    
+    r_status = _expand_source(&render, tmplate, strlen(tmplate), 0, 0);
+    
+    return _finish_render_to_sink(&render, r_status, status);
+} // end cte_render_to_sink_escaped
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_compile_template( tmplate, status )
+// ---------------------------------------------------------------------------
+//
+// Compiles template string <tmplate>  into a new compiled template object and
+// returns it.  The function fails  if NULL is passed in for <tmplate>,  if the
+// template is longer than CTE_MAX_COMPILED_LENGTH  or if allocation fails.
+// The function returns NULL if it fails.
+//
+// A compiled template  holds  its own copy of the template string,  split into
+// literal and placeholder segments.  Comments have been removed and escape se-
+// quences resolved in its literal segments,  so that only placeholder values
+// need to be scanned when the compiled template is expanded.  The template is
+// recognised according to the grammar  and static semantics  described for
+// function cte_string_from_template().
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_template_t cte_compile_template(const char *tmplate,
+                                    cte_status_t *status) {
+    
+    return cte_compile_template_with_syntax(tmplate, NULL, status);
+} // end cte_compile_template
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_compile_template_with_syntax( tmplate, syntax, status )
+// ---------------------------------------------------------------------------
+//
+// Compiles template string <tmplate>  exactly like cte_compile_template(),
+// except that the template is recognised according to template syntax <syn-
+// tax>.  If NULL is passed in for <syntax>,  the built-in syntax is used.  The
+// compiled template holds its own copy of the syntax,  which is used for the
+// placeholder values  whenever the compiled template is expanded.  The func-
+// tion returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_template_t cte_compile_template_with_syntax(const char *tmplate,
+                                                cte_syntax_t syntax,
+                                                cte_status_t *status) {
+    
+    const cte_syntax_s *t_syntax;
+    cte_template_s *compiled;
+    cardinal segment_count, text_length, source_length;
+    cardinal line_end_count;
+    const char *line_end;
+    size_t length;
+    
+    // bail out if template string is NULL
+    if (tmplate == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return NULL;
+    } // end if
+    
+    length = strlen(tmplate);
+    
+    // bail out if template is too long for segment offsets
+    if (length > CTE_MAX_COMPILED_LENGTH) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return NULL;
+    } // end if
+    
+    if (syntax != NULL)
+        t_syntax = (const cte_syntax_s *) syntax;
+    else
+        t_syntax = &_cte_default_syntax;
+    
+    // determine required storage
+    source_length = (cardinal) length;
+    _compile(tmplate, source_length, t_syntax,
+             NULL, &segment_count, &text_length);
+    
+    // count line ends
+    line_end_count = 0;
+    line_end = memchr(tmplate, NEWLINE, source_length);
+    while (line_end != NULL) {
+        line_end_count++;
+        line_end = memchr(line_end + 1, NEWLINE,
+                          source_length - (line_end + 1 - tmplate));
+    } // end while
+    
+    // allocate template, segments, line ends, source and text in one block
+    compiled = ALLOCATE(sizeof(cte_template_s) +
+                        segment_count * sizeof(cte_segment_s) +
+                        line_end_count * sizeof(cardinal) +
+                        source_length + 1 + text_length);
+    
+    // bail out if allocation failed
+    if (compiled == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_ALLOCATION_FAILED);
+        return NULL;
+    } // end if
+    
+#ifdef CTE_WITH_HISTOGRAMS
+    compiled->histograms = cte_new_histogram_set(NULL);
+    
+    // bail out if allocation failed
+    if (compiled->histograms == NULL) {
+        DEALLOCATE(compiled);
+        ASSIGN_BY_REF(status, CTE_STATUS_ALLOCATION_FAILED);
+        return NULL;
+    } // end if
+#else
+    compiled->histograms = NULL;
+#endif
+    
+    compiled->identity = __sync_add_and_fetch(&_cte_template_identity, 1);
+    compiled->segment_count = segment_count;
+    compiled->segment = (cte_segment_s *) (compiled + 1);
+    compiled->line_end_count = line_end_count;
+    compiled->line_end = (cardinal *) (compiled->segment + segment_count);
+    compiled->source = (char *) (compiled->line_end + line_end_count);
+    compiled->source_length = source_length;
+    compiled->text = compiled->source + source_length + 1;
+    compiled->syntax = *t_syntax;
+    
+    memcpy(compiled->source, tmplate, source_length + 1);
+    
+    // build line end index
+    line_end_count = 0;
+    line_end = memchr(tmplate, NEWLINE, source_length);
+    while (line_end != NULL) {
+        compiled->line_end[line_end_count] = line_end - tmplate;
+        line_end_count++;
+        line_end = memchr(line_end + 1, NEWLINE,
+                          source_length - (line_end + 1 - tmplate));
+    } // end while
+    _compile(compiled->source, source_length, &compiled->syntax,
+             compiled, &segment_count, &text_length);
+    
+    ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
+    return (cte_template_t) compiled;
+} // end cte_compile_template_with_syntax
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_string_from_compiled( compiled, placeholders, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in compiled template <compi-
+// led>  and  returns a pointer to a new dynamically allocated string contain-
+// ing the resulting string.  The function fails  if NULL is passed in for
+// <compiled>  or <placeholders>  or if allocation fails  or the template nest-
+// ing limit is exceeded.  The function returns NULL if it fails.
+//
+// The result is the same as that of cte_string_from_template() for the tem-
+// plate string the compiled template was compiled from.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_compiled(cte_template_t compiled,
+                               kvs_table_t placeholders,
+                               cte_status_t *status) {
+    
+    return cte_string_from_compiled_escaped(compiled, placeholders,
+                                            CTE_ESCAPE_DEFAULT, status);
+} // end cte_string_from_compiled
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_string_from_compiled_escaped( compiled, placeholders, escape, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in compiled template <compi-
+// led>  exactly like cte_string_from_compiled(),  except that all output that
+// originates from placeholder values  is escaped  as described for function
+// cte_string_from_template_escaped().  If CTE_ESCAPE_DEFAULT is passed in for
+// <escape>,  the mode of the template's syntax is used.  The function fails
+// for the same reasons as cte_string_from_compiled()  and with status CTE_ST-
+// ATUS_INVALID_SYNTAX  if <escape> is not a valid escaping mode.  It returns
+// NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_compiled_escaped(cte_template_t compiled,
+                                       kvs_table_t placeholders,
+                                       cte_escape_t escape,
+                                       cte_status_t *status) {
+    
+    cte_render_s render;
+    cte_values_s values;
+    cte_status_t r_status;
+    
+    // bail out if compiled template is NULL
+    if (compiled == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return NULL;
+    } // end if
+    
+    // bail out if placeholders is NULL
+    if (placeholders == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
+        return NULL;
+    } // end if
+    
+    // bail out if escaping mode is invalid
+    if (escape > CTE_ESCAPE_DEFAULT) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_SYNTAX);
+        return NULL;
+    } // end if
+    
+    _init_values(&values, NULL, placeholders, NULL, NULL);
+    
+    r_status = _begin_render(&render, &values,
+                             ((cte_template_s *) compiled)->source);
+    
+    // bail out if allocation failed
+    if (r_status != CTE_STATUS_SUCCESS) {
+        ASSIGN_BY_REF(status, r_status);
+        return NULL;
+    } // end if
+    
+    CTE_CAPTURE_BEGIN(&render, ((cte_template_s *) compiled)->source,
+                      ((cte_template_s *) compiled)->source_length);
+    
+    render.escape = escape;
+    
+    r_status = _expand_compiled(&render, (cte_template_s *) compiled);
+    
+    return _finish_render(&render, r_status, status);
+} // end cte_string_from_compiled_escaped
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_string_from_compiled_table( compiled, table, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in compiled template <compi-
+// led>  and  returns a pointer to a new dynamically allocated string contain-
+// ing the resulting string.  Placeholder values are looked up in placeholder
+// table <table>.  The function fails  if NULL is passed in for <compiled>  or
+// <table>  or if allocation fails  or the template nesting limit is exceeded.
+// The function returns NULL if it fails.
+//
+// The result is the same as that of cte_string_from_table() for the template
+// string the compiled template was compiled from.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_compiled_table(cte_template_t compiled,
+                                     cte_table_t table,
+                                     cte_status_t *status) {
+    
+    return cte_string_from_compiled_table_escaped(compiled, table,
+                                                  CTE_ESCAPE_DEFAULT, status);
+} // end cte_string_from_compiled_table
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_string_from_compiled_table_escaped( compiled, table, escape, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in compiled template <compi-
+// led>  exactly like cte_string_from_compiled_table(),  except that all out-
+// put that originates from placeholder values is escaped as described for
+// function cte_string_from_compiled_escaped().  Values stored in <table> with
+// a mode of their own are escaped in their own mode instead.  The function
+// fails for the same reasons as cte_string_from_compiled_table()  and with
+// status CTE_STATUS_INVALID_SYNTAX  if <escape> is not a valid escaping mode.
+// It returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_compiled_table_escaped(cte_template_t compiled,
+                                             cte_table_t table,
+                                             cte_escape_t escape,
+                                             cte_status_t *status) {
+    
+    cte_render_s render;
+    cte_values_s values;
+    cte_status_t r_status;
+    
+    // bail out if compiled template is NULL
+    if (compiled == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return NULL;
+    } // end if
+    
+    // bail out if table is NULL
+    if (table == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
+        return NULL;
+    } // end if
+    
+    // bail out if escaping mode is invalid
+    if (escape > CTE_ESCAPE_DEFAULT) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_SYNTAX);
+        return NULL;
+    } // end if
+    
+    _init_values(&values, table, NULL, NULL, NULL);
+    
+    r_status = _begin_render(&render, &values,
+                             ((cte_template_s *) compiled)->source);
+    
+    // bail out if allocation failed
+    if (r_status != CTE_STATUS_SUCCESS) {
+        ASSIGN_BY_REF(status, r_status);
+        return NULL;
+    } // end if
+    
+    CTE_CAPTURE_BEGIN(&render, ((cte_template_s *) compiled)->source,
+                      ((cte_template_s *) compiled)->source_length);
+    
+    render.escape = escape;
+    
+    r_status = _expand_compiled(&render, (cte_template_s *) compiled);
+    
+    return _finish_render(&render, r_status, status);
+} // end cte_string_from_compiled_table_escaped
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_string_from_compiled_with_budget( compiled, placeholders, budget, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in compiled template <compi-
+// led> exactly like cte_string_from_compiled(),  except that the render is
+// aborted as soon as it exceeds a limit of budget <budget>  as described for
+// cte_string_from_template_with_budget().  If NULL is passed in for <budget>,
+// the render is unlimited.  The function fails for the same reasons  as cte_
+// string_from_template_with_budget().  It returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_compiled_with_budget(cte_template_t compiled,
+                                           kvs_table_t placeholders,
+                                           const cte_budget_t *budget,
+                                           cte_status_t *status) {
+    
+    #define this_template ((cte_template_s *) compiled)
+    
+    cte_render_s render;
+    cte_values_s values;
+    cte_status_t r_status;
+    
+    // bail out if compiled template is NULL
+    if (compiled == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return NULL;
+    } // end if
+    
+    // bail out if placeholders is NULL
+    if (placeholders == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
+        return NULL;
+    } // end if
+    
+    _init_values(&values, NULL, placeholders, NULL, NULL);
+    
+    r_status = _begin_render(&render, &values, this_template->source);
+    
+    // bail out if allocation failed
+    if (r_status != CTE_STATUS_SUCCESS) {
+        ASSIGN_BY_REF(status, r_status);
+        return NULL;
+    } // end if
+    
+    CTE_CAPTURE_BEGIN(&render, this_template->source,
+                      this_template->source_length);
+    
+    _begin_budget(&render, budget);
+    
+    r_status = _expand_compiled(&render, this_template);
+    r_status = _settle_budget(&render, this_template->source,
+                              this_template->source_length, r_status);
+    
+    return _finish_render(&render, r_status, status);
+    
+    #undef this_template
+} // end cte_string_from_compiled_with_budget
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_string_from_compiled_parallel( compiled, placeholders,
+//                                                threads, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in compiled template <compi-
+// led>  using up to <threads> threads  and  returns a pointer to a new dyna-
+// mically allocated string  containing the resulting string.  If zero is
+// passed in for <threads>,  one thread per online processor is used.  The re-
+// sult is the same as that of cte_string_from_compiled().  The function fails
+// if NULL is passed in for <compiled>  or <placeholders>  or  if allocation
+// fails  or the template nesting limit is exceeded.  The function returns
+// NULL if it fails.
+//
+// The expansion is performed in two passes.  The first pass determines the
+// expanded size of each top level segment,  from which the offset of each
+// segment in the result is obtained by a prefix sum.  The result is then al-
+// located once and the second pass expands  contiguous runs of segments of
+// about equal expanded size into their disjoint regions of the result,  each
+// run on a thread of its own.  Both passes are run in parallel.  If the tem-
+// plate contains an undefined placeholder,  the remainder of the template
+// from there on is expanded by a single thread.
+//
+// Placeholder table <placeholders> is read concurrently by multiple threads
+// and must not be modified during the render.  Notifications are only passed
+// to the handlers by the second pass,  each event is reported once as by cte_
+// string_from_compiled().  Events within the runs of the second pass are re-
+// ported by the threads expanding them,  notification and diagnostic handlers
+// must therefore be thread-safe  and the order of events from different runs
+// is unspecified.  If the library is built with CTE_NO_THREADS defined,  all
+// work is performed on the calling thread.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_compiled_parallel(cte_template_t compiled,
+                                        kvs_table_t placeholders,
+                                        cardinal threads,
+                                        cte_status_t *status) {
+    
+    #define this_template ((cte_template_s *)compiled)
+    cte_work_unit_s unit[CTE_PARALLEL_MAX_THREADS];
+    cte_render_s render;
+    cte_values_s values;
+    cte_status_t r_status;
+    cte_capture_record_t capture;
+    cardinal index, count, first, stop, per_unit;
+    size_t total, offset, share, *size;
+    char *result;
+#ifdef CTE_WITH_HISTOGRAMS
+    uint64_t started = cte_clock();
+#endif
+    
+    // bail out if compiled template is NULL
+    if (compiled == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return NULL;
+    } // end if
+    
+    // bail out if placeholders is NULL
+    if (placeholders == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
+        return NULL;
+    } // end if
+    
+    capture = cte_capture_begin();
+    
+    // zero threads means one per online processor
+    if (threads == 0) {
+#ifndef CTE_NO_THREADS
+        threads = (cardinal) MAX(sysconf(_SC_NPROCESSORS_ONLN), 1);
+#else
+        threads = 1;
+#endif
+    } // end if
+    
+    threads = MIN(threads, CTE_PARALLEL_MAX_THREADS);
+    threads = MIN(threads, MAX(this_template->segment_count, 1));
+    
+    _init_values(&values, NULL, placeholders, NULL, NULL);
+    
+    size = ALLOCATE((this_template->segment_count + 1) * sizeof(size_t));
+    
+    // bail out if allocation failed
+    if (size == NULL) {
+        cte_capture_discard(capture);
+        ASSIGN_BY_REF(status, CTE_STATUS_ALLOCATION_FAILED);
+        return NULL;
+    } // end if
+    
+    // sizing pass, split segments into runs of equal count
+    per_unit = (this_template->segment_count + threads - 1) / threads;
+    first = 0;
+    
+    for (count = 0; count < threads; count++) {
+        unit[count].compiled = this_template;
+        unit[count].values = &values;
+        unit[count].first = first;
+        unit[count].end = MIN(first + per_unit, this_template->segment_count);
+        unit[count].size = size;
+        first = unit[count].end;
+    } // end for
+    
+    _run_work_units(unit, threads, _size_segments);
+    
+    // find first failure or undefined placeholder
+    stop = this_template->segment_count;
+    r_status = CTE_STATUS_SUCCESS;
+    
+    for (index = 0; index < threads; index++) {
+        if (unit[index].r_status != CTE_STATUS_SUCCESS) {
+            r_status = unit[index].r_status;
+            break;
+        } // end if
+        
+        if (unit[index].stop < unit[index].end) {
+            stop = unit[index].stop;
+            break;
+        } // end if
+    } // end for
+    
+    // bail out if sizing failed
+    if (r_status != CTE_STATUS_SUCCESS) {
+        DEALLOCATE(size);
+        _report_sizing(&values, this_template->source, this_template);
+        cte_capture_discard(capture);
+        ASSIGN_BY_REF(status, r_status);
+        return NULL;
+    } // end if
+    
+    // size remainder after undefined placeholder
+    size[stop] = 0;
+    
+    if (stop < this_template->segment_count) {
+        _begin_render_into(&render, &values, NULL, 0);
+        render.sizing = true;
+        r_status = _expand_remainder(&render, this_template, stop);
+        size[stop] = render.t_index;
+        cte_dispose_stack(render.stack);
+        
+        // bail out if sizing failed
+        if (r_status != CTE_STATUS_SUCCESS) {
+            DEALLOCATE(size);
+            _report_sizing(&values, this_template->source, this_template);
+            cte_capture_discard(capture);
+            ASSIGN_BY_REF(status, r_status);
+            return NULL;
+        } // end if
+    } // end if
+    
+    // prefix sum
+    total = 0;
+    
+    for (index = 0; index <= stop; index++)
+        total = total + size[index];
+    
+    result = ALLOCATE_AT(CTE_ALLOC_SITE_TARGET, total + 1);
+    
+    // bail out if allocation failed
+    if (result == NULL) {
+        CTE_NOTIFY(CTE_NOTIFICATION_TARGET_ALLOCATION_FAILED,
+                   this_template->source, 0);
+        DEALLOCATE(size);
+        cte_capture_discard(capture);
+        ASSIGN_BY_REF(status, CTE_STATUS_ALLOCATION_FAILED);
+        return NULL;
+    } // end if
+    
+    // fill pass, split segments into runs of about equal expanded size
+    if (total < CTE_PARALLEL_MIN_SIZE)
+        threads = 1;
+    
+    share = total / threads + 1;
+    offset = 0;
+    first = 0;
+    count = 0;
+    
+    while ((first < stop) && (count < threads)) {
+        unit[count].first = first;
+        unit[count].target = result + offset;
+        unit[count].t_size = 0;
+        
+        // take segments until share is reached, last unit takes the rest
+        while ((first < stop) &&
+               ((unit[count].t_size < share) || (count + 1 == threads))) {
+            unit[count].t_size = unit[count].t_size + size[first];
+            first++;
+        } // end while
+        
+        unit[count].end = first;
+        offset = offset + unit[count].t_size;
+        count++;
+    } // end while
+    
+    if (count > 0)
+        _run_work_units(unit, count, _fill_segments);
+    
+    // expand remainder after undefined placeholder
+    if (stop < this_template->segment_count) {
+        _begin_render_into(&render, &values, result + offset, size[stop] + 1);
+        r_status = _expand_remainder(&render, this_template, stop);
+        cte_dispose_stack(render.stack);
+    } // end if
+    
+    for (index = 0; index < count; index++) {
+        if (unit[index].r_status != CTE_STATUS_SUCCESS)
+            r_status = unit[index].r_status;
+    } // end for
+    
+    DEALLOCATE(size);
+    
+    // bail out if expansion failed
+    if (r_status != CTE_STATUS_SUCCESS) {
+        DEALLOCATE_AT(CTE_ALLOC_SITE_TARGET, result, total + 1);
+        cte_capture_discard(capture);
+        ASSIGN_BY_REF(status, r_status);
+        return NULL;
+    } // end if
+    
+    result[total] = CSTRING_TERMINATOR;
+    RELEASE_AT(CTE_ALLOC_SITE_TARGET, total + 1);
+    
+    CTE_NOTIFY(CTE_NOTIFICATION_TARGET_SIZE_INFO, result, total + 1);
+    
+#ifdef CTE_WITH_HISTOGRAMS
+    cte_histogram_record(this_template->histograms,
+                         cte_clock() - started, total);
+#endif
+    
+    _capture_parallel(capture, this_template, placeholders, result, total);
+    
+    CTE_METRIC_ADD(CTE_METRIC_RENDERS, 1);
+    CTE_METRIC_ADD(CTE_METRIC_BYTES_OUT, total);
+    
+    ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
+    return result;
+    
+    #undef this_template
+} // end cte_string_from_compiled_parallel
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_string_and_digest_from_compiled( compiled, placeholders,
+//                                                  kinds, digest, status )
+// ---------------------------------------------------------------------------
+//
+// Expands compiled template <compiled> exactly like cte_string_from_compiled()
+// and returns the result,  additionally computing the digests requested in bit
+// set <kinds>  of the result  and passing them back in <digest>.  The digests
+// are computed incrementally as the result is produced,  without a further
+// pass over the result.  The terminator is not included in the digests.  The
+// function fails for the same reasons as cte_string_from_compiled() and if
+// NULL is passed in for <digest>.  The function returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_and_digest_from_compiled(cte_template_t compiled,
+                                          kvs_table_t placeholders,
+                                          cardinal kinds,
+                                          cte_digest_t *digest,
+                                          cte_status_t *status) {
+    
+    cte_render_s render;
+    cte_values_s values;
+    cte_digest_state_t state;
+    cte_status_t r_status;
+    
+    // bail out if compiled template is NULL
+    if (compiled == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return NULL;
+    } // end if
+    
+    // bail out if placeholders or digest is NULL
+    if ((placeholders == NULL) || (digest == NULL)) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
+        return NULL;
+    } // end if
+    
+    _init_values(&values, NULL, placeholders, NULL, NULL);
+    
+    r_status = _begin_render(&render, &values,
+                             ((cte_template_s *) compiled)->source);
+    
+    // bail out if allocation failed
+    if (r_status != CTE_STATUS_SUCCESS) {
+        ASSIGN_BY_REF(status, r_status);
+        return NULL;
+    } // end if
+    
+    CTE_CAPTURE_BEGIN(&render, ((cte_template_s *) compiled)->source,
+                      ((cte_template_s *) compiled)->source_length);
+    
+    cte_digest_init(&state, kinds);
+    render.digest = &state;
+    
+    r_status = _expand_compiled(&render, (cte_template_s *) compiled);
+    
+    cte_digest_final(&state, digest);
+    
+    return _finish_render(&render, r_status, status);
+} // end cte_string_and_digest_from_compiled
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_render_compiled_to_sink( compiled, placeholders, sink,
+//                                         context, chunk_size, status )
+// ---------------------------------------------------------------------------
+//
+// Expands compiled template <compiled>  and passes the result to sink <sink>
+// exactly like cte_render_to_sink() does for template strings.  Returns the
+// number of bytes passed to the sink.  The result is the same as that of
+// cte_string_from_compiled().
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_render_compiled_to_sink(cte_template_t compiled,
+                                   kvs_table_t placeholders,
+                                   cte_sink_f sink,
+                                   void *context,
+                                   size_t chunk_size,
+                                   cte_status_t *status) {
+    
+    cte_render_s render;
+    cte_values_s values;
+    cte_status_t r_status;
+    
+    // bail out if compiled template is NULL
+    if (compiled == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return 0;
+    } // end if
+    
+    // bail out if placeholders is NULL
+    if (placeholders == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
+        return 0;
+    } // end if
+    
+    // bail out if sink is NULL
+    if (sink == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TARGET);
+        return 0;
+    } // end if
+    
+    // zero chunk size means default
+    if (chunk_size == 0)
+        chunk_size = CTE_SINK_CHUNK_SIZE;
+    
+    _init_values(&values, NULL, placeholders, NULL, NULL);
+    
+    r_status = _begin_render_to_sink(&render, &values, sink, context,
+                   chunk_size, ((cte_template_s *) compiled)->source);
+    
+    // bail out if allocation failed
+    if (r_status != CTE_STATUS_SUCCESS) {
+        ASSIGN_BY_REF(status, r_status);
+        return 0;
+    } // end if
+    
+    CTE_CAPTURE_BEGIN(&render, ((cte_template_s *) compiled)->source,
+                      ((cte_template_s *) compiled)->source_length);
+    
+    r_status = _expand_compiled(&render, (cte_template_s *) compiled);
+    
+    return _finish_render_to_sink(&render, r_status, status);
+} // end cte_render_compiled_to_sink
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_render_to_file( fd, tmplate, placeholders, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in template string <tmplate>
+// and writes the result to the file open for writing  with file descriptor
+// <fd>,  starting at its current file offset,  which is advanced past the
+// output as if it had been written with write().  Returns the number of bytes
+// written.  Placeholder values are looked up in <placeholders>  as described
+// for function cte_string_from_template().
+//
+// If <fd> refers to a regular file,  the exact size of the output is deter-
+// mined first,  by an expansion that writes nothing.  The file is then ex-
+// tended with posix_fallocate(),  or with ftruncate() where the file system
+// does not support it,  and mapped into memory,  and the template is expanded
+// directly into the mapping.  No copy of the output is held in memory.
+//
+// Output to other kinds of files,  output smaller than CTE_FILE_MAP_MIN_SIZE
+// and output to files that cannot be mapped  is written in chunks of CTE_SINK_
+// CHUNK_SIZE bytes instead.  The same applies  if the library was built with
+// CTE_NO_MMAP defined.
+//
+// The function fails if NULL is passed in for <tmplate> or <placeholders>  or
+// if <fd> is negative,  if allocation fails,  if the template nesting limit is
+// exceeded or if the file could not be written,  in which case errno des-
+// cribes the cause.  If the function fails after extending a mapped file,  the
+// file is truncated to its original size.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_render_to_file(int fd,
+                          const char *tmplate,
+                          kvs_table_t placeholders,
+                          cte_status_t *status) {
+    
+    cte_values_s values;
+    
+    // bail out if template string is NULL
+    if (tmplate == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return 0;
+    } // end if
+    
+    // bail out if placeholders is NULL
+    if (placeholders == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
+        return 0;
+    } // end if
+    
+    // bail out if file descriptor is invalid
+    if (fd < 0) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TARGET);
+        return 0;
+    } // end if
+    
+    _init_values(&values, NULL, placeholders, NULL, NULL);
+    
+    return _render_to_file(fd, &values, tmplate, NULL, status);
+} // end cte_render_to_file
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_render_compiled_to_file( fd, compiled, placeholders, status )
+// ---------------------------------------------------------------------------
+//
+// Expands compiled template <compiled> like cte_string_from_compiled() and
+// writes the result to the file open for writing  with file descriptor <fd>
+// exactly as cte_render_to_file() does.  Returns the number of bytes written.
+// The function fails for the same reasons as cte_render_to_file().
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_render_compiled_to_file(int fd,
+                                   cte_template_t compiled,
+                                   kvs_table_t placeholders,
+                                   cte_status_t *status) {
+    
+    cte_values_s values;
+    
+    // bail out if compiled template is NULL
+    if (compiled == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return 0;
+    } // end if
+    
+    // bail out if placeholders is NULL
+    if (placeholders == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
+        return 0;
+    } // end if
+    
+    // bail out if file descriptor is invalid
+    if (fd < 0) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TARGET);
+        return 0;
+    } // end if
+    
+    _init_values(&values, NULL, placeholders, NULL, NULL);
+    
+    return _render_to_file(fd, &values,
+               ((cte_template_s *) compiled)->source,
+               (cte_template_s *) compiled, status);
+} // end cte_render_compiled_to_file
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_new_render_state( tmplate, placeholders, status )
+// ---------------------------------------------------------------------------
+//
+// Creates and returns a new resumable render state  for the expansion of tem-
+// plate string <tmplate>  with placeholder values looked up in <placeholders>
+// as described for function cte_string_from_template().  Nothing is expanded
+// until cte_render_step() is called.  The template and the placeholder values
+// are not copied,  they must remain valid and unmodified  until the state has
+// been disposed of,  except that pending values may be completed between two
+// steps.  The function fails if NULL is passed in for <tmplate> or
+// <placeholders> or if allocation fails.  It returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_render_state_t cte_new_render_state(const char *tmplate,
+                                       kvs_table_t placeholders,
+                                      cte_status_t *status) {
+    
+    cte_render_state_s *state;
+    
+    // bail out if template string is NULL
+    if (tmplate == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return NULL;
+    } // end if
+    
+    // bail out if placeholders is NULL
+    if (placeholders == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
+        return NULL;
+    } // end if
+    
+    state = _new_render_state(tmplate, strlen(tmplate),
+                              &_cte_default_syntax, status);
+    
+    if (state != NULL)
+        _init_values(&state->values, NULL, placeholders, NULL, NULL);
+    
+    return (cte_render_state_t) state;
+} // end cte_new_render_state
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_new_render_state_with_table( tmplate, table, status )
+// ---------------------------------------------------------------------------
+//
+// Creates and returns a new resumable render state  exactly like cte_new_ren-
+// der_state(),  except that placeholder values are looked up in placeholder
+// table <table>  as described for function cte_string_from_table().  The
+// function fails if NULL is passed in for <tmplate> or <table>  or if alloca-
+// tion fails.  It returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_render_state_t cte_new_render_state_with_table(const char *tmplate,
+                                                 cte_table_t table,
+                                                cte_status_t *status) {
+    
+    cte_render_state_s *state;
+    
+    // bail out if template string is NULL
+    if (tmplate == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return NULL;
+    } // end if
+    
+    // bail out if table is NULL
+    if (table == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
+        return NULL;
+    } // end if
+    
+    state = _new_render_state(tmplate, strlen(tmplate),
+                              &_cte_default_syntax, status);
+    
+    if (state != NULL)
+        _init_values(&state->values, table, NULL, NULL, NULL);
+    
+    return (cte_render_state_t) state;
+} // end cte_new_render_state_with_table
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_new_render_state_with_resolver( tmplate, resolver, context, status )
+// ---------------------------------------------------------------------------
+//
+// Creates and returns a new resumable render state  exactly like cte_new_ren-
+// der_state(),  except that placeholder values are obtained from resolver
+// function <resolver> with context <context>  as described for function
+// cte_string_from_resolver().  Resolved values are cached for the lifetime of
+// the state.  The function fails if NULL is passed in for <tmplate> or <re-
+// solver> or if allocation fails.  It returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_render_state_t cte_new_render_state_with_resolver(const char *tmplate,
+                                                 cte_resolver_f resolver,
+                                                           void *context,
+                                                   cte_status_t *status) {
+    
+    cte_render_state_s *state;
+    
+    // bail out if template string is NULL
+    if (tmplate == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return NULL;
+    } // end if
+    
+    // bail out if resolver is NULL
+    if (resolver == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
+        return NULL;
+    } // end if
+    
+    state = _new_render_state(tmplate, strlen(tmplate),
+                              &_cte_default_syntax, status);
+    
+    if (state != NULL)
+        _init_values(&state->values, NULL, NULL, resolver, context);
+    
+    return (cte_render_state_t) state;
+} // end cte_new_render_state_with_resolver
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_new_compiled_render_state( compiled, table, status )
+// ---------------------------------------------------------------------------
+//
+// Creates and returns a new resumable render state  for the expansion of com-
+// piled template <compiled>  with placeholder values looked up in placeholder
+// table <table>.  The template is expanded from its source according to its
+// syntax,  the result is the same as that of cte_string_from_compiled_table().
+// The compiled template must not be disposed of before the state.  The func-
+// tion fails if NULL is passed in for <compiled> or <table>  or if allocation
+// fails.  It returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_render_state_t cte_new_compiled_render_state(cte_template_t compiled,
+                                                    cte_table_t table,
+                                                   cte_status_t *status) {
+    
+    #define this_template ((cte_template_s *) compiled)
+    
+    cte_render_state_s *state;
+    
+    // bail out if compiled template is NULL
+    if (compiled == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return NULL;
+    } // end if
+    
+    // bail out if table is NULL
+    if (table == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
+        return NULL;
+    } // end if
+    
+    state = _new_render_state(this_template->source,
+                              this_template->source_length,
+                              &this_template->syntax, status);
+    
+    if (state != NULL)
+        _init_values(&state->values, table, NULL, NULL, NULL);
+    
+    return (cte_render_state_t) state;
+    
+    #undef this_template
+} // end cte_new_compiled_render_state
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_render_step( state, buffer, capacity, status )
+// ---------------------------------------------------------------------------
+//
+// Continues the expansion of render state <state>,  writing up to <capacity>
+// bytes of output into caller owned buffer <buffer>,  and returns the number
+// of bytes written.  No terminator is written.  The expansion stops when the
+// buffer is full  and resumes exactly where it stopped  on the next call,  the
+// source strings,  indices and template nesting stack are kept in the state.
+// Output that did not fit is held back  by reference to the source  and is
+// written first on the next call,  memory use does not grow with the output.
+// When the expansion is complete,  cte_render_state_done() returns true and
+// further calls return zero.
+//
+// If the value of a placeholder is pending,  the step writes all output that
+// precedes the placeholder and stops there,  cte_render_state_pending() then
+// returns its identifier.  The next call looks up the placeholder again and
+// continues if its value has been completed in the meantime,  otherwise it
+// returns zero and stops at the same placeholder.  Values that complete in
+// any order may thus be written as soon as all preceding output is written.
+//
+// The function fails  if NULL is passed in for <state>,  if NULL is passed in
+// for <buffer> with a non-zero <capacity>,  or if allocation fails or the
+// template nesting limit is exceeded during expansion.  A state that failed
+// remains failed,  further calls return zero and pass back the same status.
+// Output written before the failure is not retracted.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_render_step(cte_render_state_t state,
+                                     char *buffer,
+                                   size_t capacity,
+                             cte_status_t *status) {
+    
+    #define this_state ((cte_render_state_s *) state)
+    
+    cte_render_s *render;
+    cte_step_s *step;
+    const char *pending;
+    size_t length;
+    cte_status_t r_status;
+    
+    // bail out if state is NULL
+    if (state == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_STATE);
+        return 0;
+    } // end if
+    
+    // bail out if buffer is NULL but capacity is not zero
+    if ((buffer == NULL) && (capacity > 0)) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TARGET);
+        return 0;
+    } // end if
+    
+    // bail out if expansion failed during an earlier step
+    if (this_state->r_status != CTE_STATUS_SUCCESS) {
+        ASSIGN_BY_REF(status, this_state->r_status);
+        return 0;
+    } // end if
+    
+    render = &this_state->render;
+    step = &this_state->step;
+    
+    render->target = buffer;
+    render->t_index = 0;
+    render->t_size = capacity;
+    render->suspended = false;
+    step->hole = NULL;
+    
+    // write rest of escape sequence held back
+    if (step->stash_index < step->stash_length) {
+        length = MIN(step->stash_length - step->stash_index, render->t_size);
+        
+        if (length > 0)
+            memcpy(render->target, &step->stash[step->stash_index], length);
+        
+        step->stash_index = step->stash_index + (cardinal) length;
+        render->t_index = length;
+    
+        if (step->stash_index < step->stash_length)
+            render->suspended = true;
+    } // end if
+    
+    // write output held back,  escaping it as it would have been
+    if ((NOT(render->suspended)) && (step->pending != NULL)) {
+        pending = step->pending;
+        length = step->p_length;
+        step->pending = NULL;
+    
+        if (step->p_escape == CTE_ESCAPE_NONE)
+            _append_to_step(render, pending, length);
+        else
+            _append_escaped(render, step->p_escape, pending, length);
+    } // end if
+    
+    // continue expansion unless buffer is full or expansion is complete
+    if ((NOT(render->suspended)) && (NOT(this_state->done))) {
+        r_status = _expand_source(render,
+                       this_state->source, this_state->s_length, 0, 0);
+    
+        if (r_status == CTE_STATUS_SUSPENDED) {
+            step->resuming = true;
+        }
+        else if (r_status == CTE_STATUS_SUCCESS) {
+            this_state->done = true;
+            CTE_METER(render, CTE_METRIC_RENDERS, 1);
+        }
+        else /* expansion failed */ {
+            this_state->r_status = r_status;
+            CTE_METER(render, CTE_METRIC_BYTES_OUT, render->t_index);
+            ASSIGN_BY_REF(status, r_status);
+            return render->t_index;
+        } // end if
+    } // end if
+    
+    CTE_METER(render, CTE_METRIC_BYTES_OUT, render->t_index);
+    
+    ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
+    return render->t_index;
+    
+    #undef this_state
+} // end cte_render_step
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_render_state_pending( state, length )
+// ---------------------------------------------------------------------------
+//
+// Returns the identifier of the placeholder  at which the last step of render
+// state <state> stopped because its value is pending,  and passes back its
+// length in <length>  unless NULL was passed in for <length>.  The identifier
+// is not terminated.  Returns NULL if the last step did not stop at a pending
+// value or if NULL is passed in for <state>.
+
+const char *cte_render_state_pending(cte_render_state_t state,
+                                     cardinal *length) {
+    
+    #define this_state ((cte_render_state_s *) state)
+    
+    if ((state == NULL) || (this_state->step.hole == NULL))
+        return NULL;
+    
+    ASSIGN_BY_REF(length, this_state->step.h_length);
+    return this_state->step.hole;
+    
+    #undef this_state
+} // end cte_render_state_pending
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_render_state_done( state )
+// ---------------------------------------------------------------------------
+//
+// Returns true if the expansion of render state <state> is complete  and all
+// of its output has been returned by cte_render_step(),  returns false other-
+// wise or if NULL is passed in for <state>.
+
+bool cte_render_state_done(cte_render_state_t state) {
+    
+    #define this_state ((cte_render_state_s *) state)
+    
+    if (state == NULL)
+        return false;
+    
+    return ((this_state->done) &&
+            (this_state->step.pending == NULL) &&
+            (this_state->step.stash_index >= this_state->step.stash_length));
+    
+    #undef this_state
+} // end cte_render_state_done
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_dispose_render_state( state )
+// ---------------------------------------------------------------------------
+//
+// Disposes of render state <state>,  whether or not its expansion is complete.
+// Returns NULL.
+
+cte_render_state_t cte_dispose_render_state(cte_render_state_t state) {
+    
+    #define this_state ((cte_render_state_s *) state)
+    
+    if (state == NULL)
+        return NULL;
+    
+    cte_dispose_stack(this_state->render.stack);
+    
+    // dispose of resolver cache
+    if (this_state->values.cache.entry != NULL)
+        DEALLOCATE(this_state->values.cache.entry);
+    
+    DEALLOCATE(state);
+    
+    return NULL;
+    
+    #undef this_state
+} // end cte_dispose_render_state
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_new_chunked_render( placeholders, sink, context, status )
+// ---------------------------------------------------------------------------
+//
+// Creates and returns a new chunked render  for the expansion of a template
+// that is passed in  by any number of calls to cte_chunked_render_feed(),  in
+// chunks of arbitrary size.  Placeholder values are looked up in <placehol-
+// ders>  as described for function cte_string_from_template().  The output is
+// passed to sink <sink>,  together with <context>,  as it is produced.  The
+// function fails if NULL is passed in for <placeholders> or <sink>  or if al-
+// location fails.  It returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_chunked_render_t cte_new_chunked_render(kvs_table_t placeholders,
+                                             cte_sink_f sink,
+                                                   void *context,
+                                           cte_status_t *status) {
+
+    // bail out if placeholders is NULL
+    if (placeholders == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
+        return NULL;
+    } // end if
+
+    // bail out if sink is NULL
+    if (sink == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TARGET);
+        return NULL;
+    } // end if
+
+    return (cte_chunked_render_t)
+        _new_chunked_render(NULL, placeholders, sink, context, status);
+} // end cte_new_chunked_render
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_new_chunked_render_with_table( table, sink, context, status )
+// ---------------------------------------------------------------------------
+//
+// Creates and returns a new chunked render  exactly like cte_new_chunked_ren-
+// der(),  except that placeholder values are looked up in placeholder table
+// <table>  as described for function cte_string_from_table().  The function
+// fails if NULL is passed in for <table> or <sink> or if allocation fails.  It
+// returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_chunked_render_t cte_new_chunked_render_with_table(cte_table_t table,
+                                                        cte_sink_f sink,
+                                                              void *context,
+                                                      cte_status_t *status) {
+
+    // bail out if table is NULL
+    if (table == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
+        return NULL;
+    } // end if
+
+    // bail out if sink is NULL
+    if (sink == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TARGET);
+        return NULL;
+    } // end if
+
+    return (cte_chunked_render_t)
+        _new_chunked_render(table, NULL, sink, context, status);
+} // end cte_new_chunked_render_with_table
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_chunked_render_feed( render, chunk, length, status )
+// ---------------------------------------------------------------------------
+//
+// Passes the next <length> bytes of the template  to chunked render <render>,
+// which expands  as much of the template  as can be expanded  without further
+// input  and passes the output to its sink before returning.  Delimiters,
+// escapes and comment line prefixes  may be split across chunks,  the chunk
+// need not be terminated  and need not remain valid after the call.  Fewer
+// than CTE_MAX_PLACEHOLDER_LENGTH + 6 bytes are carried over to the next
+// chunk,  except that a section with rows is carried over  until its section
+// end has arrived.  Memory use is thus bounded by the chunk size  plus the
+// carried bytes.  Positions reported to notification handlers are relative to
+// the carried bytes followed by the chunk.
+//
+// The function fails if NULL is passed in for <render>,  if NULL is passed in
+// for <chunk> with a non-zero <length>,  if the render has been finished,  or
+// if allocation fails,  the template nesting limit is exceeded or the sink
+// returns false.  A render that failed remains failed,  further calls pass
+// back the same status.  Output passed to the sink is not retracted.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_chunked_render_feed(cte_chunked_render_t render,
+                                       const char *chunk,
+                                           size_t length,
+                                     cte_status_t *status) {
+
+    #define this_render ((cte_chunked_render_s *) render)
+
+    char *buffer;
+    size_t index, stop, size;
+    cte_status_t r_status;
+
+    // bail out if render is NULL or has been finished
+    if ((render == NULL) || (this_render->finished)) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_STATE);
+        return;
+    } // end if
+
+    // bail out if chunk is NULL but length is not zero
+    if ((chunk == NULL) && (length > 0)) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return;
+    } // end if
+
+    // bail out if expansion failed during an earlier feed
+    if (this_render->r_status != CTE_STATUS_SUCCESS) {
+        ASSIGN_BY_REF(status, this_render->r_status);
+        return;
+    } // end if
+
+    // skip rest of comment line continued from previous chunk
+    if (this_render->chunk.skipping) {
+        index = 0;
+        while ((index < length) && (chunk[index] != NEWLINE))
+            index++;
+
+        // keep last character skipped for start of line detection
+        if (index > 0)
+            this_render->buffer[0] = chunk[index - 1];
+
+        // bail out if comment line continues into next chunk
+        if (index == length) {
+            ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
+            return;
+        } // end if
+
+        this_render->chunk.skipping = false;
+        chunk = chunk + index;
+        length = length - index;
+    } // end if
+
+    // enlarge buffer to hold carried bytes and chunk
+    size = this_render->b_length + length;
+    if (size > this_render->b_size) {
+        buffer = REALLOCATE(this_render->buffer, size);
+
+        // bail out if enlargement failed
+        if (buffer == NULL) {
+            CTE_NOTIFY(CTE_NOTIFICATION_TARGET_ENLARGEMENT_FAILED,
+                       this_render->buffer, this_render->b_length);
+            this_render->r_status = CTE_STATUS_ALLOCATION_FAILED;
+            ASSIGN_BY_REF(status, CTE_STATUS_ALLOCATION_FAILED);
+            return;
+        } // end if
+
+        this_render->buffer = buffer;
+        this_render->b_size = size;
+    } // end if
+
+    memcpy(&this_render->buffer[this_render->b_length], chunk, length);
+    this_render->b_length = size;
+
+    // expand from first carried byte, preceding character is kept at index 0
+    r_status = _expand_source(&this_render->render,
+                              this_render->buffer, this_render->b_length,
+                              1, 0);
+
+    // expansion stopped before construct that may continue in next chunk
+    if (r_status == CTE_STATUS_SUSPENDED) {
+        stop = this_render->chunk.stop;
+        r_status = CTE_STATUS_SUCCESS;
+    }
+    else /* all bytes consumed */ {
+        stop = this_render->b_length;
+    } // end if
+
+    // pass output of this chunk to sink
+    if ((r_status == CTE_STATUS_SUCCESS) &&
+        (this_render->render.t_index > 0))
+        r_status = _flush_to_sink(&this_render->render);
+
+    // bail out if expansion or sink failed
+    if (r_status != CTE_STATUS_SUCCESS) {
+        this_render->r_status = r_status;
+        ASSIGN_BY_REF(status, r_status);
+        return;
+    } // end if
+
+    // carry bytes not consumed,  preceded by the character before them
+    this_render->b_length = this_render->b_length - stop + 1;
+    memmove(this_render->buffer,
+            &this_render->buffer[stop - 1], this_render->b_length);
+
+    ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
+    return;
+
+    #undef this_render
+} // end cte_chunked_render_feed
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_chunked_render_finish( render, status )
+// ---------------------------------------------------------------------------
+//
+// Marks the end of the template passed to chunked render <render>,  expands
+// the bytes carried over from the last chunk  and passes the remaining output
+// to the sink.  Returns the total number of bytes passed to the sink.  The
+// function fails if NULL is passed in for <render>,  if the render has been
+// finished or failed before,  or for the reasons given for cte_chunked_ren-
+// der_feed().
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_chunked_render_finish(cte_chunked_render_t render,
+                                         cte_status_t *status) {
+
+    #define this_render ((cte_chunked_render_s *) render)
+
+    cte_status_t r_status;
+
+    // bail out if render is NULL or has been finished
+    if ((render == NULL) || (this_render->finished)) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_STATE);
+        return 0;
+    } // end if
+
+    // no further input,  carried bytes are expanded as they are
+    this_render->render.chunk = NULL;
+    this_render->finished = true;
+
+    r_status = this_render->r_status;
+
+    if (r_status == CTE_STATUS_SUCCESS)
+        r_status = _expand_source(&this_render->render,
+                                  this_render->buffer, this_render->b_length,
+                                  1, 0);
+
+    this_render->r_status = r_status;
+
+    return _finish_render_to_sink(&this_render->render, r_status, status);
+
+    #undef this_render
+} // end cte_chunked_render_finish
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_dispose_chunked_render( render )
+// ---------------------------------------------------------------------------
+//
+// Disposes of chunked render <render>,  whether or not it has been finished.
+// Returns NULL.
+
+cte_chunked_render_t cte_dispose_chunked_render(cte_chunked_render_t render) {
+    
+    #define this_render ((cte_chunked_render_s *) render)
+    
+    if (render == NULL)
+        return NULL;
+    
+    // chunk buffer and stack are disposed of when finished
+    if (NOT(this_render->finished)) {
+        cte_dispose_stack(this_render->render.stack);
+        DEALLOCATE_AT(CTE_ALLOC_SITE_TARGET,
+                      this_render->render.target, this_render->render.t_size);
+    } // end if
+    
+    DEALLOCATE(this_render->buffer);
+    DEALLOCATE(render);
+    
+    return NULL;
+    
+    #undef this_render
+} // end cte_dispose_chunked_render
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_dispose_template( compiled )
+// ---------------------------------------------------------------------------
+//
+// Disposes of compiled template <compiled>.  Returns NULL.
+
+cte_template_t cte_dispose_template(cte_template_t compiled) {
+    
+    if (compiled == NULL)
+        return NULL;
+    
+    cte_dispose_histogram_set(((cte_template_s *) compiled)->histograms);
+    DEALLOCATE(compiled);
+    
+    return NULL;
+} // end cte_dispose_template
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_template_identity( compiled )
+// ---------------------------------------------------------------------------
+//
+// Returns the identity of compiled template <compiled>.  Identities are never
+// zero and are unique among all templates compiled by the process,  even if a
+// template is allocated at the address of one previously disposed of.  Re-
+// turns zero if NULL is passed in for <compiled>.
+
+uint64_t cte_template_identity(cte_template_t compiled) {
+    
+    if (compiled == NULL)
+        return 0;
+    
+    return ((cte_template_s *) compiled)->identity;
+} // end cte_template_identity
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_template_histograms( compiled, snapshot, status )
+// ---------------------------------------------------------------------------
+//
+// Passes back in <snapshot>  the histograms of render latency and output size
+// of all successful renders of compiled template <compiled>  since it was com-
+// piled,  merged across all threads.  A render is recorded when the expansion
+// of the template completes,  the latency covers the expansion  including all
+// lookups and writes to the target or sink.  Renders by render states and
+// chunked renders are not recorded.  The function fails if NULL is passed in
+// for <compiled>  or <snapshot>  or if the library was built without CTE_WITH_
+// HISTOGRAMS,  in which case an empty snapshot is passed back.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_template_histograms(cte_template_t compiled,
+                             cte_histogram_snapshot_t *snapshot,
+                             cte_status_t *status) {
+    
+    cte_histogram_status_t h_status;
+    
+    // bail out if snapshot is NULL
+    if (snapshot == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TARGET);
+        return;
+    } // end if
+    
+    // bail out if compiled template is NULL
+    if (compiled == NULL) {
+        memset(snapshot, 0, sizeof(cte_histogram_snapshot_t));
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return;
+    } // end if
+    
+    cte_histogram_snapshot(((cte_template_s *) compiled)->histograms,
+                           snapshot, &h_status);
+    
+    if (h_status != CTE_HISTOGRAM_STATUS_SUCCESS) {
+        ASSIGN_BY_REF(status, CTE_STATUS_UNAVAILABLE);
+        return;
+    } // end if
+    
+    ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
+    return;
+} // end cte_template_histograms
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_template_histograms_dump( compiled, sink, context, status )
+// ---------------------------------------------------------------------------
+//
+// Writes a text dump of the histograms of compiled template <compiled>  as
+// described for cte_histogram_format() to sink <sink>,  passing <context> to
+// the sink,  and returns the number of bytes passed to the sink.  The function
+// fails if NULL is passed in for <compiled> or <sink>,  if the sink fails  or
+// if the library was built without CTE_WITH_HISTOGRAMS.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_template_histograms_dump(cte_template_t compiled,
+                                    cte_sink_f sink,
+                                    void *context,
+                                    cte_status_t *status) {
+    
+    cte_histogram_snapshot_t *snapshot;
+    char text[CTE_HISTOGRAM_TEXT_SIZE];
+    cte_status_t r_status;
+    size_t length = 0;
+    
+    // bail out if sink is NULL
+    if (sink == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TARGET);
+        return 0;
+    } // end if
+    
+    // snapshot is too large to be held on the stack of worker threads
+    snapshot = ALLOCATE(sizeof(cte_histogram_snapshot_t));
+    
+    // bail out if allocation failed
+    if (snapshot == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_ALLOCATION_FAILED);
+        return 0;
+    } // end if
+    
+    cte_template_histograms(compiled, snapshot, &r_status);
+    
+    if (r_status == CTE_STATUS_SUCCESS)
+        length = MIN(cte_histogram_format(snapshot, text, sizeof(text)),
+                     sizeof(text) - 1);
+    
+    DEALLOCATE(snapshot);
+    
+    // bail out if snapshot failed
+    if (r_status != CTE_STATUS_SUCCESS) {
+        ASSIGN_BY_REF(status, r_status);
+        return 0;
+    } // end if
+    
+    // bail out if sink failed
+    if (NOT(sink(text, length, context))) {
+        ASSIGN_BY_REF(status, CTE_STATUS_SINK_FAILED);
+        return 0;
+    } // end if
+    
+    ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
+    return length;
+} // end cte_template_histograms_dump
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_placeholders_in_template( tmplate, placeholders, status )
+// ---------------------------------------------------------------------------
+//
+// Determines  the  placeholders  referenced  in template string <tmplate>
+// without expanding it, and returns a new placeholder set object containing
+// their identifiers and keys.  The function fails  if NULL is passed in for
+// <tmplate> or if allocation fails.  The function returns NULL if it fails.
+//
+// If a placeholder table is passed in <placeholders>,  references are fol-
+// lowed transitively into the values of placeholders defined in the table and
+// the set contains exactly those placeholders  which an expansion  with the
+// table would look up.  If NULL is passed in for <placeholders>,  all place-
+// holders are assumed to be undefined and the set contains every placeholder
+// that an expansion  could look up,  which may include identifiers  that are
+// formed by the closing delimiter of one placeholder string  and  the text
+// following it.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_placeholder_set_t cte_placeholders_in_template(const char *tmplate,
+                                                   kvs_table_t placeholders,
+                                                   cte_status_t *status) {
+    
+    cte_placeholder_set_s *set;
+    cte_status_t r_status;
+    
+    // bail out if template string is NULL
+    if (tmplate == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return NULL;
+    } // end if
+    
+    set = _new_placeholder_set();
+    
+    // bail out if allocation failed
+    if (set == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_ALLOCATION_FAILED);
+        return NULL;
+    } // end if
+    
+    r_status = _collect_placeholders(set,
+                   &_cte_default_syntax, tmplate, 0, placeholders);
+    
+    // bail out if search failed
+    if (r_status != CTE_STATUS_SUCCESS) {
+        cte_dispose_placeholder_set(set);
+        ASSIGN_BY_REF(status, r_status);
+        return NULL;
+    } // end if
+    
+    ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
+    return (cte_placeholder_set_t) set;
+} // end cte_placeholders_in_template
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_placeholders_in_compiled( compiled, placeholders, status )
+// ---------------------------------------------------------------------------
+//
+// Determines the placeholders referenced in compiled template <compiled> and
+// returns  a  new placeholder set object  containing their identifiers and
+// keys.  The top level placeholders are taken from the compiled template with-
+// out scanning.  Otherwise the function behaves  and  fails  the same way as
+// cte_placeholders_in_template() does for the template string the compiled
+// template was compiled from.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_placeholder_set_t cte_placeholders_in_compiled(cte_template_t compiled,
+                                                   kvs_table_t placeholders,
+                                                   cte_status_t *status) {
+    
+    #define this_template ((cte_template_s *)compiled)
+    cte_placeholder_set_s *set;
+    cte_segment_s *segment;
+    cte_status_t r_status;
+    const char *value;
+    cardinal index;
+    bool added;
+    
+    // bail out if compiled template is NULL
+    if (compiled == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return NULL;
+    } // end if
+    
+    set = _new_placeholder_set();
+    
+    // bail out if allocation failed
+    if (set == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_ALLOCATION_FAILED);
+        return NULL;
+    } // end if
+    
+    r_status = CTE_STATUS_SUCCESS;
+    
+    for (index = 0; index < this_template->segment_count; index++) {
+        segment = &this_template->segment[index];
+        
+        if (segment->kind != CTE_SEGMENT_PLACEHOLDER)
+            continue;
+        
+        r_status = _add_to_placeholder_set(set,
+                       &this_template->source[segment->offset + 2],
+                       segment->length, segment->key, &added);
+        
+        if (r_status != CTE_STATUS_SUCCESS)
+            break;
+        
+        if ((placeholders != NULL) &&
+            (kvs_entry_exists(placeholders, segment->key, NULL)))
+            value = kvs_value_for_key(placeholders, segment->key, NULL);
+        else
+            value = NULL;
+        
+        // undefined, search remainder from source at closing delimiter
+        if (value == NULL) {
+            r_status = _collect_placeholders(set, &this_template->syntax,
+                           this_template->source,
+                           segment->offset + segment->length + 2,
+                           placeholders);
+            break;
+        } // end if
+        
+        // defined and new, search its value
+        if (added) {
+            r_status = _collect_placeholders(set,
+                           &this_template->syntax, value, 0, placeholders);
+            
+            if (r_status != CTE_STATUS_SUCCESS)
+                break;
+        } // end if
+    } // end for
+    
+    // bail out if search failed
+    if (r_status != CTE_STATUS_SUCCESS) {
+        cte_dispose_placeholder_set(set);
+        ASSIGN_BY_REF(status, r_status);
+        return NULL;
+    } // end if
+    
+    ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
+    return (cte_placeholder_set_t) set;
+    
+    #undef this_template
+} // end cte_placeholders_in_compiled
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_placeholder_set_count( set )
+// ---------------------------------------------------------------------------
+//
+// Returns the number of placeholders in placeholder set <set>,  returns zero
+// if NULL is passed in for <set>.
+
+cardinal cte_placeholder_set_count(cte_placeholder_set_t set) {
+    
+    if (set == NULL)
+        return 0;
+    
+    return ((cte_placeholder_set_s *) set)->count;
+} // end cte_placeholder_set_count
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_placeholder_set_identifier( set, index )
+// ---------------------------------------------------------------------------
+//
+// Returns a pointer to the identifier of the placeholder at index <index> in
+// placeholder set <set>.  Placeholders are indexed from zero in the order in
+// which they were first referenced.  Returns NULL if NULL is passed in for
+// <set> or if <index> is out of range.
+
+const char *cte_placeholder_set_identifier(cte_placeholder_set_t set,
+                                           cardinal index) {
+    
+    #define this_set ((cte_placeholder_set_s *)set)
+    
+    if ((set == NULL) || (index >= this_set->count))
+        return NULL;
+    
+    return this_set->entry[index].identifier;
+    
+    #undef this_set
+} // end cte_placeholder_set_identifier
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_placeholder_set_key( set, index )
+// ---------------------------------------------------------------------------
+//
+// Returns the key of the placeholder at index <index>  in placeholder set
+// <set>.  Returns zero if NULL is passed in for <set> or if <index> is out of
+// range.
+
+kvs_key_t cte_placeholder_set_key(cte_placeholder_set_t set,
+                                  cardinal index) {
+    
+    #define this_set ((cte_placeholder_set_s *)set)
+    
+    if ((set == NULL) || (index >= this_set->count))
+        return 0;
+    
+    return this_set->entry[index].key;
+    
+    #undef this_set
+} // end cte_placeholder_set_key
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_dispose_placeholder_set( set )
+// ---------------------------------------------------------------------------
+//
+// Disposes of placeholder set <set>.  Returns NULL.
+
+cte_placeholder_set_t cte_dispose_placeholder_set(cte_placeholder_set_t set) {
+    
+    #define this_set ((cte_placeholder_set_s *)set)
+    
+    if (set == NULL)
+        return NULL;
+    
+    DEALLOCATE(this_set->entry);
+    DEALLOCATE(this_set->slot);
+    DEALLOCATE(set);
+    return NULL;
+    
+    #undef this_set
+} // end cte_dispose_placeholder_set
+
+
+// ===========================================================================
+// P R I V A T E   F U N C T I O N   I M P L E M E N T A T I O N S
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// private function:
+//  _string_from_template( tmplate, syntax, placeholders, escape, status )
+// ---------------------------------------------------------------------------
+//
+// Expands template string <tmplate>  according to template syntax <syntax>,
+// the built-in syntax if NULL is passed in for <syntax>,  with the values in
+// <placeholders>,  escaping values in escaping mode <escape>.  Both function
+// cte_string_from_template_with_syntax() and cte_string_from_template_esca-
+// ped() are implemented by this function.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+static char *_string_from_template(const char *tmplate,
+                                   cte_syntax_t syntax,
+                                   kvs_table_t placeholders,
+                                   cte_escape_t escape,
+                                   cte_status_t *status) {
+    
+    cte_render_s render;
+    cte_values_s values;
+    cte_status_t r_status;
+    
+    // bail out if template string is NULL
+    if (tmplate == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return NULL;
+    } // end if
+    
+    // bail out if placeholders is NULL
+    if (placeholders == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
+        return NULL;
+    } // end if
+    
+    // bail out if escaping mode is invalid
+    if (escape > CTE_ESCAPE_DEFAULT) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_SYNTAX);
+        return NULL;
+    } // end if
+    
+    _init_values(&values, NULL, placeholders, NULL, NULL);
+    
+    r_status = _begin_render(&render, &values, tmplate);
+    
+    // bail out if allocation failed
+    if (r_status != CTE_STATUS_SUCCESS) {
+        ASSIGN_BY_REF(status, r_status);
+        return NULL;
+    } // end if
+    
+    CTE_CAPTURE_BEGIN(&render, tmplate, strlen(tmplate));
+    
+    if (syntax != NULL)
+        render.syntax = (cte_syntax_s *) syntax;
+    
+    render.escape = escape;
+    
+    r_status = _expand_source(&render, tmplate, strlen(tmplate), 0, 0);
+    
+    return _finish_render(&render, r_status, status);
+} // _string_from_template
+
+
+// ---------------------------------------------------------------------------
+// private function:  _begin_render( render, values, tmplate )
+// ---------------------------------------------------------------------------
+//
+// Initialises render state <render>  for an expansion  that looks up place-
+// holder values in value source <values>,  allocating its target string.  The
+// template context stack is held in the render state itself.  Template <tmp-
+// late> is only used for notification.
+// Returns CTE_STATUS_SUCCESS,  or CTE_STATUS_ALLOCATION_FAILED if allocation
+// failed in which case nothing remains allocated.
+
+static cte_status_t _begin_render(cte_render_s *render,
+                                  cte_values_s *values,
+                                    const char *tmplate) {
+    
+    // allocate new target string
+    render->t_size = CTE_TARGET_SIZE_INITIAL;
+    render->t_index = 0;
+    render->target = ALLOCATE_AT(CTE_ALLOC_SITE_TARGET, render->t_size);
+    
+    // bail out if target allocation failed
+    if (render->target == NULL) {
+        CTE_NOTIFY(CTE_NOTIFICATION_TARGET_ALLOCATION_FAILED, tmplate, 0);
+        return CTE_STATUS_ALLOCATION_FAILED;
+    } // end if
+    
+    // set up recursion stack in render state, cannot fail
+    render->stack = cte_new_stack_in_storage(render->stack_storage,
+                                             sizeof(render->stack_storage),
+                                             NULL);
+    
+    render->bounded = false;
+    render->values = values;
+    render->digest = NULL;
+    render->sink = NULL;
+    render->emitted = 0;
+    render->syntax = &_cte_default_syntax;
+    render->escape = CTE_ESCAPE_DEFAULT;
+    render->v_escape = CTE_ESCAPE_NONE;
+    render->compiled = NULL;
+    render->segment = NULL;
+    render->section_depth = 0;
+    render->step = NULL;
+    render->suspended = false;
+    render->chunk = NULL;
+    render->sizing = false;
+    render->budget = NULL;
+    render->capture = NULL;
+    
+    return CTE_STATUS_SUCCESS;
+} // _begin_render
+
+
+// ---------------------------------------------------------------------------
+// private function:  _finish_render( render, r_status, status )
+// ---------------------------------------------------------------------------
+//
+// Finalises render state <render>  after an expansion  that ended with status
+// <r_status>.  If the expansion was successful,  the target string is termi-
+// nated and returned,  otherwise it is deallocated and NULL is returned.  The
+// template context stack is disposed of  and  a capture of the render is ended
+// in either case.
+//
+// The final status  is passed back in <status>,  unless  NULL  was passed in
+// for <status>.
+
+static char *_finish_render(cte_render_s *render,
+                            cte_status_t r_status,
+                            cte_status_t *status) {
+    
+    // terminator is not output
+    CTE_CAPTURE_END(render, r_status);
+    
+    // terminate target string, enlarge if necessary, terminator is not digested
+    if (r_status == CTE_STATUS_SUCCESS) {
+        render->digest = NULL;
+        r_status = _append_char_to_target(render, CSTRING_TERMINATOR);
+        
+        if (r_status != CTE_STATUS_SUCCESS)
+            CTE_NOTIFY(CTE_NOTIFICATION_TARGET_ENLARGEMENT_FAILED,
+                       render->target, render->t_index);
+    } // end if
+    
+    cte_dispose_stack(render->stack);
+    
+    // bail out if expansion failed
+    if (r_status != CTE_STATUS_SUCCESS) {
+        DEALLOCATE_AT(CTE_ALLOC_SITE_TARGET, render->target, render->t_size);
+        ASSIGN_BY_REF(status, r_status);
+        return NULL;
+    } // end if
+    
+    RELEASE_AT(CTE_ALLOC_SITE_TARGET, render->t_size);
+    
+    CTE_NOTIFY(CTE_NOTIFICATION_TARGET_SIZE_INFO,
+               render->target, render->t_size);
+    
+    // terminator is not output
+    CTE_METER(render, CTE_METRIC_RENDERS, 1);
+    CTE_METER(render, CTE_METRIC_BYTES_OUT, render->t_index - 1);
+    
+    ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
+    return render->target;
+} // _finish_render
+
+
+// ---------------------------------------------------------------------------
+// private function:  _begin_render_into( render, values, buffer, capacity )
+// ---------------------------------------------------------------------------
+//
+// Initialises render state <render>  for a bounded expansion  that looks up
+// placeholder values in value source <values>  and writes into caller owned
+// buffer <buffer> of <capacity> bytes.  One byte is reserved for the termina-
+// tor.  Characters that do not fit are counted but not written.  Nothing is
+// allocated.
+
+static void _begin_render_into(cte_render_s *render,
+                               cte_values_s *values,
+                                       char *buffer,
+                                     size_t capacity) {
+    
+    // reserve room for terminator
+    render->target = buffer;
+    render->t_index = 0;
+    render->t_size = (capacity > 0) ? capacity - 1 : 0;
+    render->bounded = true;
+    
+    // set up recursion stack in render state, cannot fail
+    render->stack = cte_new_stack_in_storage(render->stack_storage,
+                                             sizeof(render->stack_storage),
+                                             NULL);
+    
+    render->values = values;
+    render->digest = NULL;
+    render->sink = NULL;
+    render->emitted = 0;
+    render->syntax = &_cte_default_syntax;
+    render->escape = CTE_ESCAPE_DEFAULT;
+    render->v_escape = CTE_ESCAPE_NONE;
+    render->compiled = NULL;
+    render->segment = NULL;
+    render->section_depth = 0;
+    render->step = NULL;
+    render->suspended = false;
+    render->chunk = NULL;
+    render->sizing = false;
+    render->budget = NULL;
+    render->capture = NULL;
+    
+    return;
+} // _begin_render_into
+
+
+// ---------------------------------------------------------------------------
+// private function:  _finish_render_into( render, r_status, status )
+// ---------------------------------------------------------------------------
+//
+// Finalises render state <render>  after a bounded expansion  that ended with
+// status <r_status>.  If the expansion was successful,  the buffer is termi-
+// nated after the last character written and the number of characters of the
+// full expansion is returned.  Otherwise the buffer is set to the empty string
+// and zero is returned.  Nothing is written if the buffer has zero capacity.
+// A capture of the render is ended in either case.
+//
+// The final status  is passed back in <status>,  unless  NULL  was passed in
+// for <status>.
+
+static size_t _finish_render_into(cte_render_s *render,
+                                  cte_status_t r_status,
+                                  cte_status_t *status) {
+    
+    cte_dispose_stack(render->stack);
+    CTE_CAPTURE_END(render, r_status);
+    
+    // bail out if expansion failed
+    if (r_status != CTE_STATUS_SUCCESS) {
+        if (render->target != NULL)
+            render->target[0] = CSTRING_TERMINATOR;
+        
+        ASSIGN_BY_REF(status, r_status);
+        return 0;
+    } // end if
+    
+    // terminate buffer after last character written
+    if (render->target != NULL) {
+        if (render->t_index < render->t_size)
+            render->target[render->t_index] = CSTRING_TERMINATOR;
+        else
+            render->target[render->t_size] = CSTRING_TERMINATOR;
+    } // end if
+    
+    // characters that did not fit are not output
+    CTE_METER(render, CTE_METRIC_RENDERS, 1);
+    CTE_METER(render, CTE_METRIC_BYTES_OUT,
+              (render->target != NULL) ?
+              MIN(render->t_index, render->t_size) : 0);
+    
+    ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
+    return render->t_index;
+} // _finish_render_into
+
+
+// ---------------------------------------------------------------------------
+// private function:  _begin_render_to_sink( render, values, sink, context,
+//                                           chunk_size, tmplate )
+// ---------------------------------------------------------------------------
+//
+// Initialises render state <render>  for an expansion  that looks up place-
+// holder values in value source <values>  and passes its output  to sink
+// <sink> with context <context>  in chunks of <chunk_size> bytes.  A chunk
+// buffer is allocated as the target,  it is never enlarged.  Template <tmp-
+// late> is only used for notification.  Returns CTE_STATUS_SUCCESS,  or
+// CTE_STATUS_ALLOCATION_FAILED if allocation failed.
+
+static cte_status_t _begin_render_to_sink(cte_render_s *render,
+                                          cte_values_s *values,
+                                            cte_sink_f sink,
+                                                  void *context,
+                                                size_t chunk_size,
+                                            const char *tmplate) {
+    
+    // allocate chunk buffer
+    render->t_size = chunk_size;
+    render->t_index = 0;
+    render->target = ALLOCATE_AT(CTE_ALLOC_SITE_TARGET, render->t_size);
+    
+    // bail out if chunk buffer allocation failed
+    if (render->target == NULL) {
+        CTE_NOTIFY(CTE_NOTIFICATION_TARGET_ALLOCATION_FAILED, tmplate, 0);
+        return CTE_STATUS_ALLOCATION_FAILED;
+    } // end if
+    
+    // set up recursion stack in render state, cannot fail
+    render->stack = cte_new_stack_in_storage(render->stack_storage,
+                                             sizeof(render->stack_storage),
+                                             NULL);
+    
+    render->bounded = false;
+    render->values = values;
+    render->digest = NULL;
+    render->sink = sink;
+    render->sink_context = context;
+    render->emitted = 0;
+    render->syntax = &_cte_default_syntax;
+    render->escape = CTE_ESCAPE_DEFAULT;
+    render->v_escape = CTE_ESCAPE_NONE;
+    render->compiled = NULL;
+    render->segment = NULL;
+    render->section_depth = 0;
+    render->step = NULL;
+    render->suspended = false;
+    render->chunk = NULL;
+    render->sizing = false;
+    render->budget = NULL;
+    render->capture = NULL;
+    
+    return CTE_STATUS_SUCCESS;
+} // _begin_render_to_sink
+
+
+// ---------------------------------------------------------------------------
+// private function:  _finish_render_to_sink( render, r_status, status )
+// ---------------------------------------------------------------------------
+//
+// Finalises render state <render>  after an expansion to a sink  that ended
+// with status <r_status>.  If the expansion was successful,  the remaining
+// output in the chunk buffer is passed to the sink.  The chunk buffer and the
+// template context stack are disposed of  and  a capture of the render is
+// ended in either case.  Returns the number of bytes passed to the sink.
+//
+// The final status  is passed back in <status>,  unless  NULL  was passed in
+// for <status>.
+
+static size_t _finish_render_to_sink(cte_render_s *render,
+                                     cte_status_t r_status,
+                                     cte_status_t *status) {
+    
+    // pass remaining output to sink
+    if ((r_status == CTE_STATUS_SUCCESS) && (render->t_index > 0))
+        r_status = _flush_to_sink(render);
+    
+    CTE_CAPTURE_END(render, r_status);
+    cte_dispose_stack(render->stack);
+    DEALLOCATE_AT(CTE_ALLOC_SITE_TARGET, render->target, render->t_size);
+    
+    if (r_status == CTE_STATUS_SUCCESS)
+        CTE_METER(render, CTE_METRIC_RENDERS, 1);
+    
+    CTE_METER(render, CTE_METRIC_BYTES_OUT, render->emitted);
+    
+    ASSIGN_BY_REF(status, r_status);
+    return render->emitted;
+} // _finish_render_to_sink
+
+
+// ---------------------------------------------------------------------------
+// private function:  _begin_budget( render, budget )
+// ---------------------------------------------------------------------------
+//
+// Limits render state <render>  by budget <budget>  and starts its clock.  The
+// render remains unlimited if NULL is passed in for <budget>  or if none of
+// its limits is set.
+
+static void _begin_budget(cte_render_s *render, const cte_budget_t *budget) {
+    
+    // no limit, no budget checks
+    if ((budget == NULL) || ((budget->max_output == 0) &&
+        (budget->max_expansions == 0) && (budget->time_limit == 0)))
+        return;
+    
+    render->budget = budget;
+    render->expansions = 0;
+    render->deadline = 0;
+    
+    if (budget->time_limit > 0)
+        render->deadline = cte_clock() + budget->time_limit;
+    
+    return;
+} // _begin_budget
+
+
+// ---------------------------------------------------------------------------
+// private function:  _charge_budget( render )
+// ---------------------------------------------------------------------------
+//
+// Charges one expansion  to the budget  of limited render state <render>  and
+// checks its limits.  The output limit is checked against the output produced
+// so far,  the clock is only read every CTE_DEADLINE_CHECK_INTERVAL expansions.
+//
+// Returns CTE_STATUS_SUCCESS  if the render is within its budget,  otherwise
+// returns the status describing the limit that was exceeded.
+
+static cte_status_t _charge_budget(cte_render_s *render) {
+    
+    const cte_budget_t *budget = render->budget;
+    
+    render->expansions++;
+    
+    if ((budget->max_expansions > 0) &&
+        (render->expansions > budget->max_expansions))
+        return CTE_STATUS_EXPANSION_LIMIT_EXCEEDED;
+    
+    if ((budget->max_output > 0) &&
+        (render->emitted + render->t_index > budget->max_output))
+        return CTE_STATUS_OUTPUT_LIMIT_EXCEEDED;
+    
+    if ((render->deadline != 0) &&
+        ((render->expansions % CTE_DEADLINE_CHECK_INTERVAL) == 0) &&
+        (cte_clock() >= render->deadline))
+        return CTE_STATUS_DEADLINE_EXCEEDED;
+    
+    return CTE_STATUS_SUCCESS;
+} // _charge_budget
+
+
+// ---------------------------------------------------------------------------
+// private function:  _settle_budget( render, source, s_length, r_status )
+// ---------------------------------------------------------------------------
+//
+// Checks the output limit of render state <render>  after an expansion of
+// source <source> of length <s_length>  that ended with status <r_status>,
+// since output produced after the last expansion has not been checked.
+//
+// Returns <r_status>  unless the expansion was successful  and its output ex-
+// ceeds the limit,  in which case CTE_STATUS_OUTPUT_LIMIT_EXCEEDED is returned.
+
+static cte_status_t _settle_budget(cte_render_s *render,
+                                   const char *source,
+                                   size_t s_length,
+                                   cte_status_t r_status) {
+    
+    if ((r_status != CTE_STATUS_SUCCESS) || (render->budget == NULL) ||
+        (render->budget->max_output == 0) ||
+        (render->emitted + render->t_index <= render->budget->max_output))
+        return r_status;
+    
+    CTE_NOTIFY_RENDER(render, CTE_NOTIFICATION_BUDGET_EXCEEDED,
+                      source, s_length);
+    
+    return CTE_STATUS_OUTPUT_LIMIT_EXCEEDED;
+} // _settle_budget
+
+
+// ---------------------------------------------------------------------------
+// private function:  _flush_to_sink( render )
+// ---------------------------------------------------------------------------
+//
+// Passes the output in the chunk buffer of render state <render> to its sink
+// and empties the chunk buffer.  Returns CTE_STATUS_SUCCESS,  or CTE_STATUS_
+// SINK_FAILED if the sink did not accept the output.
+
+static cte_status_t _flush_to_sink(cte_render_s *render) {
+    
+    if (NOT(render->sink(render->target, render->t_index,
+                         render->sink_context)))
+        return CTE_STATUS_SINK_FAILED;
+    
+    render->emitted = render->emitted + render->t_index;
+    render->t_index = 0;
+    
+    return CTE_STATUS_SUCCESS;
+} // _flush_to_sink
+
+
+// ---------------------------------------------------------------------------
+// private function:  _append_to_sink( render, str, length )
+// ---------------------------------------------------------------------------
+//
+// Appends <length> characters starting at <str> to the output of render state
+// <render>  whose chunk buffer cannot hold them.  The chunk buffer is filled
+// up and passed to the sink.  If the remaining characters would fill another
+// chunk,  they are passed to the sink directly without copying,  otherwise
+// they are copied to the chunk buffer.  Returns CTE_STATUS_SUCCESS,  or
+// CTE_STATUS_SINK_FAILED if the sink did not accept the output.
+
+static cte_status_t _append_to_sink(cte_render_s *render,
+                                    const char *str,
+                                    size_t length) {
+    cte_status_t r_status;
+    size_t fill;
+    
+    // fill up and flush partial chunk
+    if (render->t_index > 0) {
+        fill = render->t_size - render->t_index;
+        memcpy(&render->target[render->t_index], str, fill);
+        render->t_index = render->t_size;
+        
+        r_status = _flush_to_sink(render);
+        
+        if (r_status != CTE_STATUS_SUCCESS)
+            return r_status;
+        
+        str = str + fill;
+        length = length - fill;
+    } // end if
+    
+    // pass whole chunks directly
+    if (length >= render->t_size) {
+        if (NOT(render->sink(str, length, render->sink_context)))
+            return CTE_STATUS_SINK_FAILED;
+        
+        render->emitted = render->emitted + length;
+        return CTE_STATUS_SUCCESS;
+    } // end if
+    
+    memcpy(render->target, str, length);
+    render->t_index = length;
+    
+    return CTE_STATUS_SUCCESS;
+} // _append_to_sink
+
+
+// ---------------------------------------------------------------------------
+// private function:  _expand_template( render, tmplate, compiled )
+// ---------------------------------------------------------------------------
+//
+// Expands compiled template <compiled>,  or template string <tmplate> if NULL
+// is passed in for <compiled>,  and appends the result to the target of ren-
+// der state <render>.  Returns the status of the expansion.
+
+static cte_status_t _expand_template(cte_render_s *render,
+                                     const char *tmplate,
+                                     cte_template_s *compiled) {
+    
+    if (compiled != NULL)
+        return _expand_compiled(render, compiled);
+    
+    return _expand_source(render, tmplate, strlen(tmplate), 0, 0);
+} // _expand_template
+
+
+// ---------------------------------------------------------------------------
+// private function:  _report_sizing( values, tmplate, compiled )
+// ---------------------------------------------------------------------------
+//
+// Repeats a sizing render of compiled template <compiled>,  or template string
+// <tmplate> if NULL is passed in for <compiled>,  with placeholder values from
+// value source <values>  that failed,  so that its notifications,  including
+// that of the failure,  reach the handlers.  Nothing is written.  Called only
+// when a sizing render failed,  since no render follows to report its events.
+
+static void _report_sizing(cte_values_s *values,
+                           const char *tmplate,
+                           cte_template_s *compiled) {
+    
+    cte_render_s render;
+    
+    _begin_render_into(&render, values, NULL, 0);
+    _expand_template(&render, tmplate, compiled);
+    cte_dispose_stack(render.stack);
+    
+    return;
+} // _report_sizing
+
+
+// ---------------------------------------------------------------------------
+// private function:  _render_to_file( fd, values, tmplate, compiled, status )
+// ---------------------------------------------------------------------------
+//
+// Expands compiled template <compiled>,  or template string <tmplate> if NULL
+// is passed in for <compiled>,  looking up placeholder values in value source
+// <values>,  and writes the result to file descriptor <fd>  at its current
+// offset.  Regular files are extended and mapped  and the output is expanded
+// into the mapping,  other files are written through a chunk buffer.  This is
+// the engine behind cte_render_to_file() and cte_render_compiled_to_file().
+// Returns the number of bytes written.
+//
+// The final status  is passed back in <status>,  unless  NULL  was passed in
+// for <status>.
+
+static size_t _render_to_file(int fd,
+                              cte_values_s *values,
+                              const char *tmplate,
+                              cte_template_s *compiled,
+                              cte_status_t *status) {
+    
+    cte_render_s render;
+    cte_status_t r_status;
+    size_t size;
+    
+#ifndef CTE_NO_MMAP
+    struct stat info;
+    off_t offset, base;
+    size_t page_size, map_size;
+    char *mapping;
+    int result;
+    
+    // only regular files can be mapped
+    if ((fstat(fd, &info) != 0) || (NOT(S_ISREG(info.st_mode))))
+        BAILOUT(stream_to_file);
+    
+    offset = lseek(fd, 0, SEEK_CUR);
+    
+    if (offset < 0)
+        BAILOUT(stream_to_file);
+    
+    // determine exact size of output without writing anything
+    _begin_render_into(&render, values, NULL, 0);
+    render.sizing = true;
+    r_status = _expand_template(&render, tmplate, compiled);
+    size = _finish_render_into(&render, r_status, &r_status);
+    
+    // bail out if expansion failed
+    if (r_status != CTE_STATUS_SUCCESS) {
+        _report_sizing(values, tmplate, compiled);
+        ASSIGN_BY_REF(status, r_status);
+        return 0;
+    } // end if
+    
+    // small output is not worth mapping
+    if (size < CTE_FILE_MAP_MIN_SIZE)
+        BAILOUT(stream_to_file);
+    
+    // extend file, fall back to truncation where allocation is unsupported
+    result = posix_fallocate(fd, offset, size);
+    
+    if ((result == EINVAL) || (result == EOPNOTSUPP))
+        result = (ftruncate(fd, offset + size) == 0) ? 0 : errno;
+    
+    // bail out if file could not be extended
+    if (result != 0) {
+        errno = result;
+        ASSIGN_BY_REF(status, CTE_STATUS_FILE_FAILED);
+        return 0;
+    } // end if
+    
+    // mappings must start at a page boundary
+    page_size = (size_t) sysconf(_SC_PAGESIZE);
+    base = offset - (offset % page_size);
+    map_size = (size_t) (offset - base) + size;
+    
+    mapping = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                   fd, base);
+    
+    // write through chunk buffer if file cannot be mapped
+    if (mapping == MAP_FAILED) {
+        result = ftruncate(fd, info.st_size);
+        BAILOUT(stream_to_file);
+    } // end if
+    
+    // expand into mapping, no room is reserved for a terminator
+    _begin_render_into(&render, values, &mapping[offset - base], 1);
+    render.t_size = size;
+    CTE_CAPTURE_BEGIN(&render,
+        (compiled != NULL) ? compiled->source : tmplate,
+        (compiled != NULL) ? compiled->source_length : strlen(tmplate));
+    r_status = _expand_template(&render, tmplate, compiled);
+    cte_dispose_stack(render.stack);
+    CTE_CAPTURE_END(&render, r_status);
+    
+    munmap(mapping, map_size);
+    
+    // restore original size if expansion failed
+    if (r_status != CTE_STATUS_SUCCESS) {
+        result = ftruncate(fd, info.st_size);
+        ASSIGN_BY_REF(status, r_status);
+        return 0;
+    } // end if
+    
+    // advance file offset past output
+    lseek(fd, offset + size, SEEK_SET);
+    
+    CTE_METER(&render, CTE_METRIC_RENDERS, 1);
+    CTE_METER(&render, CTE_METRIC_BYTES_OUT, size);
+    
+    ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
+    return size;
+    
+    ON_ERROR(stream_to_file) :
+#endif
+    
+    // write output to file through chunk buffer
+    r_status = _begin_render_to_sink(&render, values, _write_to_file,
+                   (void *) (intptr_t) fd, CTE_SINK_CHUNK_SIZE, tmplate);
+    
+    // bail out if allocation failed
+    if (r_status != CTE_STATUS_SUCCESS) {
+        ASSIGN_BY_REF(status, r_status);
+        return 0;
+    } // end if
+    
+    CTE_CAPTURE_BEGIN(&render,
+        (compiled != NULL) ? compiled->source : tmplate,
+        (compiled != NULL) ? compiled->source_length : strlen(tmplate));
+    
+    r_status = _expand_template(&render, tmplate, compiled);
+    size = _finish_render_to_sink(&render, r_status, &r_status);
+    
+    // sink failure means the file could not be written
+    if (r_status == CTE_STATUS_SINK_FAILED)
+        r_status = CTE_STATUS_FILE_FAILED;
+    
+    ASSIGN_BY_REF(status, r_status);
+    return size;
+} // _render_to_file
+
+
+// ---------------------------------------------------------------------------
+// private function:  _write_to_file( data, length, fd )
+// ---------------------------------------------------------------------------
+//
+// Sink function  that writes <length> bytes starting at <data>  to the file
+// descriptor passed in <fd>,  retrying partial and interrupted writes.  Re-
+// turns true if all bytes were written, otherwise false.
+
+static bool _write_to_file(const char *data, size_t length, void *fd) {
+    ssize_t written;
+    
+    while (length > 0) {
+        written = write((int) (intptr_t) fd, data, length);
+        
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            
+            return false;
+        } // end if
+        
+        data = data + written;
+        length = length - written;
+    } // end while
+    
+    return true;
+} // _write_to_file
+
+
+// ---------------------------------------------------------------------------
+// private function:  _expand_source( render, source, length, s_index, level )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all  placeholder strings  in string <source>  of length
+// <length>,  starting at index <s_index>,  and appends the result to the tar-
+// get string of render state <render>.  Placeholder values are looked up in
+// the value source of the render state.  The nesting level of <source> must be
+// passed in <nesting_level>,  expansion ends when the end of <source> is rea-
+// ched.  This is the common expansion engine  behind  all  public expansion
+// functions.  It follows  the grammar  and  static semantics  described for
+// function cte_string_from_template().
+//
+// Strings are delimited by their length,  not by a terminator,  and runs of
+// characters without special meaning are copied to the target in one piece.
+// Strings are recognised according to the template syntax of the render state.
+//
+// Returns CTE_STATUS_SUCCESS  if expansion was successful,  otherwise returns
+// the status describing the failure.
+
+static cte_status_t _expand_source(cte_render_s *render,
+                                     const char *source_str,
+                                       size_t s_length,
+                                       size_t s_index,
+                                       cardinal nesting_level) {
+    
+    char *source; // source string pointer
+    size_t run_start; // start index of character run to copy
+    const cte_syntax_s *syntax; // delimiters and character classes
+    
+    cte_stack_status_t s_status; // stack operation status
+    cardinal base_level; // nesting level of initial source string
+    
+    const char *value; // placeholder value
+    size_t v_length; // placeholder value length
+    cte_escape_t escape; // placeholder value escaping mode
+    kvs_key_t key; // placeholder key
+    cardinal ident_len; // identifier length
+    size_t next; // source index past section
+    cardinal level; // nesting level of restored placeholder
+    cte_step_frame_s *frame; // frame of suspended step render
+    cte_status_t r_status; // intermediate status
+    
+    #define CTE_CHAR_AT(_index) \
+        (((_index) < s_length) ? source[_index] : CSTRING_TERMINATOR)
+    
+    #define CTE_APPEND(_str, _length) \
+        (((nesting_level > 0) && (render->v_escape != CTE_ESCAPE_NONE)) ? \
+         _append_escaped(render, render->v_escape, _str, _length) : \
+         _append_to_target(render, _str, _length))
+    
+    #define CTE_TRACE_WHOLE \
+        ((base_level == 0) && (render->section_depth == 0))
+    
+    #define CTE_TRACE_OPEN_EVENTS \
+        (nesting_level - base_level + ((CTE_TRACE_WHOLE) ? 1 : 0))
+    
+    
+    source = (char *) source_str;
+    syntax = render->syntax;
+    base_level = nesting_level;
+    frame = NULL;
+    
+    // resuming a step render, restore state of this invocation
+    if ((render->step != NULL) && (render->step->resuming)) {
+        frame = &render->step->frame[render->section_depth];
+        source = (char *) frame->source;
+        s_length = frame->s_length;
+        s_index = frame->s_index;
+        nesting_level = frame->nesting_level;
+        base_level = frame->base_level;
+        
+        // innermost invocation resumes expansion
+        if (render->section_depth == render->step->depth)
+            render->step->resuming = false;
+    } // end if
+    
+    // expansion of a template or remainder is traced as a whole
+    if (CTE_TRACE_WHOLE)
+        CTE_TRACE_BEGIN((render->compiled == NULL) ?
+                        CTE_TRACE_RENDER : CTE_TRACE_REMAINDER, NULL, 0);
+    
+    if (frame != NULL) {
+        
+        // placeholder events were ended on suspension, begin them anew
+        for (level = base_level; level < nesting_level; level++)
+            CTE_TRACE_BEGIN(CTE_TRACE_PLACEHOLDER, NULL, 0);
+        
+        // re-enter section that was suspended
+        if (frame->in_section) {
+            r_status = _expand_section(render, source, s_length,
+                                       s_index, nesting_level, &next);
+            
+            // bail out if expansion of rows failed or was suspended
+            if (r_status != CTE_STATUS_SUCCESS)
+                BAILOUT(section_failed);
+            
+            s_index = next;
+        } // end if
+    } // end if
+    
+    // recursively expand source strings
+    loop {
+        
+        // find end of run of characters without special meaning
+        run_start = s_index;
+        while ((s_index < s_length) &&
+               (CTE_CHAR_CLASS(syntax, source[s_index]) ==
+                CTE_CHAR_ORDINARY)) {
+            s_index++;
+        } // end while
+        
+        // copy run to target, enlarge if necessary
+        if (s_index > run_start) {
+            r_status = CTE_APPEND(&source[run_start], s_index - run_start);
+            
+            // bail out if allocation failed
+            if (r_status != CTE_STATUS_SUCCESS)
+                BAILOUT(enlargement_failed);
+            
+            // suspend step render if step buffer is full
+            if (render->suspended)
+                BAILOUT(suspended);
+        } // end if
+        
+        // end of string indicates return from recursion
+        if (s_index >= s_length) {
+            
+            // done when back at initial nesting level
+            if (nesting_level == base_level)
+                break;
+            
+            // restore source, length and index from recursion stack
+            source = cte_stack_pop_context(render->stack,
+                                           &s_length, &s_index, NULL);
+            // update template nesting level
+            nesting_level--;
+            CTE_TRACE_END(1);
+            
+            continue;
+        } // end if
+        
+        // stop chunked render before construct continued in next chunk
+        if ((render->chunk != NULL) && (nesting_level == 0) &&
+            (render->section_depth == 0) &&
+            (_chunk_stop(render, source, s_length, s_index)))
+            BAILOUT(chunk_stopped);
+        
+        // handle special characters
+        switch (CTE_CHAR_CLASS(syntax, source[s_index])) {
+                
+                // backslash may indicate escaped delimiter
+            case CTE_CHAR_ESCAPE :
+                
+                // characters from run start to index are copied
+                run_start = s_index;
+                
+                switch (CTE_CHAR_CLASS(syntax, CTE_CHAR_AT(s_index+1))) {
+                        
+                    // found backslash escaped backslash
+                    case CTE_CHAR_ESCAPE :
+                        // copy both backslashes to target
+                        s_index++;
+                        
+                        break; // case
+                        
+                        // found backslash escaped delimiter
+                    case CTE_CHAR_DELIMITER :
+                        // skip leading backslash
+                        s_index++;
+                        run_start = s_index;
+                        
+                        break; // case
+                        
+                        // found ignore prefix following backslash
+                    case CTE_CHAR_IGNORE_PREFIX :
+                        // check if leading backslash is at first row of line
+                        if (CTE_START_OF_LINE(source, s_index)) {
+                            // skip leading backslash
+                            s_index++;
+                            run_start = s_index;
+                        } // end if
+                        
+                        break; // case
+                } // end switch
+                
+                // copy remaining characters to target, enlarge if necessary
+                r_status = CTE_APPEND(&source[run_start],
+                                      s_index + 1 - run_start);
+                
+                // bail out if allocation failed
+                if (r_status != CTE_STATUS_SUCCESS)
+                    BAILOUT(enlargement_failed);
+                
+                s_index++;
+                
+                break; // case
+                
+                // delimiter char may indicate template engine placeholder
+            case CTE_CHAR_DELIMITER :
+                
+                // check for opening delimiter followed by letter
+                if ((CTE_CHAR_AT(s_index+1) == syntax->delimiter[1]) &&
+                    (IS_LETTER(CTE_CHAR_AT(s_index+2)))) {
+                    
+                    // calculate key for identifier following delimiter
+                    s_index = s_index + 2;
+                    key = HASH_INITIAL;
+                    ident_len = 0;
+                    
+                    // calculate key of identifier
+                    repeat {
+                        key = HASH_NEXT_CHAR(key, source[s_index]);
+                        s_index++;
+                        ident_len++;
+                    } until ((IS_NOT_UNDERSCORE_NOR_ALPHANUM(
+                                  CTE_CHAR_AT(s_index)))
+                             || (ident_len > CTE_MAX_PLACEHOLDER_LENGTH));
+                    key = HASH_FINAL(key);
+                    
+                    // look up value if identifier is properly delimited
+                    if ((ident_len <= CTE_MAX_PLACEHOLDER_LENGTH) &&
+                        (CTE_CHAR_AT(s_index) ==
+                         syntax->closing_delimiter[0]) &&
+                        (CTE_CHAR_AT(s_index+1) ==
+                         syntax->closing_delimiter[1])) {
+                        CTE_TRACE_BEGIN(CTE_TRACE_LOOKUP,
+                                        &source[s_index - ident_len],
+                                        ident_len);
+                        value = _value_for_placeholder(render->values,
+                                    &source[s_index - ident_len],
+                                    ident_len, key, &v_length, &escape);
+                        CTE_TRACE_END(1);
+                        CTE_CAPTURE_VALUE(render,
+                                          &source[s_index - ident_len],
+                                          ident_len, key, value, v_length,
+                                          escape);
+                    }
+                    else
+                        value = NULL;
+                    
+                    // value is pending, step render waits at placeholder
+                    if (value == CTE_PENDING_VALUE) {
+                        if (render->step != NULL) {
+                            s_index = s_index - ident_len - 2;
+                            render->step->hole = &source[s_index + 2];
+                            render->step->h_length = ident_len;
+                            BAILOUT(suspended);
+                        } // end if
+                        
+                        // other renders treat it as undefined
+                        value = NULL;
+                    } // end if
+                    
+                    // check if identifier is a placeholder
+                    if (value != NULL) {
+                        
+                        // bail out if nesting limit is reached
+                        if (nesting_level >= CTE_MAX_NESTING_LEVEL)
+                            BAILOUT(nesting_limit_exceeded);
+                        
+                        // bail out if render budget is exceeded
+                        if (CTE_BUDGET_EXCEEDED(render, r_status))
+                            BAILOUT(budget_exceeded);
+                        
+                        // save source and index past closing delimiter
+                        cte_stack_push_context(render->stack, source,
+                                        s_length, s_index + 2, &s_status);
+                        
+                        // bail out if stack enlargement failed
+                        if (s_status != CTE_STACK_STATUS_SUCCESS)
+                            BAILOUT(stack_enlargement_failed);
+                        
+                        CTE_TRACE_BEGIN(CTE_TRACE_PLACEHOLDER,
+                                        &source[s_index - ident_len],
+                                        ident_len);
+                        CTE_METER(render, CTE_METRIC_PLACEHOLDERS_EXPANDED, 1);
+                        
+                        // mode of value entered from template applies to
+                        // its expansion as a whole, including nested values
+                        if (nesting_level == 0)
+                            render->v_escape = _value_escape(render, escape);
+                        
+                        // set source and index to content of placeholder
+                        source = (char *) value;
+                        s_length = v_length;
+                        s_index = 0;
+                        
+                        // update template nesting level
+                        nesting_level++;
+                    }
+                    else /* identifier is not a placeholder */ {
+                        
+                        // restore source index to delimiter position 
+                        s_index = s_index - ident_len - 2;
+                        
+                        CTE_NOTIFY_RENDER(render,
+                                   CTE_NOTIFICATION_UNDEFINED_PLACEHOLDER,
+                                   source, s_index);
+                        
+                        // copy char to target, enlarge if necessary
+                        r_status = CTE_APPEND(&source[s_index], 1);
+                        
+                        // bail out if allocation failed
+                        if (r_status != CTE_STATUS_SUCCESS)
+                            BAILOUT(enlargement_failed);
+                        
+                        s_index++;
+                    } // end if
+                }
+                // check for opening delimiter followed by section tag
+                else if ((CTE_CHAR_AT(s_index+1) == syntax->delimiter[1]) &&
+                         (CTE_CHAR_AT(s_index+2) == CTE_SECTION_OPENING) &&
+                         (IS_LETTER(CTE_CHAR_AT(s_index+3)))) {
+                    
+                    // expand all rows if this is a section
+                    r_status = _expand_section(render, source, s_length,
+                                               s_index, nesting_level, &next);
+                    
+                    // bail out if expansion of rows failed
+                    if (r_status != CTE_STATUS_SUCCESS)
+                        BAILOUT(section_failed);
+                    
+                    // section without rows is copied like undefined placeholder
+                    if (next == s_index) {
+                        CTE_NOTIFY_RENDER(render,
+                                   CTE_NOTIFICATION_UNDEFINED_PLACEHOLDER,
+                                   source, s_index);
+                        
+                        // copy char to target, enlarge if necessary
+                        r_status = CTE_APPEND(&source[s_index], 1);
+                        
+                        // bail out if allocation failed
+                        if (r_status != CTE_STATUS_SUCCESS)
+                            BAILOUT(enlargement_failed);
+                        
+                        next++;
+                    } // end if
+                    
+                    s_index = next;
+                }
+                else /* no opening delimiter followed by letter found */ {
+                    // copy char to target, enlarge if necessary
+                    r_status = CTE_APPEND(&source[s_index], 1);
+                    
+                    // bail out if allocation failed
+                    if (r_status != CTE_STATUS_SUCCESS)
+                        BAILOUT(enlargement_failed);
+                    
+                    s_index++;
+                } // end if
+                
+                break; // case
+                
+                // prefix char may indicate template engine comment line
+            case CTE_CHAR_IGNORE_PREFIX :
+                // check for ignore line prefix at first coloumn
+                if ((CTE_CHAR_AT(s_index+1) == syntax->ignore_prefix[1]) &&
+                    CTE_START_OF_LINE(source, s_index)) {
+                    
+                    // skip all characters until line end without copying
+                    while ((s_index < s_length) &&
+                           (source[s_index] != NEWLINE)) {
+                        s_index++;
+                    } // end while
+                    
+                    // comment line continues in next chunk
+                    if ((s_index >= s_length) && (render->chunk != NULL) &&
+                        (nesting_level == 0) && (render->section_depth == 0))
+                        render->chunk->skipping = true;
+                }
+                else /* no ignore line prefix found at first coloumn */ {
+                    // copy char to target, enlarge if necessary
+                    r_status = CTE_APPEND(&source[s_index], 1);
+                    
+                    // bail out if allocation failed
+                    if (r_status != CTE_STATUS_SUCCESS)
+                        BAILOUT(enlargement_failed);
+                    
+                    s_index++;
+                } // end if
+                
+                break; // case
+                
+                // terminator within string is copied like any character
+            default :
+                r_status = CTE_APPEND(&source[s_index], 1);
+                
+                // bail out if allocation failed
+                if (r_status != CTE_STATUS_SUCCESS)
+                    BAILOUT(enlargement_failed);
+                
+                s_index++;
+        } // end switch
+        
+        // suspend step render if step buffer is full
+        if (render->suspended)
+            BAILOUT(suspended);
+        
+    } // end loop
+    
+    /* NORMAL TERMINATION */
+    
+    CTE_TRACE_END(CTE_TRACE_OPEN_EVENTS);
+    
+    return CTE_STATUS_SUCCESS;
+    
+    /* ERROR HANDLING */
+    
+    ON_ERROR(enlargement_failed) :
+        CTE_TRACE_END(CTE_TRACE_OPEN_EVENTS);
+        
+        // sink failure is reported as such, not as allocation failure
+        if (r_status == CTE_STATUS_SINK_FAILED)
+            return r_status;
+        
+        CTE_NOTIFY_RENDER(render, CTE_NOTIFICATION_TARGET_ENLARGEMENT_FAILED,
+                          source, s_index);
+        return CTE_STATUS_ALLOCATION_FAILED;
+    
+    ON_ERROR(stack_enlargement_failed) :
+        CTE_TRACE_END(CTE_TRACE_OPEN_EVENTS);
+        CTE_NOTIFY_RENDER(render, CTE_NOTIFICATION_STACK_ENLARGEMENT_FAILED,
+                          source, s_index);
+        return CTE_STATUS_ALLOCATION_FAILED;
+    
+    ON_ERROR(nesting_limit_exceeded) :
+        CTE_TRACE_END(CTE_TRACE_OPEN_EVENTS);
+        CTE_NOTIFY_RENDER(render, CTE_NOTIFICATION_NESTING_LIMIT_EXCEEDED,
+                          source, s_index);
+        return CTE_STATUS_NESTING_LIMIT_EXCEEDED;
+    
+    ON_ERROR(budget_exceeded) :
+        CTE_TRACE_END(CTE_TRACE_OPEN_EVENTS);
+        CTE_NOTIFY_RENDER(render, CTE_NOTIFICATION_BUDGET_EXCEEDED,
+                          source, s_index);
+        return r_status;
+    
+    ON_ERROR(section_failed) :
+        // suspended within section, resume by re-entering the section
+        if (r_status == CTE_STATUS_SUSPENDED)
+            _save_frame(render, source, s_length,
+                        s_index, nesting_level, base_level, true);
+        
+        // failure has already been notified within the section
+        CTE_TRACE_END(CTE_TRACE_OPEN_EVENTS);
+        return r_status;
+    
+    ON_ERROR(suspended) :
+        _save_frame(render, source, s_length,
+                    s_index, nesting_level, base_level, false);
+        CTE_TRACE_END(CTE_TRACE_OPEN_EVENTS);
+        return CTE_STATUS_SUSPENDED;
+    
+    ON_ERROR(chunk_stopped) :
+        render->chunk->stop = s_index;
+        CTE_TRACE_END(CTE_TRACE_OPEN_EVENTS);
+        return CTE_STATUS_SUSPENDED;
+    
+    #undef CTE_CHAR_AT
+    #undef CTE_APPEND
+    #undef CTE_TRACE_WHOLE
+    #undef CTE_TRACE_OPEN_EVENTS
+} // _expand_source
+
+
+// ---------------------------------------------------------------------------
+// private function:  _new_render_state( source, s_length, syntax, status )
+// ---------------------------------------------------------------------------
+//
+// Allocates and returns a new resumable render state  for the expansion of
+// source <source> of length <s_length>  according to syntax <syntax>.  The
+// render is bounded by the buffer passed to each step and writes through the
+// step state of the new render state.  Its value source must be initialised
+// by the caller.  Returns NULL if allocation failed.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+static cte_render_state_s *_new_render_state(const char *source,
+                                             size_t s_length,
+                                             const cte_syntax_s *syntax,
+                                             cte_status_t *status) {
+    cte_render_state_s *state;
+    
+    state = ALLOCATE(sizeof(cte_render_state_s));
+    
+    // bail out if allocation failed
+    if (state == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_ALLOCATION_FAILED);
+        return NULL;
+    } // end if
+    
+    _begin_render_into(&state->render, &state->values, NULL, 0);
+    state->render.syntax = syntax;
+    state->render.step = &state->step;
+    
+    state->step.depth = 0;
+    state->step.resuming = false;
+    state->step.stash_index = 0;
+    state->step.stash_length = 0;
+    state->step.pending = NULL;
+    state->step.p_length = 0;
+    state->step.p_escape = CTE_ESCAPE_NONE;
+    state->step.hole = NULL;
+    state->step.h_length = 0;
+    
+    state->source = source;
+    state->s_length = s_length;
+    state->done = false;
+    state->r_status = CTE_STATUS_SUCCESS;
+    
+    ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
+    return state;
+} // _new_render_state
+
+
+// ---------------------------------------------------------------------------
+// private function:
+//  _save_frame( render, source, s_length, s_index, nesting_level, base_level,
+//               in_section )
+// ---------------------------------------------------------------------------
+//
+// Saves the state of an invocation of the expansion engine  that is suspended
+// at section depth <render->section_depth>  into the corresponding step frame
+// of render state <render>.  If the invocation is not suspended within a sec-
+// tion,  it is the innermost invocation and its depth is recorded as such.
+
+static fmacro void _save_frame(cte_render_s *render,
+                               const char *source,
+                               size_t s_length,
+                               size_t s_index,
+                               cardinal nesting_level,
+                               cardinal base_level,
+                               bool in_section) {
+    
+    cte_step_frame_s *frame;
+    
+    frame = &render->step->frame[render->section_depth];
+    frame->source = source;
+    frame->s_length = s_length;
+    frame->s_index = s_index;
+    frame->nesting_level = nesting_level;
+    frame->base_level = base_level;
+    frame->in_section = in_section;
+    
+    if (NOT(in_section))
+        render->step->depth = render->section_depth;
+    
+    return;
+} // _save_frame
+
+
+// ---------------------------------------------------------------------------
+// private function:
+//  _new_chunked_render( table, kvs, sink, context, status )
+// ---------------------------------------------------------------------------
+//
+// Allocates and returns a new chunked render  that looks up placeholder values
+// in placeholder table <table>,  or in KVS table <kvs> if NULL is passed in for
+// <table>,  and passes its output to sink <sink> with context <context>.  The
+// buffer for carried bytes and chunk initially holds a newline only,  so that
+// the start of the template is recognised as the start of a line.  Returns
+// NULL if allocation failed.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+static cte_chunked_render_s *_new_chunked_render(cte_table_t table,
+                                                 kvs_table_t kvs,
+                                                 cte_sink_f sink,
+                                                 void *context,
+                                                 cte_status_t *status) {
+    cte_chunked_render_s *chunked;
+    cte_status_t r_status;
+
+    chunked = ALLOCATE(sizeof(cte_chunked_render_s));
+
+    // bail out if allocation failed
+    if (chunked == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_ALLOCATION_FAILED);
+        return NULL;
+    } // end if
+
+    chunked->b_size = CTE_CHUNK_LOOKAHEAD;
+    chunked->buffer = ALLOCATE(chunked->b_size);
+
+    // bail out if buffer allocation failed
+    if (chunked->buffer == NULL) {
+        DEALLOCATE(chunked);
+        ASSIGN_BY_REF(status, CTE_STATUS_ALLOCATION_FAILED);
+        return NULL;
+    } // end if
+
+    _init_values(&chunked->values, table, kvs, NULL, NULL);
+
+    r_status = _begin_render_to_sink(&chunked->render, &chunked->values,
+                                     sink, context, CTE_SINK_CHUNK_SIZE, "");
+
+    // bail out if chunk buffer allocation failed
+    if (r_status != CTE_STATUS_SUCCESS) {
+        DEALLOCATE(chunked->buffer);
+        DEALLOCATE(chunked);
+        ASSIGN_BY_REF(status, r_status);
+        return NULL;
+    } // end if
+
+    chunked->render.chunk = &chunked->chunk;
+    chunked->chunk.stop = 0;
+    chunked->chunk.skipping = false;
+
+    chunked->buffer[0] = NEWLINE;
+    chunked->b_length = 1;
+    chunked->r_status = CTE_STATUS_SUCCESS;
+    chunked->finished = false;
+
+    ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
+    return chunked;
+} // _new_chunked_render
+
+
+// ---------------------------------------------------------------------------
+// private function:  _chunk_stop( render, source, s_length, s_index )
+// ---------------------------------------------------------------------------
+//
+// Returns true if the special character at index <s_index>  of the carried
+// bytes and chunk in string <source> of length <s_length>  may start an escape
+// sequence,  comment line prefix,  placeholder or section opening  that con-
+// tinues in the next chunk of chunked render <render>.  A section with rows
+// continues until its section end.  Returns false otherwise.
+
+static fmacro bool _chunk_stop(cte_render_s *render,
+                               const char *source,
+                               size_t s_length,
+                               size_t s_index) {
+
+    const cte_syntax_s *syntax;
+    cardinal ident_len, count;
+    size_t body_end;
+    kvs_key_t key;
+
+    syntax = render->syntax;
+
+    switch (CTE_CHAR_CLASS(syntax, source[s_index])) {
+
+        // escape and comment line prefix depend on the next character
+        case CTE_CHAR_ESCAPE :
+        case CTE_CHAR_IGNORE_PREFIX :
+            return (s_index + 1 >= s_length);
+
+        // identifier and closing delimiter may be cut off
+        case CTE_CHAR_DELIMITER :
+            if (s_length - s_index < CTE_CHUNK_LOOKAHEAD)
+                return true;
+
+            // section with rows is expanded once its section end has arrived
+            return ((_section_at(syntax, source, s_length, s_index,
+                                 &ident_len, &key)) &&
+                    (_rows_for_placeholder(render->values,
+                                           key, &count) != NULL) &&
+                    (NOT(_section_end(syntax, source, s_length,
+                                      s_index + ident_len + 5,
+                                      &source[s_index + 3], ident_len,
+                                      &body_end))));
+
+        default :
+            return false;
+    } // end switch
+} // _chunk_stop
+
+
+// ---------------------------------------------------------------------------
+// private function:  _expand_compiled( render, compiled )
+// ---------------------------------------------------------------------------
+//
+// Expands compiled template <compiled>  and appends the result to the target
+// string of render state <render>.  Literal segments are copied as they are,
+// the values of placeholder segments are expanded  by _expand_source().  If a
+// placeholder turns out to be undefined,  the remainder of the template is
+// expanded from its source, starting past the first character of the opening
+// delimiter,  exactly as cte_string_from_template() would have done.
+//
+// Returns CTE_STATUS_SUCCESS  if expansion was successful,  otherwise returns
+// the status describing the failure.
+
+static cte_status_t _expand_compiled(cte_render_s *render,
+                                     cte_template_s *compiled) {
+    
+    cte_status_t r_status;
+    cardinal stop;
+#ifdef CTE_WITH_HISTOGRAMS
+    uint64_t started = cte_clock();
+    size_t before = render->emitted + render->t_index;
+#endif
+    
+    CTE_TRACE_BEGIN(CTE_TRACE_RENDER, NULL, 0);
+    
+    r_status = _expand_segments(render,
+                                compiled, 0, compiled->segment_count, &stop);
+    
+    // undefined placeholder, expand remainder from source
+    if ((r_status == CTE_STATUS_SUCCESS) &&
+        (stop < compiled->segment_count))
+        r_status = _expand_remainder(render, compiled, stop);
+    
+    CTE_TRACE_END(1);
+    
+#ifdef CTE_WITH_HISTOGRAMS
+    if ((r_status == CTE_STATUS_SUCCESS) && (NOT(render->sizing)))
+        cte_histogram_record(compiled->histograms,
+                             cte_clock() - started,
+                             render->emitted + render->t_index - before);
+#endif
+    
+    return r_status;
+} // _expand_compiled
+
+
+// ---------------------------------------------------------------------------
+// private function:  _expand_segments( render, compiled, first, end, stop )
+// ---------------------------------------------------------------------------
+//
+// Expands  the segments  of compiled template <compiled>  from index <first>
+// up to but not including index <end>  and appends the result to the target
+// string of render state <render>.  Expansion stops at the first placeholder
+// or section that turns out to be undefined.  Its index is passed back in
+// <stop>,  <end> is passed back if all placeholders in the range were defined.
+//
+// Returns CTE_STATUS_SUCCESS  if expansion was successful,  otherwise returns
+// the status describing the failure.
+
+static cte_status_t _expand_segments(cte_render_s *render,
+                                     cte_template_s *compiled,
+                                     cardinal first,
+                                     cardinal end,
+                                     cardinal *stop) {
+    
+    cte_segment_s *segment;
+    const char *value;
+    size_t v_length;
+    cte_escape_t escape;
+    size_t next;
+    cte_status_t r_status;
+    cardinal index;
+    
+    // placeholder values are recognised according to the template's syntax
+    render->syntax = &compiled->syntax;
+    render->compiled = compiled;
+    
+    for (index = first; index < end; index++) {
+        segment = &compiled->segment[index];
+        
+        // copy literal segment
+        if (segment->kind == CTE_SEGMENT_LITERAL) {
+            r_status = _append_to_target(render,
+                           &compiled->text[segment->offset], segment->length);
+            
+            if (r_status == CTE_STATUS_ALLOCATION_FAILED)
+                CTE_NOTIFY_RENDER(render,
+                           CTE_NOTIFICATION_TARGET_ENLARGEMENT_FAILED,
+                           compiled->source, segment->offset);
+            
+            if (r_status != CTE_STATUS_SUCCESS)
+                return r_status;
+            
+            continue;
+        } // end if
+        
+        // expand all rows of section, stop if it has none
+        if (segment->kind == CTE_SEGMENT_SECTION) {
+            r_status = _expand_section(render, compiled->source,
+                           compiled->source_length, segment->offset, 0, &next);
+            
+            if (r_status != CTE_STATUS_SUCCESS)
+                return r_status;
+            
+            if (next == segment->offset)
+                break;
+            
+            continue;
+        } // end if
+        
+        CTE_TRACE_BEGIN(CTE_TRACE_LOOKUP,
+                        &compiled->source[segment->offset + 2],
+                        segment->length);
+        value = _value_for_placeholder(render->values,
+                    &compiled->source[segment->offset + 2],
+                    segment->length, segment->key, &v_length, &escape);
+        CTE_TRACE_END(1);
+        CTE_CAPTURE_VALUE(render, &compiled->source[segment->offset + 2],
+                          segment->length, segment->key, value, v_length,
+                          escape);
+        
+        // stop at undefined or pending placeholder
+        if ((value == NULL) || (value == CTE_PENDING_VALUE))
+            break;
+        
+        // bail out if render budget is exceeded
+        if (CTE_BUDGET_EXCEEDED(render, r_status)) {
+            CTE_NOTIFY_RENDER(render, CTE_NOTIFICATION_BUDGET_EXCEEDED,
+                              compiled->source, segment->offset);
+            return r_status;
+        } // end if
+        
+        // expand placeholder value at nesting level one
+        CTE_TRACE_BEGIN(CTE_TRACE_PLACEHOLDER,
+                        &compiled->source[segment->offset + 2],
+                        segment->length);
+        CTE_METER(render, CTE_METRIC_PLACEHOLDERS_EXPANDED, 1);
+        render->segment = segment;
+        render->v_escape = _value_escape(render, escape);
+        r_status = _expand_source(render, value, v_length, 0, 1);
+        CTE_TRACE_END(1);
+        
+        if (r_status != CTE_STATUS_SUCCESS)
+            return r_status;
+        
+        render->segment = NULL;
+    } // end for
+    
+    *stop = index;
+    return CTE_STATUS_SUCCESS;
+} // _expand_segments
+
+
+// ---------------------------------------------------------------------------
+// private function:  _expand_remainder( render, compiled, index )
+// ---------------------------------------------------------------------------
+//
+// Expands the remainder  of compiled template <compiled>  from its source,
+// starting at the undefined placeholder of segment <index>,  and appends the
+// result to the target string of render state <render>.  The first character
+// of the opening delimiter is copied,  expansion resumes past it.
+//
+// Returns CTE_STATUS_SUCCESS  if expansion was successful,  otherwise returns
+// the status describing the failure.
+
+static cte_status_t _expand_remainder(cte_render_s *render,
+                                      cte_template_s *compiled,
+                                      cardinal index) {
+    
+    cte_segment_s *segment = &compiled->segment[index];
+    cte_status_t r_status;
+    
+    render->syntax = &compiled->syntax;
+    render->compiled = compiled;
+    
+    CTE_NOTIFY_RENDER(render, CTE_NOTIFICATION_UNDEFINED_PLACEHOLDER,
+                      compiled->source, segment->offset);
+    
+    r_status = _append_to_target(render,
+                   &compiled->source[segment->offset], 1);
+    
+    if (r_status == CTE_STATUS_ALLOCATION_FAILED)
+        CTE_NOTIFY_RENDER(render, CTE_NOTIFICATION_TARGET_ENLARGEMENT_FAILED,
+                          compiled->source, segment->offset);
+    
+    if (r_status != CTE_STATUS_SUCCESS)
+        return r_status;
+    
+    return _expand_source(render, compiled->source,
+                          compiled->source_length, segment->offset + 1, 0);
+} // _expand_remainder
+
+
+// ---------------------------------------------------------------------------
+// private function:
+//  _expand_section( render, source, length, s_index, level, next )
+// ---------------------------------------------------------------------------
+//
+// Expands the section  whose opening delimiter is at index <s_index>  of string
+// <source> of length <length>  and appends the result to the target string of
+// render state <render>.  The nesting level of <source> must be passed in
+// <nesting_level>.  If the section is properly delimited and closed and rows
+// are stored for its identifier in the value source of the render state,  its
+// body is expanded once per row  and the index past its section end is passed
+// back in <next>.  Otherwise nothing is appended and <s_index> is passed back.
+//
+// Returns CTE_STATUS_SUCCESS  if expansion was successful,  otherwise returns
+// the status describing the failure.
+
+static cte_status_t _expand_section(cte_render_s *render,
+                                    const char *source,
+                                    size_t s_length,
+                                    size_t s_index,
+                                    cardinal nesting_level,
+                                    size_t *next) {
+    
+    const cte_table_t *row;
+    cardinal ident_len, count;
+    size_t body_end;
+    cte_status_t r_status;
+    kvs_key_t key;
+    
+    *next = s_index;
+    
+    // bail out if not properly delimited
+    if (NOT(_section_at(render->syntax,
+                        source, s_length, s_index, &ident_len, &key)))
+        return CTE_STATUS_SUCCESS;
+    
+    row = _rows_for_placeholder(render->values, key, &count);
+    
+    // bail out if no rows are stored or the section is not closed
+    if ((row == NULL) ||
+        (NOT(_section_end(render->syntax, source, s_length,
+                          s_index + ident_len + 5, &source[s_index + 3],
+                          ident_len, &body_end))))
+        return CTE_STATUS_SUCCESS;
+    
+    // rows are not recorded,  a render that expands them cannot be replayed
+    CTE_CAPTURE_DISCARD(render);
+    
+    CTE_TRACE_BEGIN(CTE_TRACE_SECTION, &source[s_index + 3], ident_len);
+    r_status = _expand_rows(render, source, s_index + ident_len + 5,
+                            body_end, row, count, nesting_level);
+    CTE_TRACE_END(1);
+    
+    if (r_status != CTE_STATUS_SUCCESS)
+        return r_status;
+    
+    *next = body_end + ident_len + 5;
+    return CTE_STATUS_SUCCESS;
+} // _expand_section
+
+
+// ---------------------------------------------------------------------------
+// private function:
+//  _expand_rows( render, source, body_start, body_end, row, count, level )
+// ---------------------------------------------------------------------------
+//
+// Expands the section body from index <body_start> up to but not including
+// index <body_end> of string <source>  once for each of the <count> row tables
+// in array <row>,  appending the results to the target string of render state
+// <render>.  The nesting level of <source> must be passed in <nesting_level>.
+// For each row,  the row's table becomes the value source of the render,  the
+// previous value source is searched for placeholders not found in the row.
+// When a step render is resumed,  expansion continues with the suspended row.
+//
+// Returns CTE_STATUS_SUCCESS  if expansion was successful,  otherwise returns
+// the status describing the failure.
+
+static cte_status_t _expand_rows(cte_render_s *render,
+                                 const char *source,
+                                 size_t body_start,
+                                 size_t body_end,
+                                 const cte_table_t *row,
+                                 cardinal count,
+                                 cardinal nesting_level) {
+    
+    cte_values_s row_values, *values;
+    cte_status_t r_status;
+    cardinal index;
+    
+    // bail out if section depth limit is reached
+    if (render->section_depth >= CTE_MAX_SECTION_DEPTH) {
+        CTE_NOTIFY_RENDER(render, CTE_NOTIFICATION_NESTING_LIMIT_EXCEEDED,
+                          source, body_start);
+        return CTE_STATUS_NESTING_LIMIT_EXCEEDED;
+    } // end if
+    
+    values = render->values;
+    _init_values(&row_values, NULL, NULL, NULL, NULL);
+    row_values.outer = values;
+    
+    // resuming a step render, continue with the row that was suspended
+    if ((render->step != NULL) && (render->step->resuming))
+        index = render->step->frame[render->section_depth].row;
+    else
+        index = 0;
+    
+    render->values = &row_values;
+    render->section_depth++;
+    r_status = CTE_STATUS_SUCCESS;
+    
+    while (index < count) {
+        
+        // bail out if render budget is exceeded
+        if (CTE_BUDGET_EXCEEDED(render, r_status)) {
+            CTE_NOTIFY_RENDER(render, CTE_NOTIFICATION_BUDGET_EXCEEDED,
+                              source, body_start);
+            break;
+        } // end if
+        
+        row_values.table = row[index];
+        
+        r_status = _expand_source(render,
+                       source, body_end, body_start, nesting_level);
+        
+        if (r_status != CTE_STATUS_SUCCESS)
+            break;
+        
+        index++;
+    } // end while
+    
+    render->section_depth--;
+    render->values = values;
+    
+    // remember row to resume with
+    if (r_status == CTE_STATUS_SUSPENDED)
+        render->step->frame[render->section_depth].row = index;
+    
+    return r_status;
+} // _expand_rows
+
+
+// ---------------------------------------------------------------------------
+// private function:  _size_segments( unit )
+// ---------------------------------------------------------------------------
+//
+// Sizing pass worker.  Determines the expanded size of each segment  of work
+// unit <unit>  by a bounded render into a buffer of zero capacity,  recording
+// the sizes in the unit's size array.  Sizing stops  at the first undefined
+// placeholder,  whose index is recorded in the unit.  Returns NULL.
+
+static void *_size_segments(void *unit) {
+    #define this_unit ((cte_work_unit_s *)unit)
+    cte_render_s render;
+    cardinal index;
+    size_t before;
+    
+    _begin_render_into(&render, this_unit->values, NULL, 0);
+    render.sizing = true;
+    
+    this_unit->stop = this_unit->end;
+    this_unit->r_status = CTE_STATUS_SUCCESS;
+    
+    CTE_TRACE_BEGIN(CTE_TRACE_SEGMENTS, NULL, 0);
+    
+    for (index = this_unit->first; index < this_unit->end; index++) {
+        before = render.t_index;
+        
+        this_unit->r_status = _expand_segments(&render,
+            this_unit->compiled, index, index + 1, &this_unit->stop);
+        
+        if ((this_unit->r_status != CTE_STATUS_SUCCESS) ||
+            (this_unit->stop == index))
+            break;
+        
+        this_unit->size[index] = render.t_index - before;
+    } // end for
+    
+    CTE_TRACE_END(1);
+    
+    this_unit->stop = index;
+    cte_dispose_stack(render.stack);
+    
+    return NULL;
+    #undef this_unit
+} // _size_segments
+
+
+// ---------------------------------------------------------------------------
+// private function:  _fill_segments( unit )
+// ---------------------------------------------------------------------------
+//
+// Fill pass worker.  Expands the segments of work unit <unit> into the unit's
+// region of the output buffer.  The render is bounded by the size of the re-
+// gion so that it cannot write into neighbouring regions,  no terminator is
+// written.  Returns NULL.
+
+static void *_fill_segments(void *unit) {
+    #define this_unit ((cte_work_unit_s *)unit)
+    cte_render_s render;
+    cardinal stop;
+    
+    // capacity includes a terminator, which is never written here
+    _begin_render_into(&render, this_unit->values,
+                       this_unit->target, this_unit->t_size + 1);
+    
+    CTE_TRACE_BEGIN(CTE_TRACE_SEGMENTS, NULL, 0);
+    this_unit->r_status = _expand_segments(&render, this_unit->compiled,
+                                           this_unit->first,
+                                           this_unit->end, &stop);
+    CTE_TRACE_END(1);
+    
+    cte_dispose_stack(render.stack);
+    
+    return NULL;
+    #undef this_unit
+} // _fill_segments
+
+
+// ---------------------------------------------------------------------------
+// private function:  _run_work_units( unit, count, work )
+// ---------------------------------------------------------------------------
+//
+// Runs worker function <work> on each of the <count> work units in array
+// <unit>,  each on a thread of its own  except for the last one which is run
+// on the calling thread.  Units for which no thread could be started are run
+// on the calling thread as well.  Returns when all units are done.
+
+static void _run_work_units(cte_work_unit_s *unit,
+                            cardinal count,
+                            void *(*work)(void *)) {
+    
+    cardinal index;
+    
+#ifndef CTE_NO_THREADS
+    pthread_t thread[CTE_PARALLEL_MAX_THREADS];
+    bool started[CTE_PARALLEL_MAX_THREADS];
+    
+    for (index = 0; index + 1 < count; index++)
+        started[index] =
+            (pthread_create(&thread[index], NULL, work, &unit[index]) == 0);
+    
+    work(&unit[count - 1]);
+    
+    for (index = 0; index + 1 < count; index++) {
+        if (started[index])
+            pthread_join(thread[index], NULL);
+        else
+            work(&unit[index]);
+    } // end for
+#else
+    for (index = 0; index < count; index++)
+        work(&unit[index]);
+#endif
+    
+    return;
+} // _run_work_units
+
+
+// ---------------------------------------------------------------------------
+// private function:
+//  _capture_parallel( capture, compiled, placeholders, result, total )
+// ---------------------------------------------------------------------------
+//
+// Ends capture record <capture> of a parallel render of compiled template
+// <compiled>  with the values in <placeholders>,  which produced the <total>
+// bytes of output at <result>.  The work units of a parallel render look up
+// values concurrently  and are not captured themselves,  the values recorded
+// are those of the placeholders found in the template and its values instead.
+// The record is discarded if the template's syntax is not the built-in syntax
+// or if allocation fails.  Does nothing if NULL is passed in for <capture>.
+
+static void _capture_parallel(cte_capture_record_t capture,
+                              cte_template_s *compiled,
+                              kvs_table_t placeholders,
+                              const char *result,
+                              size_t total) {
+    
+    cte_placeholder_set_t set;
+    const char *identifier, *value;
+    kvs_key_t key;
+    cardinal index, count;
+    
+    if (capture == NULL)
+        return;
+    
+    set = cte_placeholders_in_compiled(compiled, placeholders, NULL);
+    
+    // bail out if allocation failed or syntax is not the built-in syntax
+    if ((set == NULL) ||
+        (memcmp(&compiled->syntax, &_cte_default_syntax,
+                sizeof(cte_syntax_s)) != 0)) {
+        cte_dispose_placeholder_set(set);
+        cte_capture_discard(capture);
+        return;
+    } // end if
+    
+    count = cte_placeholder_set_count(set);
+    
+    for (index = 0; index < count; index++) {
+        identifier = cte_placeholder_set_identifier(set, index);
+        key = cte_placeholder_set_key(set, index);
+        
+        if (kvs_entry_exists(placeholders, key, NULL))
+            value = kvs_value_for_key(placeholders, key, NULL);
+        else
+            value = NULL;
+        
+        cte_capture_value(capture, key, identifier, strlen(identifier),
+                          value, (value != NULL) ? strlen(value) : 0);
+    } // end for
+    
+    cte_dispose_placeholder_set(set);
+    
+    cte_capture_output(capture, result, total);
+    cte_capture_end(capture, compiled->source, compiled->source_length, true);
+    
+    return;
+} // _capture_parallel
+
+
+// ---------------------------------------------------------------------------
+// private function:
+//  _compile( source, length, syntax, compiled, segment_count, text_length )
+// ---------------------------------------------------------------------------
+//
+// Splits template string <source> of length <length> into literal, placehol-
+// der and section segments and stores them in compiled template <compiled>.  Comments are removed and es-
+// cape sequences are resolved  in the text of literal segments  according to
+// the static semantics described for function cte_string_from_template()  and
+// template syntax <syntax>.
+//
+// If NULL is passed in for <compiled>, nothing is stored,  which can be used
+// to determine the storage required for the compiled template.  The  number
+// of segments  and the  length of all literal text  are passed back in <seg-
+// ment_count> and <text_length>.
+
+static void _compile(const char *source,
+                     cardinal s_length,
+                     const cte_syntax_s *syntax,
+                     cte_template_s *compiled,
+                     cardinal *segment_count,
+                     cardinal *text_length) {
+    
+    cardinal s_index, t_index, literal_start, seg_count;
+    cardinal ident_len;
+    size_t body_end;
+    kvs_key_t key;
+    char ch;
+    
+    #define CTE_EMIT_CHAR(_ch) \
+        { if (compiled != NULL) compiled->text[t_index] = _ch; t_index++; }
+    
+    #define CTE_EMIT_SEGMENT(_kind, _offset, _length, _key) \
+        { if (compiled != NULL) { \
+            compiled->segment[seg_count].kind = _kind; \
+            compiled->segment[seg_count].offset = _offset; \
+            compiled->segment[seg_count].length = _length; \
+            compiled->segment[seg_count].key = _key; } \
+          seg_count++; }
+    
+    #define CTE_CLOSE_LITERAL \
+        { if (t_index > literal_start) { \
+            CTE_EMIT_SEGMENT(CTE_SEGMENT_LITERAL, \
+                             literal_start, t_index - literal_start, 0); \
+            literal_start = t_index; } }
+    
+    s_index = 0;
+    t_index = 0;
+    literal_start = 0;
+    seg_count = 0;
+    
+    while (source[s_index] != CSTRING_TERMINATOR) {
+        ch = source[s_index];
+        
+        // backslash may indicate escaped delimiter
+        if (CTE_CHAR_CLASS(syntax, ch) == CTE_CHAR_ESCAPE) {
+            switch (CTE_CHAR_CLASS(syntax, source[s_index+1])) {
+                case CTE_CHAR_ESCAPE :
+                    CTE_EMIT_CHAR(BACKSLASH);
+                    s_index++;
+                    break; // case
+                case CTE_CHAR_DELIMITER :
+                    s_index++;
+                    break; // case
+                case CTE_CHAR_IGNORE_PREFIX :
+                    if (CTE_START_OF_LINE(source, s_index))
+                        s_index++;
+                    break; // case
+            } // end switch
+            
+            CTE_EMIT_CHAR(source[s_index]);
+            s_index++;
+        }
+        // delimiter char may indicate template engine placeholder
+        else if ((CTE_CHAR_CLASS(syntax, ch) == CTE_CHAR_DELIMITER) &&
+                 (source[s_index+1] == syntax->delimiter[1]) &&
+                 (IS_LETTER(source[s_index+2]))) {
+            
+            // calculate key of identifier
+            key = HASH_INITIAL;
+            ident_len = 0;
+            repeat {
+                key = HASH_NEXT_CHAR(key, source[s_index + 2 + ident_len]);
+                ident_len++;
+            } until ((IS_NOT_UNDERSCORE_NOR_ALPHANUM(
+                          source[s_index + 2 + ident_len])) ||
+                     (ident_len > CTE_MAX_PLACEHOLDER_LENGTH));
+            key = HASH_FINAL(key);
+            
+            // check if identifier is properly delimited
+            if ((ident_len <= CTE_MAX_PLACEHOLDER_LENGTH) &&
+                (source[s_index + 2 + ident_len] ==
+                 syntax->closing_delimiter[0]) &&
+                (source[s_index + 3 + ident_len] ==
+                 syntax->closing_delimiter[1])) {
+                
+                // close pending literal segment
+                CTE_CLOSE_LITERAL;
+                
+                CTE_EMIT_SEGMENT(CTE_SEGMENT_PLACEHOLDER,
+                                 s_index, ident_len, key);
+                
+                // continue past closing delimiter
+                s_index = s_index + ident_len + 4;
+            }
+            else /* not a placeholder */ {
+                CTE_EMIT_CHAR(ch);
+                s_index++;
+            } // end if
+        }
+        // delimiter char may indicate section with matching section end
+        else if ((CTE_CHAR_CLASS(syntax, ch) == CTE_CHAR_DELIMITER) &&
+                 (_section_at(syntax, source, s_length,
+                              s_index, &ident_len, &key)) &&
+                 (_section_end(syntax, source, s_length,
+                               s_index + ident_len + 5,
+                               &source[s_index + 3], ident_len, &body_end))) {
+            
+            // close pending literal segment
+            CTE_CLOSE_LITERAL;
+            
+            CTE_EMIT_SEGMENT(CTE_SEGMENT_SECTION, s_index, ident_len, key);
+            
+            // continue past section end, the body is expanded from source
+            s_index = body_end + ident_len + 5;
+        }
+        // prefix char may indicate template engine comment line
+        else if ((CTE_CHAR_CLASS(syntax, ch) == CTE_CHAR_IGNORE_PREFIX) &&
+                 (source[s_index+1] == syntax->ignore_prefix[1]) &&
+                 (CTE_START_OF_LINE(source, s_index))) {
+            
+            // skip all characters until line end
+            while ((source[s_index] != NEWLINE) &&
+                   (source[s_index] != CSTRING_TERMINATOR)) {
+                s_index++;
+            } // end while
+        }
+        else /* ordinary character */ {
+            CTE_EMIT_CHAR(ch);
+            s_index++;
+        } // end if
+    } // end while
+    
+    // close final literal segment
+    CTE_CLOSE_LITERAL;
+    
+    *segment_count = seg_count;
+    *text_length = t_index;
+    
+    #undef CTE_EMIT_CHAR
+    #undef CTE_EMIT_SEGMENT
+    #undef CTE_CLOSE_LITERAL
+    return;
+} // _compile
+
+
+// ---------------------------------------------------------------------------
+// private function:
+//  _next_placeholder( syntax, source, s_index, ident_len, key )
+// ---------------------------------------------------------------------------
+//
+// Searches string <source>  from index <s_index>  for the next properly deli-
+// mited placeholder string,  skipping template comments and escape sequences
+// according to the static semantics  described for cte_string_from_template()
+// and template syntax <syntax>.  If a placeholder string is found,  its open-
+// ing delimiter's index is passed back in <s_index>,  the length of its iden-
+// tifier is passed back in <ident_len>  and its key is passed back in <key>
+// and true is returned.  If none is found,  the index of the terminator is
+// passed back in <s_index> and false is returned.
+
+static bool _next_placeholder(const cte_syntax_s *syntax,
+                              const char *source,
+                              size_t *s_index,
+                              cardinal *ident_len,
+                              kvs_key_t *key) {
+    
+    size_t index = *s_index;
+    cardinal length;
+    kvs_key_t hash;
+    
+    loop {
+        switch (CTE_CHAR_CLASS(syntax, source[index])) {
+            
+            // skip escaped character
+            case CTE_CHAR_ESCAPE :
+                switch (CTE_CHAR_CLASS(syntax, source[index+1])) {
+                    case CTE_CHAR_ESCAPE :
+                    case CTE_CHAR_DELIMITER :
+                        index++;
+                        break; // case
+                    case CTE_CHAR_IGNORE_PREFIX :
+                        if (CTE_START_OF_LINE(source, index))
+                            index++;
+                        break; // case
+                } // end switch
+                
+                if (source[index] != CSTRING_TERMINATOR)
+                    index++;
+                
+                break; // case
+            
+            // check for placeholder string
+            case CTE_CHAR_DELIMITER :
+                if ((source[index+1] == syntax->delimiter[1]) &&
+                    (IS_LETTER(source[index+2]))) {
+                    
+                    hash = HASH_INITIAL;
+                    length = 0;
+                    repeat {
+                        hash = HASH_NEXT_CHAR(hash, source[index + 2 + length]);
+                        length++;
+                    } until ((IS_NOT_UNDERSCORE_NOR_ALPHANUM(
+                                  source[index + 2 + length])) ||
+                             (length > CTE_MAX_PLACEHOLDER_LENGTH));
+                    
+                    if ((length <= CTE_MAX_PLACEHOLDER_LENGTH) &&
+                        (source[index + 2 + length] ==
+                         syntax->closing_delimiter[0]) &&
+                        (source[index + 3 + length] ==
+                         syntax->closing_delimiter[1])) {
+                        *s_index = index;
+                        *ident_len = length;
+                        *key = HASH_FINAL(hash);
+                        return true;
+                    } // end if
+                } // end if
+                
+                index++;
+                break; // case
+            
+            // skip template comment
+            case CTE_CHAR_IGNORE_PREFIX :
+                if ((source[index+1] == syntax->ignore_prefix[1]) &&
+                    (CTE_START_OF_LINE(source, index))) {
+                    while ((source[index] != NEWLINE) &&
+                           (source[index] != CSTRING_TERMINATOR))
+                        index++;
+                }
+                else {
+                    index++;
+                } // end if
+                
+                break; // case
+            
+            // end of string
+            case CTE_CHAR_TERMINATOR :
+                *s_index = index;
+                return false;
+            
+            default :
+                index++;
+        } // end switch
+    } // end loop
+} // _next_placeholder
+
+
+// ---------------------------------------------------------------------------
+// private function:  _section_at( syntax, source, length, s_index, len, key )
+// ---------------------------------------------------------------------------
+//
+// Returns true if a properly delimited section opening  starts at index <s_in-
+// dex> of string <source> of length <length>  according to template syntax
+// <syntax>,  passing back the length of its identifier in <ident_len> and its
+// key in <key>.  Returns false otherwise.  The identifier starts at index
+// <s_index> + 3,  the section body at index <s_index> + <ident_len> + 5.
+
+static bool _section_at(const cte_syntax_s *syntax,
+                        const char *source,
+                        size_t s_length,
+                        size_t s_index,
+                        cardinal *ident_len,
+                        kvs_key_t *key) {
+    
+    size_t index;
+    cardinal length;
+    kvs_key_t hash;
+    
+    // bail out if no opening delimiter and section tag followed by letter
+    if ((s_index + 3 >= s_length) ||
+        (source[s_index] != syntax->delimiter[0]) ||
+        (source[s_index + 1] != syntax->delimiter[1]) ||
+        (source[s_index + 2] != CTE_SECTION_OPENING) ||
+        (IS_NOT_LETTER(source[s_index + 3])))
+        return false;
+    
+    index = s_index + 3;
+    hash = HASH_INITIAL;
+    length = 0;
+    repeat {
+        hash = HASH_NEXT_CHAR(hash, source[index]);
+        index++;
+        length++;
+    } until ((index >= s_length) ||
+             (IS_NOT_UNDERSCORE_NOR_ALPHANUM(source[index])) ||
+             (length > CTE_MAX_PLACEHOLDER_LENGTH));
+    
+    // bail out if identifier is too long or not properly delimited
+    if ((length > CTE_MAX_PLACEHOLDER_LENGTH) ||
+        (index + 2 > s_length) ||
+        (source[index] != syntax->closing_delimiter[0]) ||
+        (source[index + 1] != syntax->closing_delimiter[1]))
+        return false;
+    
+    *ident_len = length;
+    *key = HASH_FINAL(hash);
+    return true;
+} // _section_at
+
+
+// ---------------------------------------------------------------------------
+// private function:
+//  _section_end( syntax, source, length, s_index, ident, ident_len, end )
+// ---------------------------------------------------------------------------
+//
+// Searches string <source> of length <length>  from index <s_index>  for the
+// section end matching a section  whose identifier of length <ident_len>  is
+// passed in <ident>,  skipping template comments  and  escape sequences  and
+// counting nested sections of the same name  according to template syntax
+// <syntax>.  If the section end is found,  the index of its opening delimiter
+// is passed back in <body_end> and true is returned.  Returns false otherwise.
+
+static bool _section_end(const cte_syntax_s *syntax,
+                         const char *source,
+                         size_t s_length,
+                         size_t s_index,
+                         const char *ident,
+                         cardinal ident_len,
+                         size_t *body_end) {
+    
+    cardinal depth = 0;
+    
+    while (s_index < s_length) {
+        switch (CTE_CHAR_CLASS(syntax, source[s_index])) {
+            
+            // skip escaped character
+            case CTE_CHAR_ESCAPE :
+                if ((s_index + 1 < s_length) &&
+                    ((CTE_CHAR_CLASS(syntax, source[s_index+1]) ==
+                      CTE_CHAR_ESCAPE) ||
+                     (CTE_CHAR_CLASS(syntax, source[s_index+1]) ==
+                      CTE_CHAR_DELIMITER)))
+                    s_index++;
+                
+                s_index++;
+                break; // case
+            
+            // check for nested section or section end of the same name
+            case CTE_CHAR_DELIMITER :
+                switch (_section_tag_at(syntax,
+                            source, s_length, s_index, ident, ident_len)) {
+                    
+                    case CTE_SECTION_OPENING :
+                        depth++;
+                        s_index = s_index + ident_len + 5;
+                        break; // case
+                    
+                    case CTE_SECTION_CLOSING :
+                        if (depth == 0) {
+                            *body_end = s_index;
+                            return true;
+                        } // end if
+                        
+                        depth--;
+                        s_index = s_index + ident_len + 5;
+                        break; // case
+                    
+                    default :
+                        s_index++;
+                } // end switch
+                
+                break; // case
+            
+            // skip template comment
+            case CTE_CHAR_IGNORE_PREFIX :
+                if ((s_index + 1 < s_length) &&
+                    (source[s_index+1] == syntax->ignore_prefix[1]) &&
+                    (CTE_START_OF_LINE(source, s_index))) {
+                    while ((s_index < s_length) &&
+                           (source[s_index] != NEWLINE))
+                        s_index++;
+                }
+                else {
+                    s_index++;
+                } // end if
+                
+                break; // case
+            
+            default :
+                s_index++;
+        } // end switch
+    } // end while
+    
+    return false;
+} // _section_end
+
+
+// ---------------------------------------------------------------------------
+// private function:
+//  _section_tag_at( syntax, source, length, s_index, ident, ident_len )
+// ---------------------------------------------------------------------------
+//
+// Returns the section tag  if a section opening or section end  whose identi-
+// fier of length <ident_len> matches <ident>  starts at index <s_index>  of
+// string <source> of length <length>  according to template syntax <syntax>.
+// Returns zero otherwise.  The tag is at index <s_index> + 2,  the tag string
+// is <ident_len> + 5 characters long.
+
+static fmacro char _section_tag_at(const cte_syntax_s *syntax,
+                                   const char *source,
+                                   size_t s_length,
+                                   size_t s_index,
+                                   const char *ident,
+                                   cardinal ident_len) {
+    
+    // bail out if tag string would extend past the end of source
+    if (s_index + ident_len + 5 > s_length)
+        return 0;
+    
+    // bail out if tag string is not delimited or identifier does not match
+    if ((source[s_index + 1] != syntax->delimiter[1]) ||
+        ((source[s_index + 2] != CTE_SECTION_OPENING) &&
+         (source[s_index + 2] != CTE_SECTION_CLOSING)) ||
+        (memcmp(&source[s_index + 3], ident, ident_len) != 0) ||
+        (source[s_index + ident_len + 3] != syntax->closing_delimiter[0]) ||
+        (source[s_index + ident_len + 4] != syntax->closing_delimiter[1]))
+        return 0;
+    
+    return source[s_index + 2];
+} // _section_tag_at
+
+
+// ---------------------------------------------------------------------------
+// private function:
+//  _collect_placeholders( set, syntax, source, s_index, table )
+// ---------------------------------------------------------------------------
+//
+// Adds the identifiers  of all placeholders  referenced  in string <source>,
+// starting at index <s_index>,  to placeholder set <set>.  Strings are recog-
+// nised according to template syntax <syntax>.  If NULL is passed
+// in for <table>,  placeholders are  not  followed  and all placeholders are
+// assumed to be undefined.  Otherwise the values of placeholders found in the
+// table are searched in turn,  each only once.  The search follows expansion
+// semantics:  after a defined placeholder it continues past its closing deli-
+// miter, after an undefined one it continues at its closing delimiter, which
+// may open another placeholder string.
+//
+// Returns CTE_STATUS_SUCCESS if successful, otherwise returns the status de-
+// scribing the failure.
+
+static cte_status_t _collect_placeholders(cte_placeholder_set_s *set,
+                                    const cte_syntax_s *syntax,
+                                          const char *source,
+                                          size_t s_index,
+                                          kvs_table_t table) {
+    
+    cte_stack_t stack;
+    cte_stack_status_t s_status;
+    cte_status_t r_status;
+    const char *value;
+    cardinal ident_len;
+    size_t length;
+    kvs_key_t key;
+    bool added;
+    
+    stack = cte_new_stack(0, NULL);
+    
+    // bail out if stack allocation failed
+    if (stack == NULL) {
+        CTE_NOTIFY(CTE_NOTIFICATION_STACK_ALLOCATION_FAILED, source, 0);
+        return CTE_STATUS_ALLOCATION_FAILED;
+    } // end if
+    
+    loop {
+        
+        // return to enclosing value at end of string
+        if (NOT(_next_placeholder(syntax,
+                                  source, &s_index, &ident_len, &key))) {
+            if (cte_stack_number_of_entries(stack) == 0)
+                break;
+            
+            // values in key value tables are terminated, length is unused
+            source = cte_stack_pop_context(stack, &length, &s_index, NULL);
+            continue;
+        } // end if
+        
+        r_status = _add_to_placeholder_set(set,
+                       &source[s_index + 2], ident_len, key, &added);
+        
+        // bail out if set enlargement failed
+        if (r_status != CTE_STATUS_SUCCESS) {
+            cte_dispose_stack(stack);
+            return r_status;
+        } // end if
+        
+        if ((table != NULL) && (kvs_entry_exists(table, key, NULL)))
+            value = kvs_value_for_key(table, key, NULL);
+        else
+            value = NULL;
+        
+        // undefined, continue at closing delimiter
+        if (value == NULL) {
+            s_index = s_index + ident_len + 2;
+        }
+        // defined and seen before, continue past closing delimiter
+        else if (NOT(added)) {
+            s_index = s_index + ident_len + 4;
+        }
+        // defined and new, search its value
+        else {
+            cte_stack_push_context(stack, (char *) source, 0,
+                                   s_index + ident_len + 4, &s_status);
+            
+            // bail out if stack enlargement failed
+            if (s_status != CTE_STACK_STATUS_SUCCESS) {
+                CTE_NOTIFY(CTE_NOTIFICATION_STACK_ENLARGEMENT_FAILED,
+                           source, s_index);
+                cte_dispose_stack(stack);
+                return CTE_STATUS_ALLOCATION_FAILED;
+            } // end if
+            
+            source = value;
+            s_index = 0;
+        } // end if
+    } // end loop
+    
+    cte_dispose_stack(stack);
+    return CTE_STATUS_SUCCESS;
+} // _collect_placeholders
+
+
+// ---------------------------------------------------------------------------
+// private function:  _new_placeholder_set()
+// ---------------------------------------------------------------------------
+//
+// Allocates and returns a new empty placeholder set.  If allocation fails,
+// NULL is returned.
+
+static cte_placeholder_set_s *_new_placeholder_set(void) {
+    cte_placeholder_set_s *set;
+    
+    set = ALLOCATE(sizeof(cte_placeholder_set_s));
+    
+    if (set == NULL)
+        return NULL;
+    
+    set->entry =
+        ALLOCATE(CTE_PLACEHOLDER_SET_SIZE_INITIAL *
+                 sizeof(cte_placeholder_entry_s));
+    set->slot =
+        ALLOCATE(2 * CTE_PLACEHOLDER_SET_SIZE_INITIAL * sizeof(cardinal));
+    
+    if ((set->entry == NULL) || (set->slot == NULL)) {
+        DEALLOCATE(set->entry);
+        DEALLOCATE(set->slot);
+        DEALLOCATE(set);
+        return NULL;
+    } // end if
+    
+    memset(set->slot, 0,
+           2 * CTE_PLACEHOLDER_SET_SIZE_INITIAL * sizeof(cardinal));
+    set->size = CTE_PLACEHOLDER_SET_SIZE_INITIAL;
+    set->count = 0;
+    
+    return set;
+} // _new_placeholder_set
+
+
+// ---------------------------------------------------------------------------
+// private function:  _add_to_placeholder_set( set, ident, length, key, added )
+// ---------------------------------------------------------------------------
+//
+// Adds the identifier starting at <ident> with length <length> and key <key>
+// to placeholder set <set>  unless it is already a member.  Passes back true
+// in <added> if it was added,  false if it was already a member.  Entries are
+// kept in order of insertion.  Their hash slots index an array twice the size
+// of the entry array,  both arrays are doubled when the entry array is full.
+//
+// Returns CTE_STATUS_SUCCESS,  or CTE_STATUS_ALLOCATION_FAILED if the set was
+// full and could not be enlarged.
+
+static cte_status_t _add_to_placeholder_set(cte_placeholder_set_s *set,
+                                            const char *ident,
+                                            cardinal length,
+                                            kvs_key_t key,
+                                            bool *added) {
+    
+    cte_placeholder_entry_s *entry;
+    cardinal *slot_array;
+    cardinal index, mask, slot;
+    
+    mask = 2 * set->size - 1;
+    slot = key & mask;
+    
+    // search for identifier, slots hold entry index plus one, zero if empty
+    while (set->slot[slot] != 0) {
+        entry = &set->entry[set->slot[slot] - 1];
+        
+        if ((entry->key == key) &&
+            (strncmp(entry->identifier, ident, length) == 0) &&
+            (entry->identifier[length] == CSTRING_TERMINATOR)) {
+            *added = false;
+            return CTE_STATUS_SUCCESS;
+        } // end if
+        
+        slot = (slot + 1) & mask;
+    } // end while
+    
+    // enlarge set if full
+    if (set->count == set->size) {
+        entry = REALLOCATE(set->entry,
+                    2 * set->size * sizeof(cte_placeholder_entry_s));
+        
+        if (entry == NULL)
+            return CTE_STATUS_ALLOCATION_FAILED;
+        
+        set->entry = entry;
+        
+        slot_array = ALLOCATE(4 * set->size * sizeof(cardinal));
+        
+        if (slot_array == NULL)
+            return CTE_STATUS_ALLOCATION_FAILED;
+        
+        memset(slot_array, 0, 4 * set->size * sizeof(cardinal));
+        DEALLOCATE(set->slot);
+        set->slot = slot_array;
+        set->size = 2 * set->size;
+        mask = 2 * set->size - 1;
+        
+        // rehash existing entries
+        for (index = 0; index < set->count; index++) {
+            slot = set->entry[index].key & mask;
+            while (set->slot[slot] != 0)
+                slot = (slot + 1) & mask;
+            set->slot[slot] = index + 1;
+        } // end for
+        
+        // find empty slot for new entry
+        slot = key & mask;
+        while (set->slot[slot] != 0)
+            slot = (slot + 1) & mask;
+    } // end if
+    
+    // append new entry
+    entry = &set->entry[set->count];
+    memcpy(entry->identifier, ident, length);
+    entry->identifier[length] = CSTRING_TERMINATOR;
+    entry->key = key;
+    set->count++;
+    set->slot[slot] = set->count;
+    
+    *added = true;
+    return CTE_STATUS_SUCCESS;
+} // _add_to_placeholder_set
+
+
+// ---------------------------------------------------------------------------
+// private function:  _append_to_target( render, str, length )
+// ---------------------------------------------------------------------------
+//
+// Appends <length> characters starting at <str> to the target string of ren-
+// der state <render>,  enlarging the target string as necessary.  If the tar-
+// get is bounded,  characters that do not fit are counted but not written.
+// If the render has a sink,  full chunks are passed to the sink instead of
+// enlarging the target.  If the render is a step render,  characters that do
+// not fit are held back by _append_to_step().  If the render computes a di-
+// gest or is captured,  the characters are fed into the digest or capture.
+// Returns CTE_STATUS_SUCCESS, or the status describing the failure.
+
+static fmacro cte_status_t _append_to_target(cte_render_s *render,
+                                             const char *str,
+                                             size_t length) {
+    char *new_target;
+    size_t new_size;
+    
+    if (render->digest != NULL)
+        cte_digest_update(render->digest, str, length);
+    
+    CTE_CAPTURE_OUTPUT(render, str, length);
+    
+    // bounded target, write what fits and count the rest
+    if (render->bounded) {
+        
+        // step render, write what fits and hold back the rest
+        if (render->step != NULL)
+            return _append_to_step(render, str, length);
+        
+        if (render->t_index < render->t_size)
+            memcpy(&render->target[render->t_index], str,
+                   MIN(length, render->t_size - render->t_index));
+        
+        render->t_index = render->t_index + length;
+        return CTE_STATUS_SUCCESS;
+    } // end if
+    
+    if (render->t_index + length > render->t_size) {
+        
+        // sink, pass on output instead of enlarging
+        if (render->sink != NULL)
+            return _append_to_sink(render, str, length);
+        
+        new_size = render->t_size + CTE_TARGET_SIZE_INCREMENT;
+        
+        if (new_size < render->t_index + length)
+            new_size = render->t_index + length + CTE_TARGET_SIZE_INCREMENT;
+        
+        CTE_TRACE_BEGIN(CTE_TRACE_ENLARGEMENT, NULL, 0);
+        new_target = REALLOCATE_AT(CTE_ALLOC_SITE_TARGET,
+                                   render->target, render->t_size, new_size);
+        CTE_TRACE_END(1);
+        
+        if (new_target == NULL)
+            return CTE_STATUS_ALLOCATION_FAILED;
+        
+        render->target = new_target;
+        render->t_size = new_size;
+    } // end if
+    
+    memcpy(&render->target[render->t_index], str, length);
+    render->t_index = render->t_index + length;
+    
+    return CTE_STATUS_SUCCESS;
+} // _append_to_target
+
+
+// ---------------------------------------------------------------------------
+// private function:  _append_to_step( render, str, length )
+// ---------------------------------------------------------------------------
+//
+// Appends as many of the <length> characters starting at <str>  as fit into
+// the step buffer of render state <render>.  If not all of them fit,  the rest
+// is held back in the step state by reference  and the render is suspended.
+// Returns CTE_STATUS_SUCCESS.
+
+static cte_status_t _append_to_step(cte_render_s *render,
+                                    const char *str,
+                                    size_t length) {
+    size_t fit;
+    
+    fit = MIN(length, render->t_size - render->t_index);
+    
+    if (fit > 0)
+        memcpy(&render->target[render->t_index], str, fit);
+    
+    render->t_index = render->t_index + fit;
+    
+    // hold back what did not fit and suspend
+    if (fit < length) {
+        render->step->pending = &str[fit];
+        render->step->p_length = length - fit;
+        render->step->p_escape = CTE_ESCAPE_NONE;
+        render->suspended = true;
+    } // end if
+    
+    return CTE_STATUS_SUCCESS;
+} // _append_to_step
+
+
+// ---------------------------------------------------------------------------
+// private function:  _init_values( values, table, kvs, resolver, context )
+// ---------------------------------------------------------------------------
+//
+// Initialises value source <values>  to look up placeholder values in place-
+// holder table <table>,  or in key value table <kvs>,  or by calling resolver
+// <resolver> passing it <context>.  Only one of them may be other than NULL.
+
+static fmacro void _init_values(cte_values_s *values,
+                                cte_table_t table,
+                                kvs_table_t kvs,
+                                cte_resolver_f resolver,
+                                void *context) {
+    
+    values->table = table;
+    values->kvs = kvs;
+    values->resolver = resolver;
+    values->context = context;
+    values->cache.entry = NULL;
+    values->outer = NULL;
+    
+    return;
+} // _init_values
+
+
+// ---------------------------------------------------------------------------
+// private function:
+//  _value_for_placeholder( values, ident, len, key, v_len, escape )
+// ---------------------------------------------------------------------------
+//
+// Returns the value for the placeholder whose identifier starts at <ident> in
+// the  template being expanded  and is <length> characters long.  The key for
+// the identifier  must be passed in <key>.  The value is taken from the value
+// source passed in <values>,  its length is passed back in <v_length>  and its
+// escaping mode in <escape>,  which is DEFAULT unless the value was stored in
+// a placeholder table with a mode of its own.
+// Within a section,  the row tables of all enclosing sections are searched
+// first,  innermost first.  Returns NULL if the placeholder is undefined  and
+// CTE_PENDING_VALUE if its value is pending.
+//
+// If the value source is a resolver,  the resolver is only called  the first
+// time  a placeholder is encountered  during a render,  any further lookup of
+// the same placeholder is served from the value source's resolver cache.
+
+static fmacro const char *_value_for_placeholder(cte_values_s *values,
+                                                  const char *ident,
+                                                    cardinal length,
+                                                   kvs_key_t key,
+                                                      size_t *v_length,
+                                                cte_escape_t *escape) {
+    const char *value;
+    
+    // look up placeholder in row tables of enclosing sections
+    while (values->outer != NULL) {
+        value = cte_table_escaped_value_for_key(values->table,
+                                                key, v_length, escape);
+        
+        if (value != NULL)
+            return value;
+        
+        values = values->outer;
+    } // end while
+    
+    // look up placeholder in placeholder table
+    if (values->table != NULL)
+        return cte_table_escaped_value_for_key(values->table,
+                                               key, v_length, escape);
+    
+    // values from other sources have no escaping mode of their own
+    *escape = CTE_ESCAPE_DEFAULT;
+    
+    // look up placeholder in key value table
+    if (values->kvs != NULL) {
+        if (NOT(kvs_entry_exists(values->kvs, key, NULL)))
+            return NULL;
+        
+        value = kvs_value_for_key(values->kvs, key, NULL);
+        *v_length = strlen(value);
+        return value;
+    } // end if
+    
+    // look up placeholder via resolver, resolving on cache miss
+    return _resolve_placeholder(values, ident, length, key, v_length);
+} // _value_for_placeholder
+
+
+// ---------------------------------------------------------------------------
+// private function:  _resolve_placeholder( values, ident, len, key, v_len )
+// ---------------------------------------------------------------------------
+//
+// Returns the value for the placeholder whose identifier starts at <ident> in
+// the  template being expanded  and is <length> characters long,  passing back
+// the length of the value in <v_length>.  The value is obtained from the re-
+// solver cache of value source <values> or,  if the placeholder has not been
+// resolved before during the render,  by calling the value source's resolver
+// function.  Results are entered into the resolver cache,  this includes un-
+// defined placeholders for which the resolver returned NULL,  but not pending
+// placeholders for which it returned CTE_PENDING_VALUE.
+//
+// The resolver cache is an open addressing hash table  keyed by  placeholder
+// key.  It is allocated on first use and doubled in size whenever it is found
+// three quarters full.  If allocation fails,  the resolver is called without
+// caching the result.  Returns NULL if the placeholder is undefined.
+
+static const char *_resolve_placeholder(cte_values_s *values,
+                                         const char *ident,
+                                           cardinal length,
+                                          kvs_key_t key,
+                                             size_t *v_length) {
+    
+    #define this_cache (&values->cache)
+    cte_resolver_cache_entry_s *entry;
+    char identifier[CTE_MAX_PLACEHOLDER_LENGTH + 1];
+    const char *value;
+    cardinal mask, slot;
+    
+    // allocate cache on first use
+    if (this_cache->entry == NULL) {
+        this_cache->entry =
+            _new_resolver_cache(CTE_RESOLVER_CACHE_SIZE_INITIAL);
+        if (this_cache->entry != NULL) {
+            this_cache->size = CTE_RESOLVER_CACHE_SIZE_INITIAL;
+            this_cache->count = 0;
+        } // end if
+    }
+    // enlarge cache when three quarters full
+    else if (CTE_RESOLVER_CACHE_FULL(this_cache)) {
+        _enlarge_resolver_cache(this_cache);
+    } // end if
+    
+    // search cache for placeholder
+    if (this_cache->entry != NULL) {
+        mask = this_cache->size - 1;
+        slot = key & mask;
+        entry = &this_cache->entry[slot];
+        
+        while (entry->identifier[0] != CSTRING_TERMINATOR) {
+            
+            // return cached value if identifier matches
+            if ((entry->key == key) &&
+                (strncmp(entry->identifier, ident, length) == 0) &&
+                (entry->identifier[length] == CSTRING_TERMINATOR)) {
+                *v_length = entry->length;
+                return entry->value;
+            } // end if
+            
+            slot = (slot + 1) & mask;
+            entry = &this_cache->entry[slot];
+        } // end while
+    }
+    else /* no cache */ {
+        entry = NULL;
+    } // end if
+    
+    // resolvers are passed a terminated copy of the identifier
+    memcpy(identifier, ident, length);
+    identifier[length] = CSTRING_TERMINATOR;
+    
+    value = values->resolver(identifier, key, values->context);
+    
+    // pending values are not cached,  the resolver is called again
+    if (value == CTE_PENDING_VALUE) {
+        *v_length = 0;
+        return value;
+    } // end if
+    
+    if (value != NULL)
+        *v_length = strlen(value);
+    
+    // bail out if there is no room to enter the result into the cache
+    if ((entry == NULL) || (CTE_RESOLVER_CACHE_FULL(this_cache)))
+        return value;
+    
+    // enter result into empty slot found during search
+    memcpy(entry->identifier, identifier, length + 1);
+    entry->key = key;
+    entry->value = value;
+    entry->length = (value != NULL) ? *v_length : 0;
+    this_cache->count++;
+    
+    return value;
+    
+    #undef this_cache
+} // _resolve_placeholder
+
+
+// ---------------------------------------------------------------------------
+// private function:  _rows_for_placeholder( values, key, count )
+// ---------------------------------------------------------------------------
+//
+// Returns the row tables  stored for the section  whose key is passed in
+// <key>  and passes back the number of rows in <count>.  The placeholder
+// tables of value source <values>  and of its enclosing value sources  are
+// searched,  innermost first.  Rows can only be stored in placeholder tables,
+// returns NULL if no rows are found.
+
+static const cte_table_t *_rows_for_placeholder(cte_values_s *values,
+                                                kvs_key_t key,
+                                                cardinal *count) {
+    const cte_table_t *row;
+    
+    while (values != NULL) {
+        row = cte_table_rows_for_key(values->table, key, count);
+        
+        if (row != NULL)
+            return row;
+        
+        values = values->outer;
+    } // end while
+    
+    return NULL;
+} // _rows_for_placeholder
+
+
+// ---------------------------------------------------------------------------
+// private function:  _new_resolver_cache( size )
+// ---------------------------------------------------------------------------
+//
+// Allocates  and returns  an array of <size> empty resolver cache entries.  A
+// cache entry is empty if the first character of its identifier is  '\0'.  If
+// allocation fails, NULL is returned.
+
+static cte_resolver_cache_entry_s *_new_resolver_cache(cardinal size) {
+    cte_resolver_cache_entry_s *entry;
+    cardinal index;
+    
+    entry = ALLOCATE(size * sizeof(cte_resolver_cache_entry_s));
+    
+    if (entry == NULL)
+        return NULL;
+    
+    for (index = 0; index < size; index++)
+        entry[index].identifier[0] = CSTRING_TERMINATOR;
+    
+    return entry;
+} // _new_resolver_cache
+
+
+// ---------------------------------------------------------------------------
+// private function:  _enlarge_resolver_cache( cache )
+// ---------------------------------------------------------------------------
+//
+// Doubles the size of resolver cache <cache>  and rehashes all its entries.
+// If allocation fails, the cache is left unmodified.
+
+static void _enlarge_resolver_cache(cte_resolver_cache_s *cache) {
+    cte_resolver_cache_entry_s *new_entry;
+    cardinal new_size, index, mask, slot;
+    
+    new_size = cache->size * 2;
+    new_entry = _new_resolver_cache(new_size);
+    
+    // bail out if allocation failed
+    if (new_entry == NULL)
+        return;
+    
+    mask = new_size - 1;
+    
+    // rehash all entries into new array
+    for (index = 0; index < cache->size; index++) {
+        if (cache->entry[index].identifier[0] != CSTRING_TERMINATOR) {
+            slot = cache->entry[index].key & mask;
+            while (new_entry[slot].identifier[0] != CSTRING_TERMINATOR)
+                slot = (slot + 1) & mask;
+            new_entry[slot] = cache->entry[index];
+        } // end if
+    } // end for
+    
+    DEALLOCATE(cache->entry);
+    cache->entry = new_entry;
+    cache->size = new_size;
+    
+    return;
+} // _enlarge_resolver_cache
+
+
+// ---------------------------------------------------------------------------
+// private function:  _append_char_to_target( render, ch )
+// ---------------------------------------------------------------------------
+//
+// Appends character <ch> to the target string of render state <render>,  en-
+// larging the target string if necessary.  If the target is bounded and the
+// character does not fit,  it is counted but not written.  If the render has
+// a sink,  a full chunk is passed to the sink instead of enlarging the target.
+// If the render computes a digest or is captured,  the character is fed into
+// the digest or capture.  Returns CTE_STATUS_SUCCESS,  or the status descri-
+// bing the failure.
+//
+// NOTE: This primitive does  NOT  implicitly terminate the target string.  To
+// terminate the target string,  this primitive must be called passing '\0' in
+// parameter <ch>.
+
+static fmacro cte_status_t _append_char_to_target(cte_render_s *render,
+                                                  char ch) {
+    char *new_target;
+    size_t new_size;
+    
+    if (render->digest != NULL)
+        cte_digest_update(render->digest, &ch, 1);
+    
+    CTE_CAPTURE_OUTPUT(render, &ch, 1);
+    
+    // bounded target, write if it fits and count it
+    if (render->bounded) {
+        if (render->t_index < render->t_size)
+            render->target[render->t_index] = ch;
+        
+        render->t_index++;
+        return CTE_STATUS_SUCCESS;
     } // end if
     
+    if (render->t_index >= render->t_size) {
+        
+        // sink, pass on output instead of enlarging
+        if (render->sink != NULL)
+            return _append_to_sink(render, &ch, 1);
+        
+        new_size = render->t_size + CTE_TARGET_SIZE_INCREMENT;
+        CTE_TRACE_BEGIN(CTE_TRACE_ENLARGEMENT, NULL, 0);
+        new_target = REALLOCATE_AT(CTE_ALLOC_SITE_TARGET,
+                                   render->target, render->t_size, new_size);
+        CTE_TRACE_END(1);
+        
+        if (new_target == NULL)
+            return CTE_STATUS_ALLOCATION_FAILED;
+        
+        render->target = new_target;
+        render->t_size = new_size;
+    } // end if
     
-    nesting_level = 0;
+    render->target[render->t_index] = ch;
+    render->t_index++;
     
-    source = (char *) template;
-    s_index = 0;
-    t_index = 0;
+    return CTE_STATUS_SUCCESS;
+} // _append_char_to_target
+
+
+// ---------------------------------------------------------------------------
+// private function:  _append_escaped( render, escape, str, length )
+// ---------------------------------------------------------------------------
+//
+// Appends the <length> characters at <str>  escaped in escaping mode <escape>
+// to the target string of render state <render>.  Runs of characters that need
+// no escaping are found by cte_escape_scan() and appended in one piece,  each
+// character that does is replaced by its escape sequence.  If a step render is
+// suspended,  the characters not yet appended are held back  with <escape>,
+// the part of an escape sequence that did not fit is held back in the stash.
+//
+// Returns CTE_STATUS_SUCCESS  if the characters were appended,  otherwise the
+// status returned by _append_to_target().
+
+static cte_status_t _append_escaped(cte_render_s *render,
+                                    cte_escape_t escape,
+                                    const char *str,
+                                    size_t length) {
     
-    // recursively expand source strings
-    repeat {
+    char sequence[CTE_ESCAPE_MAX_LENGTH];
+    size_t index = 0, run;
+    cardinal seq_length;
+    cte_step_s *step = render->step;
+    cte_status_t r_status;
+    
+    while (index < length) {
         
-        // copy all characters until special character is found
-        while ((source[s_index] != BACKSLASH) &&
-               (source[s_index] != CTE_DELIMITER_CHAR_1) &&
-               (source[s_index] != CTE_IGNORE_PFX_CHAR_1) &&
-               (source[s_index] != CSTRING_TERMINATOR)) {
+        // append run of characters that need no escaping
+        run = cte_escape_scan(escape, &str[index], length - index);
+        
+        if (run > 0) {
+            r_status = _append_to_target(render, &str[index], run);
             
-            // copy char to target, enlarge if necessary
-            target = _update_target(source[s_index],
-                                    target, t_index, &t_size, &r_status);
+            if (r_status != CTE_STATUS_SUCCESS)
+                return r_status;
             
-            // bail out if allocation failed
-            if (r_status == CTE_STATUS_ALLOCATION_FAILED)
-                BAILOUT(enlargement_failed);
+            // step suspended, hold back rest of the run and all that follows
+            if (render->suspended) {
+                step->p_length = length - (size_t) (step->pending - str);
+                step->p_escape = escape;
+                return CTE_STATUS_SUCCESS;
+            } // end if
             
-            s_index++;
-            t_index++;
-        } // end while
+            index = index + run;
+            
+            if (index >= length)
+                break;
+        } // end if
         
-        // handle special characters
-        switch (source[s_index]) {
-                
-                // backslash may indicate escaped delimiter
-            case BACKSLASH :
-                
-                switch (source[s_index+1]) {
-                        
-                    // found backslash escaped backslash
-                    case BACKSLASH :
-                    // copy leading backslash to target, enlarge if necessary
-                        target = _update_target(source[s_index],
-                                        target, t_index, &t_size, &r_status);
-                        
-                        // bail out if allocation failed
-                        if (r_status == CTE_STATUS_ALLOCATION_FAILED)
-                            BAILOUT(enlargement_failed);
-                        
-                        s_index++;
-                        t_index++;
-                        
-                        break; // case
-                        
-                        // found backslash escaped delimiter
-                    case CTE_DELIMITER_CHAR_1 :
-                        // skip leading backslash
-                        s_index++;
-                        
-                        break; // case
-                        
-                        // found ignore prefix following backslash
-                    case CTE_IGNORE_PFX_CHAR_1 :
-                        // check if leading backslash is at first row of line
-                        if (CTE_START_OF_LINE(source, s_index))
-                            // skip leading backslash
-                            s_index++;
-                        
-                        break; // case
-                } // end switch
-                
-                // copy remaining character to target, enlarge if necessary
-                target = _update_target(source[s_index],
-                                        target, t_index, &t_size, &r_status);
-                
-                // bail out if allocation failed
-                if (r_status == CTE_STATUS_ALLOCATION_FAILED)
-                    BAILOUT(enlargement_failed);
-                
-                s_index++;
-                t_index++;
-                
-                break; // case
-                
-                // delimiter char may indicate template engine placeholder
-            case CTE_DELIMITER_CHAR_1:
-                
-                // check for opening delimiter followed by letter
-                if ((source[s_index+1] == CTE_DELIMITER_CHAR_2) &&
-                    (IS_LETTER(source[s_index+2]))) {
-                    
-                    // calculate key for identifier following delimiter
-                    s_index = s_index + 2;
-                    key = HASH_INITIAL;
-                    ident_len = 0;
-                    
-                    // calculate key of identifier
-                    repeat {
-                        key = HASH_NEXT_CHAR(key, source[s_index]);
-                        s_index++;
-                        ident_len++;
-                    } until ((IS_NOT_UNDERSCORE_NOR_ALPHANUM(source[s_index]))
-                             || (ident_len > CTE_MAX_PLACEHOLDER_LENGTH));
-                    key = HASH_FINAL(key);
-                    
-                    // check if identifier is a placeholder
-                    if ((ident_len <= CTE_MAX_PLACEHOLDER_LENGTH) &&
-                        (kvs_entry_exists(placeholders, key, NULL)) &&
-                        (source[s_index] == CTE_DELIMITER_CHAR_1) &&
-                        (source[s_index+1] == CTE_DELIMITER_CHAR_2)) {
-                        
-                        // bail out if nesting limit is reached
-                        if (nesting_level >= CTE_MAX_NESTING_LEVEL)
-                            BAILOUT(nesting_limit_exceeded);
-                        
-                        // save source and index to recursion stack
-                        cte_stack_push_context(stack, source, s_index, NULL);
-                        
-                        // set source and index to content of placeholder
-                        source = kvs_value_for_key(placeholders, key, NULL);
-                        s_index = 0;
-                        
-                        // update template nesting level
-                        nesting_level++;
-                    }
-                    else /* identifier is not a placeholder */ {
-                        
-                        // restore source index to delimiter position 
-                        s_index = s_index - ident_len - 2;
-                        
-                        CTE_NOTIFY(CTE_NOTIFICATION_UNDEFINED_PLACEHOLDER,
-                                   source, s_index);
-                        
-                        // copy char to target, enlarge if necessary
-                        target = _update_target(source[s_index],
-                                        target, t_index, &t_size, &r_status);
-                        
-                        // bail out if allocation failed
-                        if (r_status == CTE_STATUS_ALLOCATION_FAILED)
-                            BAILOUT(enlargement_failed);
-                        
-                        s_index++;
-                        t_index++;
-                    } // end if
-                }
-                else /* no opening delimiter followed by letter found */ {
-                    // copy char to target, enlarge if necessary
-                    target = _update_target(source[s_index],
-                                        target, t_index, &t_size, &r_status);
-                    
-                    // bail out if allocation failed
-                    if (r_status == CTE_STATUS_ALLOCATION_FAILED)
-                        BAILOUT(enlargement_failed);
-                    
-                    s_index++;
-                    t_index++;
-                } // end if
-                
-                break; // case
-                
-                // prefix char may indicate template engine comment line
-            case CTE_IGNORE_PFX_CHAR_1:
-                // check for ignore line prefix at first coloumn
-                if ((source[s_index+1] == CTE_IGNORE_PFX_CHAR_2) &&
-                    CTE_START_OF_LINE(source, s_index)) {
-                    
-                    // skip all characters until line end without copying
-                    while ((source[s_index] != NEWLINE) &&
-                           (source[s_index] != CSTRING_TERMINATOR)) {
-                        s_index++;
-                    } // end while
-                }
-                else /* no ignore line prefix found at first coloumn */ {
-                    // copy char to target, enlarge if necessary
-                    target = _update_target(source[s_index],
-                                        target, t_index, &t_size, &r_status);
-                    
-                    // bail out if allocation failed
-                    if (r_status == CTE_STATUS_ALLOCATION_FAILED)
-                        BAILOUT(enlargement_failed);
-                    
-                    s_index++;
-                    t_index++;
-                } // end if
-                
-                break; // case
-                
-                // C string terminator indicates end of template string
-            case CSTRING_TERMINATOR:
-                
-                // return from recursion unless nesting level is zero
-                if (nesting_level > 0) {
-                    // restore source and index from recursion stack
-                    source = cte_stack_pop_context(stack, &s_index, NULL);
-                    // update template nesting level
-                    nesting_level--;
-                } // end if
-                
-                break; // case
-        } // end switch
+        // append escape sequence for character that needs escaping
+        seq_length = cte_escape_char(escape, str[index], sequence);
+        r_status = _append_to_target(render, sequence, seq_length);
+        
+        if (r_status != CTE_STATUS_SUCCESS)
+            return r_status;
         
-    } until ((source[s_index] == CSTRING_TERMINATOR) && (nesting_level == 0));
+        // step suspended, stash rest of sequence and hold back what follows
+        if (render->suspended) {
+            memcpy(step->stash, step->pending, step->p_length);
+            step->stash_index = 0;
+            step->stash_length = (cardinal) step->p_length;
+            step->pending = &str[index + 1];
+            step->p_length = length - index - 1;
+            step->p_escape = escape;
+            return CTE_STATUS_SUCCESS;
+        } // end if
+        
+        index++;
+    } // end while
     
-    // clean up
+    return CTE_STATUS_SUCCESS;
+} // _append_escaped
+
+
+// ---------------------------------------------------------------------------
+// private function:  _value_escape( render, escape )
+// ---------------------------------------------------------------------------
+//
+// Returns the escaping mode  in which a value with escaping mode <escape>  is
+// escaped by render state <render>.  The mode of the value takes precedence
+// over that of the render,  which takes precedence over that of its syntax.
+
+static fmacro uint8_t _value_escape(cte_render_s *render,
+                                    cte_escape_t escape) {
     
-    // terminate target string, enlarge if necessary
-    target = _update_target(CSTRING_TERMINATOR,
-                            target, t_index, &t_size, &r_status);
+    if (escape != CTE_ESCAPE_DEFAULT)
+        return escape;
     
-    // bail out if allocation failed
-    if (r_status == CTE_STATUS_ALLOCATION_FAILED)
-        BAILOUT(enlargement_failed);
+    if (render->escape != CTE_ESCAPE_DEFAULT)
+        return render->escape;
     
-    /* NORMAL TERMINATION */
+    return render->syntax->escape;
+} // _value_escape
+
 
-    CTE_NOTIFY(CTE_NOTIFICATION_TARGET_SIZE_INFO, target, t_size);
+// ---------------------------------------------------------------------------
+// private function:  _is_syntax_string( str )
+// ---------------------------------------------------------------------------
+//
+// Returns true if string <str>  consists of exactly two printable characters
+// that are neither whitespace,  backslash,  underscore,  letter nor digit and
+// may therefore be used as a delimiter or ignore prefix, otherwise false.
+
+static fmacro bool _is_syntax_string(const char *str) {
+    cardinal index;
+    char ch;
     
-    // return expanded string and status to caller
-    ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
-    DEALLOCATE(stack);
-    return target;
+    for (index = 0; index < 2; index++) {
+        ch = str[index];
+        
+        if ((IS_NOT_7BIT_ASCII(ch)) || (IS_CONTROL(ch)) ||
+            (ch == WHITESPACE) || (ch == BACKSLASH) ||
+            (ch == UNDERSCORE) || (IS_ALPHANUM(ch)))
+            return false;
+    } // end for
     
-    /* ERROR HANDLING */
+    return (str[2] == CSTRING_TERMINATOR);
+} // _is_syntax_string
+
+
+// ---------------------------------------------------------------------------
+// private function:
+//  _init_syntax( syntax, delimiter, closing_delimiter, prefix )
+// ---------------------------------------------------------------------------
+//
+// Initialises template syntax <syntax>  with opening delimiter <delimiter>,
+// closing delimiter <closing_delimiter> and ignore prefix <prefix>,  all of
+// which must have been validated,  and builds its character class table.  The
+// table marks the terminator,  the backslash and the first characters of the
+// opening delimiter and ignore prefix,  all other characters are ordinary.  The
+// syntax does not escape output.
+
+static void _init_syntax(cte_syntax_s *syntax,
+                         const char *delimiter,
+                         const char *closing_delimiter,
+                         const char *prefix) {
     
-    ON_ERROR(enlargement_failed) :
-        CTE_NOTIFY(CTE_NOTIFICATION_TARGET_ENLARGEMENT_FAILED,
-                   source, s_index);
-        DEALLOCATE(stack);
-        ASSIGN_BY_REF(status, CTE_STATUS_ALLOCATION_FAILED);
-        return target;
+    memcpy(syntax->delimiter, delimiter, 3);
+    memcpy(syntax->closing_delimiter, closing_delimiter, 3);
+    memcpy(syntax->ignore_prefix, prefix, 3);
     
-    ON_ERROR(nesting_limit_exceeded) :
-        CTE_NOTIFY(CTE_NOTIFICATION_NESTING_LIMIT_EXCEEDED,
-                   source, s_index);
-        DEALLOCATE(target);
-        DEALLOCATE(stack);
-        ASSIGN_BY_REF(status, CTE_STATUS_NESTING_LIMIT_EXCEEDED);
-        return NULL;
-} // cte_string_from_template
-
+    memset(syntax->char_class, CTE_CHAR_ORDINARY, sizeof(syntax->char_class));
+    
+    CTE_CHAR_CLASS(syntax, CSTRING_TERMINATOR) = CTE_CHAR_TERMINATOR;
+    CTE_CHAR_CLASS(syntax, BACKSLASH) = CTE_CHAR_ESCAPE;
+    CTE_CHAR_CLASS(syntax, delimiter[0]) = CTE_CHAR_DELIMITER;
+    CTE_CHAR_CLASS(syntax, prefix[0]) = CTE_CHAR_IGNORE_PREFIX;
+    
+    syntax->escape = CTE_ESCAPE_NONE;
+    
+    return;
+} // _init_syntax
 
-// ===========================================================================
-// P R I V A T E   F U N C T I O N   I M P L E M E N T A T I O N S
-// ===========================================================================
 
 // ---------------------------------------------------------------------------
-// private function:  _update_target( ch, initial_str, index, size, status)
+// private function:  _diagnose( render, notification, str, index )
 // ---------------------------------------------------------------------------
 //
-// Writes a single character <char_to_add> at position <index> into the target
-// string,  pointed to by <initial_target>.  The target string must be a dyna-
-// mically allocated string  and its allocation size must be passed in <size>.
-// If <index> is equal to or greater than <size>,  then the target string will
-// be  dynamically enlarged  by the number of bytes  as defined  in file CTE.c
-// by constant CTE_TARGET_SIZE_INCREMENT.  If the  target string  has been en-
-// larged,  its  new allocation size  is passed back  in <size>.  A pointer to
-// the  updated  target  string  is returned  as the  function result.  In the
-// event that enlargement failed,  the target string is deallocated  and  NULL
-// is returned.
-//
-// NOTE: This primitive does  NOT  implicitly terminate the target string.  To
-// terminate the target string,  this primitive must be called passing '\0' in
-// parameter <char_to_add>.
+// Passes a diagnostic  for notification <notification>  at index <index>  of
+// string <str>  to the installed diagnostic handler.  If <render> is not NULL,
+// the diagnostic describes the nesting of render state <render>,  otherwise it
+// only describes the position within <str>.  No position is determined for
+// size information, whose index is a size.
+
+static void _diagnose(cte_render_s *render,
+                      cte_notification_t notification,
+                      const char *str,
+                      size_t index) {
+    
+    cte_diagnostic_t diagnostic;
+    cte_template_s *compiled = NULL;
+    cte_stack_size_t entries = 0;
+    const char *outer;
+    size_t o_length, o_index;
+    cardinal ident_len;
+    
+    diagnostic.notification = notification;
+    diagnostic.str = str;
+    diagnostic.index = index;
+    diagnostic.position.line = 0;
+    diagnostic.position.col = 0;
+    diagnostic.nesting_level = 0;
+    diagnostic.context = render;
+    
+    if (render != NULL) {
+        compiled = render->compiled;
+        entries = cte_stack_number_of_entries(render->stack);
+        diagnostic.nesting_level = entries;
+        
+        if (render->segment != NULL)
+            diagnostic.nesting_level++;
+    } // end if
+    
+    if ((notification != CTE_NOTIFICATION_TARGET_SIZE_INFO) && (str != NULL))
+        diagnostic.position = _position_of(str, index, compiled);
+    
+    // locate outermost placeholder within the template
+    if (diagnostic.nesting_level == 0) {
+        diagnostic.template_position = diagnostic.position;
+    }
+    else if (render->segment != NULL) {
+        diagnostic.template_position =
+            _position_of(compiled->source, render->segment->offset, compiled);
+    }
+    else /* outermost placeholder was saved on the stack */ {
+        outer = cte_stack_context_at(render->stack,
+                                     0, &o_length, &o_index, NULL);
+        _identifier_before(outer, o_index - 2, &ident_len);
+        diagnostic.template_position =
+            _position_of(outer, o_index - ident_len - 4, compiled);
+    } // end if
+    
+    _cte_diagnose(&diagnostic);
+    
+    return;
+} // _diagnose
+
+
+// ---------------------------------------------------------------------------
+// private function:  _position_of( str, index, compiled )
+// ---------------------------------------------------------------------------
 //
-// The status of the operation  is passed back in <status>,  unless  NULL  was
-// passed in for <status>.
+// Returns the line and coloumn  of index <index>  within string <str>,  both
+// counted from one.  If <str> is the source of compiled template <compiled>,
+// the line is found by binary search of its line end index,  otherwise line
+// ends preceding <index> are counted.
+
+static long_file_pos_t _position_of(const char *str,
+                                    size_t index,
+                                    cte_template_s *compiled) {
+    
+    long_file_pos_t position;
+    const char *line_end;
+    cardinal lower, upper, middle;
+    size_t line_start;
+    
+    if ((compiled != NULL) && (str == compiled->source)) {
+        
+        // find number of line ends preceding index
+        lower = 0;
+        upper = compiled->line_end_count;
+        while (lower < upper) {
+            middle = lower + (upper - lower) / 2;
+            
+            if (compiled->line_end[middle] < index)
+                lower = middle + 1;
+            else
+                upper = middle;
+        } // end while
+        
+        line_start = (lower > 0) ? compiled->line_end[lower - 1] + 1 : 0;
+    }
+    else /* count line ends */ {
+        lower = 0;
+        line_start = 0;
+        line_end = memchr(str, NEWLINE, index);
+        
+        while (line_end != NULL) {
+            lower++;
+            line_start = line_end + 1 - str;
+            line_end = memchr(line_end + 1, NEWLINE, index - line_start);
+        } // end while
+    } // end if
+    
+    position.line = lower + 1;
+    position.col = (uint32_t) (index - line_start + 1);
+    
+    return position;
+} // _position_of
+
+
+// ---------------------------------------------------------------------------
+// private function:  _identifier_before( str, end, length )
+// ---------------------------------------------------------------------------
 //
-// pre-conditions:
-//  o  initial_target  must point to a dynamically allocated character string
-//  o  char_to_add  must contain the character to be added to the string
-//  o  index must not be larger than size + CTE_TARGET_SIZE_INCREMENT
-//  o  size  must point to a cardinal number containing the current allocation
-//     size of the string
-//  o  status  must either be NULL or point to a variable of type cte_status_t
+// Returns a pointer to the identifier ending before index <end> of string <str>
+// and passes back its length in <length>.  The identifier must be preceded by
+// an opening delimiter,  whose characters are never identifier characters.
+
+static const char *_identifier_before(const char *str,
+                                      size_t end,
+                                      cardinal *length) {
+    size_t start = end;
+    
+    while ((start > 0) &&
+           ((str[start - 1] == UNDERSCORE) || (IS_ALPHANUM(str[start - 1]))))
+        start--;
+    
+    *length = (cardinal) (end - start);
+    
+    return &str[start];
+} // _identifier_before
+
+
+// ---------------------------------------------------------------------------
+// private function:  _is_metered( render )
+// ---------------------------------------------------------------------------
 //
-// post-conditions:
-//  o  char_to_add has been written to position index in string initial_target
-//  o  if the target string has been enlarged,  then the  new  allocation size
-//     is passed back in size, otherwise size remains unmodified
-//  o  if status is not NULL, then CTE_STATUS_SUCCESS is passed back in status
-//  o  a pointer to the modified (and possibly enlarged) string is returned
+// Returns true if events of render state <render>  are passed to the notifi-
+// cation and diagnostic handlers and counted in the engine metrics,  that is
+// unless it is a sizing render,  whose events are reported by the render that
+// follows it.  Events outside of a render are passed in with NULL for <render>
+// and are always reported.
+
+static fmacro bool _is_metered(const cte_render_s *render) {
+    
+    return ((render == NULL) || (NOT(render->sizing)));
+} // _is_metered
+
+#ifdef CTE_WITH_CAPTURE
+
+// ---------------------------------------------------------------------------
+// private function:
+//  _capture_value( render, ident, length, key, value, v_length, escape )
+// ---------------------------------------------------------------------------
 //
-// error-conditions:
-//  o  if target string enlargement failed, then the string passed in via
-//     initial_target string is deallocated, size is not modified,
-//     CTE_STATUS_ALLOCATION_FAILED is passed back in status and
-//     NULL is returned
+// Records the value <value> of <v_length> characters  that was looked up for
+// the placeholder whose identifier starts at <ident>,  is <length> characters
+// long and has key <key>  in the capture record of render state <render>.  A
+// pending value is recorded as undefined,  as which the render treats it.  A
+// value with escaping mode <escape> of its own cannot be replayed,  the cap-
+// ture record is discarded.
 
-static fmacro char *_update_target(char char_to_add,
-                                   char *initial_target,
-                                   cardinal index,
-                                   cardinal *size,
-                                   cte_status_t *status) {
-    char *new_target;
-    cardinal new_size;
+static void _capture_value(cte_render_s *render,
+                           const char *ident,
+                           cardinal length,
+                           kvs_key_t key,
+                           const char *value,
+                           size_t v_length,
+                           cte_escape_t escape) {
     
-    if (index >= *size) {
-        new_size = *size + CTE_TARGET_SIZE_INCREMENT;
-        new_target = REALLOCATE(initial_target, new_size);
-        
-        if (new_target != NULL) {
-            *size = new_size;
-        }
-        else /* reallocation failed */ {
-            ASSIGN_BY_REF(status, CTE_STATUS_ALLOCATION_FAILED);
-            return initial_target;
-        } // end if
+    if (value == CTE_PENDING_VALUE)
+        value = NULL;
+    
+    // bail out if value has an escaping mode of its own
+    if ((value != NULL) && (escape != CTE_ESCAPE_DEFAULT)) {
+        CTE_CAPTURE_DISCARD(render);
+        return;
     } // end if
     
-    new_target[index] = char_to_add;
-    ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
+    cte_capture_value(render->capture, key, ident, length, value, v_length);
+    
+    return;
+} // _capture_value
+
+
+// ---------------------------------------------------------------------------
+// private function:  _end_capture( render, r_status )
+// ---------------------------------------------------------------------------
+//
+// Ends the capture of render state <render>  after an expansion  that ended
+// with status <r_status>.  The render is recorded if it was successful,  used
+// a syntax equal to the built-in syntax and was not escaped,  since only such
+// renders can be replayed,  otherwise its capture record is discarded.  A
+// render of a compiled template is recorded as such.
+
+static void _end_capture(cte_render_s *render, cte_status_t r_status) {
     
-    return new_target;
-} // _update_target
+    if ((r_status != CTE_STATUS_SUCCESS) ||
+        (render->escape != CTE_ESCAPE_DEFAULT) ||
+        ((render->syntax != &_cte_default_syntax) &&
+         (memcmp(render->syntax, &_cte_default_syntax,
+                 sizeof(cte_syntax_s)) != 0)))
+        cte_capture_discard(render->capture);
+    else
+        cte_capture_end(render->capture, render->c_template,
+                        render->c_length, (render->compiled != NULL));
+    
+    render->capture = NULL;
+    
+    return;
+} // _end_capture
+
+#endif /* CTE_WITH_CAPTURE */
 
 
 // END OF FILE
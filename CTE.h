@@ -52,7 +52,17 @@
 #define CTE_H
 
 
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #include "../KVS/KVS.h"
+#include "cte_table.h"
+#include "cte_escape.h"
+#include "cte_digest.h"
+#include "cte_histogram.h"
 
 
 // ---------------------------------------------------------------------------
@@ -69,6 +79,45 @@
 #define CTE_MAX_NESTING_LEVEL 65535
 
 
+// ---------------------------------------------------------------------------
+// Maximum section nesting depth
+// ---------------------------------------------------------------------------
+
+#define CTE_MAX_SECTION_DEPTH 64
+
+
+// ---------------------------------------------------------------------------
+// Template nesting level up to which rendering does not allocate stack space
+// ---------------------------------------------------------------------------
+
+#define CTE_RENDER_STACK_SIZE 16
+
+
+// ---------------------------------------------------------------------------
+// Default chunk size for rendering to a sink
+// ---------------------------------------------------------------------------
+
+#define CTE_SINK_CHUNK_SIZE (16*1024) /* 16 KBytes */
+
+
+// ---------------------------------------------------------------------------
+// Number of expansions between deadline checks of renders with a budget
+// ---------------------------------------------------------------------------
+
+#define CTE_DEADLINE_CHECK_INTERVAL 64 /* expansions */
+
+
+// ---------------------------------------------------------------------------
+// Maximum length of templates to be compiled
+// ---------------------------------------------------------------------------
+//
+// Compiled templates locate their segments  by 32-bit offsets.  Longer tem-
+// plates are expanded from their source,  whose length is only limited by the
+// address space,  as are the lengths of placeholder values and of the output.
+
+#define CTE_MAX_COMPILED_LENGTH 0xfffffff0 /* almost 4 GBytes */
+
+
 // ---------------------------------------------------------------------------
 // Status codes
 // ---------------------------------------------------------------------------
@@ -79,6 +128,15 @@ typedef /* cte_status_t */ enum {
     CTE_STATUS_INVALID_PLACEHOLDERS,
     CTE_STATUS_ALLOCATION_FAILED,
     CTE_STATUS_NESTING_LIMIT_EXCEEDED,
+    CTE_STATUS_INVALID_TARGET,
+    CTE_STATUS_SINK_FAILED,
+    CTE_STATUS_INVALID_SYNTAX,
+    CTE_STATUS_FILE_FAILED,
+    CTE_STATUS_INVALID_STATE,
+    CTE_STATUS_UNAVAILABLE,
+    CTE_STATUS_OUTPUT_LIMIT_EXCEEDED,
+    CTE_STATUS_EXPANSION_LIMIT_EXCEEDED,
+    CTE_STATUS_DEADLINE_EXCEEDED,
 } cte_status_t;
 
 
@@ -94,6 +152,7 @@ typedef /* cte_notification_t */ enum {
     CTE_NOTIFICATION_STACK_ENLARGEMENT_FAILED,
     CTE_NOTIFICATION_UNDEFINED_PLACEHOLDER,
     CTE_NOTIFICATION_NESTING_LIMIT_EXCEEDED,
+    CTE_NOTIFICATION_BUDGET_EXCEEDED,
 } cte_notification_t;
 
 
@@ -101,7 +160,158 @@ typedef /* cte_notification_t */ enum {
 // Notification handler type
 // ---------------------------------------------------------------------------
 
-typedef void (*cte_notification_f)(cte_notification_t, const char*, cardinal);
+typedef void (*cte_notification_f)(cte_notification_t, const char*, size_t);
+
+
+// ---------------------------------------------------------------------------
+// Diagnostic type
+// ---------------------------------------------------------------------------
+//
+// A diagnostic describes a notification in terms of lines and coloumns.  Its
+// <str> and <index> are those passed to notification handlers,  <position> is
+// the line and coloumn of <index> within <str>.  If the event occurred within
+// a placeholder value,  <template_position>  is the line and coloumn  of the
+// outermost placeholder within the template,  otherwise it is <position>.  The
+// number of placeholders being expanded is <nesting_level>,  their names may
+// be obtained by calling cte_diagnostic_placeholder().  Lines and coloumns are
+// counted from one.  Member <context> is private to the template engine.
+
+typedef struct /* cte_diagnostic_t */ {
+    cte_notification_t notification;
+            const char *str;
+                size_t index;
+       long_file_pos_t position;
+       long_file_pos_t template_position;
+              cardinal nesting_level;
+            const void *context;
+} cte_diagnostic_t;
+
+
+// ---------------------------------------------------------------------------
+// Diagnostic handler type
+// ---------------------------------------------------------------------------
+
+typedef void (*cte_diagnostic_f)(const cte_diagnostic_t *diagnostic);
+
+
+// ---------------------------------------------------------------------------
+// Placeholder resolver type
+// ---------------------------------------------------------------------------
+//
+// A resolver is called with the identifier of a placeholder as a terminated
+// string,  the key calculated for the identifier  and a user supplied context
+// pointer.  It returns the value of the placeholder,  or NULL if undefined.
+// A resolver may return CTE_PENDING_VALUE  if the value is not available yet,
+// the resolver is then called again for the placeholder  when a resumable
+// render is continued,  any other render treats the placeholder as undefined.
+
+typedef const char *(*cte_resolver_f)(const char *, kvs_key_t, void *);
+
+
+// ---------------------------------------------------------------------------
+// Output sink type
+// ---------------------------------------------------------------------------
+//
+// A sink is called with a chunk of rendered output,  its length and a user
+// supplied context pointer.  The chunk is not terminated and only valid for
+// the duration of the call.  The sink returns true if it accepted the chunk,
+// false to abort the render.
+
+typedef bool (*cte_sink_f)(const char *, size_t, void *);
+
+
+// ---------------------------------------------------------------------------
+// Render budget type
+// ---------------------------------------------------------------------------
+//
+// A budget limits a single render  to at most <max_output> bytes of output,
+// at most <max_expansions> expansions of placeholder values and section rows
+// and at most <time_limit> nanoseconds of monotonic clock time.  A limit of
+// zero means unlimited.  Limits are checked whenever a placeholder value or
+// section row is about to be expanded,  the clock is only read every CTE_DEAD-
+// LINE_CHECK_INTERVAL expansions.  The output limit is checked again when the
+// render is complete,  output exceeding it is never returned.
+
+typedef struct /* cte_budget_t */ {
+      size_t max_output;
+    uint64_t max_expansions;
+    uint64_t time_limit;
+} cte_budget_t;
+
+
+// ---------------------------------------------------------------------------
+// Opaque compiled template handle type
+// ---------------------------------------------------------------------------
+//
+// WARNING:  Objects of this opaque type should  only be accessed through this
+// public interface.  DO NOT EVER attempt to bypass the public interface.
+//
+// The internal data structure of this opaque type is  HIDDEN  and  MAY CHANGE
+// at any time WITHOUT NOTICE.  Accessing the internal data structure directly
+// other than  through the  functions  in this public interface is  UNSAFE and
+// may result in an inconsistent program state or a crash.
+
+typedef opaque_t cte_template_t;
+
+
+// ---------------------------------------------------------------------------
+// Opaque placeholder set handle type
+// ---------------------------------------------------------------------------
+//
+// WARNING:  Objects of this opaque type should  only be accessed through this
+// public interface.  DO NOT EVER attempt to bypass the public interface.
+//
+// The internal data structure of this opaque type is  HIDDEN  and  MAY CHANGE
+// at any time WITHOUT NOTICE.  Accessing the internal data structure directly
+// other than  through the  functions  in this public interface is  UNSAFE and
+// may result in an inconsistent program state or a crash.
+
+typedef opaque_t cte_placeholder_set_t;
+
+
+// ---------------------------------------------------------------------------
+// Opaque template syntax handle type
+// ---------------------------------------------------------------------------
+//
+// WARNING:  Objects of this opaque type should  only be accessed through this
+// public interface.  DO NOT EVER attempt to bypass the public interface.
+//
+// The internal data structure of this opaque type is  HIDDEN  and  MAY CHANGE
+// at any time WITHOUT NOTICE.  Accessing the internal data structure directly
+// other than  through the  functions  in this public interface is  UNSAFE and
+// may result in an inconsistent program state or a crash.
+
+typedef opaque_t cte_syntax_t;
+
+
+// ---------------------------------------------------------------------------
+// Opaque resumable render state handle type
+// ---------------------------------------------------------------------------
+//
+// WARNING:  Objects of this opaque type should  only be accessed through this
+// public interface.  DO NOT EVER attempt to bypass the public interface.
+//
+// The internal data structure of this opaque type is  HIDDEN  and  MAY CHANGE
+// at any time WITHOUT NOTICE.  Accessing the internal data structure directly
+// other than  through the  functions  in this public interface is  UNSAFE and
+// may result in an inconsistent program state or a crash.
+
+typedef opaque_t cte_render_state_t;
+
+
+// ---------------------------------------------------------------------------
+// Opaque chunked render handle type
+// ---------------------------------------------------------------------------
+//
+// WARNING:  Objects of this opaque type should  only be accessed through this
+// public interface.  DO NOT EVER attempt to bypass the public interface.
+//
+// The internal data structure of this opaque type is  HIDDEN  and  MAY CHANGE
+// at any time WITHOUT NOTICE.  Accessing the internal data structure directly
+// other than  through the  functions  in this public interface is  UNSAFE and
+// may result in an inconsistent program state or a crash.
+
+typedef opaque_t cte_chunked_render_t;
 
 
 // ---------------------------------------------------------------------------
@@ -109,10 +319,11 @@ typedef void (*cte_notification_f)(cte_notification_t, const char*, cardinal);
 // ---------------------------------------------------------------------------
 //
 // Returns a pointer to a constant C string  containing the library's built-in
-// placeholder delimiter.  The placeholder delimiter may be changed at compile
-// time only.  The factory setting is "@@".
+// placeholder delimiter.  The built-in delimiter may be changed  at compile
+// time only,  other delimiters may be used with a syntax  created at runtime
+// by cte_new_syntax().  The factory setting is "@@".
 
-inline const char *cte_delimiter(void);
+const char *cte_delimiter(void);
 
 
 // ---------------------------------------------------------------------------
@@ -120,10 +331,79 @@ inline const char *cte_delimiter(void);
 // ---------------------------------------------------------------------------
 //
 // Returns a pointer to a constant C string  containing the library's built-in
-// ignore prefix.  The ignore prefix may be changed at compile time only.  The
-// factory setting is "%%".
+// ignore prefix.  The built-in ignore prefix may be changed at compile time
+// only,  other prefixes may be used with a syntax created at runtime by func-
+// tion cte_new_syntax().  The factory setting is "%%".
+
+const char *cte_ignore_prefix(void);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_new_syntax( delimiter, closing_delimiter, prefix, status )
+// ---------------------------------------------------------------------------
+//
+// Creates and returns a new template syntax  with opening placeholder delimi-
+// ter <delimiter>,  closing placeholder delimiter <closing_delimiter>  and
+// ignore prefix <prefix>.  If NULL is passed in for <delimiter> or <prefix>,
+// the built-in delimiter or ignore prefix is used.  If NULL is passed in for
+// <closing_delimiter>,  the closing delimiter is the same as the opening de-
+// limiter.  The function returns NULL if it fails.
+//
+// Delimiters and prefix must consist of exactly two printable characters that
+// are neither whitespace,  backslash,  underscore,  letter nor digit,  and the
+// first character of the opening delimiter must differ from the first charac-
+// ter of the ignore prefix.  Otherwise the function fails with status
+// CTE_STATUS_INVALID_SYNTAX.
+//
+// A syntax  replaces '@@' and '%%' in the grammar described for function
+// cte_string_from_template(),  with the first character of the opening deli-
+// miter  and  the first character of the ignore prefix  taking the place of
+// '@' and '%' in escape sequences.  The character classification used by the
+// template scanners is built when the syntax is created,  so that templates
+// of any syntax are scanned as fast as those of the built-in syntax.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_syntax_t cte_new_syntax(const char *delimiter,
+                            const char *closing_delimiter,
+                            const char *prefix,
+                          cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_syntax_set_escape( syntax, escape, status )
+// ---------------------------------------------------------------------------
+//
+// Sets the output escaping mode of template syntax <syntax> to <escape>.  All
+// output  that originates from placeholder values,  including nested values,
+// is escaped while it is copied to the target,  the text of the template it-
+// self is copied as it is.  Values need therefore not be escaped before they
+// are stored.  Runs of characters that need no escaping are found several
+// bytes at a time where SSE2 or NEON is available,  so that escaping costs
+// little more than copying  for typical values.  The function fails  if NULL
+// is passed in for <syntax> or if <escape> is not a valid escaping mode.  The
+// escaping mode of a new syntax is CTE_ESCAPE_NONE.  Templates compiled with
+// the syntax before the call are not affected.  The mode is overridden by the
+// escaping mode of a render,  see cte_string_from_template_escaped(),  and by
+// that of a value,  see cte_table_store_escaped_value().
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
 
-inline const char *cte_ignore_prefix(void);
+void cte_syntax_set_escape(cte_syntax_t syntax,
+                           cte_escape_t escape,
+                           cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_dispose_syntax( syntax )
+// ---------------------------------------------------------------------------
+//
+// Disposes of template syntax <syntax>.  Templates compiled with the syntax
+// hold their own copy of it and are not affected.  Returns NULL.
+
+cte_syntax_t cte_dispose_syntax(cte_syntax_t syntax);
 
 
 // ---------------------------------------------------------------------------
@@ -143,18 +423,52 @@ inline const char *cte_ignore_prefix(void);
 //
 // A notification handler may be uninstalled by passing in NULL for <handler>.
 
-inline void cte_install_notification_handler(cte_notification_f handler);
+void cte_install_notification_handler(cte_notification_f handler);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_install_diagnostic_handler( handler )
+// ---------------------------------------------------------------------------
+//
+// Installs function <handler>  as  diagnostic handler.  If a diagnostic hand-
+// ler is installed,  the template engine calls the handler  for the same events
+// as a notification handler,  passing a diagnostic that describes the event.
+// Line, coloumn and nesting information is only determined when an event occurs
+// and does not slow down expansion otherwise.  Compiled templates hold an index
+// of their line ends  so that positions within them are found by binary search.
+// Diagnostics and their placeholder names are only valid during the call.
+// By default no handler is installed.
+//
+// A diagnostic handler may be uninstalled by passing in NULL for <handler>.
+
+void cte_install_diagnostic_handler(cte_diagnostic_f handler);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_diagnostic_placeholder( diagnostic, level, length )
+// ---------------------------------------------------------------------------
+//
+// Returns a pointer to the name of the placeholder being expanded at nesting
+// level <level>  when the event described by <diagnostic> occurred  and passes
+// back the length of the name in <length>.  Level one is the outermost place-
+// holder within the template.  The name is not terminated.  Returns NULL if
+// NULL is passed in for <diagnostic> or <length>  or if <level> is zero or ex-
+// ceeds the nesting level of the diagnostic.
+
+const char *cte_diagnostic_placeholder(const cte_diagnostic_t *diagnostic,
+                                       cardinal level,
+                                       cardinal *length);
 
 
 // ---------------------------------------------------------------------------
 // function:  cte_string_from_template( tmplate, placeholders, status )
 // ---------------------------------------------------------------------------
 //
-// Recursively expands  all placeholder strings  in template string <template>
+// Recursively expands  all placeholder strings  in template string <tmplate>
 // and  returns a pointer to a new dynamically allocated string containing the
-// resulting string.  The function fails  if NULL is passed in  for <template>
-// or <placeholders>  or if allocation fails  or the template nesting limit is
-// exceeded.  The function returns NULL if it fails.
+// resulting string.  The function fails  if NULL is passed in  for <tmplate>
+// or <placeholders>  or if allocation fails  or the template nesting limit or
+// the section depth limit is exceeded.  The function returns NULL if it fails.
 //
 // When a placeholder string is found in the template, a key is calculated for
 // its identifier.  The key is then looked up in the placeholder table  passed
@@ -165,7 +479,8 @@ inline void cte_install_notification_handler(cte_notification_f handler);
 // The function recognises templates according to the following EBNF grammar:
 //
 //  template :
-//    ( template-comment | escape-sequence | placeholder-string | character )*
+//    ( template-comment | escape-sequence | placeholder-string | section |
+//      character )*
 //
 //  template-comment :
 //    '%%' character* end-of-line
@@ -173,6 +488,9 @@ inline void cte_install_notification_handler(cte_notification_f handler);
 //  placeholder-string :
 //    '@@' identifier '@@'
 //
+//  section :
+//    '@@#' identifier '@@' template '@@/' identifier '@@'
+//
 //  identifier :
 //    letter ( letter | digit | '_' )*
 //
@@ -201,6 +519,21 @@ inline void cte_install_notification_handler(cte_notification_f handler);
 //
 // o  template nesting must not exceed the value of cte_max_nesting_level().
 //
+// o  a section is  ONLY  recognised  if rows have been stored for its identi-
+//    fier with cte_table_store_rows()  and its body is closed by a section end
+//    with the same identifier,  sections of the same name may be nested.  The
+//    body is expanded once per row,  placeholders are looked up in the row's
+//    table first,  then in the tables of enclosing sections,  then in the
+//    value source of the render.  Section identifiers are looked up the same
+//    way:  a section nested in a row that has no rows of its own name expands
+//    the rows found in an enclosing scope.  With rows A and B stored for r,
+//    each setting x to its name,  @@#r@@(@@x@@@@#r@@{@@x@@}@@/r@@)@@/r@@
+//    expands to (A{A}{B})(B{A}{B}).  Sections with no rows produce no output.
+//    Otherwise the section opening is copied like an undefined placeholder.
+//
+// o  sections must not be nested deeper than CTE_MAX_SECTION_DEPTH,  other-
+//    wise the render fails with status CTE_STATUS_NESTING_LIMIT_EXCEEDED.
+//
 // o  escape sequences are reproduced as follows:
 //    "\\" produces "\\" in the expanded result string
 //    "\@" produces "@" in the expanded result string
@@ -210,10 +543,1018 @@ inline void cte_install_notification_handler(cte_notification_f handler);
 // The status of the operation  is passed back in <status>,  unless  NULL  was
 // passed in for <status>.
 
-char *cte_string_from_template(const char *template,
+char *cte_string_from_template(const char *tmplate,
                               kvs_table_t placeholders,
                              cte_status_t *status);
-    
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_string_from_template_with_syntax( tmplate, syntax, placeholders, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in template string <tmplate>
+// exactly like cte_string_from_template(),  except that the template and its
+// placeholder values are recognised according to template syntax <syntax>.
+// If NULL is passed in for <syntax>,  the built-in syntax is used.  The func-
+// tion fails for the same reasons as cte_string_from_template().  It returns
+// NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_template_with_syntax(const char *tmplate,
+                                          cte_syntax_t syntax,
+                                           kvs_table_t placeholders,
+                                          cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_string_from_template_escaped( tmplate, placeholders, escape, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in template string <tmplate>
+// exactly like cte_string_from_template(),  except that all output that ori-
+// ginates from placeholder values  is escaped in escaping mode <escape> while
+// it is copied to the target,  the text of the template itself is copied as
+// it is.  The mode applies to the expansion of a value entered from the tem-
+// plate as a whole,  including any values nested in it.  If CTE_ESCAPE_DEFAULT
+// is passed in for <escape>,  the mode of the built-in syntax is used.  The
+// function fails for the same reasons as cte_string_from_template()  and with
+// status CTE_STATUS_INVALID_SYNTAX  if <escape> is not a valid escaping mode.
+// It returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_template_escaped(const char *tmplate,
+                                       kvs_table_t placeholders,
+                                      cte_escape_t escape,
+                                     cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_string_from_resolver( tmplate, resolver, context, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in template string <tmplate>
+// and  returns a pointer to a new dynamically allocated string containing the
+// resulting string.  Unlike cte_string_from_template(),  placeholder values
+// are not looked up in a placeholder table but obtained on demand by calling
+// resolver function <resolver>.  The function fails if NULL is passed in for
+// <tmplate> or <resolver> or if allocation fails or the template nesting limit
+// is exceeded.  The function returns NULL if it fails.
+//
+// The resolver is only called for placeholders  actually encountered  during
+// expansion,  and at most once per distinct identifier and render.  Resolved
+// values are cached for the duration of the render,  this includes undefined
+// placeholders for which the resolver returned NULL.  The resolver is passed
+// the identifier as a terminated string, its key and the pointer passed in
+// <context>.  Strings returned by the resolver must remain valid  until this
+// function returns.  They are never modified nor deallocated by the engine.
+//
+// Templates  and  resolved values  are recognised  according to the grammar
+// and static semantics described for function cte_string_from_template().
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_resolver(const char *tmplate,
+                           cte_resolver_f resolver,
+                                     void *context,
+                             cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_string_from_table( tmplate, table, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in template string <tmplate>
+// and  returns a pointer to a new dynamically allocated string containing the
+// resulting string.  Unlike cte_string_from_template(),  placeholder values
+// are looked up in placeholder table <table>,  which is optimised for the
+// small number of placeholders typical of templates.  The function fails if
+// NULL is passed in for <tmplate> or <table> or if allocation fails or the
+// template nesting limit is exceeded.  The function returns NULL if it fails.
+//
+// Values in the table need not be terminated,  their lengths are taken from
+// the table.  Templates and values are recognised  according to the grammar
+// and static semantics described for function cte_string_from_template().
+// Placeholders whose value is pending are treated as undefined.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_table(const char *tmplate,
+                           cte_table_t table,
+                          cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_string_from_table_escaped( tmplate, table, escape, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in template string <tmplate>
+// exactly like cte_string_from_table(),  except that all output that origin-
+// ates from placeholder values is escaped as described for function cte_str-
+// ing_from_template_escaped().  Values stored in <table>  with a mode of their
+// own are escaped in their own mode instead.  The function fails for the same
+// reasons as cte_string_from_table()  and with status CTE_STATUS_INVALID_SYN-
+// TAX  if <escape> is not a valid escaping mode.  It returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_table_escaped(const char *tmplate,
+                                    cte_table_t table,
+                                   cte_escape_t escape,
+                                  cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_string_from_template_with_budget( tmplate, placeholders, budget, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in template string <tmplate>
+// exactly like cte_string_from_template(),  except that the render is aborted
+// as soon as it exceeds a limit of budget <budget>.  If NULL is passed in for
+// <budget>,  the render is unlimited.  The function fails for the same reasons
+// as cte_string_from_template()  and with status CTE_STATUS_OUTPUT_LIMIT_EX-
+// CEEDED,  CTE_STATUS_EXPANSION_LIMIT_EXCEEDED or CTE_STATUS_DEADLINE_EXCEEDED
+// if the respective limit is exceeded.  It returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_template_with_budget(const char *tmplate,
+                                           kvs_table_t placeholders,
+                                    const cte_budget_t *budget,
+                                          cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_render_into( buffer, capacity, tmplate, placeholders, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in template string <tmplate>
+// into caller owned buffer <buffer> of <capacity> bytes and returns the num-
+// ber of characters of the full expansion,  not counting the terminator.  The
+// semantics follow those of snprintf():  At most <capacity> - 1 characters are
+// written and the buffer is always terminated unless <capacity> is zero.  The
+// result was truncated if the return value is not less than <capacity>,  in
+// which case a buffer of return value + 1 bytes will hold the full result.
+// NULL may be passed in for <buffer> if zero is passed in for <capacity>,  to
+// obtain the required size without writing anything.
+//
+// Placeholder values are looked up in <placeholders>  as described for func-
+// tion cte_string_from_template().  No memory is allocated  unless template
+// nesting exceeds CTE_RENDER_STACK_SIZE levels.
+//
+// The function fails if NULL is passed in for <tmplate> or <placeholders>,  or
+// for <buffer> while <capacity> is not zero,  or if allocation fails or the
+// template nesting limit is exceeded.  If the function fails,  it returns zero
+// and the buffer holds the empty string.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_render_into(char *buffer,
+                     size_t capacity,
+                 const char *tmplate,
+                kvs_table_t placeholders,
+               cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_render_table_into( buffer, capacity, tmplate, t_length, table, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in template string <tmplate>
+// of length <t_length> into caller owned buffer <buffer> of <capacity> bytes,
+// with the same semantics as cte_render_into(),  except that placeholder va-
+// lues are looked up in placeholder table <table>  as described for function
+// cte_string_from_table().  Neither the template nor the values need to be
+// terminated,  which permits rendering from and into storage managed by other
+// languages without copying.
+//
+// The function fails if NULL is passed in for <tmplate> or <table>,  or for
+// <buffer> while <capacity> is not zero,  or if allocation fails or the tem-
+// plate nesting limit is exceeded.  If the function fails,  it returns zero
+// and the buffer holds the empty string.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_render_table_into(char *buffer,
+                           size_t capacity,
+                       const char *tmplate,
+                           size_t t_length,
+                      cte_table_t table,
+                     cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_render_table_length( tmplate, t_length, table, status )
+// ---------------------------------------------------------------------------
+//
+// Returns the number of characters  that cte_render_table_into() produces for
+// template string <tmplate> of length <t_length>  with placeholder values from
+// placeholder table <table>,  not counting the terminator,  without writing
+// anything.  The sizing render is silent:  its notifications and diagnostics
+// are not passed to the handlers and it is not counted in the engine metrics,
+// so that the render that follows it reports every event once.  If it fails,
+// the events of the failed render are reported,  since no render follows.
+//
+// The function fails for the same reasons as cte_render_table_into()  and re-
+// turns zero if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_render_table_length(const char *tmplate,
+                                   size_t t_length,
+                              cte_table_t table,
+                             cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_string_and_digest_from_template( tmplate, placeholders,
+//                                                  kinds, digest, status )
+// ---------------------------------------------------------------------------
+//
+// Expands template string <tmplate>  exactly like cte_string_from_template()
+// and returns the result,  additionally computing the digests requested in bit
+// set <kinds>  of the result  and passing them back in <digest>.  The digests
+// are computed incrementally as the result is produced,  without a further
+// pass over the result.  The terminator is not included in the digests.  The
+// function fails for the same reasons as cte_string_from_template() and if
+// NULL is passed in for <digest>.  The function returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_and_digest_from_template(const char *tmplate,
+                                         kvs_table_t placeholders,
+                                            cardinal kinds,
+                                        cte_digest_t *digest,
+                                        cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_render_to_sink( tmplate, placeholders, sink, context,
+//                                chunk_size, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in template string <tmplate>
+// and passes the result to sink <sink>,  together with <context>,  in chunks
+// of up to <chunk_size> bytes,  as it is produced.  Returns the number of bytes
+// passed to the sink.  If zero is passed in for <chunk_size>,  chunks are of up
+// to CTE_SINK_CHUNK_SIZE bytes.  Memory use is bounded by the chunk size,  the
+// result is never held in full.  Values that fill a whole chunk by themselves
+// are passed to the sink without copying,  the sink must therefore accept
+// chunks larger than <chunk_size>.  No terminator is passed to the sink.
+//
+// Placeholder values are looked up in <placeholders>  as described for func-
+// tion cte_string_from_template().  The function fails if NULL is passed in
+// for <tmplate>,  <placeholders> or <sink>  or if allocation fails or the tem-
+// plate nesting limit is exceeded or the sink returns false.  Output passed to
+// the sink before the failure is not retracted.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_render_to_sink(const char *tmplate,
+                         kvs_table_t placeholders,
+                          cte_sink_f sink,
+                                void *context,
+                              size_t chunk_size,
+                        cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_render_to_sink_escaped( tmplate, placeholders, sink, context,
+//                              chunk_size, escape, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in template string <tmplate>
+// and passes the result to sink <sink>  exactly like cte_render_to_sink(),
+// except that all output that originates from placeholder values is escaped
+// as described for function cte_string_from_template_escaped().  The function
+// fails for the same reasons as cte_render_to_sink()  and with status CTE_ST-
+// ATUS_INVALID_SYNTAX  if <escape> is not a valid escaping mode.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_render_to_sink_escaped(const char *tmplate,
+                                  kvs_table_t placeholders,
+                                   cte_sink_f sink,
+                                        void *context,
+                                       size_t chunk_size,
+                                 cte_escape_t escape,
+                                cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_compile_template( tmplate, status )
+// ---------------------------------------------------------------------------
+//
+// Compiles template string <tmplate>  into a new compiled template object and
+// returns it.  The function fails  if NULL is passed in for <tmplate>,  if the
+// template is longer than CTE_MAX_COMPILED_LENGTH  or if allocation fails.
+// The function returns NULL if it fails.
+//
+// A compiled template  holds  its own copy of the template string,  split into
+// literal and placeholder segments.  Comments have been removed and escape se-
+// quences resolved in its literal segments,  so that only placeholder values
+// need to be scanned when the compiled template is expanded.  The template is
+// recognised according to the grammar  and static semantics  described for
+// function cte_string_from_template().
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_template_t cte_compile_template(const char *tmplate,
+                                  cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_compile_template_with_syntax( tmplate, syntax, status )
+// ---------------------------------------------------------------------------
+//
+// Compiles template string <tmplate>  exactly like cte_compile_template(),
+// except that the template is recognised according to template syntax <syn-
+// tax>.  If NULL is passed in for <syntax>,  the built-in syntax is used.  The
+// compiled template holds its own copy of the syntax,  which is used for the
+// placeholder values  whenever the compiled template is expanded.  The func-
+// tion returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_template_t cte_compile_template_with_syntax(const char *tmplate,
+                                              cte_syntax_t syntax,
+                                              cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_string_from_compiled( compiled, placeholders, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in compiled template <compi-
+// led>  and  returns a pointer to a new dynamically allocated string contain-
+// ing the resulting string.  The function fails  if NULL is passed in for
+// <compiled>  or <placeholders>  or if allocation fails  or the template nest-
+// ing limit is exceeded.  The function returns NULL if it fails.
+//
+// The result is the same as that of cte_string_from_template() for the tem-
+// plate string the compiled template was compiled from.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_compiled(cte_template_t compiled,
+                                  kvs_table_t placeholders,
+                                 cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_string_from_compiled_escaped( compiled, placeholders, escape, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in compiled template <compi-
+// led>  exactly like cte_string_from_compiled(),  except that all output that
+// originates from placeholder values  is escaped  as described for function
+// cte_string_from_template_escaped().  If CTE_ESCAPE_DEFAULT is passed in for
+// <escape>,  the mode of the template's syntax is used.  The function fails
+// for the same reasons as cte_string_from_compiled()  and with status CTE_ST-
+// ATUS_INVALID_SYNTAX  if <escape> is not a valid escaping mode.  It returns
+// NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_compiled_escaped(cte_template_t compiled,
+                                          kvs_table_t placeholders,
+                                         cte_escape_t escape,
+                                        cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_string_from_compiled_table( compiled, table, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in compiled template <compi-
+// led>  and  returns a pointer to a new dynamically allocated string contain-
+// ing the resulting string.  Placeholder values are looked up in placeholder
+// table <table>.  The function fails  if NULL is passed in for <compiled>  or
+// <table>  or if allocation fails  or the template nesting limit is exceeded.
+// The function returns NULL if it fails.
+//
+// The result is the same as that of cte_string_from_table() for the template
+// string the compiled template was compiled from.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_compiled_table(cte_template_t compiled,
+                                        cte_table_t table,
+                                       cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_string_from_compiled_table_escaped( compiled, table, escape, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in compiled template <compi-
+// led>  exactly like cte_string_from_compiled_table(),  except that all out-
+// put that originates from placeholder values is escaped as described for
+// function cte_string_from_compiled_escaped().  Values stored in <table> with
+// a mode of their own are escaped in their own mode instead.  The function
+// fails for the same reasons as cte_string_from_compiled_table()  and with
+// status CTE_STATUS_INVALID_SYNTAX  if <escape> is not a valid escaping mode.
+// It returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_compiled_table_escaped(cte_template_t compiled,
+                                                cte_table_t table,
+                                               cte_escape_t escape,
+                                              cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_string_from_compiled_with_budget( compiled, placeholders, budget, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in compiled template <compi-
+// led> exactly like cte_string_from_compiled(),  except that the render is
+// aborted as soon as it exceeds a limit of budget <budget>  as described for
+// cte_string_from_template_with_budget().  If NULL is passed in for <budget>,
+// the render is unlimited.  The function fails for the same reasons  as cte_
+// string_from_template_with_budget().  It returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_compiled_with_budget(cte_template_t compiled,
+                                              kvs_table_t placeholders,
+                                       const cte_budget_t *budget,
+                                             cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_string_from_compiled_parallel( compiled, placeholders,
+//                                                threads, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in compiled template <compi-
+// led>  using up to <threads> threads  and  returns a pointer to a new dyna-
+// mically allocated string  containing the resulting string.  If zero is
+// passed in for <threads>,  one thread per online processor is used.  The re-
+// sult is the same as that of cte_string_from_compiled().  The function fails
+// if NULL is passed in for <compiled>  or <placeholders>  or  if allocation
+// fails  or the template nesting limit is exceeded.  The function returns
+// NULL if it fails.
+//
+// The expansion is performed in two passes.  The first pass determines the
+// expanded size of each top level segment,  from which the offset of each
+// segment in the result is obtained by a prefix sum.  The result is then al-
+// located once and the second pass expands  contiguous runs of segments of
+// about equal expanded size into their disjoint regions of the result,  each
+// run on a thread of its own.  Both passes are run in parallel.  If the tem-
+// plate contains an undefined placeholder,  the remainder of the template
+// from there on is expanded by a single thread.
+//
+// Placeholder table <placeholders> is read concurrently by multiple threads
+// and must not be modified during the render.  Notifications are only passed
+// to the handlers by the second pass,  each event is reported once as by cte_
+// string_from_compiled().  Events within the runs of the second pass are re-
+// ported by the threads expanding them,  notification and diagnostic handlers
+// must therefore be thread-safe  and the order of events from different runs
+// is unspecified.  If the library is built with CTE_NO_THREADS defined,  all
+// work is performed on the calling thread.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_from_compiled_parallel(cte_template_t compiled,
+                                           kvs_table_t placeholders,
+                                              cardinal threads,
+                                          cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_string_and_digest_from_compiled( compiled, placeholders,
+//                                                  kinds, digest, status )
+// ---------------------------------------------------------------------------
+//
+// Expands compiled template <compiled> exactly like cte_string_from_compiled()
+// and returns the result,  additionally computing the digests requested in bit
+// set <kinds>  of the result  and passing them back in <digest>.  The digests
+// are computed incrementally as the result is produced,  without a further
+// pass over the result.  The terminator is not included in the digests.  The
+// function fails for the same reasons as cte_string_from_compiled() and if
+// NULL is passed in for <digest>.  The function returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_string_and_digest_from_compiled(cte_template_t compiled,
+                                             kvs_table_t placeholders,
+                                                cardinal kinds,
+                                            cte_digest_t *digest,
+                                            cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_render_compiled_to_sink( compiled, placeholders, sink,
+//                                         context, chunk_size, status )
+// ---------------------------------------------------------------------------
+//
+// Expands compiled template <compiled>  and passes the result to sink <sink>
+// exactly like cte_render_to_sink() does for template strings.  Returns the
+// number of bytes passed to the sink.  The result is the same as that of
+// cte_string_from_compiled().
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_render_compiled_to_sink(cte_template_t compiled,
+                                      kvs_table_t placeholders,
+                                       cte_sink_f sink,
+                                             void *context,
+                                           size_t chunk_size,
+                                     cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_render_to_file( fd, tmplate, placeholders, status )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in template string <tmplate>
+// and writes the result to the file open for writing  with file descriptor
+// <fd>,  starting at its current file offset,  which is advanced past the
+// output as if it had been written with write().  Returns the number of bytes
+// written.  Placeholder values are looked up in <placeholders>  as described
+// for function cte_string_from_template().
+//
+// If <fd> refers to a regular file,  the exact size of the output is deter-
+// mined first,  by an expansion that writes nothing.  The file is then ex-
+// tended with posix_fallocate(),  or with ftruncate() where the file system
+// does not support it,  and mapped into memory,  and the template is expanded
+// directly into the mapping.  No copy of the output is held in memory.
+//
+// Output to other kinds of files,  output smaller than CTE_FILE_MAP_MIN_SIZE
+// and output to files that cannot be mapped  is written in chunks of CTE_SINK_
+// CHUNK_SIZE bytes instead.  The same applies  if the library was built with
+// CTE_NO_MMAP defined.
+//
+// The function fails if NULL is passed in for <tmplate> or <placeholders>  or
+// if <fd> is negative,  if allocation fails,  if the template nesting limit is
+// exceeded or if the file could not be written,  in which case errno des-
+// cribes the cause.  If the function fails after extending a mapped file,  the
+// file is truncated to its original size.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_render_to_file(int fd,
+                  const char *tmplate,
+                 kvs_table_t placeholders,
+                cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_render_compiled_to_file( fd, compiled, placeholders, status )
+// ---------------------------------------------------------------------------
+//
+// Expands compiled template <compiled> like cte_string_from_compiled() and
+// writes the result to the file open for writing  with file descriptor <fd>
+// exactly as cte_render_to_file() does.  Returns the number of bytes written.
+// The function fails for the same reasons as cte_render_to_file().
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_render_compiled_to_file(int fd,
+                        cte_template_t compiled,
+                           kvs_table_t placeholders,
+                          cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_new_render_state( tmplate, placeholders, status )
+// ---------------------------------------------------------------------------
+//
+// Creates and returns a new resumable render state  for the expansion of tem-
+// plate string <tmplate>  with placeholder values looked up in <placeholders>
+// as described for function cte_string_from_template().  Nothing is expanded
+// until cte_render_step() is called.  The template and the placeholder values
+// are not copied,  they must remain valid and unmodified  until the state has
+// been disposed of,  except that pending values may be completed between two
+// steps.  The function fails if NULL is passed in for <tmplate> or
+// <placeholders> or if allocation fails.  It returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_render_state_t cte_new_render_state(const char *tmplate,
+                                       kvs_table_t placeholders,
+                                      cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_new_render_state_with_table( tmplate, table, status )
+// ---------------------------------------------------------------------------
+//
+// Creates and returns a new resumable render state  exactly like cte_new_ren-
+// der_state(),  except that placeholder values are looked up in placeholder
+// table <table>  as described for function cte_string_from_table().  The
+// function fails if NULL is passed in for <tmplate> or <table>  or if alloca-
+// tion fails.  It returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_render_state_t cte_new_render_state_with_table(const char *tmplate,
+                                                 cte_table_t table,
+                                                cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_new_render_state_with_resolver( tmplate, resolver, context, status )
+// ---------------------------------------------------------------------------
+//
+// Creates and returns a new resumable render state  exactly like cte_new_ren-
+// der_state(),  except that placeholder values are obtained from resolver
+// function <resolver> with context <context>  as described for function
+// cte_string_from_resolver().  Resolved values are cached for the lifetime of
+// the state.  The function fails if NULL is passed in for <tmplate> or <re-
+// solver> or if allocation fails.  It returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_render_state_t cte_new_render_state_with_resolver(const char *tmplate,
+                                                 cte_resolver_f resolver,
+                                                           void *context,
+                                                   cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_new_compiled_render_state( compiled, table, status )
+// ---------------------------------------------------------------------------
+//
+// Creates and returns a new resumable render state  for the expansion of com-
+// piled template <compiled>  with placeholder values looked up in placeholder
+// table <table>.  The template is expanded from its source according to its
+// syntax,  the result is the same as that of cte_string_from_compiled_table().
+// The compiled template must not be disposed of before the state.  The func-
+// tion fails if NULL is passed in for <compiled> or <table>  or if allocation
+// fails.  It returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_render_state_t cte_new_compiled_render_state(cte_template_t compiled,
+                                                    cte_table_t table,
+                                                   cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_render_step( state, buffer, capacity, status )
+// ---------------------------------------------------------------------------
+//
+// Continues the expansion of render state <state>,  writing up to <capacity>
+// bytes of output into caller owned buffer <buffer>,  and returns the number
+// of bytes written.  No terminator is written.  The expansion stops when the
+// buffer is full  and resumes exactly where it stopped  on the next call,  the
+// source strings,  indices and template nesting stack are kept in the state.
+// Output that did not fit is held back  by reference to the source  and is
+// written first on the next call,  memory use does not grow with the output.
+// When the expansion is complete,  cte_render_state_done() returns true and
+// further calls return zero.
+//
+// If the value of a placeholder is pending,  the step writes all output that
+// precedes the placeholder and stops there,  cte_render_state_pending() then
+// returns its identifier.  The next call looks up the placeholder again and
+// continues if its value has been completed in the meantime,  otherwise it
+// returns zero and stops at the same placeholder.  Values that complete in
+// any order may thus be written as soon as all preceding output is written.
+//
+// The function fails  if NULL is passed in for <state>,  if NULL is passed in
+// for <buffer> with a non-zero <capacity>,  or if allocation fails or the
+// template nesting limit is exceeded during expansion.  A state that failed
+// remains failed,  further calls return zero and pass back the same status.
+// Output written before the failure is not retracted.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_render_step(cte_render_state_t state,
+                                     char *buffer,
+                                   size_t capacity,
+                             cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_render_state_pending( state, length )
+// ---------------------------------------------------------------------------
+//
+// Returns the identifier of the placeholder  at which the last step of render
+// state <state> stopped because its value is pending,  and passes back its
+// length in <length>  unless NULL was passed in for <length>.  The identifier
+// is not terminated.  Returns NULL if the last step did not stop at a pending
+// value or if NULL is passed in for <state>.
+
+const char *cte_render_state_pending(cte_render_state_t state,
+                                               cardinal *length);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_render_state_done( state )
+// ---------------------------------------------------------------------------
+//
+// Returns true if the expansion of render state <state> is complete  and all
+// of its output has been returned by cte_render_step(),  returns false other-
+// wise or if NULL is passed in for <state>.
+
+bool cte_render_state_done(cte_render_state_t state);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_dispose_render_state( state )
+// ---------------------------------------------------------------------------
+//
+// Disposes of render state <state>,  whether or not its expansion is complete.
+// Returns NULL.
+
+cte_render_state_t cte_dispose_render_state(cte_render_state_t state);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_new_chunked_render( placeholders, sink, context, status )
+// ---------------------------------------------------------------------------
+//
+// Creates and returns a new chunked render  for the expansion of a template
+// that is passed in  by any number of calls to cte_chunked_render_feed(),  in
+// chunks of arbitrary size.  Placeholder values are looked up in <placehol-
+// ders>  as described for function cte_string_from_template().  The output is
+// passed to sink <sink>,  together with <context>,  as it is produced.  The
+// function fails if NULL is passed in for <placeholders> or <sink>  or if al-
+// location fails.  It returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_chunked_render_t cte_new_chunked_render(kvs_table_t placeholders,
+                                             cte_sink_f sink,
+                                                   void *context,
+                                           cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_new_chunked_render_with_table( table, sink, context, status )
+// ---------------------------------------------------------------------------
+//
+// Creates and returns a new chunked render  exactly like cte_new_chunked_ren-
+// der(),  except that placeholder values are looked up in placeholder table
+// <table>  as described for function cte_string_from_table().  The function
+// fails if NULL is passed in for <table> or <sink> or if allocation fails.  It
+// returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_chunked_render_t cte_new_chunked_render_with_table(cte_table_t table,
+                                                        cte_sink_f sink,
+                                                              void *context,
+                                                      cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_chunked_render_feed( render, chunk, length, status )
+// ---------------------------------------------------------------------------
+//
+// Passes the next <length> bytes of the template  to chunked render <render>,
+// which expands  as much of the template  as can be expanded  without further
+// input  and passes the output to its sink before returning.  Delimiters,
+// escapes and comment line prefixes  may be split across chunks,  the chunk
+// need not be terminated  and need not remain valid after the call.  Fewer
+// than CTE_MAX_PLACEHOLDER_LENGTH + 6 bytes are carried over to the next
+// chunk,  except that a section with rows is carried over  until its section
+// end has arrived.  Memory use is thus bounded by the chunk size  plus the
+// carried bytes.  Positions reported to notification handlers are relative to
+// the carried bytes followed by the chunk.
+//
+// The function fails if NULL is passed in for <render>,  if NULL is passed in
+// for <chunk> with a non-zero <length>,  if the render has been finished,  or
+// if allocation fails,  the template nesting limit is exceeded or the sink
+// returns false.  A render that failed remains failed,  further calls pass
+// back the same status.  Output passed to the sink is not retracted.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_chunked_render_feed(cte_chunked_render_t render,
+                                       const char *chunk,
+                                           size_t length,
+                                     cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_chunked_render_finish( render, status )
+// ---------------------------------------------------------------------------
+//
+// Marks the end of the template passed to chunked render <render>,  expands
+// the bytes carried over from the last chunk  and passes the remaining output
+// to the sink.  Returns the total number of bytes passed to the sink.  The
+// function fails if NULL is passed in for <render>,  if the render has been
+// finished or failed before,  or for the reasons given for cte_chunked_ren-
+// der_feed().
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_chunked_render_finish(cte_chunked_render_t render,
+                                         cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_dispose_chunked_render( render )
+// ---------------------------------------------------------------------------
+//
+// Disposes of chunked render <render>,  whether or not it has been finished.
+// Returns NULL.
+
+cte_chunked_render_t cte_dispose_chunked_render(cte_chunked_render_t render);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_dispose_template( compiled )
+// ---------------------------------------------------------------------------
+//
+// Disposes of compiled template <compiled>.  Returns NULL.
+
+cte_template_t cte_dispose_template(cte_template_t compiled);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_template_identity( compiled )
+// ---------------------------------------------------------------------------
+//
+// Returns the identity of compiled template <compiled>.  Identities are never
+// zero and are unique among all templates compiled by the process,  even if a
+// template is allocated at the address of one previously disposed of.  Re-
+// turns zero if NULL is passed in for <compiled>.
+
+uint64_t cte_template_identity(cte_template_t compiled);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_template_histograms( compiled, snapshot, status )
+// ---------------------------------------------------------------------------
+//
+// Passes back in <snapshot>  the histograms of render latency and output size
+// of all successful renders of compiled template <compiled>  since it was com-
+// piled,  merged across all threads.  A render is recorded when the expansion
+// of the template completes,  the latency covers the expansion  including all
+// lookups and writes to the target or sink.  Renders by render states and
+// chunked renders are not recorded.  The function fails if NULL is passed in
+// for <compiled>  or <snapshot>  or if the library was built without CTE_WITH_
+// HISTOGRAMS,  in which case an empty snapshot is passed back.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_template_histograms(cte_template_t compiled,
+                   cte_histogram_snapshot_t *snapshot,
+                               cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_template_histograms_dump( compiled, sink, context, status )
+// ---------------------------------------------------------------------------
+//
+// Writes a text dump of the histograms of compiled template <compiled>  as
+// described for cte_histogram_format() to sink <sink>,  passing <context> to
+// the sink,  and returns the number of bytes passed to the sink.  The function
+// fails if NULL is passed in for <compiled> or <sink>,  if the sink fails  or
+// if the library was built without CTE_WITH_HISTOGRAMS.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_template_histograms_dump(cte_template_t compiled,
+                                        cte_sink_f sink,
+                                              void *context,
+                                      cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_placeholders_in_template( tmplate, placeholders, status )
+// ---------------------------------------------------------------------------
+//
+// Determines  the  placeholders  referenced  in template string <tmplate>
+// without expanding it, and returns a new placeholder set object containing
+// their identifiers and keys.  The function fails  if NULL is passed in for
+// <tmplate> or if allocation fails.  The function returns NULL if it fails.
+//
+// If a placeholder table is passed in <placeholders>,  references are fol-
+// lowed transitively into the values of placeholders defined in the table and
+// the set contains exactly those placeholders  which an expansion  with the
+// table would look up.  If NULL is passed in for <placeholders>,  all place-
+// holders are assumed to be undefined and the set contains every placeholder
+// that an expansion  could look up,  which may include identifiers  that are
+// formed by the closing delimiter of one placeholder string  and  the text
+// following it.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_placeholder_set_t cte_placeholders_in_template(const char *tmplate,
+                                                  kvs_table_t placeholders,
+                                                 cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_placeholders_in_compiled( compiled, placeholders, status )
+// ---------------------------------------------------------------------------
+//
+// Determines the placeholders referenced in compiled template <compiled> and
+// returns  a  new placeholder set object  containing their identifiers and
+// keys.  The top level placeholders are taken from the compiled template with-
+// out scanning.  Otherwise the function behaves  and  fails  the same way as
+// cte_placeholders_in_template() does for the template string the compiled
+// template was compiled from.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_placeholder_set_t cte_placeholders_in_compiled(cte_template_t compiled,
+                                                      kvs_table_t placeholders,
+                                                     cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_placeholder_set_count( set )
+// ---------------------------------------------------------------------------
+//
+// Returns the number of placeholders in placeholder set <set>,  returns zero
+// if NULL is passed in for <set>.
+
+cardinal cte_placeholder_set_count(cte_placeholder_set_t set);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_placeholder_set_identifier( set, index )
+// ---------------------------------------------------------------------------
+//
+// Returns a pointer to the identifier of the placeholder at index <index> in
+// placeholder set <set>.  Placeholders are indexed from zero in the order in
+// which they were first referenced.  Returns NULL if NULL is passed in for
+// <set> or if <index> is out of range.
+
+const char *cte_placeholder_set_identifier(cte_placeholder_set_t set,
+                                                        cardinal index);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_placeholder_set_key( set, index )
+// ---------------------------------------------------------------------------
+//
+// Returns the key of the placeholder at index <index>  in placeholder set
+// <set>.  Returns zero if NULL is passed in for <set> or if <index> is out of
+// range.
+
+kvs_key_t cte_placeholder_set_key(cte_placeholder_set_t set,
+                                               cardinal index);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_dispose_placeholder_set( set )
+// ---------------------------------------------------------------------------
+//
+// Disposes of placeholder set <set>.  Returns NULL.
+
+cte_placeholder_set_t cte_dispose_placeholder_set(cte_placeholder_set_t set);
+
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
 
 #endif /* CTE_H */
 
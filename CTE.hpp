@@ -0,0 +1,645 @@
+/* C Template Engine
+ *
+ *  @file CTE.hpp
+ *  CTE C++ interface
+ *
+ *  C++ wrapper with string views, value tables and reusable buffers
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#ifndef CTE_HPP
+#define CTE_HPP
+
+
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if (__cplusplus >= 202002L) && defined(__cpp_impl_coroutine)
+#include <coroutine>
+#define CTE_HPP_COROUTINES
+#endif
+
+#include "CTE.h"
+
+
+namespace cte {
+
+
+// ---------------------------------------------------------------------------
+// Error type
+// ---------------------------------------------------------------------------
+//
+// Thrown when an operation fails for a reason other than memory exhaustion,
+// which is reported by throwing std::bad_alloc.  The status code describing
+// the failure is returned by function status().
+
+class error : public std::runtime_error {
+    cte_status_t code;
+    
+public:
+    explicit error(cte_status_t status) :
+        std::runtime_error(message_for(status)), code(status) { }
+    
+    cte_status_t status() const noexcept {
+        return code;
+    } // end status
+    
+    static const char *message_for(cte_status_t status) noexcept {
+        switch (status) {
+            case CTE_STATUS_INVALID_TEMPLATE :
+                return "cte: invalid template";
+            case CTE_STATUS_INVALID_PLACEHOLDERS :
+                return "cte: invalid placeholder identifier or value";
+            case CTE_STATUS_NESTING_LIMIT_EXCEEDED :
+                return "cte: template nesting limit exceeded";
+            case CTE_STATUS_INVALID_TARGET :
+                return "cte: invalid target";
+            case CTE_STATUS_INVALID_STATE :
+                return "cte: invalid render state";
+            case CTE_STATUS_UNAVAILABLE :
+                return "cte: feature not available in this build";
+            case CTE_STATUS_OUTPUT_LIMIT_EXCEEDED :
+                return "cte: render output limit exceeded";
+            case CTE_STATUS_EXPANSION_LIMIT_EXCEEDED :
+                return "cte: render expansion limit exceeded";
+            case CTE_STATUS_DEADLINE_EXCEEDED :
+                return "cte: render deadline exceeded";
+            default :
+                return "cte: operation failed";
+        } // end switch
+    } // end message_for
+}; // error
+
+
+namespace detail {
+
+
+// ---------------------------------------------------------------------------
+// function:  check( status )
+// ---------------------------------------------------------------------------
+//
+// Throws std::bad_alloc or cte::error if <status> indicates a failure.
+
+inline void check(cte_status_t status) {
+    if (status == CTE_STATUS_SUCCESS)
+        return;
+    
+    if (status == CTE_STATUS_ALLOCATION_FAILED)
+        throw std::bad_alloc();
+    
+    throw error(status);
+} // end check
+
+
+// ---------------------------------------------------------------------------
+// function:  data_of( str )
+// ---------------------------------------------------------------------------
+//
+// Returns the data pointer of string view <str>,  never NULL.
+
+inline const char *data_of(std::string_view str) noexcept {
+    return (str.data() != nullptr) ? str.data() : "";
+} // end data_of
+
+
+} // namespace detail
+
+
+// ---------------------------------------------------------------------------
+// Placeholder values type
+// ---------------------------------------------------------------------------
+//
+// A table of placeholder values,  each a string view associated with a place-
+// holder identifier.  Values are not copied,  they must remain valid while the
+// table is used.  The table owns a cte_table_t  and may be cleared and refil-
+// led for any number of renders without allocation.  It may be moved but not
+// copied.
+//
+// Values may be announced as pending  and completed later,  in any order.
+// Callbacks waiting for a pending value are called when it is completed.
+
+class values {
+    cte_table_t table_;
+    std::vector<std::pair<std::string, std::function<void()>>> waiting_;
+    
+    // identifiers are passed to the table as terminated strings
+    static void terminate_identifier(std::string_view identifier,
+                                     char *ident) {
+        if ((identifier.empty()) ||
+            (identifier.size() > CTE_MAX_PLACEHOLDER_LENGTH))
+            throw error(CTE_STATUS_INVALID_PLACEHOLDERS);
+        
+        identifier.copy(ident, identifier.size());
+        ident[identifier.size()] = '\0';
+    } // end terminate_identifier
+    
+public:
+    
+    // -----------------------------------------------------------------------
+    // Constructors and destructor
+    // -----------------------------------------------------------------------
+    //
+    // A table may be constructed empty,  from an initializer list of identi-
+    // fier and value pairs,  or from any range of such pairs,  for example a
+    // std::map or std::unordered_map of string views.
+    
+    values() : table_(cte_new_table(0, nullptr)) {
+        if (table_ == nullptr)
+            throw std::bad_alloc();
+    } // end values
+    
+    values(std::initializer_list<std::pair<std::string_view,
+                                           std::string_view>> list) :
+        values() {
+        for (const auto &entry : list)
+            set(entry.first, entry.second);
+    } // end values
+    
+    template <typename Range>
+    explicit values(const Range &range) : values() {
+        for (const auto &entry : range)
+            set(entry.first, entry.second);
+    } // end values
+    
+    values(values &&other) noexcept :
+        table_(other.table_), waiting_(std::move(other.waiting_)) {
+        other.table_ = nullptr;
+    } // end values
+    
+    values &operator=(values &&other) noexcept {
+        std::swap(table_, other.table_);
+        std::swap(waiting_, other.waiting_);
+        return *this;
+    } // end operator=
+    
+    values(const values &) = delete;
+    values &operator=(const values &) = delete;
+    
+    ~values() {
+        cte_dispose_table(table_);
+    } // end ~values
+    
+    
+    // -----------------------------------------------------------------------
+    // function:  values::set( identifier, value )
+    // -----------------------------------------------------------------------
+    //
+    // Stores value <value>  for placeholder <identifier>,  replacing any value
+    // previously stored for the same placeholder.  Throws cte::error if <iden-
+    // tifier> is not a valid placeholder identifier.
+    
+    void set(std::string_view identifier, std::string_view value) {
+        char ident[CTE_MAX_PLACEHOLDER_LENGTH + 1];
+        cte_table_status_t status;
+        
+        terminate_identifier(identifier, ident);
+        
+        cte_table_store_value(table_, ident, detail::data_of(value),
+                              value.size(), &status);
+        
+        if (status == CTE_TABLE_STATUS_ALLOCATION_FAILED)
+            throw std::bad_alloc();
+        
+        if (status != CTE_TABLE_STATUS_SUCCESS)
+            throw error(CTE_STATUS_INVALID_PLACEHOLDERS);
+    } // end set
+    
+    
+    // -----------------------------------------------------------------------
+    // function:  values::set_rows( identifier, rows, count )
+    // -----------------------------------------------------------------------
+    //
+    // Stores the array of <count> row tables passed in <rows>  for section
+    // <identifier>,  replacing any value or rows previously stored for the
+    // same identifier.  The array is not copied,  it must remain valid while
+    // the table is used.  Row tables may be obtained from values::table().
+    // Throws cte::error if <identifier> is not a valid placeholder identifier.
+    
+    void set_rows(std::string_view identifier,
+                  const cte_table_t *rows, std::size_t count) {
+        char ident[CTE_MAX_PLACEHOLDER_LENGTH + 1];
+        cte_table_status_t status;
+        
+        terminate_identifier(identifier, ident);
+        
+        cte_table_store_rows(table_, ident, rows,
+                             static_cast<cardinal>(count), &status);
+        
+        if (status == CTE_TABLE_STATUS_ALLOCATION_FAILED)
+            throw std::bad_alloc();
+        
+        if (status != CTE_TABLE_STATUS_SUCCESS)
+            throw error(CTE_STATUS_INVALID_PLACEHOLDERS);
+    } // end set_rows
+    
+    
+    // -----------------------------------------------------------------------
+    // function:  values::set_pending( identifier )
+    // -----------------------------------------------------------------------
+    //
+    // Marks the value of placeholder <identifier> as pending,  replacing any
+    // value previously stored for the same placeholder.  A render state stops
+    // at the placeholder until the value is completed.  Throws cte::error if
+    // <identifier> is not a valid placeholder identifier.
+    
+    void set_pending(std::string_view identifier) {
+        char ident[CTE_MAX_PLACEHOLDER_LENGTH + 1];
+        cte_table_status_t status;
+        
+        terminate_identifier(identifier, ident);
+        
+        cte_table_store_pending(table_, ident, &status);
+        
+        if (status == CTE_TABLE_STATUS_ALLOCATION_FAILED)
+            throw std::bad_alloc();
+        
+        if (status != CTE_TABLE_STATUS_SUCCESS)
+            throw error(CTE_STATUS_INVALID_PLACEHOLDERS);
+    } // end set_pending
+    
+    
+    // -----------------------------------------------------------------------
+    // function:  values::complete( identifier, value )
+    // -----------------------------------------------------------------------
+    //
+    // Stores value <value> for placeholder <identifier>  like values::set()
+    // and then calls all callbacks waiting for the placeholder,  in the order
+    // in which they were registered.  Callbacks are removed before they are
+    // called,  they may register further callbacks.
+    
+    void complete(std::string_view identifier, std::string_view value) {
+        std::vector<std::function<void()>> ready;
+        
+        set(identifier, value);
+        
+        for (auto entry = waiting_.begin(); entry != waiting_.end(); ) {
+            if (entry->first == identifier) {
+                ready.push_back(std::move(entry->second));
+                entry = waiting_.erase(entry);
+            }
+            else {
+                ++entry;
+            } // end if
+        } // end for
+        
+        for (auto &callback : ready)
+            callback();
+    } // end complete
+    
+    
+    // -----------------------------------------------------------------------
+    // function:  values::on_complete( identifier, callback )
+    // -----------------------------------------------------------------------
+    //
+    // Registers <callback>  to be called once  when the value of placeholder
+    // <identifier> is completed by values::complete().
+    
+    void on_complete(std::string_view identifier,
+                     std::function<void()> callback) {
+        waiting_.emplace_back(std::string(identifier), std::move(callback));
+    } // end on_complete
+    
+    
+    // -----------------------------------------------------------------------
+    // function:  values::clear()
+    // -----------------------------------------------------------------------
+    //
+    // Removes all values without deallocating the table's storage.
+    
+    void clear() noexcept {
+        cte_table_reset(table_);
+    } // end clear
+    
+    
+    // -----------------------------------------------------------------------
+    // function:  values::size()
+    // -----------------------------------------------------------------------
+    //
+    // Returns the number of values stored in the table.
+    
+    std::size_t size() const noexcept {
+        return cte_table_number_of_entries(table_);
+    } // end size
+    
+    
+    // -----------------------------------------------------------------------
+    // function:  values::table()
+    // -----------------------------------------------------------------------
+    //
+    // Returns the underlying placeholder table  for use with the functions in
+    // CTE.h.  The table remains owned by this object.
+    
+    cte_table_t table() const noexcept {
+        return table_;
+    } // end table
+}; // values
+
+
+// ---------------------------------------------------------------------------
+// function:  render_into( target, tmplate, values )
+// ---------------------------------------------------------------------------
+//
+// Recursively expands  all placeholder strings  in template <tmplate>  with
+// the values in <values>  and stores the result in string <target>,  replac-
+// ing its contents.  The template is recognised according to the grammar and
+// static semantics described for cte_string_from_template() in CTE.h.
+//
+// The length of the result is determined by a silent sizing render first,
+// the target is then resized once to that length and the template is ren-
+// dered directly into its storage.  Notifications and diagnostics are passed
+// to the handlers once,  by the second render.  The capacity of the target is
+// reused,  so that a target reused for renders of similar size is neither
+// enlarged nor copied.  Where std::basic_string::resize_and_overwrite() is
+// available,  the storage is not filled before it is rendered into.  Any
+// string type with a char allocator may be used,  including std::pmr::string.
+//
+// Throws cte::error if the template nesting limit is exceeded,  or std::bad_
+// alloc if allocation fails.  The target is empty if an exception is thrown.
+
+template <typename Allocator>
+void render_into(std::basic_string<char, std::char_traits<char>,
+                                   Allocator> &target,
+                 std::string_view tmplate,
+                 const values &values) {
+    
+    cte_status_t status;
+    std::size_t length;
+    
+    // determine the length of the result without reporting events
+    length = cte_render_table_length(detail::data_of(tmplate), tmplate.size(),
+                                     values.table(), &status);
+    
+    if (status != CTE_STATUS_SUCCESS) {
+        target.clear();
+        detail::check(status);
+    } // end if
+    
+    // render into the storage of the target, resized once
+#if defined(__cpp_lib_string_resize_and_overwrite)
+    target.resize_and_overwrite(length,
+        [&](char *data, std::size_t size) -> std::size_t {
+            return cte_render_table_into(data, size + 1,
+                                         detail::data_of(tmplate),
+                                         tmplate.size(), values.table(),
+                                         &status);
+        });
+#else
+    target.resize(length);
+    cte_render_table_into(target.data(), length + 1,
+                          detail::data_of(tmplate), tmplate.size(),
+                          values.table(), &status);
+#endif
+    
+    if (status != CTE_STATUS_SUCCESS) {
+        target.clear();
+        detail::check(status);
+    } // end if
+    
+    return;
+} // end render_into
+
+
+// ---------------------------------------------------------------------------
+// function:  render( tmplate, values, buffer )
+// ---------------------------------------------------------------------------
+//
+// Renders template <tmplate> with the values in <values> like render_into()
+// and returns the result.  The result is rendered into string <buffer>,  which
+// is moved in and moved out,  so that a buffer may be recycled without copy-
+// ing,  as in  buffer = cte::render(tmplate, values, std::move(buffer)).
+
+template <typename String = std::string>
+String render(std::string_view tmplate,
+              const values &values,
+              String buffer = String()) {
+    
+    render_into(buffer, tmplate, values);
+    return buffer;
+} // end render
+
+
+// ---------------------------------------------------------------------------
+// Resumable render state type
+// ---------------------------------------------------------------------------
+//
+// Renders a template  with the values in a values object  step by step into
+// caller supplied buffers of any size,  as described for cte_render_step() in
+// CTE.h.  The template is copied,  the values object is referenced and must
+// outlive the render state.  A render state may be moved but not copied.
+//
+// When a step stops at a pending value,  the identifier of the placeholder is
+// returned by pending().  The caller may register a callback with on_comple-
+// tion()  or,  in a coroutine,  co_await completion()  before the next step:
+//
+//   while (!state.done()) {
+//       socket.write(buffer, state.step(buffer, sizeof(buffer)));
+//       co_await state.completion();
+//   }
+
+class render_state {
+    std::unique_ptr<char[]> source_;
+    cte_render_state_t state_;
+    values *values_;
+    
+public:
+    
+    // -----------------------------------------------------------------------
+    // Constructors and destructor
+    // -----------------------------------------------------------------------
+    
+    render_state(std::string_view tmplate, values &values) :
+        source_(new char[tmplate.size() + 1]), values_(&values) {
+        cte_status_t status;
+        
+        tmplate.copy(source_.get(), tmplate.size());
+        source_[tmplate.size()] = '\0';
+        
+        state_ = cte_new_render_state_with_table(source_.get(),
+                                                 values.table(), &status);
+        detail::check(status);
+    } // end render_state
+    
+    render_state(render_state &&other) noexcept :
+        source_(std::move(other.source_)),
+        state_(other.state_), values_(other.values_) {
+        other.state_ = nullptr;
+    } // end render_state
+    
+    render_state &operator=(render_state &&other) noexcept {
+        std::swap(source_, other.source_);
+        std::swap(state_, other.state_);
+        std::swap(values_, other.values_);
+        return *this;
+    } // end operator=
+    
+    render_state(const render_state &) = delete;
+    render_state &operator=(const render_state &) = delete;
+    
+    ~render_state() {
+        cte_dispose_render_state(state_);
+    } // end ~render_state
+    
+    
+    // -----------------------------------------------------------------------
+    // function:  render_state::step( buffer, capacity )
+    // -----------------------------------------------------------------------
+    //
+    // Writes up to <capacity> bytes of output into <buffer>  and returns the
+    // number of bytes written.  Throws cte::error if the template nesting
+    // limit is exceeded,  or std::bad_alloc if allocation fails.
+    
+    std::size_t step(char *buffer, std::size_t capacity) {
+        cte_status_t status;
+        std::size_t length;
+        
+        length = cte_render_step(state_, buffer, capacity, &status);
+        detail::check(status);
+        
+        return length;
+    } // end step
+    
+    
+    // -----------------------------------------------------------------------
+    // function:  render_state::done()
+    // -----------------------------------------------------------------------
+    //
+    // Returns true if all output has been written.
+    
+    bool done() const noexcept {
+        return cte_render_state_done(state_);
+    } // end done
+    
+    
+    // -----------------------------------------------------------------------
+    // function:  render_state::pending()
+    // -----------------------------------------------------------------------
+    //
+    // Returns the identifier of the placeholder  at which the last step stop-
+    // ped because its value is pending,  or an empty view if it did not.
+    
+    std::string_view pending() const noexcept {
+        const char *identifier;
+        cardinal length;
+        
+        identifier = cte_render_state_pending(state_, &length);
+        
+        if (identifier == nullptr)
+            return std::string_view();
+        
+        return std::string_view(identifier, length);
+    } // end pending
+    
+    
+    // -----------------------------------------------------------------------
+    // function:  render_state::on_completion( callback )
+    // -----------------------------------------------------------------------
+    //
+    // Registers <callback>  to be called once  when the pending value at which
+    // the last step stopped is completed.  If the last step did not stop at a
+    // pending value,  <callback> is called immediately.
+    
+    void on_completion(std::function<void()> callback) {
+        std::string_view identifier = pending();
+        
+        if (identifier.empty())
+            callback();
+        else
+            values_->on_complete(identifier, std::move(callback));
+    } // end on_completion
+    
+    
+#ifdef CTE_HPP_COROUTINES
+    
+    // -----------------------------------------------------------------------
+    // function:  render_state::completion()
+    // -----------------------------------------------------------------------
+    //
+    // Returns an awaitable  that suspends the awaiting coroutine  until the
+    // pending value at which the last step stopped is completed.  It does not
+    // suspend if the last step did not stop at a pending value.  The coroutine
+    // is resumed by values::complete()  on the thread that calls it.
+    
+    class completion_awaiter {
+        render_state &state_;
+        
+    public:
+        explicit completion_awaiter(render_state &state) noexcept :
+            state_(state) {
+        } // end completion_awaiter
+        
+        bool await_ready() const noexcept {
+            return state_.pending().empty();
+        } // end await_ready
+        
+        void await_suspend(std::coroutine_handle<> handle) {
+            state_.values_->on_complete(state_.pending(),
+                                        [handle]() { handle.resume(); });
+        } // end await_suspend
+        
+        void await_resume() const noexcept {
+        } // end await_resume
+    }; // completion_awaiter
+    
+    completion_awaiter completion() noexcept {
+        return completion_awaiter(*this);
+    } // end completion
+    
+#endif
+}; // render_state
+
+
+} // namespace cte
+
+
+#endif /* CTE_HPP */
+
+// END OF FILE
@@ -22,6 +22,32 @@
 // deallocation function
 #define DEALLOCATE(_pointer) free(_pointer)
 
+// accounted allocation, reallocation, deallocation and release functions,
+// the size of a block is passed in by the caller, a released block has been
+// handed over to the caller and counts as deallocated
+#ifdef CTE_WITH_ALLOC_ACCOUNTING
+#include "cte_alloc.h"
+
+#define ALLOCATE_AT(_site, _size) cte_alloc_allocate(_site, _size)
+
+#define REALLOCATE_AT(_site, _pointer, _size, _new_size) \
+    cte_alloc_reallocate(_site, _pointer, _size, _new_size)
+
+#define DEALLOCATE_AT(_site, _pointer, _size) \
+    cte_alloc_deallocate(_site, _pointer, _size)
+
+#define RELEASE_AT(_site, _size) cte_alloc_release(_site, _size)
+#else
+#define ALLOCATE_AT(_site, _size) malloc(_size)
+
+#define REALLOCATE_AT(_site, _pointer, _size, _new_size) \
+    realloc(_pointer, _new_size)
+
+#define DEALLOCATE_AT(_site, _pointer, _size) free(_pointer)
+
+#define RELEASE_AT(_site, _size)
+#endif
+
 #endif /* ALLOC_H */
 
 // END OF FILE
\ No newline at end of file
@@ -0,0 +1,281 @@
+/* C Template Engine
+ *
+ *  @file cte_alloc.c
+ *  CTE allocation accounting implementation
+ *
+ *  Optional accounting of memory allocated by the template engine
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cte_alloc.h"
+
+
+#ifdef CTE_WITH_ALLOC_ACCOUNTING
+
+// ---------------------------------------------------------------------------
+// Thread local storage class
+// ---------------------------------------------------------------------------
+
+#ifndef CTE_NO_THREADS
+#define CTE_ALLOC_THREAD_LOCAL __thread
+#else
+#define CTE_ALLOC_THREAD_LOCAL
+#endif
+
+
+// ---------------------------------------------------------------------------
+// Statistics of the current thread
+// ---------------------------------------------------------------------------
+
+static CTE_ALLOC_THREAD_LOCAL cte_alloc_statistics_t _cte_alloc_statistics;
+
+
+// ===========================================================================
+// P R I V A T E   F U N C T I O N   P R O T O T Y P E S
+// ===========================================================================
+
+static fmacro void _account(cte_alloc_site_t site, int64_t delta);
+
+#endif /* CTE_WITH_ALLOC_ACCOUNTING */
+
+
+// ===========================================================================
+// P U B L I C   F U N C T I O N   I M P L E M E N T A T I O N S
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// function:  cte_alloc_get_statistics( statistics, status )
+// ---------------------------------------------------------------------------
+//
+// Passes back the allocation statistics of the calling thread in <statistics>.
+// The function fails if NULL is passed in for <statistics>  or if the library
+// was built without allocation accounting,  in which case all statistics are
+// passed back as zero.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_alloc_get_statistics(cte_alloc_statistics_t *statistics,
+                              cte_alloc_status_t *status) {
+    
+    // bail out if statistics is NULL
+    if (statistics == NULL) {
+        ASSIGN_BY_REF(status, CTE_ALLOC_STATUS_INVALID_STATISTICS);
+        return;
+    } // end if
+    
+#ifdef CTE_WITH_ALLOC_ACCOUNTING
+    *statistics = _cte_alloc_statistics;
+    
+    ASSIGN_BY_REF(status, CTE_ALLOC_STATUS_SUCCESS);
+#else
+    memset(statistics, 0, sizeof(cte_alloc_statistics_t));
+    
+    ASSIGN_BY_REF(status, CTE_ALLOC_STATUS_UNAVAILABLE);
+#endif
+    return;
+} // end cte_alloc_get_statistics
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_alloc_reset_statistics()
+// ---------------------------------------------------------------------------
+//
+// Resets the allocation counts of the calling thread to zero and its peak byte
+// counts to the number of bytes currently allocated,  so that peaks and counts
+// may be measured per render or per request.  Current byte counts are kept.
+
+void cte_alloc_reset_statistics(void) {
+#ifdef CTE_WITH_ALLOC_ACCOUNTING
+    #define this_site (_cte_alloc_statistics.site[site])
+    cardinal site;
+    
+    _cte_alloc_statistics.peak_bytes = _cte_alloc_statistics.current_bytes;
+    
+    for (site = 0; site < CTE_ALLOC_SITE_COUNT; site++) {
+        this_site.allocations = 0;
+        this_site.reallocations = 0;
+        this_site.deallocations = 0;
+        this_site.peak_bytes = this_site.current_bytes;
+    } // end for
+    
+    #undef this_site
+#endif
+    return;
+} // end cte_alloc_reset_statistics
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_alloc_allocate( site, size )
+// ---------------------------------------------------------------------------
+//
+// Allocates <size> bytes like malloc() and counts the allocation against site
+// <site>.  Returns NULL if allocation failed.
+
+void *cte_alloc_allocate(cte_alloc_site_t site, size_t size) {
+    void *pointer;
+    
+    pointer = malloc(size);
+    
+#ifdef CTE_WITH_ALLOC_ACCOUNTING
+    if (pointer != NULL) {
+        _cte_alloc_statistics.site[site].allocations++;
+        _account(site, size);
+    } // end if
+#else
+    (void) site;
+#endif
+    return pointer;
+} // end cte_alloc_allocate
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_alloc_reallocate( site, pointer, size, new_size )
+// ---------------------------------------------------------------------------
+//
+// Reallocates block <pointer> of <size> bytes to <new_size> bytes like real-
+// loc() and counts the reallocation against site <site>.  Returns NULL if re-
+// allocation failed,  in which case the block remains allocated unchanged.
+
+void *cte_alloc_reallocate(cte_alloc_site_t site,
+                           void *pointer, size_t size, size_t new_size) {
+    void *new_pointer;
+    
+    new_pointer = realloc(pointer, new_size);
+    
+#ifdef CTE_WITH_ALLOC_ACCOUNTING
+    if (new_pointer != NULL) {
+        _cte_alloc_statistics.site[site].reallocations++;
+        _account(site, (int64_t) new_size - (int64_t) size);
+    } // end if
+#else
+    (void) site;
+    (void) size;
+#endif
+    return new_pointer;
+} // end cte_alloc_reallocate
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_alloc_deallocate( site, pointer, size )
+// ---------------------------------------------------------------------------
+//
+// Deallocates block <pointer> of <size> bytes like free() and counts the deal-
+// location against site <site>.  Nothing is counted if <pointer> is NULL.
+
+void cte_alloc_deallocate(cte_alloc_site_t site, void *pointer, size_t size) {
+    
+#ifdef CTE_WITH_ALLOC_ACCOUNTING
+    if (pointer != NULL) {
+        _cte_alloc_statistics.site[site].deallocations++;
+        _account(site, -(int64_t) size);
+    } // end if
+#else
+    (void) site;
+    (void) size;
+#endif
+    free(pointer);
+    
+    return;
+} // end cte_alloc_deallocate
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_alloc_release( site, size )
+// ---------------------------------------------------------------------------
+//
+// Counts a block of <size> bytes handed over to the caller as deallocated at
+// site <site>.  The block itself is not deallocated.
+
+void cte_alloc_release(cte_alloc_site_t site, size_t size) {
+    
+#ifdef CTE_WITH_ALLOC_ACCOUNTING
+    _cte_alloc_statistics.site[site].deallocations++;
+    _account(site, -(int64_t) size);
+#else
+    (void) site;
+    (void) size;
+#endif
+    return;
+} // end cte_alloc_release
+
+
+#ifdef CTE_WITH_ALLOC_ACCOUNTING
+
+// ===========================================================================
+// P R I V A T E   F U N C T I O N   I M P L E M E N T A T I O N S
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// private function:  _account( site, delta )
+// ---------------------------------------------------------------------------
+//
+// Adds <delta> bytes to the current byte counts of site <site> and the total
+// of the calling thread and updates their peaks.
+
+static fmacro void _account(cte_alloc_site_t site, int64_t delta) {
+    #define this_site (_cte_alloc_statistics.site[site])
+    
+    this_site.current_bytes = this_site.current_bytes + delta;
+    
+    if (this_site.current_bytes > this_site.peak_bytes)
+        this_site.peak_bytes = this_site.current_bytes;
+    
+    _cte_alloc_statistics.current_bytes =
+        _cte_alloc_statistics.current_bytes + delta;
+    
+    if (_cte_alloc_statistics.current_bytes > _cte_alloc_statistics.peak_bytes)
+        _cte_alloc_statistics.peak_bytes = _cte_alloc_statistics.current_bytes;
+    
+    return;
+    #undef this_site
+} // _account
+
+#endif /* CTE_WITH_ALLOC_ACCOUNTING */
+
+
+// END OF FILE
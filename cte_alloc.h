@@ -0,0 +1,181 @@
+/* C Template Engine
+ *
+ *  @file cte_alloc.h
+ *  CTE allocation accounting interface
+ *
+ *  Optional accounting of memory allocated by the template engine
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#ifndef CTE_ALLOC_H
+#define CTE_ALLOC_H
+
+
+#include <stddef.h>
+
+#include "common.h"
+
+
+// ---------------------------------------------------------------------------
+// Availability
+// ---------------------------------------------------------------------------
+//
+// Allocation accounting is only functional  if the library is built with
+// CTE_WITH_ALLOC_ACCOUNTING defined,  otherwise the allocation macros in
+// alloc.h map directly to the C library  and no statistics are available.
+//
+// Statistics are kept per thread  without locking.  An operation is counted
+// against the thread that performs it,  memory deallocated by another thread
+// than the one that allocated it is credited to the deallocating thread.
+
+
+// ---------------------------------------------------------------------------
+// Allocation sites
+// ---------------------------------------------------------------------------
+//
+// The target site covers target strings and chunk buffers,  the stack site
+// covers dynamically allocated template context stacks  and the stack entry
+// site covers stack entries allocated above a stack's initial capacity.
+
+typedef enum /* cte_alloc_site_t */ {
+    CTE_ALLOC_SITE_TARGET,
+    CTE_ALLOC_SITE_STACK,
+    CTE_ALLOC_SITE_STACK_ENTRY,
+    CTE_ALLOC_SITE_COUNT /* number of sites */
+} cte_alloc_site_t;
+
+
+// ---------------------------------------------------------------------------
+// Allocation site statistics type
+// ---------------------------------------------------------------------------
+//
+// Counts of allocations, reallocations and deallocations at a site,  and the
+// number of bytes currently and at most allocated at the site.  Target strings
+// returned to the caller count as deallocated when they are returned.
+
+typedef struct /* cte_alloc_site_statistics_t */ {
+    uint64_t allocations;
+    uint64_t reallocations;
+    uint64_t deallocations;
+     int64_t current_bytes;
+     int64_t peak_bytes;
+} cte_alloc_site_statistics_t;
+
+
+// ---------------------------------------------------------------------------
+// Allocation statistics type
+// ---------------------------------------------------------------------------
+//
+// Number of bytes currently and at most allocated at all sites together and
+// statistics of each site,  indexed by cte_alloc_site_t.
+
+typedef struct /* cte_alloc_statistics_t */ {
+                        int64_t current_bytes;
+                        int64_t peak_bytes;
+    cte_alloc_site_statistics_t site[CTE_ALLOC_SITE_COUNT];
+} cte_alloc_statistics_t;
+
+
+// ---------------------------------------------------------------------------
+// Status codes
+// ---------------------------------------------------------------------------
+
+typedef enum /* cte_alloc_status_t */ {
+    CTE_ALLOC_STATUS_SUCCESS = 1,
+    CTE_ALLOC_STATUS_INVALID_STATISTICS,
+    CTE_ALLOC_STATUS_UNAVAILABLE
+} cte_alloc_status_t;
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_alloc_get_statistics( statistics, status )
+// ---------------------------------------------------------------------------
+//
+// Passes back the allocation statistics of the calling thread in <statistics>.
+// The function fails if NULL is passed in for <statistics>  or if the library
+// was built without allocation accounting,  in which case all statistics are
+// passed back as zero.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_alloc_get_statistics(cte_alloc_statistics_t *statistics,
+                                  cte_alloc_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_alloc_reset_statistics()
+// ---------------------------------------------------------------------------
+//
+// Resets the allocation counts of the calling thread to zero and its peak byte
+// counts to the number of bytes currently allocated,  so that peaks and counts
+// may be measured per render or per request.  Current byte counts are kept.
+
+void cte_alloc_reset_statistics(void);
+
+
+// ---------------------------------------------------------------------------
+// Accounting functions
+// ---------------------------------------------------------------------------
+//
+// The following functions are called by the allocation macros in alloc.h if
+// the library is built with CTE_WITH_ALLOC_ACCOUNTING defined.  They allocate,
+// reallocate and deallocate like their C library counterparts  and count the
+// operation against site <site>.  The size of a block is passed in by the
+// caller,  blocks carry no header and may be passed to free() as usual.  The
+// release function counts a block handed over to the caller as deallocated.
+
+void *cte_alloc_allocate(cte_alloc_site_t site, size_t size);
+
+void *cte_alloc_reallocate(cte_alloc_site_t site,
+                           void *pointer, size_t size, size_t new_size);
+
+void cte_alloc_deallocate(cte_alloc_site_t site, void *pointer, size_t size);
+
+void cte_alloc_release(cte_alloc_site_t site, size_t size);
+
+
+#endif /* CTE_ALLOC_H */
+
+// END OF FILE
@@ -0,0 +1,1286 @@
+/* C Template Engine
+ *
+ *  @file cte_cache.c
+ *  CTE output cache implementation
+ *
+ *  Bounded LRU cache of rendered output keyed by template and values
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include <string.h>
+
+#ifndef CTE_NO_THREADS
+#include <pthread.h>
+#endif
+
+#include "CTE.h"
+#include "ASCII.h"
+#include "alloc.h"
+#include "cte_cache.h"
+#include "cte_digest.h"
+#include "cte_metrics.h"
+
+
+// ---------------------------------------------------------------------------
+// Range checks
+// ---------------------------------------------------------------------------
+
+#if (CTE_DEFAULT_CACHE_ENTRIES < 1)
+#error CTE_DEFAULT_CACHE_ENTRIES must not be zero, recommended minimum is 64
+#endif
+
+#if (CTE_DEFAULT_CACHE_MEMORY < 1)
+#error CTE_DEFAULT_CACHE_MEMORY must not be zero, recommended minimum is 1 MB
+#endif
+
+
+// ---------------------------------------------------------------------------
+// Multiplier to spread template identities over buckets
+// ---------------------------------------------------------------------------
+
+#define CTE_CACHE_IDENTITY_MIX 0x9E3779B97F4A7C15ULL
+
+
+// ---------------------------------------------------------------------------
+// Recorded length of an undefined placeholder
+// ---------------------------------------------------------------------------
+
+#define CTE_CACHE_UNDEFINED_LENGTH SIZE_MAX
+
+
+// ---------------------------------------------------------------------------
+// Initial capacity of outputs of templates without a record
+// ---------------------------------------------------------------------------
+
+#define CTE_CACHE_OUTPUT_SIZE_INITIAL (4*1024) /* 4 KBytes */
+
+
+// ---------------------------------------------------------------------------
+// Lock macros
+// ---------------------------------------------------------------------------
+
+#ifndef CTE_NO_THREADS
+#define CTE_CACHE_LOCK(_cache) pthread_mutex_lock(&(_cache)->lock)
+#define CTE_CACHE_UNLOCK(_cache) pthread_mutex_unlock(&(_cache)->lock)
+#else
+#define CTE_CACHE_LOCK(_cache)
+#define CTE_CACHE_UNLOCK(_cache)
+#endif
+
+
+// ---------------------------------------------------------------------------
+// Output type
+// ---------------------------------------------------------------------------
+
+typedef struct /* cte_output_s */ {
+    cardinal ref_count;
+      size_t length;
+        char text[0];
+} cte_output_s;
+
+
+// ---------------------------------------------------------------------------
+// Output sink type
+// ---------------------------------------------------------------------------
+//
+// The context of the sink  that appends the result of an expansion  to output
+// <output> whose text has room for <capacity> characters and a terminator.
+
+typedef struct /* cte_output_sink_s */ {
+    cte_output_s *output;
+          size_t capacity;
+} cte_output_sink_s;
+
+
+// ---------------------------------------------------------------------------
+// Dependency list type
+// ---------------------------------------------------------------------------
+//
+// The keys of all placeholders an expansion of a template depends on,  in the
+// order reported by cte_placeholders_in_compiled().  A list is shared by the
+// record of its template and by all entries made with the same list,  it is
+// deallocated when its reference count drops to zero.
+
+typedef struct /* cte_cache_deps_s */ {
+    cardinal ref_count;
+    cardinal count;
+   kvs_key_t key[0];
+} cte_cache_deps_s;
+
+
+// ---------------------------------------------------------------------------
+// Template record pointer type for self referencing declaration
+// ---------------------------------------------------------------------------
+
+struct _cte_cache_template_s; /* FORWARD */
+
+typedef struct _cte_cache_template_s *cte_cache_template_p;
+
+
+// ---------------------------------------------------------------------------
+// Template record type
+// ---------------------------------------------------------------------------
+//
+// Holds the dependency list  found by the most recent expansion of the tem-
+// plate with identity <identity>,  so that a lookup  only needs to fingerprint
+// the current values of its placeholders,  without scanning the template and
+// values for placeholders,  and the length of the most recent output,  which
+// is the initial capacity of the next output.  A record exists while the
+// cache holds entries of its template,  it is chained into its hash bucket by
+// <next_in_bucket>.
+
+struct _cte_cache_template_s {
+                uint64_t identity;
+        cte_cache_deps_s *deps;
+                  size_t length;
+                cardinal entry_count;
+    cte_cache_template_p next_in_bucket;
+};
+
+typedef struct _cte_cache_template_s cte_cache_template_s;
+
+
+// ---------------------------------------------------------------------------
+// Cache entry pointer type for self referencing declaration
+// ---------------------------------------------------------------------------
+
+struct _cte_cache_entry_s; /* FORWARD */
+
+typedef struct _cte_cache_entry_s *cte_cache_entry_p;
+
+
+// ---------------------------------------------------------------------------
+// Cache entry type
+// ---------------------------------------------------------------------------
+//
+// Entries are chained into their hash bucket by <next_in_bucket>  and into the
+// recency list by <newer> and <older>.  The values of the placeholders in the
+// entry's dependency list  that the output was expanded with  follow the entry
+// in the same allocation,  each as its length followed by its characters,  or
+// as length CTE_CACHE_UNDEFINED_LENGTH alone if the placeholder was undefined.
+
+struct _cte_cache_entry_s {
+             uint64_t identity;
+             uint64_t fingerprint;
+ cte_cache_template_s *tmplate;
+     cte_cache_deps_s *deps;
+         cte_output_s *output;
+               size_t memory;
+    cte_cache_entry_p next_in_bucket;
+    cte_cache_entry_p newer;
+    cte_cache_entry_p older;
+                 char values[0];
+};
+
+typedef struct _cte_cache_entry_s cte_cache_entry_s;
+
+
+// ---------------------------------------------------------------------------
+// Cache type
+// ---------------------------------------------------------------------------
+//
+// The entry bucket array  and the template record bucket array  follow the
+// cache structure in the same allocation.  The recency list runs from the
+// most recently used entry <newest> to the least recently used entry <oldest>.
+
+typedef struct /* cte_cache_s */ {
+              cardinal entry_limit;
+                size_t memory_limit;
+              cardinal bucket_count;
+     cte_cache_entry_s *newest;
+     cte_cache_entry_s *oldest;
+     cte_cache_stats_t stats;
+#ifndef CTE_NO_THREADS
+       pthread_mutex_t lock;
+#endif
+  cte_cache_template_s **record;
+     cte_cache_entry_s *bucket[0];
+} cte_cache_s;
+
+
+// ===========================================================================
+// P R I V A T E   F U N C T I O N   P R O T O T Y P E S
+// ===========================================================================
+
+static cte_cache_deps_s *_new_deps(cte_placeholder_set_t set);
+
+static fmacro cte_cache_deps_s *_retain_deps(cte_cache_deps_s *deps);
+
+static void _release_deps(cte_cache_deps_s *deps);
+
+static bool _same_deps(const cte_cache_deps_s *deps1,
+                       const cte_cache_deps_s *deps2);
+
+static uint64_t _fingerprint(const cte_cache_deps_s *deps,
+                             kvs_table_t placeholders);
+
+static cte_cache_entry_s *_new_entry(uint64_t identity,
+                   cte_cache_deps_s *deps, kvs_table_t placeholders);
+
+static bool _values_match(const cte_cache_entry_s *entry,
+                          kvs_table_t placeholders);
+
+static cte_cache_entry_s *_find_entry(cte_cache_s *cache,
+                   uint64_t identity, uint64_t fingerprint,
+                   const cte_cache_deps_s *deps, kvs_table_t placeholders);
+
+static fmacro cte_cache_entry_s **_bucket_for(cte_cache_s *cache,
+                         uint64_t identity, uint64_t fingerprint);
+
+static fmacro cte_cache_template_s **_record_bucket_for(cte_cache_s *cache,
+                                                        uint64_t identity);
+
+static cte_cache_template_s *_record_for(cte_cache_s *cache,
+                                         uint64_t identity);
+
+static void _touch_entry(cte_cache_s *cache, cte_cache_entry_s *entry);
+
+static void _remove_entry(cte_cache_s *cache, cte_cache_entry_s *entry);
+
+static void _dispose_entry(cte_cache_entry_s *entry);
+
+static cte_output_s *_render_output(cte_template_t compiled,
+                   kvs_table_t placeholders, size_t capacity,
+                   cte_status_t *status);
+
+static bool _append_to_output(const char *data, size_t length, void *sink);
+
+
+// ===========================================================================
+// P U B L I C   F U N C T I O N   I M P L E M E N T A T I O N S
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// function:  cte_new_cache( entry_limit, memory_limit, status )
+// ---------------------------------------------------------------------------
+//
+// Creates and returns a new empty output cache  which holds at most <entry_li-
+// mit> rendered outputs occupying at most <memory_limit> bytes in total.  If
+// zero is passed in for <entry_limit> or <memory_limit>,  then the respective
+// limit is CTE_DEFAULT_CACHE_ENTRIES or CTE_DEFAULT_CACHE_MEMORY.  When either
+// limit would be exceeded,  the least recently used outputs are evicted.  The
+// function fails if memory could not be allocated.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_cache_t cte_new_cache(cardinal entry_limit,
+                          size_t memory_limit,
+                          cte_status_t *status) {
+    cte_cache_s *cache;
+    cardinal bucket_count;
+    
+    // zero limits mean defaults
+    if (entry_limit == 0)
+        entry_limit = CTE_DEFAULT_CACHE_ENTRIES;
+    
+    if (memory_limit == 0)
+        memory_limit = CTE_DEFAULT_CACHE_MEMORY;
+    
+    // one bucket per entry, rounded up to a power of two
+    bucket_count = 1;
+    
+    while (bucket_count < entry_limit)
+        bucket_count = bucket_count << 1;
+    
+    // bucket arrays for entries and for template records
+    cache = ALLOCATE(sizeof(cte_cache_s) +
+                     bucket_count * sizeof(cte_cache_entry_s *) +
+                     bucket_count * sizeof(cte_cache_template_s *));
+    
+    // bail out if allocation failed
+    if (cache == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_ALLOCATION_FAILED);
+        return NULL;
+    } // end if
+    
+    // initialise meta data
+    cache->entry_limit = entry_limit;
+    cache->memory_limit = memory_limit;
+    cache->bucket_count = bucket_count;
+    cache->newest = NULL;
+    cache->oldest = NULL;
+    memset(&cache->stats, 0, sizeof(cte_cache_stats_t));
+    memset(cache->bucket, 0, bucket_count * sizeof(cte_cache_entry_s *));
+    cache->record = (cte_cache_template_s **) &cache->bucket[bucket_count];
+    memset(cache->record, 0, bucket_count * sizeof(cte_cache_template_s *));
+    
+#ifndef CTE_NO_THREADS
+    pthread_mutex_init(&cache->lock, NULL);
+#endif
+    
+    ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
+    return (cte_cache_t) cache;
+} // end cte_new_cache
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_cache_render( cache, compiled, placeholders, status )
+// ---------------------------------------------------------------------------
+//
+// Returns the result of expanding compiled template <compiled>  with the va-
+// lues in <placeholders>,  as an output object.  If an output for the same
+// template and the same values of all placeholders the expansion depends on
+// is held in cache <cache>,  that output is returned without expanding the
+// template.  Otherwise the template is expanded  and the result is entered
+// into the cache.  If NULL is passed in for <cache>,  the template is expanded
+// without caching.  The function fails if NULL is passed in for <compiled> or
+// <placeholders> or if allocation fails or the template nesting limit is ex-
+// ceeded.  The function returns NULL if it fails.
+//
+// Templates are identified by cte_template_identity().  For each template,
+// the cache keeps the placeholders its expansion depends on  as reported by
+// cte_placeholders_in_compiled(),  so that a lookup  only takes an xxHash64
+// fingerprint of their current values,  without scanning the template or the
+// values for placeholders and without allocating.  Before an output is re-
+// turned,  the values it was expanded with are compared with the current va-
+// lues in length and characters,  a fingerprint collision is never mistaken
+// for a hit.
+//
+// Outputs are reference counted and shared between the cache and all callers
+// that obtained them.  The caller must release the returned output by calling
+// cte_release_output() when it is no longer needed.  The cache may be used by
+// multiple threads concurrently.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_output_t cte_cache_render(cte_cache_t cache,
+                              cte_template_t compiled,
+                              kvs_table_t placeholders,
+                              cte_status_t *status) {
+    
+    #define this_cache ((cte_cache_s *)cache)
+    cte_cache_entry_s *entry = NULL, *existing, **bucket;
+    cte_cache_template_s *record, **link;
+    cte_cache_deps_s *deps = NULL;
+    cte_placeholder_set_t set;
+    cte_output_s *output;
+    cte_status_t r_status;
+    uint64_t identity, fingerprint = 0;
+    size_t capacity = CTE_CACHE_OUTPUT_SIZE_INITIAL;
+    
+    // bail out if compiled template is NULL
+    if (compiled == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_TEMPLATE);
+        return NULL;
+    } // end if
+    
+    // bail out if placeholders is NULL
+    if (placeholders == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_INVALID_PLACEHOLDERS);
+        return NULL;
+    } // end if
+    
+    identity = cte_template_identity(compiled);
+    
+    // look up output in cache
+    if (cache != NULL) {
+        CTE_CACHE_LOCK(this_cache);
+        record = _record_for(this_cache, identity);
+        
+        if (record != NULL) {
+            deps = _retain_deps(record->deps);
+            capacity = record->length;
+        } // end if
+        
+        CTE_CACHE_UNLOCK(this_cache);
+        
+        // fingerprint current values of the template's known dependencies
+        if (deps != NULL)
+            fingerprint = _fingerprint(deps, placeholders);
+        
+        CTE_CACHE_LOCK(this_cache);
+        
+        if (deps != NULL)
+            entry = _find_entry(this_cache, identity, fingerprint,
+                                deps, placeholders);
+        
+        // cache hit
+        if (entry != NULL) {
+            this_cache->stats.hits++;
+            _touch_entry(this_cache, entry);
+            output = cte_retain_output(entry->output);
+            CTE_CACHE_UNLOCK(this_cache);
+            
+            _release_deps(deps);
+            CTE_METRIC_ADD(CTE_METRIC_CACHE_HITS, 1);
+            
+            ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
+            return (cte_output_t) output;
+        } // end if
+        
+        this_cache->stats.misses++;
+        
+        CTE_CACHE_UNLOCK(this_cache);
+        _release_deps(deps);
+        
+        // find the placeholders the expansion depends on
+        set = cte_placeholders_in_compiled(compiled, placeholders, &r_status);
+        
+        // bail out if set could not be obtained
+        if (set == NULL) {
+            ASSIGN_BY_REF(status, r_status);
+            return NULL;
+        } // end if
+        
+        deps = _new_deps(set);
+        cte_dispose_placeholder_set(set);
+        
+        // the entry records the values the output is expanded with
+        if (deps != NULL) {
+            entry = _new_entry(identity, deps, placeholders);
+            _release_deps(deps);
+        } // end if
+        
+        // bail out if allocation failed
+        if (entry == NULL) {
+            ASSIGN_BY_REF(status, CTE_STATUS_ALLOCATION_FAILED);
+            return NULL;
+        } // end if
+    } // end if
+    
+    // expand template outside the lock
+    output = _render_output(compiled, placeholders, capacity, &r_status);
+    
+    // bail out if expansion failed
+    if (output == NULL) {
+        _dispose_entry(entry);
+        ASSIGN_BY_REF(status, r_status);
+        return NULL;
+    } // end if
+    
+    // done if not caching
+    if (cache == NULL) {
+        ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
+        return (cte_output_t) output;
+    } // end if
+    
+    entry->memory =
+        entry->memory + sizeof(cte_output_s) + output->length + 1;
+    
+    // done if output alone exceeds memory limit
+    if (entry->memory > this_cache->memory_limit) {
+        _dispose_entry(entry);
+        
+        ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
+        return (cte_output_t) output;
+    } // end if
+    
+    entry->output = cte_retain_output(output);
+    
+    CTE_CACHE_LOCK(this_cache);
+    
+    record = _record_for(this_cache, identity);
+    
+    // enter a record for the template if it has none
+    if (record == NULL) {
+        record = ALLOCATE(sizeof(cte_cache_template_s));
+        
+        // output is still good if record allocation failed
+        if (record == NULL) {
+            CTE_CACHE_UNLOCK(this_cache);
+            _dispose_entry(entry);
+            
+            ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
+            return (cte_output_t) output;
+        } // end if
+        
+        record->identity = identity;
+        record->deps = _retain_deps(entry->deps);
+        record->length = 0;
+        record->entry_count = 0;
+        
+        link = _record_bucket_for(this_cache, identity);
+        record->next_in_bucket = *link;
+        *link = record;
+    }
+    // share the record's dependency list if it is the same
+    else if (_same_deps(record->deps, entry->deps)) {
+        _release_deps(entry->deps);
+        entry->deps = _retain_deps(record->deps);
+    }
+    // dependencies have changed, later lookups use the new list
+    else {
+        _release_deps(record->deps);
+        record->deps = _retain_deps(entry->deps);
+    } // end if
+    
+    existing = _find_entry(this_cache, identity, entry->fingerprint,
+                           entry->deps, placeholders);
+    
+    // bail out if another thread entered the same output meanwhile
+    if (existing != NULL) {
+        CTE_CACHE_UNLOCK(this_cache);
+        _dispose_entry(entry);
+        
+        ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
+        return (cte_output_t) output;
+    } // end if
+    
+    // count entry against its record first, eviction must not remove it
+    entry->tmplate = record;
+    record->entry_count++;
+    record->length = output->length;
+    
+    // evict least recently used entries until new entry fits
+    while ((this_cache->stats.entries >= this_cache->entry_limit) ||
+           (this_cache->stats.memory + entry->memory >
+            this_cache->memory_limit)) {
+        this_cache->stats.evictions++;
+        _remove_entry(this_cache, this_cache->oldest);
+    } // end while
+    
+    // enter new entry as most recently used
+    bucket = _bucket_for(this_cache, identity, entry->fingerprint);
+    entry->next_in_bucket = *bucket;
+    *bucket = entry;
+    _touch_entry(this_cache, entry);
+    
+    this_cache->stats.entries++;
+    this_cache->stats.memory = this_cache->stats.memory + entry->memory;
+    
+    CTE_CACHE_UNLOCK(this_cache);
+    
+    ASSIGN_BY_REF(status, CTE_STATUS_SUCCESS);
+    return (cte_output_t) output;
+    
+    #undef this_cache
+} // end cte_cache_render
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_cache_get_stats( cache, stats )
+// ---------------------------------------------------------------------------
+//
+// Passes back the hit,  miss and eviction counters  and the current number of
+// entries and memory use of cache <cache> in <stats>.  Does nothing if NULL is
+// passed in for <cache> or <stats>.
+
+void cte_cache_get_stats(cte_cache_t cache, cte_cache_stats_t *stats) {
+    #define this_cache ((cte_cache_s *)cache)
+    
+    if ((cache == NULL) || (stats == NULL))
+        return;
+    
+    CTE_CACHE_LOCK(this_cache);
+    *stats = this_cache->stats;
+    CTE_CACHE_UNLOCK(this_cache);
+    
+    return;
+    #undef this_cache
+} // end cte_cache_get_stats
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_cache_clear( cache )
+// ---------------------------------------------------------------------------
+//
+// Removes all outputs from cache <cache>.  Outputs still held by callers re-
+// main valid until released.  Counters are not reset.
+
+void cte_cache_clear(cte_cache_t cache) {
+    #define this_cache ((cte_cache_s *)cache)
+    
+    if (cache == NULL)
+        return;
+    
+    CTE_CACHE_LOCK(this_cache);
+    
+    while (this_cache->oldest != NULL)
+        _remove_entry(this_cache, this_cache->oldest);
+    
+    CTE_CACHE_UNLOCK(this_cache);
+    
+    return;
+    #undef this_cache
+} // end cte_cache_clear
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_dispose_cache( cache )
+// ---------------------------------------------------------------------------
+//
+// Disposes of cache object <cache>.  Outputs still held by callers remain va-
+// lid until released.  Returns NULL.
+
+cte_cache_t cte_dispose_cache(cte_cache_t cache) {
+    #define this_cache ((cte_cache_s *)cache)
+    
+    if (cache == NULL)
+        return NULL;
+    
+    cte_cache_clear(cache);
+    
+#ifndef CTE_NO_THREADS
+    pthread_mutex_destroy(&this_cache->lock);
+#endif
+    
+    DEALLOCATE(cache);
+    return NULL;
+    
+    #undef this_cache
+} // end cte_dispose_cache
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_output_string( output )
+// ---------------------------------------------------------------------------
+//
+// Returns the terminated string held by output <output>.  The string must not
+// be modified  and remains valid until the output is released.  Returns NULL
+// if NULL is passed in for <output>.
+
+const char *cte_output_string(cte_output_t output) {
+    
+    if (output == NULL)
+        return NULL;
+    
+    return ((cte_output_s *) output)->text;
+} // end cte_output_string
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_output_length( output )
+// ---------------------------------------------------------------------------
+//
+// Returns the length of the string held by output <output>, not counting the
+// terminator.  Returns zero if NULL is passed in for <output>.
+
+size_t cte_output_length(cte_output_t output) {
+    
+    if (output == NULL)
+        return 0;
+    
+    return ((cte_output_s *) output)->length;
+} // end cte_output_length
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_retain_output( output )
+// ---------------------------------------------------------------------------
+//
+// Increments the reference count of output <output>  and returns <output>.
+// Every call must be balanced by a call to cte_release_output().
+
+cte_output_t cte_retain_output(cte_output_t output) {
+    
+    if (output != NULL)
+        __sync_add_and_fetch(&((cte_output_s *) output)->ref_count, 1);
+    
+    return output;
+} // end cte_retain_output
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_release_output( output )
+// ---------------------------------------------------------------------------
+//
+// Decrements the reference count of output <output>  and deallocates it when
+// the count drops to zero.  Returns NULL.
+
+cte_output_t cte_release_output(cte_output_t output) {
+    
+    if (output == NULL)
+        return NULL;
+    
+    if (__sync_sub_and_fetch(&((cte_output_s *) output)->ref_count, 1) == 0)
+        DEALLOCATE(output);
+    
+    return NULL;
+} // end cte_release_output
+
+
+// ===========================================================================
+// P R I V A T E   F U N C T I O N   I M P L E M E N T A T I O N S
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// private function:  _new_deps( set )
+// ---------------------------------------------------------------------------
+//
+// Allocates and returns a new dependency list  holding the keys of the place-
+// holders in placeholder set <set>,  with a reference count of one.  Returns
+// NULL if allocation fails.
+
+static cte_cache_deps_s *_new_deps(cte_placeholder_set_t set) {
+    cte_cache_deps_s *deps;
+    cardinal index, count;
+    
+    count = cte_placeholder_set_count(set);
+    deps = ALLOCATE(sizeof(cte_cache_deps_s) + count * sizeof(kvs_key_t));
+    
+    if (deps == NULL)
+        return NULL;
+    
+    deps->ref_count = 1;
+    deps->count = count;
+    
+    for (index = 0; index < count; index++)
+        deps->key[index] = cte_placeholder_set_key(set, index);
+    
+    return deps;
+} // _new_deps
+
+
+// ---------------------------------------------------------------------------
+// private function:  _retain_deps( deps )
+// ---------------------------------------------------------------------------
+//
+// Increments the reference count of dependency list <deps>  and returns it.
+
+static fmacro cte_cache_deps_s *_retain_deps(cte_cache_deps_s *deps) {
+    
+    __sync_add_and_fetch(&deps->ref_count, 1);
+    
+    return deps;
+} // _retain_deps
+
+
+// ---------------------------------------------------------------------------
+// private function:  _release_deps( deps )
+// ---------------------------------------------------------------------------
+//
+// Decrements the reference count of dependency list <deps>  and deallocates
+// it when the count drops to zero.  Does nothing if <deps> is NULL.
+
+static void _release_deps(cte_cache_deps_s *deps) {
+    
+    if (deps == NULL)
+        return;
+    
+    if (__sync_sub_and_fetch(&deps->ref_count, 1) == 0)
+        DEALLOCATE(deps);
+    
+    return;
+} // _release_deps
+
+
+// ---------------------------------------------------------------------------
+// private function:  _same_deps( deps1, deps2 )
+// ---------------------------------------------------------------------------
+//
+// Returns true if dependency lists <deps1> and <deps2> hold the same keys in
+// the same order,  otherwise false.
+
+static bool _same_deps(const cte_cache_deps_s *deps1,
+                       const cte_cache_deps_s *deps2) {
+    
+    if (deps1 == deps2)
+        return true;
+    
+    if (deps1->count != deps2->count)
+        return false;
+    
+    return (memcmp(deps1->key, deps2->key,
+                   deps1->count * sizeof(kvs_key_t)) == 0);
+} // _same_deps
+
+
+// ---------------------------------------------------------------------------
+// private function:  _fingerprint( deps, placeholders )
+// ---------------------------------------------------------------------------
+//
+// Returns the xxHash64 fingerprint of the keys and values in <placeholders>
+// of the placeholders in dependency list <deps>.  Undefined placeholders con-
+// tribute their key only,  so defining a placeholder changes the fingerprint.
+// Nothing is allocated and no template or value is scanned for placeholders.
+
+static uint64_t _fingerprint(const cte_cache_deps_s *deps,
+                             kvs_table_t placeholders) {
+    
+    static const char undefined_marker = (char) 0xff;
+    cte_digest_state_t state;
+    cte_digest_t digest;
+    const char *value;
+    cardinal index;
+    
+    cte_digest_init(&state, CTE_DIGEST_XXH64);
+    
+    for (index = 0; index < deps->count; index++) {
+        cte_digest_update(&state, &deps->key[index], sizeof(kvs_key_t));
+        
+        // undefined placeholder contributes a single marker
+        if (NOT(kvs_entry_exists(placeholders, deps->key[index], NULL))) {
+            cte_digest_update(&state, &undefined_marker, 1);
+            continue;
+        } // end if
+        
+        // value including its terminator as separator
+        value = kvs_value_for_key(placeholders, deps->key[index], NULL);
+        cte_digest_update(&state, value, strlen(value) + 1);
+    } // end for
+    
+    cte_digest_final(&state, &digest);
+    
+    return digest.xxh64;
+} // _fingerprint
+
+
+// ---------------------------------------------------------------------------
+// private function:  _new_entry( identity, deps, placeholders )
+// ---------------------------------------------------------------------------
+//
+// Allocates and returns a new cache entry  for an output of the template with
+// identity <identity>  that depends on the placeholders in dependency list
+// <deps>.  Their values in <placeholders> are recorded in the entry  and the
+// entry's fingerprint is calculated from them.  The entry holds a reference
+// to <deps>,  it has no output yet  and is not entered into any list.  Its
+// memory accounts for the entry and the recorded values.  Returns NULL if
+// allocation fails.
+
+static cte_cache_entry_s *_new_entry(uint64_t identity,
+                                     cte_cache_deps_s *deps,
+                                     kvs_table_t placeholders) {
+    cte_cache_entry_s *entry;
+    const char *value;
+    size_t size, length;
+    cardinal index;
+    char *cursor;
+    
+    // size of recorded values
+    size = deps->count * sizeof(size_t);
+    
+    for (index = 0; index < deps->count; index++) {
+        if (kvs_entry_exists(placeholders, deps->key[index], NULL)) {
+            value = kvs_value_for_key(placeholders, deps->key[index], NULL);
+            size = size + strlen(value);
+        } // end if
+    } // end for
+    
+    entry = ALLOCATE(sizeof(cte_cache_entry_s) + size);
+    
+    if (entry == NULL)
+        return NULL;
+    
+    entry->identity = identity;
+    entry->fingerprint = _fingerprint(deps, placeholders);
+    entry->tmplate = NULL;
+    entry->deps = _retain_deps(deps);
+    entry->output = NULL;
+    entry->memory = sizeof(cte_cache_entry_s) + size;
+    entry->next_in_bucket = NULL;
+    entry->newer = NULL;
+    entry->older = NULL;
+    
+    // record each value as its length followed by its characters
+    cursor = entry->values;
+    
+    for (index = 0; index < deps->count; index++) {
+        
+        if (NOT(kvs_entry_exists(placeholders, deps->key[index], NULL))) {
+            length = CTE_CACHE_UNDEFINED_LENGTH;
+            memcpy(cursor, &length, sizeof(size_t));
+            cursor = cursor + sizeof(size_t);
+            continue;
+        } // end if
+        
+        value = kvs_value_for_key(placeholders, deps->key[index], NULL);
+        length = strlen(value);
+        memcpy(cursor, &length, sizeof(size_t));
+        memcpy(cursor + sizeof(size_t), value, length);
+        cursor = cursor + sizeof(size_t) + length;
+    } // end for
+    
+    return entry;
+} // _new_entry
+
+
+// ---------------------------------------------------------------------------
+// private function:  _values_match( entry, placeholders )
+// ---------------------------------------------------------------------------
+//
+// Returns true if the values in <placeholders>  of the placeholders in the
+// dependency list of cache entry <entry>  have the same lengths and charac-
+// ters as the values recorded in the entry,  and the same placeholders are
+// undefined,  otherwise false.
+
+static bool _values_match(const cte_cache_entry_s *entry,
+                          kvs_table_t placeholders) {
+    const char *cursor, *value;
+    size_t length;
+    cardinal index;
+    bool defined;
+    
+    cursor = entry->values;
+    
+    for (index = 0; index < entry->deps->count; index++) {
+        memcpy(&length, cursor, sizeof(size_t));
+        cursor = cursor + sizeof(size_t);
+        
+        defined =
+            kvs_entry_exists(placeholders, entry->deps->key[index], NULL);
+        
+        // placeholder must be undefined in both or defined in both
+        if (length == CTE_CACHE_UNDEFINED_LENGTH) {
+            if (defined)
+                return false;
+            
+            continue;
+        } // end if
+        
+        if (NOT(defined))
+            return false;
+        
+        value = kvs_value_for_key(placeholders, entry->deps->key[index], NULL);
+        
+        if ((strlen(value) != length) ||
+            (memcmp(value, cursor, length) != 0))
+            return false;
+        
+        cursor = cursor + length;
+    } // end for
+    
+    return true;
+} // _values_match
+
+
+// ---------------------------------------------------------------------------
+// private function:  _find_entry( cache, identity, fingerprint,
+//                                 deps, placeholders )
+// ---------------------------------------------------------------------------
+//
+// Returns the entry of cache <cache>  for the template with identity <iden-
+// tity>  made with dependency list <deps>  whose fingerprint is <fingerprint>
+// and whose recorded values match the values in <placeholders>.  A matching
+// fingerprint alone is not sufficient.  Returns NULL if there is no such en-
+// try.
+
+static cte_cache_entry_s *_find_entry(cte_cache_s *cache,
+                                      uint64_t identity,
+                                      uint64_t fingerprint,
+                                      const cte_cache_deps_s *deps,
+                                      kvs_table_t placeholders) {
+    cte_cache_entry_s *entry;
+    
+    entry = *_bucket_for(cache, identity, fingerprint);
+    
+    while (entry != NULL) {
+        if ((entry->identity == identity) &&
+            (entry->fingerprint == fingerprint) &&
+            (_same_deps(entry->deps, deps)) &&
+            (_values_match(entry, placeholders)))
+            return entry;
+        
+        entry = entry->next_in_bucket;
+    } // end while
+    
+    return NULL;
+} // _find_entry
+
+
+// ---------------------------------------------------------------------------
+// private function:  _bucket_for( cache, identity, fingerprint )
+// ---------------------------------------------------------------------------
+//
+// Returns a pointer to the head of the bucket chain  of cache <cache>  for the
+// entry with template identity <identity> and fingerprint <fingerprint>.
+
+static fmacro cte_cache_entry_s **_bucket_for(cte_cache_s *cache,
+                                              uint64_t identity,
+                                              uint64_t fingerprint) {
+    uint64_t hash;
+    
+    hash = (fingerprint ^ (identity * CTE_CACHE_IDENTITY_MIX));
+    hash = hash ^ (hash >> 32);
+    
+    return &cache->bucket[hash & (cache->bucket_count - 1)];
+} // _bucket_for
+
+
+// ---------------------------------------------------------------------------
+// private function:  _record_bucket_for( cache, identity )
+// ---------------------------------------------------------------------------
+//
+// Returns a pointer to the head of the bucket chain  of cache <cache>  for the
+// record of the template with identity <identity>.
+
+static fmacro cte_cache_template_s **_record_bucket_for(cte_cache_s *cache,
+                                                        uint64_t identity) {
+    uint64_t hash;
+    
+    hash = identity * CTE_CACHE_IDENTITY_MIX;
+    hash = hash ^ (hash >> 32);
+    
+    return &cache->record[hash & (cache->bucket_count - 1)];
+} // _record_bucket_for
+
+
+// ---------------------------------------------------------------------------
+// private function:  _record_for( cache, identity )
+// ---------------------------------------------------------------------------
+//
+// Returns the record of cache <cache>  for the template with identity <iden-
+// tity>,  or NULL if the cache holds no entries of the template.
+
+static cte_cache_template_s *_record_for(cte_cache_s *cache,
+                                         uint64_t identity) {
+    cte_cache_template_s *record;
+    
+    record = *_record_bucket_for(cache, identity);
+    
+    while ((record != NULL) && (record->identity != identity))
+        record = record->next_in_bucket;
+    
+    return record;
+} // _record_for
+
+
+// ---------------------------------------------------------------------------
+// private function:  _touch_entry( cache, entry )
+// ---------------------------------------------------------------------------
+//
+// Moves entry <entry> of cache <cache> to the head of the recency list,  mak-
+// ing it the most recently used entry.  The entry may or may not already be
+// linked into the recency list.
+
+static void _touch_entry(cte_cache_s *cache, cte_cache_entry_s *entry) {
+    
+    // nothing to do if already most recently used
+    if (cache->newest == entry)
+        return;
+    
+    // unlink from current position if linked
+    if (entry->newer != NULL)
+        entry->newer->older = entry->older;
+    
+    if (entry->older != NULL)
+        entry->older->newer = entry->newer;
+    else if (cache->oldest == entry)
+        cache->oldest = entry->newer;
+    
+    // link in at head
+    entry->newer = NULL;
+    entry->older = cache->newest;
+    
+    if (cache->newest != NULL)
+        cache->newest->newer = entry;
+    
+    cache->newest = entry;
+    
+    if (cache->oldest == NULL)
+        cache->oldest = entry;
+    
+    return;
+} // _touch_entry
+
+
+// ---------------------------------------------------------------------------
+// private function:  _remove_entry( cache, entry )
+// ---------------------------------------------------------------------------
+//
+// Removes entry <entry> from cache <cache>  and disposes of it.  The record
+// of its template is removed along with the last entry of the template.
+
+static void _remove_entry(cte_cache_s *cache, cte_cache_entry_s *entry) {
+    cte_cache_template_s **record_link;
+    cte_cache_entry_s **link;
+    
+    // unlink from bucket chain
+    link = _bucket_for(cache, entry->identity, entry->fingerprint);
+    
+    while (*link != entry)
+        link = &(*link)->next_in_bucket;
+    
+    *link = entry->next_in_bucket;
+    
+    // unlink from recency list
+    if (entry->newer != NULL)
+        entry->newer->older = entry->older;
+    else
+        cache->newest = entry->older;
+    
+    if (entry->older != NULL)
+        entry->older->newer = entry->newer;
+    else
+        cache->oldest = entry->newer;
+    
+    cache->stats.entries--;
+    cache->stats.memory = cache->stats.memory - entry->memory;
+    
+    // remove template record with its last entry
+    entry->tmplate->entry_count--;
+    
+    if (entry->tmplate->entry_count == 0) {
+        record_link = _record_bucket_for(cache, entry->identity);
+        
+        while (*record_link != entry->tmplate)
+            record_link = &(*record_link)->next_in_bucket;
+        
+        *record_link = entry->tmplate->next_in_bucket;
+        
+        _release_deps(entry->tmplate->deps);
+        DEALLOCATE(entry->tmplate);
+    } // end if
+    
+    _dispose_entry(entry);
+    
+    return;
+} // _remove_entry
+
+
+// ---------------------------------------------------------------------------
+// private function:  _dispose_entry( entry )
+// ---------------------------------------------------------------------------
+//
+// Releases the references of cache entry <entry>  to its dependency list and
+// its output,  if any,  and deallocates the entry.  The entry must not be en-
+// tered into any list.  Does nothing if <entry> is NULL.
+
+static void _dispose_entry(cte_cache_entry_s *entry) {
+    
+    if (entry == NULL)
+        return;
+    
+    _release_deps(entry->deps);
+    cte_release_output(entry->output);
+    DEALLOCATE(entry);
+    
+    return;
+} // _dispose_entry
+
+
+// ---------------------------------------------------------------------------
+// private function:  _render_output( compiled, placeholders, capacity,
+//                                    status )
+// ---------------------------------------------------------------------------
+//
+// Expands compiled template <compiled>  with the values in <placeholders>  di-
+// rectly into a new output,  with a reference count of one,  and returns it.
+// The output is allocated with room for <capacity> characters  and enlarged as
+// needed.  The template is expanded to a sink with a chunk size of one,  so
+// that all but single characters are appended without an intermediate copy.
+// Returns NULL if the expansion or allocation failed.
+//
+// The status of the operation is passed back in <status>.
+
+static cte_output_s *_render_output(cte_template_t compiled,
+                                    kvs_table_t placeholders,
+                                    size_t capacity,
+                                    cte_status_t *status) {
+    cte_output_sink_s sink;
+    cte_output_s *output;
+    cte_status_t r_status;
+    
+    sink.capacity = capacity;
+    sink.output = ALLOCATE(sizeof(cte_output_s) + capacity + 1);
+    
+    // bail out if allocation failed
+    if (sink.output == NULL) {
+        *status = CTE_STATUS_ALLOCATION_FAILED;
+        return NULL;
+    } // end if
+    
+    sink.output->ref_count = 1;
+    sink.output->length = 0;
+    
+    cte_render_compiled_to_sink(compiled, placeholders,
+                                _append_to_output, &sink, 1, &r_status);
+    
+    // bail out if expansion failed, the sink only fails to allocate
+    if (r_status != CTE_STATUS_SUCCESS) {
+        DEALLOCATE(sink.output);
+        
+        if (r_status == CTE_STATUS_SINK_FAILED)
+            r_status = CTE_STATUS_ALLOCATION_FAILED;
+        
+        *status = r_status;
+        return NULL;
+    } // end if
+    
+    sink.output->text[sink.output->length] = CSTRING_TERMINATOR;
+    
+    // release unused capacity, the output is still good if this fails
+    if (sink.capacity > sink.output->length) {
+        output = REALLOCATE(sink.output,
+                            sizeof(cte_output_s) + sink.output->length + 1);
+        
+        if (output != NULL)
+            sink.output = output;
+    } // end if
+    
+    *status = CTE_STATUS_SUCCESS;
+    return sink.output;
+} // _render_output
+
+
+// ---------------------------------------------------------------------------
+// private function:  _append_to_output( data, length, sink )
+// ---------------------------------------------------------------------------
+//
+// Appends the <length> characters at <data>  to the output of output sink
+// <sink>,  doubling its capacity if they do not fit.  Returns true if success-
+// ful,  false if allocation failed.  This function has the signature of a
+// cte_sink_f sink function.
+
+static bool _append_to_output(const char *data, size_t length, void *sink) {
+    #define this_sink ((cte_output_sink_s *)sink)
+    cte_output_s *output;
+    size_t capacity;
+    
+    // enlarge output if necessary
+    if (this_sink->output->length + length > this_sink->capacity) {
+        capacity = MAX(2 * this_sink->capacity,
+                       this_sink->output->length + length);
+        output = REALLOCATE(this_sink->output,
+                            sizeof(cte_output_s) + capacity + 1);
+        
+        // bail out if allocation failed
+        if (output == NULL)
+            return false;
+        
+        this_sink->output = output;
+        this_sink->capacity = capacity;
+    } // end if
+    
+    memcpy(&this_sink->output->text[this_sink->output->length], data, length);
+    this_sink->output->length = this_sink->output->length + length;
+    
+    return true;
+    
+    #undef this_sink
+} // _append_to_output
+
+
+// END OF FILE
@@ -0,0 +1,243 @@
+/* C Template Engine
+ *
+ *  @file cte_cache.h
+ *  CTE output cache interface
+ *
+ *  Bounded LRU cache of rendered output keyed by template and values
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#ifndef CTE_CACHE_H
+#define CTE_CACHE_H
+
+
+#include <stddef.h>
+
+#include "CTE.h"
+#include "common.h"
+
+
+// ---------------------------------------------------------------------------
+// Default cache limits
+// ---------------------------------------------------------------------------
+
+#define CTE_DEFAULT_CACHE_ENTRIES 1024
+
+#define CTE_DEFAULT_CACHE_MEMORY (16*1024*1024) /* 16 MBytes */
+
+
+// ---------------------------------------------------------------------------
+// Opaque cache handle type
+// ---------------------------------------------------------------------------
+//
+// WARNING:  Objects of this opaque type should  only be accessed through this
+// public interface.  DO NOT EVER attempt to bypass the public interface.
+//
+// The internal data structure of this opaque type is  HIDDEN  and  MAY CHANGE
+// at any time WITHOUT NOTICE.  Accessing the internal data structure directly
+// other than  through the  functions  in this public interface is  UNSAFE and
+// may result in an inconsistent program state or a crash.
+
+typedef opaque_t cte_cache_t;
+
+
+// ---------------------------------------------------------------------------
+// Opaque output handle type
+// ---------------------------------------------------------------------------
+//
+// WARNING:  Objects of this opaque type should  only be accessed through this
+// public interface.  DO NOT EVER attempt to bypass the public interface.
+//
+// The internal data structure of this opaque type is  HIDDEN  and  MAY CHANGE
+// at any time WITHOUT NOTICE.  Accessing the internal data structure directly
+// other than  through the  functions  in this public interface is  UNSAFE and
+// may result in an inconsistent program state or a crash.
+
+typedef opaque_t cte_output_t;
+
+
+// ---------------------------------------------------------------------------
+// Cache statistics type
+// ---------------------------------------------------------------------------
+
+typedef struct /* cte_cache_stats_t */ {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    cardinal entries;
+      size_t memory;
+} cte_cache_stats_t;
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_new_cache( entry_limit, memory_limit, status )
+// ---------------------------------------------------------------------------
+//
+// Creates and returns a new empty output cache  which holds at most <entry_li-
+// mit> rendered outputs occupying at most <memory_limit> bytes in total.  If
+// zero is passed in for <entry_limit> or <memory_limit>,  then the respective
+// limit is CTE_DEFAULT_CACHE_ENTRIES or CTE_DEFAULT_CACHE_MEMORY.  When either
+// limit would be exceeded,  the least recently used outputs are evicted.  The
+// function fails if memory could not be allocated.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_cache_t cte_new_cache(cardinal entry_limit,
+                            size_t memory_limit,
+                      cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_cache_render( cache, compiled, placeholders, status )
+// ---------------------------------------------------------------------------
+//
+// Returns the result of expanding compiled template <compiled>  with the va-
+// lues in <placeholders>,  as an output object.  If an output for the same
+// template and the same values of all placeholders the expansion depends on
+// is held in cache <cache>,  that output is returned without expanding the
+// template.  Otherwise the template is expanded  and the result is entered
+// into the cache.  If NULL is passed in for <cache>,  the template is expanded
+// without caching.  The function fails if NULL is passed in for <compiled> or
+// <placeholders> or if allocation fails or the template nesting limit is ex-
+// ceeded.  The function returns NULL if it fails.
+//
+// Templates are identified by cte_template_identity().  For each template,
+// the cache keeps the placeholders its expansion depends on  as reported by
+// cte_placeholders_in_compiled(),  so that a lookup  only takes an xxHash64
+// fingerprint of their current values,  without scanning the template or the
+// values for placeholders and without allocating.  Before an output is re-
+// turned,  the values it was expanded with are compared with the current va-
+// lues in length and characters,  a fingerprint collision is never mistaken
+// for a hit.
+//
+// Outputs are reference counted and shared between the cache and all callers
+// that obtained them.  The caller must release the returned output by calling
+// cte_release_output() when it is no longer needed.  The cache may be used by
+// multiple threads concurrently.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_output_t cte_cache_render(cte_cache_t cache,
+                           cte_template_t compiled,
+                              kvs_table_t placeholders,
+                             cte_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_cache_get_stats( cache, stats )
+// ---------------------------------------------------------------------------
+//
+// Passes back the hit,  miss and eviction counters  and the current number of
+// entries and memory use of cache <cache> in <stats>.  Does nothing if NULL is
+// passed in for <cache> or <stats>.
+
+void cte_cache_get_stats(cte_cache_t cache, cte_cache_stats_t *stats);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_cache_clear( cache )
+// ---------------------------------------------------------------------------
+//
+// Removes all outputs from cache <cache>.  Outputs still held by callers re-
+// main valid until released.  Counters are not reset.
+
+void cte_cache_clear(cte_cache_t cache);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_dispose_cache( cache )
+// ---------------------------------------------------------------------------
+//
+// Disposes of cache object <cache>.  Outputs still held by callers remain va-
+// lid until released.  Returns NULL.
+
+cte_cache_t cte_dispose_cache(cte_cache_t cache);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_output_string( output )
+// ---------------------------------------------------------------------------
+//
+// Returns the terminated string held by output <output>.  The string must not
+// be modified  and remains valid until the output is released.  Returns NULL
+// if NULL is passed in for <output>.
+
+const char *cte_output_string(cte_output_t output);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_output_length( output )
+// ---------------------------------------------------------------------------
+//
+// Returns the length of the string held by output <output>, not counting the
+// terminator.  Returns zero if NULL is passed in for <output>.
+
+size_t cte_output_length(cte_output_t output);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_retain_output( output )
+// ---------------------------------------------------------------------------
+//
+// Increments the reference count of output <output>  and returns <output>.
+// Every call must be balanced by a call to cte_release_output().
+
+cte_output_t cte_retain_output(cte_output_t output);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_release_output( output )
+// ---------------------------------------------------------------------------
+//
+// Decrements the reference count of output <output>  and deallocates it when
+// the count drops to zero.  Returns NULL.
+
+cte_output_t cte_release_output(cte_output_t output);
+
+
+#endif /* CTE_CACHE_H */
+
+// END OF FILE
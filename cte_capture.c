@@ -0,0 +1,1296 @@
+/* C Template Engine
+ *
+ *  @file cte_capture.c
+ *  CTE capture implementation
+ *
+ *  Optional capture of sampled renders and replay of captured renders
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef CTE_NO_THREADS
+#include <pthread.h>
+#endif
+
+#include "ASCII.h"
+#include "alloc.h"
+#include "cte_table.h"
+#include "cte_digest.h"
+#include "cte_clock.h"
+#include "cte_capture.h"
+
+
+// ---------------------------------------------------------------------------
+// Capture log signature
+// ---------------------------------------------------------------------------
+
+#define CTE_CAPTURE_SIGNATURE "CTEC"
+
+#define CTE_CAPTURE_SIGNATURE_LENGTH 4 /* bytes */
+
+
+// ---------------------------------------------------------------------------
+// Record flags
+// ---------------------------------------------------------------------------
+
+#define CTE_CAPTURE_FLAG_COMPILED 1
+
+
+// ---------------------------------------------------------------------------
+// Initial size of record buffers, entry arrays and latency arrays
+// ---------------------------------------------------------------------------
+
+#define CTE_CAPTURE_INITIAL_RECORD_SIZE 256 /* bytes */
+
+#define CTE_CAPTURE_INITIAL_ENTRIES 16 /* entries */
+
+#define CTE_CAPTURE_INITIAL_LATENCIES 1024 /* entries */
+
+
+// ---------------------------------------------------------------------------
+// Record reader type
+// ---------------------------------------------------------------------------
+//
+// A reader decodes numbers and strings from the capture log data at <data>
+// of length <length>,  starting at <index>.  Reads beyond the end of the data
+// and strings without terminator set <failed> and yield zero or NULL.
+
+typedef struct /* cte_capture_reader_s */ {
+    const uint8_t *data;
+           size_t length;
+           size_t index;
+             bool failed;
+} cte_capture_reader_s;
+
+
+// ---------------------------------------------------------------------------
+// Latency array type
+// ---------------------------------------------------------------------------
+
+typedef struct /* cte_capture_latencies_s */ {
+    uint64_t *value;
+      size_t count;
+      size_t size;
+} cte_capture_latencies_s;
+
+
+#ifdef CTE_WITH_CAPTURE
+
+// ---------------------------------------------------------------------------
+// Thread local storage class
+// ---------------------------------------------------------------------------
+
+#ifndef CTE_NO_THREADS
+#define CTE_CAPTURE_THREAD_LOCAL __thread
+#else
+#define CTE_CAPTURE_THREAD_LOCAL
+#endif
+
+
+// ---------------------------------------------------------------------------
+// Lock macros
+// ---------------------------------------------------------------------------
+
+#ifndef CTE_NO_THREADS
+#define CTE_CAPTURE_LOCK() pthread_mutex_lock(&_cte_capture_lock)
+#define CTE_CAPTURE_UNLOCK() pthread_mutex_unlock(&_cte_capture_lock)
+#else
+#define CTE_CAPTURE_LOCK()
+#define CTE_CAPTURE_UNLOCK()
+#endif
+
+
+// ---------------------------------------------------------------------------
+// Record buffer type
+// ---------------------------------------------------------------------------
+//
+// A record is encoded into a buffer  before it is written to the log,  so
+// that records of concurrent renders are never interleaved.  If enlarging the
+// buffer fails,  <failed> is set and further data is discarded.
+
+typedef struct /* cte_capture_buffer_s */ {
+    uint8_t *data;
+     size_t length;
+     size_t size;
+       bool failed;
+} cte_capture_buffer_s;
+
+
+// ---------------------------------------------------------------------------
+// Capture record types
+// ---------------------------------------------------------------------------
+//
+// A capture record holds the start time of a sampled render,  the size and
+// the digest of its output so far  and the placeholders it has looked up,
+// encoded into a value buffer as they are to appear in the log.  Each entry
+// refers to the identifier of a placeholder in the value buffer,  the entries'
+// hash slots index an array twice the size of the entry array,  both arrays
+// are doubled when the entry array is full.
+
+typedef struct /* cte_capture_entry_s */ {
+    kvs_key_t key;
+       size_t offset;
+     cardinal length;
+} cte_capture_entry_s;
+
+typedef struct /* cte_capture_record_s */ {
+               uint64_t started;
+               uint64_t size;
+     cte_digest_state_t digest;
+   cte_capture_buffer_s values;
+    cte_capture_entry_s *entry;
+               cardinal *slot;
+               cardinal e_size;
+               cardinal count;
+} cte_capture_record_s;
+
+
+// ---------------------------------------------------------------------------
+// Capture state type
+// ---------------------------------------------------------------------------
+//
+// The log file,  the sampling interval  and whether a capture is active.  The
+// state is only modified while holding the capture lock.  Renders test the
+// active flag without holding the lock,  records of renders that were sampled
+// before a capture was stopped are discarded when the lock is taken.
+
+typedef struct /* cte_capture_s */ {
+             FILE *file;
+         cardinal interval;
+    volatile bool active;
+             bool failed;
+} cte_capture_s;
+
+
+// ---------------------------------------------------------------------------
+// Capture state,  capture lock and renders left to skip by the current thread
+// ---------------------------------------------------------------------------
+
+static cte_capture_s _cte_capture = { NULL, 0, false, false };
+
+#ifndef CTE_NO_THREADS
+static pthread_mutex_t _cte_capture_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static CTE_CAPTURE_THREAD_LOCAL cardinal _cte_capture_skip = 0;
+
+#endif /* CTE_WITH_CAPTURE */
+
+
+// ===========================================================================
+// P R I V A T E   F U N C T I O N   P R O T O T Y P E S
+// ===========================================================================
+
+#ifdef CTE_WITH_CAPTURE
+static void _put_bytes(cte_capture_buffer_s *buffer,
+                       const void *data, size_t length);
+
+static void _put_number(cte_capture_buffer_s *buffer, uint64_t value);
+
+static void _put_string(cte_capture_buffer_s *buffer,
+                        const char *string, size_t length);
+
+static bool _add_entry(cte_capture_record_s *record, kvs_key_t key,
+                       const char *ident, cardinal length);
+
+#endif /* CTE_WITH_CAPTURE */
+
+static uint64_t _get_number(cte_capture_reader_s *reader);
+
+static const char *_get_string(cte_capture_reader_s *reader, size_t *length);
+
+static void _add_latency(cte_capture_latencies_s *latencies, uint64_t value);
+
+static int _compare_latencies(const void *left, const void *right);
+
+static uint64_t _percentile(const cte_capture_latencies_s *latencies,
+                            cardinal per_mille);
+
+static uint8_t *_read_log(const char *path, size_t *length,
+                          cte_capture_status_t *status);
+
+
+// ===========================================================================
+// P U B L I C   F U N C T I O N   I M P L E M E N T A T I O N S
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// function:  cte_capture_start( path, interval, status )
+// ---------------------------------------------------------------------------
+//
+// Starts capturing one in every <interval> renders of each thread  into a new
+// capture log at <path>,  replacing any file at <path>.  If zero is passed in
+// for <interval>,  every render is captured.  The function fails if NULL is
+// passed in for <path>,  if a capture is already active,  if the file could
+// not be created  or if the library was built without capture.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_capture_start(const char *path,
+                         cardinal interval,
+             cte_capture_status_t *status) {
+    
+#ifdef CTE_WITH_CAPTURE
+    FILE *file;
+    uint8_t version = CTE_CAPTURE_LOG_VERSION;
+    
+    // bail out if path is NULL
+    if (path == NULL) {
+        ASSIGN_BY_REF(status, CTE_CAPTURE_STATUS_INVALID_PATH);
+        return;
+    } // end if
+    
+    CTE_CAPTURE_LOCK();
+    
+    // bail out if a capture is already active
+    if (_cte_capture.active) {
+        CTE_CAPTURE_UNLOCK();
+        ASSIGN_BY_REF(status, CTE_CAPTURE_STATUS_ALREADY_ACTIVE);
+        return;
+    } // end if
+    
+    file = fopen(path, "wb");
+    
+    // bail out if file could not be created or header could not be written
+    if ((file == NULL) ||
+        (fwrite(CTE_CAPTURE_SIGNATURE, 1,
+                CTE_CAPTURE_SIGNATURE_LENGTH, file) !=
+         CTE_CAPTURE_SIGNATURE_LENGTH) ||
+        (fwrite(&version, 1, 1, file) != 1)) {
+        if (file != NULL)
+            fclose(file);
+        CTE_CAPTURE_UNLOCK();
+        ASSIGN_BY_REF(status, CTE_CAPTURE_STATUS_FILE_FAILED);
+        return;
+    } // end if
+    
+    _cte_capture.file = file;
+    _cte_capture.interval = MAX(interval, 1);
+    _cte_capture.failed = false;
+    _cte_capture.active = true;
+    
+    CTE_CAPTURE_UNLOCK();
+    
+    ASSIGN_BY_REF(status, CTE_CAPTURE_STATUS_SUCCESS);
+    return;
+#else
+    (void) path;
+    (void) interval;
+    
+    ASSIGN_BY_REF(status, CTE_CAPTURE_STATUS_UNAVAILABLE);
+    return;
+#endif
+} // end cte_capture_start
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_capture_stop( status )
+// ---------------------------------------------------------------------------
+//
+// Stops the active capture and closes its capture log.  Renders in progress
+// when the capture is stopped are not captured.  The function fails if no
+// capture is active  or if the log could not be written completely.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_capture_stop(cte_capture_status_t *status) {
+    
+#ifdef CTE_WITH_CAPTURE
+    bool failed;
+    
+    CTE_CAPTURE_LOCK();
+    
+    // bail out if no capture is active
+    if (NOT(_cte_capture.active)) {
+        CTE_CAPTURE_UNLOCK();
+        ASSIGN_BY_REF(status, CTE_CAPTURE_STATUS_NOT_ACTIVE);
+        return;
+    } // end if
+    
+    _cte_capture.active = false;
+    failed = (fclose(_cte_capture.file) != 0) || (_cte_capture.failed);
+    _cte_capture.file = NULL;
+    
+    CTE_CAPTURE_UNLOCK();
+    
+    if (failed)
+        ASSIGN_BY_REF(status, CTE_CAPTURE_STATUS_FILE_FAILED)
+    else
+        ASSIGN_BY_REF(status, CTE_CAPTURE_STATUS_SUCCESS)
+    
+    return;
+#else
+    ASSIGN_BY_REF(status, CTE_CAPTURE_STATUS_UNAVAILABLE);
+    return;
+#endif
+} // end cte_capture_stop
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_capture_begin()
+// ---------------------------------------------------------------------------
+//
+// Called by the engine  when a render begins.  Returns a new capture record
+// if the render is to be captured,  otherwise returns NULL.  Always returns
+// NULL if no capture is active,  if allocation fails  or if the library was
+// built without capture.
+
+cte_capture_record_t cte_capture_begin(void) {
+    
+#ifdef CTE_WITH_CAPTURE
+    cte_capture_record_s *record;
+    
+    if (NOT(_cte_capture.active))
+        return NULL;
+    
+    // skip renders between samples
+    if (_cte_capture_skip > 0) {
+        _cte_capture_skip--;
+        return NULL;
+    } // end if
+    
+    _cte_capture_skip = _cte_capture.interval - 1;
+    
+    record = ALLOCATE(sizeof(cte_capture_record_s));
+    
+    // bail out if allocation failed
+    if (record == NULL)
+        return NULL;
+    
+    record->values.data = ALLOCATE(CTE_CAPTURE_INITIAL_RECORD_SIZE);
+    record->entry = ALLOCATE(CTE_CAPTURE_INITIAL_ENTRIES *
+                             sizeof(cte_capture_entry_s));
+    record->slot = ALLOCATE(2 * CTE_CAPTURE_INITIAL_ENTRIES *
+                            sizeof(cardinal));
+    
+    // bail out if allocation failed
+    if ((record->values.data == NULL) ||
+        (record->entry == NULL) || (record->slot == NULL)) {
+        cte_capture_discard(record);
+        return NULL;
+    } // end if
+    
+    memset(record->slot, 0, 2 * CTE_CAPTURE_INITIAL_ENTRIES * sizeof(cardinal));
+    
+    record->values.length = 0;
+    record->values.size = CTE_CAPTURE_INITIAL_RECORD_SIZE;
+    record->values.failed = false;
+    record->e_size = CTE_CAPTURE_INITIAL_ENTRIES;
+    record->count = 0;
+    record->size = 0;
+    cte_digest_init(&record->digest, CTE_DIGEST_XXH64);
+    record->started = cte_clock();
+    
+    return (cte_capture_record_t) record;
+#else
+    return NULL;
+#endif
+} // end cte_capture_begin
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_capture_value( record, key, ident, length, value, v_length )
+// ---------------------------------------------------------------------------
+//
+// Called by the engine  when the render of capture record <record>  looks up
+// the placeholder whose identifier starts at <ident>,  is <length> characters
+// long and has key <key>.  Records the <v_length> characters at <value> as the
+// value of the placeholder,  or records it as undefined  if NULL is passed in
+// for <value>,  unless the placeholder has already been recorded.
+
+void cte_capture_value(cte_capture_record_t record,
+                                  kvs_key_t key,
+                                 const char *ident,
+                                   cardinal length,
+                                 const char *value,
+                                     size_t v_length) {
+
+#ifdef CTE_WITH_CAPTURE
+    #define this_record ((cte_capture_record_s *) record)
+
+    // bail out if placeholder has been recorded or could not be added
+    if ((record == NULL) ||
+        (NOT(_add_entry(this_record, key, ident, length))))
+        return;
+
+    if (value == NULL) {
+        _put_number(&this_record->values, 0);
+    }
+    else {
+        _put_number(&this_record->values, (uint64_t) v_length + 1);
+        _put_bytes(&this_record->values, value, v_length);
+    } // end if
+
+    return;
+
+    #undef this_record
+#else
+    (void) record;
+    (void) key;
+    (void) ident;
+    (void) length;
+    (void) value;
+    (void) v_length;
+
+    return;
+#endif
+} // end cte_capture_value
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_capture_output( record, data, length )
+// ---------------------------------------------------------------------------
+//
+// Called by the engine  when the render of capture record <record>  outputs
+// the <length> bytes at <data>.  The bytes are counted and digested.
+
+void cte_capture_output(cte_capture_record_t record,
+                                  const char *data,
+                                      size_t length) {
+
+#ifdef CTE_WITH_CAPTURE
+    #define this_record ((cte_capture_record_s *) record)
+
+    if (record == NULL)
+        return;
+
+    this_record->size = this_record->size + length;
+    cte_digest_update(&this_record->digest, data, length);
+
+    return;
+
+    #undef this_record
+#else
+    (void) record;
+    (void) data;
+    (void) length;
+
+    return;
+#endif
+} // end cte_capture_output
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_capture_end( record, tmplate, t_length, compiled )
+// ---------------------------------------------------------------------------
+//
+// Called by the engine  when the render of capture record <record>  has com-
+// pleted.  Appends a record of the render of the <t_length> characters of
+// template <tmplate>,  as a compiled template if <compiled> is true,  to the
+// capture log and disposes of the capture record.  The render is not recor-
+// ded if no capture is active any more  or if allocation failed.  Does noth-
+// ing if NULL is passed in for <record>.
+
+void cte_capture_end(cte_capture_record_t record,
+                               const char *tmplate,
+                                   size_t t_length,
+                                     bool compiled) {
+
+#ifdef CTE_WITH_CAPTURE
+    #define this_record ((cte_capture_record_s *) record)
+
+    cte_capture_buffer_s header;
+    cte_digest_t digest;
+    uint8_t digest_bytes[8];
+    uint64_t duration;
+    cardinal index;
+
+    if (record == NULL)
+        return;
+
+    duration = cte_clock() - this_record->started;
+
+    // bail out if capture has been stopped or values could not be recorded
+    if ((NOT(_cte_capture.active)) || (tmplate == NULL) ||
+        (this_record->values.failed)) {
+        cte_capture_discard(record);
+        return;
+    } // end if
+
+    cte_digest_final(&this_record->digest, &digest);
+
+    for (index = 0; index < 8; index++)
+        digest_bytes[index] = (uint8_t) (digest.xxh64 >> (8 * index));
+
+    header.data = ALLOCATE(CTE_CAPTURE_INITIAL_RECORD_SIZE);
+    header.length = 0;
+    header.size = CTE_CAPTURE_INITIAL_RECORD_SIZE;
+    header.failed = (header.data == NULL);
+
+    _put_number(&header, compiled ? CTE_CAPTURE_FLAG_COMPILED : 0);
+    _put_string(&header, tmplate, t_length);
+    _put_number(&header, this_record->size);
+    _put_number(&header, duration);
+    _put_bytes(&header, digest_bytes, 8);
+    _put_number(&header, this_record->count);
+
+    // write header and values unless encoding failed or capture has stopped
+    if (NOT(header.failed)) {
+        CTE_CAPTURE_LOCK();
+
+        if ((_cte_capture.active) &&
+            ((fwrite(header.data, 1, header.length, _cte_capture.file) !=
+              header.length) ||
+             (fwrite(this_record->values.data, 1, this_record->values.length,
+                     _cte_capture.file) != this_record->values.length)))
+            _cte_capture.failed = true;
+
+        CTE_CAPTURE_UNLOCK();
+    } // end if
+
+    if (header.data != NULL)
+        DEALLOCATE(header.data);
+
+    cte_capture_discard(record);
+
+    return;
+
+    #undef this_record
+#else
+    (void) record;
+    (void) tmplate;
+    (void) t_length;
+    (void) compiled;
+
+    return;
+#endif
+} // end cte_capture_end
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_capture_discard( record )
+// ---------------------------------------------------------------------------
+//
+// Called by the engine  when the render of capture record <record>  failed or
+// is not to be captured.  Disposes of the capture record  without recording
+// the render.  Does nothing if NULL is passed in for <record>.
+
+void cte_capture_discard(cte_capture_record_t record) {
+    
+#ifdef CTE_WITH_CAPTURE
+    #define this_record ((cte_capture_record_s *) record)
+    
+    if (record == NULL)
+        return;
+    
+    if (this_record->values.data != NULL)
+        DEALLOCATE(this_record->values.data);
+    
+    if (this_record->entry != NULL)
+        DEALLOCATE(this_record->entry);
+    
+    if (this_record->slot != NULL)
+        DEALLOCATE(this_record->slot);
+    
+    DEALLOCATE(record);
+    
+    return;
+    
+    #undef this_record
+#else
+    (void) record;
+    
+    return;
+#endif
+} // end cte_capture_discard
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_replay( path, repetitions, handler, context, report, status )
+// ---------------------------------------------------------------------------
+//
+// Replays the renders recorded in the capture log at <path>  against the
+// engine as built,  rendering each record <repetitions> times,  or once if
+// zero is passed in for <repetitions>,  and passes back the resulting through-
+// put and latency distribution in <report>.  Templates recorded as compiled
+// are compiled before they are rendered and rendered with cte_string_from_
+// compiled_table(),  other templates are rendered with cte_string_from_table(),
+// with a placeholder table holding the recorded values.  The output of the
+// first render of each record is compared to the recorded output size and
+// digest,  handler <handler> is called for each record that differs  unless
+// NULL is passed in for <handler>,  passing <context> to the handler.  The
+// function fails if NULL is passed in for <path> or <report>,  if the log
+// could not be read,  if it is not a valid capture log  or if allocation
+// fails.  A record whose template cannot be compiled is invalid.  Records
+// before an invalid record are replayed and reported.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_replay(const char *path,
+                  cardinal repetitions,
+   cte_replay_difference_f handler,
+                      void *context,
+       cte_replay_report_t *report,
+      cte_capture_status_t *status) {
+    
+    cte_capture_reader_s reader;
+    cte_capture_latencies_s latencies;
+    cte_capture_status_t r_status;
+    cte_status_t c_status;
+    cte_template_t compiled;
+    cte_table_t table;
+    cte_digest_t digest;
+    const char *tmplate, *identifier, *value;
+    uint64_t flags, size, duration, recorded, count, length, started;
+    size_t t_length, i_length, o_length;
+    cardinal index, repetition;
+    uint8_t *data;
+    char *output;
+    
+    // bail out if report is NULL
+    if (report == NULL) {
+        ASSIGN_BY_REF(status, CTE_CAPTURE_STATUS_INVALID_REPORT);
+        return;
+    } // end if
+    
+    memset(report, 0, sizeof(cte_replay_report_t));
+    
+    // bail out if path is NULL
+    if (path == NULL) {
+        ASSIGN_BY_REF(status, CTE_CAPTURE_STATUS_INVALID_PATH);
+        return;
+    } // end if
+    
+    data = _read_log(path, &reader.length, status);
+    
+    // bail out if log could not be read
+    if (data == NULL)
+        return;
+    
+    // bail out if signature or version do not match
+    if ((reader.length < CTE_CAPTURE_SIGNATURE_LENGTH + 1) ||
+        (memcmp(data, CTE_CAPTURE_SIGNATURE,
+                CTE_CAPTURE_SIGNATURE_LENGTH) != 0) ||
+        (data[CTE_CAPTURE_SIGNATURE_LENGTH] != CTE_CAPTURE_LOG_VERSION)) {
+        DEALLOCATE(data);
+        ASSIGN_BY_REF(status, CTE_CAPTURE_STATUS_INVALID_LOG);
+        return;
+    } // end if
+    
+    reader.data = data;
+    reader.index = CTE_CAPTURE_SIGNATURE_LENGTH + 1;
+    reader.failed = false;
+    
+    latencies.value = NULL;
+    latencies.count = 0;
+    latencies.size = 0;
+    
+    table = cte_new_table(0, NULL);
+    
+    // bail out if allocation failed
+    if (table == NULL) {
+        DEALLOCATE(data);
+        ASSIGN_BY_REF(status, CTE_CAPTURE_STATUS_ALLOCATION_FAILED);
+        return;
+    } // end if
+    
+    repetitions = MAX(repetitions, 1);
+    r_status = CTE_CAPTURE_STATUS_SUCCESS;
+    
+    while ((reader.index < reader.length) &&
+           (r_status == CTE_CAPTURE_STATUS_SUCCESS)) {
+        
+        // decode record and fill placeholder table
+        flags = _get_number(&reader);
+        tmplate = _get_string(&reader, &t_length);
+        size = _get_number(&reader);
+        duration = _get_number(&reader);
+        recorded = 0;
+        
+        // digest must lie entirely within the data
+        if ((reader.failed) || (reader.length - reader.index < 8)) {
+            reader.failed = true;
+        }
+        else {
+            for (index = 0; index < 8; index++)
+                recorded = recorded |
+                    ((uint64_t) data[reader.index + index] << (8 * index));
+            
+            reader.index = reader.index + 8;
+        } // end if
+        
+        count = _get_number(&reader);
+        cte_table_reset(table);
+        
+        while ((count > 0) && (NOT(reader.failed))) {
+            identifier = _get_string(&reader, &i_length);
+            length = _get_number(&reader);
+            
+            // value length is stored plus one,  zero if undefined
+            if ((length > 0) && (NOT(reader.failed))) {
+                length--;
+                
+                if (length > reader.length - reader.index) {
+                    reader.failed = true;
+                }
+                else {
+                    value = (const char *) &data[reader.index];
+                    reader.index = reader.index + length;
+                    cte_table_store_value(table, identifier, value,
+                                          length, NULL);
+                } // end if
+            } // end if
+            
+            count--;
+        } // end while
+        
+        // bail out of replay if record is invalid
+        if (reader.failed) {
+            r_status = CTE_CAPTURE_STATUS_INVALID_LOG;
+            break;
+        } // end if
+        
+        compiled = NULL;
+        
+        if ((flags & CTE_CAPTURE_FLAG_COMPILED) != 0) {
+            compiled = cte_compile_template(tmplate, &c_status);
+            
+            // bail out of replay if recorded template cannot be compiled
+            if (compiled == NULL) {
+                if (c_status == CTE_STATUS_ALLOCATION_FAILED)
+                    r_status = CTE_CAPTURE_STATUS_ALLOCATION_FAILED;
+                else
+                    r_status = CTE_CAPTURE_STATUS_INVALID_LOG;
+                break;
+            } // end if
+        } // end if
+        
+        // render record the requested number of times
+        for (repetition = 0; repetition < repetitions; repetition++) {
+            started = cte_clock();
+            
+            if (compiled != NULL)
+                output = cte_string_from_compiled_table(compiled, table, NULL);
+            else
+                output = cte_string_from_table(tmplate, table, NULL);
+            
+            _add_latency(&latencies, cte_clock() - started);
+            report->renders++;
+            
+            if (output == NULL) {
+                report->failures++;
+                continue;
+            } // end if
+            
+            o_length = strlen(output);
+            report->bytes = report->bytes + o_length;
+            
+            // compare output of first render to recorded output
+            if (repetition == 0) {
+                cte_digest_of(output, o_length, CTE_DIGEST_XXH64, &digest);
+                
+                if ((o_length != size) || (digest.xxh64 != recorded)) {
+                    report->differences++;
+                    
+                    if (handler != NULL)
+                        handler((cardinal) report->records, tmplate,
+                                (size_t) size, o_length, output, context);
+                } // end if
+            } // end if
+            
+            DEALLOCATE(output);
+        } // end for
+        
+        if (compiled != NULL)
+            cte_dispose_template(compiled);
+        
+        report->records++;
+        report->captured = report->captured + duration;
+    } // end while
+    
+    // latency distribution is incomplete if the latency array is incomplete
+    if ((r_status == CTE_CAPTURE_STATUS_SUCCESS) &&
+        (latencies.count < report->renders))
+        r_status = CTE_CAPTURE_STATUS_ALLOCATION_FAILED;
+    
+    if (latencies.count > 0) {
+        qsort(latencies.value, latencies.count, sizeof(uint64_t),
+              _compare_latencies);
+        
+        for (index = 0; index < latencies.count; index++)
+            report->elapsed = report->elapsed + latencies.value[index];
+        
+        report->latency_min = latencies.value[0];
+        report->latency_p50 = _percentile(&latencies, 500);
+        report->latency_p90 = _percentile(&latencies, 900);
+        report->latency_p99 = _percentile(&latencies, 990);
+        report->latency_p999 = _percentile(&latencies, 999);
+        report->latency_max = latencies.value[latencies.count - 1];
+    } // end if
+    
+    if (latencies.value != NULL)
+        DEALLOCATE(latencies.value);
+    
+    cte_dispose_table(table);
+    DEALLOCATE(data);
+    
+    ASSIGN_BY_REF(status, r_status);
+    return;
+} // end cte_replay
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_replay_format( report, buffer, size )
+// ---------------------------------------------------------------------------
+//
+// Writes a text dump of replay report <report>  into buffer <buffer> of <size>
+// bytes and returns the length of the text.  The dump states the number of
+// records, renders, failures and differences,  the throughput in renders and
+// megabytes per second,  the render latency distribution  and  the ratio of
+// replayed to captured render time,  one line each.  Like snprintf(),  the
+// text is truncated to fit and terminated unless <size> is zero,  the length
+// returned is that of the entire text.  A buffer of CTE_REPLAY_TEXT_SIZE bytes
+// is always large enough.  Returns zero if NULL is passed in for <report>.
+
+size_t cte_replay_format(const cte_replay_report_t *report,
+                         char *buffer, size_t size) {
+    
+    double seconds, ratio;
+    int count;
+    
+    if (report == NULL)
+        return 0;
+    
+    if (buffer == NULL)
+        size = 0;
+    
+    seconds = (double) report->elapsed / 1e9;
+    
+    // ratio of mean replayed latency to mean captured duration
+    if ((report->renders > 0) && (report->captured > 0))
+        ratio = ((double) report->elapsed / report->renders) /
+                ((double) report->captured / report->records);
+    else
+        ratio = 0.0;
+    
+    count = snprintf(buffer, size,
+        "records %llu renders %llu failures %llu differences %llu\n"
+        "throughput renders_per_s %.0f mb_per_s %.1f\n"
+        "latency_ns min %llu p50 %llu p90 %llu p99 %llu p999 %llu max %llu\n"
+        "replayed_to_captured %.3f\n",
+        (unsigned long long) report->records,
+        (unsigned long long) report->renders,
+        (unsigned long long) report->failures,
+        (unsigned long long) report->differences,
+        (seconds > 0.0) ? report->renders / seconds : 0.0,
+        (seconds > 0.0) ? report->bytes / seconds / 1e6 : 0.0,
+        (unsigned long long) report->latency_min,
+        (unsigned long long) report->latency_p50,
+        (unsigned long long) report->latency_p90,
+        (unsigned long long) report->latency_p99,
+        (unsigned long long) report->latency_p999,
+        (unsigned long long) report->latency_max,
+        ratio);
+    
+    return (size_t) MAX(count, 0);
+} // end cte_replay_format
+
+
+// ===========================================================================
+// P R I V A T E   F U N C T I O N   I M P L E M E N T A T I O N S
+// ===========================================================================
+
+#ifdef CTE_WITH_CAPTURE
+
+// ---------------------------------------------------------------------------
+// private function:  _put_bytes( buffer, data, length )
+// ---------------------------------------------------------------------------
+//
+// Appends <length> bytes at <data> to record buffer <buffer>,  enlarging the
+// buffer if necessary.  Sets the failed flag of the buffer if enlarging fails.
+
+static void _put_bytes(cte_capture_buffer_s *buffer,
+                       const void *data, size_t length) {
+    uint8_t *new_data;
+    size_t new_size;
+    
+    if (buffer->failed)
+        return;
+    
+    // enlarge buffer if necessary
+    if (buffer->size - buffer->length < length) {
+        new_size = MAX(buffer->size * 2, buffer->length + length);
+        new_data = REALLOCATE(buffer->data, new_size);
+        
+        if (new_data == NULL) {
+            buffer->failed = true;
+            return;
+        } // end if
+        
+        buffer->data = new_data;
+        buffer->size = new_size;
+    } // end if
+    
+    memcpy(&buffer->data[buffer->length], data, length);
+    buffer->length = buffer->length + length;
+    
+    return;
+} // _put_bytes
+
+
+// ---------------------------------------------------------------------------
+// private function:  _put_number( buffer, value )
+// ---------------------------------------------------------------------------
+//
+// Appends <value> as an unsigned LEB128 varint to record buffer <buffer>.
+
+static void _put_number(cte_capture_buffer_s *buffer, uint64_t value) {
+    uint8_t bytes[10];
+    cardinal length = 0;
+    
+    repeat {
+        bytes[length] = (uint8_t) (value & 0x7F);
+        value = value >> 7;
+        
+        if (value != 0)
+            bytes[length] = bytes[length] | 0x80;
+        
+        length++;
+    } until (value == 0);
+    
+    _put_bytes(buffer, bytes, length);
+    
+    return;
+} // _put_number
+
+
+// ---------------------------------------------------------------------------
+// private function:  _put_string( buffer, string, length )
+// ---------------------------------------------------------------------------
+//
+// Appends the length of string <string>,  its <length> characters and a ter-
+// minator to record buffer <buffer>.
+
+static void _put_string(cte_capture_buffer_s *buffer,
+                        const char *string, size_t length) {
+    
+    _put_number(buffer, length);
+    _put_bytes(buffer, string, length);
+    _put_bytes(buffer, EMPTY_STRING, 1);
+    
+    return;
+} // _put_string
+
+
+// ---------------------------------------------------------------------------
+// private function:  _add_entry( record, key, ident, length )
+// ---------------------------------------------------------------------------
+//
+// Adds the placeholder whose identifier starts at <ident>,  is <length> char-
+// acters long and has key <key> to capture record <record>,  appending its
+// identifier to the value buffer,  unless it has already been added.  Returns
+// true if it was added,  false if it had already been added  or if the record
+// could not be enlarged,  in which case the value buffer is marked as failed.
+
+static bool _add_entry(cte_capture_record_s *record,
+                       kvs_key_t key,
+                       const char *ident,
+                       cardinal length) {
+    
+    cte_capture_entry_s *entry;
+    cardinal *slot_array;
+    cardinal index, mask, slot;
+    
+    if (record->values.failed)
+        return false;
+    
+    mask = 2 * record->e_size - 1;
+    slot = key & mask;
+    
+    // search for identifier, slots hold entry index plus one, zero if empty
+    while (record->slot[slot] != 0) {
+        entry = &record->entry[record->slot[slot] - 1];
+        
+        if ((entry->key == key) && (entry->length == length) &&
+            (memcmp(&record->values.data[entry->offset], ident, length) == 0))
+            return false;
+        
+        slot = (slot + 1) & mask;
+    } // end while
+    
+    // enlarge entry and slot arrays if full
+    if (record->count == record->e_size) {
+        entry = REALLOCATE(record->entry,
+                    2 * record->e_size * sizeof(cte_capture_entry_s));
+        
+        if (entry == NULL) {
+            record->values.failed = true;
+            return false;
+        } // end if
+        
+        record->entry = entry;
+        
+        slot_array = ALLOCATE(4 * record->e_size * sizeof(cardinal));
+        
+        if (slot_array == NULL) {
+            record->values.failed = true;
+            return false;
+        } // end if
+        
+        memset(slot_array, 0, 4 * record->e_size * sizeof(cardinal));
+        DEALLOCATE(record->slot);
+        record->slot = slot_array;
+        record->e_size = 2 * record->e_size;
+        mask = 2 * record->e_size - 1;
+        
+        // rehash existing entries
+        for (index = 0; index < record->count; index++) {
+            slot = record->entry[index].key & mask;
+            while (record->slot[slot] != 0)
+                slot = (slot + 1) & mask;
+            record->slot[slot] = index + 1;
+        } // end for
+        
+        // find empty slot for new entry
+        slot = key & mask;
+        while (record->slot[slot] != 0)
+            slot = (slot + 1) & mask;
+    } // end if
+    
+    _put_string(&record->values, ident, length);
+    
+    if (record->values.failed)
+        return false;
+    
+    // identifier is followed by its terminator
+    entry = &record->entry[record->count];
+    entry->key = key;
+    entry->offset = record->values.length - length - 1;
+    entry->length = length;
+    record->count++;
+    record->slot[slot] = record->count;
+    
+    return true;
+} // _add_entry
+
+#endif /* CTE_WITH_CAPTURE */
+
+
+// ---------------------------------------------------------------------------
+// private function:  _get_number( reader )
+// ---------------------------------------------------------------------------
+//
+// Decodes and returns an unsigned LEB128 varint from reader <reader>.  Sets
+// the failed flag of the reader and returns zero if the data ends within the
+// number or the number does not fit into 64 bits.
+
+static uint64_t _get_number(cte_capture_reader_s *reader) {
+    uint64_t value = 0;
+    cardinal shift = 0;
+    uint8_t byte;
+    
+    if (reader->failed)
+        return 0;
+    
+    repeat {
+        if ((reader->index >= reader->length) || (shift > 63)) {
+            reader->failed = true;
+            return 0;
+        } // end if
+        
+        byte = reader->data[reader->index];
+        reader->index++;
+        value = value | ((uint64_t) (byte & 0x7F) << shift);
+        shift = shift + 7;
+    } until ((byte & 0x80) == 0);
+    
+    return value;
+} // _get_number
+
+
+// ---------------------------------------------------------------------------
+// private function:  _get_string( reader, length )
+// ---------------------------------------------------------------------------
+//
+// Decodes a string from reader <reader>,  passes back its length in <length>
+// and returns a pointer to its characters within the data of the reader.
+// Sets the failed flag of the reader and returns NULL if the data ends within
+// the string or the string is not terminated.
+
+static const char *_get_string(cte_capture_reader_s *reader, size_t *length) {
+    const char *string;
+    uint64_t s_length;
+    
+    s_length = _get_number(reader);
+    
+    if ((reader->failed) ||
+        (s_length >= reader->length - reader->index) ||
+        (reader->data[reader->index + s_length] != CSTRING_TERMINATOR)) {
+        reader->failed = true;
+        *length = 0;
+        return NULL;
+    } // end if
+    
+    string = (const char *) &reader->data[reader->index];
+    reader->index = reader->index + s_length + 1;
+    *length = (size_t) s_length;
+    
+    return string;
+} // _get_string
+
+
+// ---------------------------------------------------------------------------
+// private function:  _add_latency( latencies, value )
+// ---------------------------------------------------------------------------
+//
+// Appends latency <value> to latency array <latencies>,  enlarging the array
+// if necessary.  The latency is dropped if enlarging the array fails.
+
+static void _add_latency(cte_capture_latencies_s *latencies, uint64_t value) {
+    uint64_t *new_value;
+    size_t new_size;
+    
+    // enlarge array if necessary
+    if (latencies->count == latencies->size) {
+        new_size = MAX(latencies->size * 2, CTE_CAPTURE_INITIAL_LATENCIES);
+        new_value = REALLOCATE(latencies->value, new_size * sizeof(uint64_t));
+        
+        if (new_value == NULL)
+            return;
+        
+        latencies->value = new_value;
+        latencies->size = new_size;
+    } // end if
+    
+    latencies->value[latencies->count] = value;
+    latencies->count++;
+    
+    return;
+} // _add_latency
+
+
+// ---------------------------------------------------------------------------
+// private function:  _compare_latencies( left, right )
+// ---------------------------------------------------------------------------
+//
+// Compares the latencies at <left> and <right> for qsort().
+
+static int _compare_latencies(const void *left, const void *right) {
+    uint64_t l_value = *(const uint64_t *) left;
+    uint64_t r_value = *(const uint64_t *) right;
+    
+    return (l_value > r_value) - (l_value < r_value);
+} // _compare_latencies
+
+
+// ---------------------------------------------------------------------------
+// private function:  _percentile( latencies, per_mille )
+// ---------------------------------------------------------------------------
+//
+// Returns the latency at or below which <per_mille> thousandths of the sorted
+// non-empty latency array <latencies> lie,  by the nearest rank method.
+
+static uint64_t _percentile(const cte_capture_latencies_s *latencies,
+                            cardinal per_mille) {
+    size_t rank;
+    
+    rank = (latencies->count * per_mille + 999) / 1000;
+    
+    return latencies->value[MAX(rank, 1) - 1];
+} // _percentile
+
+
+// ---------------------------------------------------------------------------
+// private function:  _read_log( path, length, status )
+// ---------------------------------------------------------------------------
+//
+// Reads the entire file at <path> into a new allocated buffer,  passes back
+// its length in <length> and returns the buffer.  Returns NULL if the file
+// could not be read or allocation failed.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+static uint8_t *_read_log(const char *path, size_t *length,
+                          cte_capture_status_t *status) {
+    uint8_t *data;
+    FILE *file;
+    long size;
+    
+    file = fopen(path, "rb");
+    
+    // bail out if file could not be opened or its size determined
+    if ((file == NULL) ||
+        (fseek(file, 0, SEEK_END) != 0) ||
+        ((size = ftell(file)) < 0) ||
+        (fseek(file, 0, SEEK_SET) != 0)) {
+        if (file != NULL)
+            fclose(file);
+        ASSIGN_BY_REF(status, CTE_CAPTURE_STATUS_FILE_FAILED);
+        return NULL;
+    } // end if
+    
+    data = ALLOCATE(MAX(size, 1));
+    
+    // bail out if allocation failed
+    if (data == NULL) {
+        fclose(file);
+        ASSIGN_BY_REF(status, CTE_CAPTURE_STATUS_ALLOCATION_FAILED);
+        return NULL;
+    } // end if
+    
+    // bail out if file could not be read
+    if (fread(data, 1, (size_t) size, file) != (size_t) size) {
+        DEALLOCATE(data);
+        fclose(file);
+        ASSIGN_BY_REF(status, CTE_CAPTURE_STATUS_FILE_FAILED);
+        return NULL;
+    } // end if
+    
+    fclose(file);
+    
+    *length = (size_t) size;
+    return data;
+} // _read_log
+
+
+// END OF FILE
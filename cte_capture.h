@@ -0,0 +1,334 @@
+/* C Template Engine
+ *
+ *  @file cte_capture.h
+ *  CTE capture interface
+ *
+ *  Optional capture of sampled renders and replay of captured renders
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#ifndef CTE_CAPTURE_H
+#define CTE_CAPTURE_H
+
+
+#include <stddef.h>
+
+#include "CTE.h"
+#include "common.h"
+
+
+// ---------------------------------------------------------------------------
+// Availability
+// ---------------------------------------------------------------------------
+//
+// Renders are only captured  if the library is built with CTE_WITH_CAPTURE
+// defined.  Otherwise every attempt to start a capture fails with status UN-
+// AVAILABLE.  Replay is always available,  so that a log captured by one build
+// may be replayed against any other.
+//
+// While a capture is active,  one in every <interval> renders of each thread
+// is captured,  whichever function performed it.  Only renders that complete
+// successfully in one call  with the built-in syntax  and  without escaping
+// are captured,  renders that expand sections or look up values stored with
+// an escaping mode of their own are not.  Renders by render state  and  chun-
+// ked renders are never captured.
+
+
+// ---------------------------------------------------------------------------
+// Capture log format
+// ---------------------------------------------------------------------------
+//
+// A capture log starts with the four characters "CTEC"  followed by a format
+// version byte,  followed by one record per captured render.  All numbers are
+// unsigned LEB128 varints,  except for the digest,  which is eight bytes,  least
+// significant byte first.  A record consists of
+//
+//  flags, bit 0 set if the render was of a compiled template,
+//  template length, template characters and a terminator,
+//  output size, render duration in nanoseconds, xxHash64 digest of the output,
+//  placeholder count, and for each placeholder the render looked up
+//   identifier length, identifier characters and a terminator,
+//   value length plus one,  or zero if the placeholder was undefined,
+//   value characters.
+
+#define CTE_CAPTURE_LOG_VERSION 1
+
+
+// ---------------------------------------------------------------------------
+// Status codes
+// ---------------------------------------------------------------------------
+
+typedef enum /* cte_capture_status_t */ {
+    CTE_CAPTURE_STATUS_SUCCESS = 1,
+    CTE_CAPTURE_STATUS_INVALID_PATH,
+    CTE_CAPTURE_STATUS_INVALID_REPORT,
+    CTE_CAPTURE_STATUS_INVALID_LOG,
+    CTE_CAPTURE_STATUS_FILE_FAILED,
+    CTE_CAPTURE_STATUS_ALLOCATION_FAILED,
+    CTE_CAPTURE_STATUS_ALREADY_ACTIVE,
+    CTE_CAPTURE_STATUS_NOT_ACTIVE,
+    CTE_CAPTURE_STATUS_UNAVAILABLE
+} cte_capture_status_t;
+
+
+// ---------------------------------------------------------------------------
+// Opaque capture record handle type
+// ---------------------------------------------------------------------------
+//
+// WARNING:  Objects of this opaque type should only be accessed through this
+// public interface.  DO NOT EVER attempt to bypass the public interface.
+//
+// The internal structure of this type  is HIDDEN  and  MAY CHANGE  at any time
+// WITHOUT NOTICE.
+
+typedef opaque_t cte_capture_record_t;
+
+
+// ---------------------------------------------------------------------------
+// Replay report type
+// ---------------------------------------------------------------------------
+//
+// The number of records replayed,  of renders performed,  of renders that
+// failed  and  of records whose replayed output differs in size or digest from
+// the captured output,  the number of bytes of output,  the sum of the laten-
+// cies of all renders and of the durations captured for them in nanoseconds,
+// and the smallest,  50th, 90th, 99th and 99.9th percentile and largest render
+// latency in nanoseconds.
+
+typedef struct /* cte_replay_report_t */ {
+    uint64_t records;
+    uint64_t renders;
+    uint64_t failures;
+    uint64_t differences;
+    uint64_t bytes;
+    uint64_t elapsed;
+    uint64_t captured;
+    uint64_t latency_min;
+    uint64_t latency_p50;
+    uint64_t latency_p90;
+    uint64_t latency_p99;
+    uint64_t latency_p999;
+    uint64_t latency_max;
+} cte_replay_report_t;
+
+
+// ---------------------------------------------------------------------------
+// Maximum length of a formatted replay report
+// ---------------------------------------------------------------------------
+
+#define CTE_REPLAY_TEXT_SIZE 512 /* bytes */
+
+
+// ---------------------------------------------------------------------------
+// Difference handler type
+// ---------------------------------------------------------------------------
+//
+// Called for each record  whose replayed output differs  from the captured
+// output,  with the index of the record counting from zero,  the template,
+// the captured and replayed output size,  the replayed output  and the
+// context passed to cte_replay().  The replayed output is only valid during
+// the call.
+
+typedef void (*cte_replay_difference_f)(cardinal record,
+                                        const char *tmplate,
+                                        size_t captured_size,
+                                        size_t replayed_size,
+                                        const char *output,
+                                        void *context);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_capture_start( path, interval, status )
+// ---------------------------------------------------------------------------
+//
+// Starts capturing one in every <interval> renders of each thread  into a new
+// capture log at <path>,  replacing any file at <path>.  If zero is passed in
+// for <interval>,  every render is captured.  The function fails if NULL is
+// passed in for <path>,  if a capture is already active,  if the file could
+// not be created  or if the library was built without capture.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_capture_start(const char *path,
+                         cardinal interval,
+             cte_capture_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_capture_stop( status )
+// ---------------------------------------------------------------------------
+//
+// Stops the active capture and closes its capture log.  Renders in progress
+// when the capture is stopped are not captured.  The function fails if no
+// capture is active  or if the log could not be written completely.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_capture_stop(cte_capture_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_capture_begin()
+// ---------------------------------------------------------------------------
+//
+// Called by the engine  when a render begins.  Returns a new capture record
+// if the render is to be captured,  otherwise returns NULL.  Always returns
+// NULL if no capture is active,  if allocation fails  or if the library was
+// built without capture.
+
+cte_capture_record_t cte_capture_begin(void);
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_capture_value( record, key, ident, length, value, v_length )
+// ---------------------------------------------------------------------------
+//
+// Called by the engine  when the render of capture record <record>  looks up
+// the placeholder whose identifier starts at <ident>,  is <length> characters
+// long and has key <key>.  Records the <v_length> characters at <value> as the
+// value of the placeholder,  or records it as undefined  if NULL is passed in
+// for <value>,  unless the placeholder has already been recorded.
+
+void cte_capture_value(cte_capture_record_t record,
+                                  kvs_key_t key,
+                                 const char *ident,
+                                   cardinal length,
+                                 const char *value,
+                                     size_t v_length);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_capture_output( record, data, length )
+// ---------------------------------------------------------------------------
+//
+// Called by the engine  when the render of capture record <record>  outputs
+// the <length> bytes at <data>.  The bytes are counted and digested.
+
+void cte_capture_output(cte_capture_record_t record,
+                                  const char *data,
+                                      size_t length);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_capture_end( record, tmplate, t_length, compiled )
+// ---------------------------------------------------------------------------
+//
+// Called by the engine  when the render of capture record <record>  has com-
+// pleted.  Appends a record of the render of the <t_length> characters of
+// template <tmplate>,  as a compiled template if <compiled> is true,  to the
+// capture log and disposes of the capture record.  The render is not recor-
+// ded if no capture is active any more  or if allocation failed.  Does noth-
+// ing if NULL is passed in for <record>.
+
+void cte_capture_end(cte_capture_record_t record,
+                               const char *tmplate,
+                                   size_t t_length,
+                                     bool compiled);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_capture_discard( record )
+// ---------------------------------------------------------------------------
+//
+// Called by the engine  when the render of capture record <record>  failed or
+// is not to be captured.  Disposes of the capture record  without recording
+// the render.  Does nothing if NULL is passed in for <record>.
+
+void cte_capture_discard(cte_capture_record_t record);
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_replay( path, repetitions, handler, context, report, status )
+// ---------------------------------------------------------------------------
+//
+// Replays the renders recorded in the capture log at <path>  against the
+// engine as built,  rendering each record <repetitions> times,  or once if
+// zero is passed in for <repetitions>,  and passes back the resulting through-
+// put and latency distribution in <report>.  Templates recorded as compiled
+// are compiled before they are rendered and rendered with cte_string_from_
+// compiled_table(),  other templates are rendered with cte_string_from_table(),
+// with a placeholder table holding the recorded values.  The output of the
+// first render of each record is compared to the recorded output size and
+// digest,  handler <handler> is called for each record that differs  unless
+// NULL is passed in for <handler>,  passing <context> to the handler.  The
+// function fails if NULL is passed in for <path> or <report>,  if the log
+// could not be read,  if it is not a valid capture log  or if allocation
+// fails.  A record whose template cannot be compiled is invalid.  Records
+// before an invalid record are replayed and reported.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_replay(const char *path,
+                  cardinal repetitions,
+   cte_replay_difference_f handler,
+                      void *context,
+       cte_replay_report_t *report,
+      cte_capture_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_replay_format( report, buffer, size )
+// ---------------------------------------------------------------------------
+//
+// Writes a text dump of replay report <report>  into buffer <buffer> of <size>
+// bytes and returns the length of the text.  The dump states the number of
+// records, renders, failures and differences,  the throughput in renders and
+// megabytes per second,  the render latency distribution  and  the ratio of
+// replayed to captured render time,  one line each.  Like snprintf(),  the
+// text is truncated to fit and terminated unless <size> is zero,  the length
+// returned is that of the entire text.  A buffer of CTE_REPLAY_TEXT_SIZE bytes
+// is always large enough.  Returns zero if NULL is passed in for <report>.
+
+size_t cte_replay_format(const cte_replay_report_t *report,
+                         char *buffer, size_t size);
+
+
+#endif /* CTE_CAPTURE_H */
+
+// END OF FILE
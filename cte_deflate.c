@@ -0,0 +1,427 @@
+/* C Template Engine
+ *
+ *  @file cte_deflate.c
+ *  CTE deflate sink implementation
+ *
+ *  Output sink compressing rendered output with streaming deflate
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include <limits.h>
+
+#ifdef CTE_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#include "alloc.h"
+#include "cte_deflate.h"
+
+
+// ---------------------------------------------------------------------------
+// Range checks
+// ---------------------------------------------------------------------------
+
+#if (CTE_DEFLATE_DEFAULT_LEVEL < 0) || (CTE_DEFLATE_DEFAULT_LEVEL > 9)
+#error CTE_DEFLATE_DEFAULT_LEVEL must be in range 0 to 9
+#endif
+
+#if (CTE_DEFLATE_DEFAULT_CHUNK_SIZE < 1024)
+#warning CTE_DEFLATE_DEFAULT_CHUNK_SIZE is unreasonably low, factory setting is 16K
+#endif
+
+
+#ifdef CTE_WITH_ZLIB
+
+// ---------------------------------------------------------------------------
+// Window bits for gzip format, 32K window plus gzip wrapper
+// ---------------------------------------------------------------------------
+
+#define CTE_DEFLATE_GZIP_WINDOW_BITS (15 + 16)
+
+
+// ---------------------------------------------------------------------------
+// Deflate sink type
+// ---------------------------------------------------------------------------
+//
+// The chunk buffer follows the sink structure in the same allocation.
+
+typedef struct /* cte_deflate_sink_s */ {
+                z_stream stream;
+    cte_deflate_output_f output;
+                    void *context;
+                  size_t chunk_size;
+                  size_t total_out;
+                    bool finished;
+           unsigned char chunk[0];
+} cte_deflate_sink_s;
+
+
+// ===========================================================================
+// P R I V A T E   F U N C T I O N   P R O T O T Y P E S
+// ===========================================================================
+
+static cte_deflate_status_t _deflate(cte_deflate_sink_s *sink, int flush);
+
+#endif /* CTE_WITH_ZLIB */
+
+
+// ===========================================================================
+// P U B L I C   F U N C T I O N   I M P L E M E N T A T I O N S
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// function:  cte_new_deflate_sink( level, chunk_size, output, context, status )
+// ---------------------------------------------------------------------------
+//
+// Creates and returns a new deflate sink  which compresses all data written to
+// it into gzip format at compression level <level>,  0 to 9,  and passes the
+// compressed data to output handler <output>,  together with <context>,  in
+// chunks of <chunk_size> bytes.  If -1 is passed in for <level>  the level is
+// CTE_DEFLATE_DEFAULT_LEVEL,  if zero is passed in for <chunk_size> the chunk
+// size is CTE_DEFLATE_DEFAULT_CHUNK_SIZE,  chunk sizes above UINT_MAX are re-
+// duced to UINT_MAX.  The function fails if NULL is passed in for <output>,
+// if <level> is out of range,  if allocation fails or if the library was built
+// without zlib.
+//
+// Data is written to the sink  by passing cte_deflate_sink_write() as sink and
+// the deflate sink as context to cte_render_to_sink()  or  cte_render_compi-
+// led_to_sink().  Several renders may be written to the same sink in turn.
+// Compression is completed by calling cte_deflate_sink_finish().
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_deflate_sink_t cte_new_deflate_sink(int level,
+                                        size_t chunk_size,
+                                        cte_deflate_output_f output,
+                                        void *context,
+                                        cte_deflate_status_t *status) {
+#ifdef CTE_WITH_ZLIB
+    cte_deflate_sink_s *sink;
+    
+    // bail out if output handler is NULL
+    if (output == NULL) {
+        ASSIGN_BY_REF(status, CTE_DEFLATE_STATUS_INVALID_OUTPUT);
+        return NULL;
+    } // end if
+    
+    // -1 means default level
+    if (level == -1)
+        level = CTE_DEFLATE_DEFAULT_LEVEL;
+    
+    // bail out if level is out of range
+    if ((level < 0) || (level > 9)) {
+        ASSIGN_BY_REF(status, CTE_DEFLATE_STATUS_INVALID_LEVEL);
+        return NULL;
+    } // end if
+    
+    // zero chunk size means default
+    if (chunk_size == 0)
+        chunk_size = CTE_DEFLATE_DEFAULT_CHUNK_SIZE;
+    
+    // zlib counts output space in unsigned int
+    chunk_size = MIN(chunk_size, UINT_MAX);
+    
+    sink = ALLOCATE(sizeof(cte_deflate_sink_s) + chunk_size);
+    
+    // bail out if allocation failed
+    if (sink == NULL) {
+        ASSIGN_BY_REF(status, CTE_DEFLATE_STATUS_ALLOCATION_FAILED);
+        return NULL;
+    } // end if
+    
+    sink->stream.zalloc = Z_NULL;
+    sink->stream.zfree = Z_NULL;
+    sink->stream.opaque = Z_NULL;
+    
+    // bail out if compressor initialisation failed
+    if (deflateInit2(&sink->stream, level, Z_DEFLATED,
+                     CTE_DEFLATE_GZIP_WINDOW_BITS, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+        DEALLOCATE(sink);
+        ASSIGN_BY_REF(status, CTE_DEFLATE_STATUS_ALLOCATION_FAILED);
+        return NULL;
+    } // end if
+    
+    sink->output = output;
+    sink->context = context;
+    sink->chunk_size = chunk_size;
+    sink->total_out = 0;
+    sink->finished = false;
+    
+    sink->stream.next_out = sink->chunk;
+    sink->stream.avail_out = (uInt) chunk_size;
+    
+    ASSIGN_BY_REF(status, CTE_DEFLATE_STATUS_SUCCESS);
+    return (cte_deflate_sink_t) sink;
+#else
+    (void) level;
+    (void) chunk_size;
+    (void) output;
+    (void) context;
+    
+    ASSIGN_BY_REF(status, CTE_DEFLATE_STATUS_UNAVAILABLE);
+    return NULL;
+#endif
+} // end cte_new_deflate_sink
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_deflate_sink_write( data, length, sink )
+// ---------------------------------------------------------------------------
+//
+// Compresses <length> bytes starting at <data> into deflate sink <sink>,  pass-
+// ing any completed chunks of compressed output to the sink's output handler.
+// Returns true if successful,  false if NULL is passed in for <sink>,  if the
+// sink has already been finished  or if compression or the output handler
+// failed.  Data of any length is accepted,  it is passed to zlib in slices of
+// at most UINT_MAX bytes.  The function has the signature of a cte_sink_f sink
+// function.
+
+bool cte_deflate_sink_write(const char *data,
+                            size_t length,
+                            void *sink) {
+#ifdef CTE_WITH_ZLIB
+    #define this_sink ((cte_deflate_sink_s *)sink)
+    size_t slice;
+    
+    // bail out if sink is NULL or finished
+    if ((sink == NULL) || (this_sink->finished))
+        return false;
+    
+    // zlib counts input in unsigned int, feed longer data in slices
+    repeat {
+        slice = MIN(length, UINT_MAX);
+        this_sink->stream.next_in = (unsigned char *) data;
+        this_sink->stream.avail_in = (uInt) slice;
+        
+        if (_deflate(this_sink, Z_NO_FLUSH) != CTE_DEFLATE_STATUS_SUCCESS)
+            return false;
+        
+        data = data + slice;
+        length = length - slice;
+    } until (length == 0);
+    
+    return true;
+    
+    #undef this_sink
+#else
+    (void) data;
+    (void) length;
+    (void) sink;
+    
+    return false;
+#endif
+} // end cte_deflate_sink_write
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_deflate_sink_finish( sink, status )
+// ---------------------------------------------------------------------------
+//
+// Completes compression in deflate sink <sink>  and passes all remaining com-
+// pressed output including the gzip trailer to the sink's output handler.  No
+// further data may be written to the sink afterwards.  The function fails if
+// NULL is passed in for <sink>  or if compression or the output handler fail.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_deflate_sink_finish(cte_deflate_sink_t sink,
+                             cte_deflate_status_t *status) {
+#ifdef CTE_WITH_ZLIB
+    #define this_sink ((cte_deflate_sink_s *)sink)
+    cte_deflate_status_t d_status;
+    
+    // bail out if sink is NULL or finished
+    if ((sink == NULL) || (this_sink->finished)) {
+        ASSIGN_BY_REF(status, CTE_DEFLATE_STATUS_INVALID_SINK);
+        return;
+    } // end if
+    
+    this_sink->stream.next_in = Z_NULL;
+    this_sink->stream.avail_in = 0;
+    
+    d_status = _deflate(this_sink, Z_FINISH);
+    
+    // pass on the final partial chunk
+    if ((d_status == CTE_DEFLATE_STATUS_SUCCESS) &&
+        (this_sink->stream.avail_out < this_sink->chunk_size)) {
+        
+        if (this_sink->output((const char *) this_sink->chunk,
+                this_sink->chunk_size - this_sink->stream.avail_out,
+                this_sink->context))
+            this_sink->total_out = this_sink->total_out +
+                this_sink->chunk_size - this_sink->stream.avail_out;
+        else
+            d_status = CTE_DEFLATE_STATUS_OUTPUT_FAILED;
+    } // end if
+    
+    this_sink->finished = true;
+    
+    ASSIGN_BY_REF(status, d_status);
+    return;
+    
+    #undef this_sink
+#else
+    (void) sink;
+    
+    ASSIGN_BY_REF(status, CTE_DEFLATE_STATUS_INVALID_SINK);
+    return;
+#endif
+} // end cte_deflate_sink_finish
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_deflate_sink_total_in( sink )
+// ---------------------------------------------------------------------------
+//
+// Returns the number of bytes written to deflate sink <sink>  so far,  returns
+// zero if NULL is passed in for <sink>.
+
+size_t cte_deflate_sink_total_in(cte_deflate_sink_t sink) {
+#ifdef CTE_WITH_ZLIB
+    if (sink == NULL)
+        return 0;
+    
+    return ((cte_deflate_sink_s *) sink)->stream.total_in;
+#else
+    (void) sink;
+    
+    return 0;
+#endif
+} // end cte_deflate_sink_total_in
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_deflate_sink_total_out( sink )
+// ---------------------------------------------------------------------------
+//
+// Returns the number of compressed bytes passed to the output handler of de-
+// flate sink <sink> so far,  returns zero if NULL is passed in for <sink>.
+
+size_t cte_deflate_sink_total_out(cte_deflate_sink_t sink) {
+#ifdef CTE_WITH_ZLIB
+    if (sink == NULL)
+        return 0;
+    
+    return ((cte_deflate_sink_s *) sink)->total_out;
+#else
+    (void) sink;
+    
+    return 0;
+#endif
+} // end cte_deflate_sink_total_out
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_dispose_deflate_sink( sink )
+// ---------------------------------------------------------------------------
+//
+// Disposes of deflate sink <sink>,  whether finished or not.  Returns NULL.
+
+cte_deflate_sink_t cte_dispose_deflate_sink(cte_deflate_sink_t sink) {
+#ifdef CTE_WITH_ZLIB
+    if (sink == NULL)
+        return NULL;
+    
+    deflateEnd(&((cte_deflate_sink_s *) sink)->stream);
+    DEALLOCATE(sink);
+#else
+    (void) sink;
+#endif
+    return NULL;
+} // end cte_dispose_deflate_sink
+
+
+#ifdef CTE_WITH_ZLIB
+
+// ===========================================================================
+// P R I V A T E   F U N C T I O N   I M P L E M E N T A T I O N S
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// private function:  _deflate( sink, flush )
+// ---------------------------------------------------------------------------
+//
+// Runs the compressor of deflate sink <sink>  with flush mode <flush>  until
+// it has consumed all pending input,  or for Z_FINISH  until the stream is
+// complete.  Every time the chunk buffer fills up,  it is passed to the out-
+// put handler and reused.  The final partial chunk is left in the buffer.
+// Returns CTE_DEFLATE_STATUS_SUCCESS or the status describing the failure.
+
+static cte_deflate_status_t _deflate(cte_deflate_sink_s *sink, int flush) {
+    int z_status;
+    
+    loop {
+        z_status = deflate(&sink->stream, flush);
+        
+        // bail out if compression failed
+        if ((z_status != Z_OK) && (z_status != Z_STREAM_END) &&
+            (z_status != Z_BUF_ERROR))
+            return CTE_DEFLATE_STATUS_COMPRESSION_FAILED;
+        
+        // pass on full chunk and reuse buffer
+        if (sink->stream.avail_out == 0) {
+            if (NOT(sink->output((const char *) sink->chunk,
+                                 sink->chunk_size, sink->context)))
+                return CTE_DEFLATE_STATUS_OUTPUT_FAILED;
+            
+            sink->total_out = sink->total_out + sink->chunk_size;
+            sink->stream.next_out = sink->chunk;
+            sink->stream.avail_out = (uInt) sink->chunk_size;
+            continue;
+        } // end if
+        
+        // done when input is consumed, or stream is complete when finishing
+        if ((flush == Z_FINISH) ? (z_status == Z_STREAM_END)
+                                : (sink->stream.avail_in == 0))
+            return CTE_DEFLATE_STATUS_SUCCESS;
+    } // end loop
+} // _deflate
+
+#endif /* CTE_WITH_ZLIB */
+
+
+// END OF FILE
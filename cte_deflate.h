@@ -0,0 +1,214 @@
+/* C Template Engine
+ *
+ *  @file cte_deflate.h
+ *  CTE deflate sink interface
+ *
+ *  Output sink compressing rendered output with streaming deflate
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#ifndef CTE_DEFLATE_H
+#define CTE_DEFLATE_H
+
+
+#include <stddef.h>
+
+#include "common.h"
+
+
+// ---------------------------------------------------------------------------
+// Availability
+// ---------------------------------------------------------------------------
+//
+// The deflate sink requires zlib.  It is only functional if the library is
+// built with CTE_WITH_ZLIB defined and linked against zlib,  otherwise every
+// attempt to create a deflate sink fails with CTE_DEFLATE_STATUS_UNAVAILABLE.
+
+
+// ---------------------------------------------------------------------------
+// Default compression level and chunk size
+// ---------------------------------------------------------------------------
+
+#define CTE_DEFLATE_DEFAULT_LEVEL 6
+
+#define CTE_DEFLATE_DEFAULT_CHUNK_SIZE (16*1024) /* 16 KBytes */
+
+
+// ---------------------------------------------------------------------------
+// Opaque deflate sink handle type
+// ---------------------------------------------------------------------------
+//
+// WARNING:  Objects of this opaque type should  only be accessed through this
+// public interface.  DO NOT EVER attempt to bypass the public interface.
+//
+// The internal data structure of this opaque type is  HIDDEN  and  MAY CHANGE
+// at any time WITHOUT NOTICE.  Accessing the internal data structure directly
+// other than  through the  functions  in this public interface is  UNSAFE and
+// may result in an inconsistent program state or a crash.
+
+typedef opaque_t cte_deflate_sink_t;
+
+
+// ---------------------------------------------------------------------------
+// Compressed output handler type
+// ---------------------------------------------------------------------------
+//
+// An output handler is called with a chunk of compressed output,  its length
+// and a user supplied context pointer.  The chunk is only valid for the dura-
+// tion of the call.  The handler returns true if it accepted the chunk,  false
+// to abort compression.
+
+typedef bool (*cte_deflate_output_f)(const char *, size_t, void *);
+
+
+// ---------------------------------------------------------------------------
+// Status codes
+// ---------------------------------------------------------------------------
+
+typedef enum /* cte_deflate_status_t */ {
+    CTE_DEFLATE_STATUS_SUCCESS = 1,
+    CTE_DEFLATE_STATUS_INVALID_SINK,
+    CTE_DEFLATE_STATUS_INVALID_LEVEL,
+    CTE_DEFLATE_STATUS_INVALID_OUTPUT,
+    CTE_DEFLATE_STATUS_ALLOCATION_FAILED,
+    CTE_DEFLATE_STATUS_COMPRESSION_FAILED,
+    CTE_DEFLATE_STATUS_OUTPUT_FAILED,
+    CTE_DEFLATE_STATUS_UNAVAILABLE
+} cte_deflate_status_t;
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_new_deflate_sink( level, chunk_size, output, context, status )
+// ---------------------------------------------------------------------------
+//
+// Creates and returns a new deflate sink  which compresses all data written to
+// it into gzip format at compression level <level>,  0 to 9,  and passes the
+// compressed data to output handler <output>,  together with <context>,  in
+// chunks of <chunk_size> bytes.  If -1 is passed in for <level>  the level is
+// CTE_DEFLATE_DEFAULT_LEVEL,  if zero is passed in for <chunk_size> the chunk
+// size is CTE_DEFLATE_DEFAULT_CHUNK_SIZE,  chunk sizes above UINT_MAX are re-
+// duced to UINT_MAX.  The function fails if NULL is passed in for <output>,
+// if <level> is out of range,  if allocation fails or if the library was built
+// without zlib.
+//
+// Data is written to the sink  by passing cte_deflate_sink_write() as sink and
+// the deflate sink as context to cte_render_to_sink()  or  cte_render_compi-
+// led_to_sink().  Several renders may be written to the same sink in turn.
+// Compression is completed by calling cte_deflate_sink_finish().
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_deflate_sink_t cte_new_deflate_sink(int level,
+                                     size_t chunk_size,
+                       cte_deflate_output_f output,
+                                       void *context,
+                       cte_deflate_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_deflate_sink_write( data, length, sink )
+// ---------------------------------------------------------------------------
+//
+// Compresses <length> bytes starting at <data> into deflate sink <sink>,  pass-
+// ing any completed chunks of compressed output to the sink's output handler.
+// Returns true if successful,  false if NULL is passed in for <sink>,  if the
+// sink has already been finished  or if compression or the output handler
+// failed.  Data of any length is accepted,  it is passed to zlib in slices of
+// at most UINT_MAX bytes.  The function has the signature of a cte_sink_f sink
+// function.
+
+bool cte_deflate_sink_write(const char *data,
+                                size_t length,
+                                  void *sink);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_deflate_sink_finish( sink, status )
+// ---------------------------------------------------------------------------
+//
+// Completes compression in deflate sink <sink>  and passes all remaining com-
+// pressed output including the gzip trailer to the sink's output handler.  No
+// further data may be written to the sink afterwards.  The function fails if
+// NULL is passed in for <sink>  or if compression or the output handler fail.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_deflate_sink_finish(cte_deflate_sink_t sink,
+                           cte_deflate_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_deflate_sink_total_in( sink )
+// ---------------------------------------------------------------------------
+//
+// Returns the number of bytes written to deflate sink <sink>  so far,  returns
+// zero if NULL is passed in for <sink>.
+
+size_t cte_deflate_sink_total_in(cte_deflate_sink_t sink);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_deflate_sink_total_out( sink )
+// ---------------------------------------------------------------------------
+//
+// Returns the number of compressed bytes passed to the output handler of de-
+// flate sink <sink> so far,  returns zero if NULL is passed in for <sink>.
+
+size_t cte_deflate_sink_total_out(cte_deflate_sink_t sink);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_dispose_deflate_sink( sink )
+// ---------------------------------------------------------------------------
+//
+// Disposes of deflate sink <sink>,  whether finished or not.  Returns NULL.
+
+cte_deflate_sink_t cte_dispose_deflate_sink(cte_deflate_sink_t sink);
+
+
+#endif /* CTE_DEFLATE_H */
+
+// END OF FILE
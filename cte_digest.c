@@ -0,0 +1,482 @@
+/* C Template Engine
+ *
+ *  @file cte_digest.c
+ *  CTE content digest implementation
+ *
+ *  Incremental xxHash64 and CRC32C digests of rendered output
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include <string.h>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+#include "cte_digest.h"
+
+
+// ---------------------------------------------------------------------------
+// xxHash64 primes
+// ---------------------------------------------------------------------------
+
+#define CTE_XXH_PRIME_1 0x9E3779B185EBCA87ULL
+#define CTE_XXH_PRIME_2 0xC2B2AE3D27D4EB4FULL
+#define CTE_XXH_PRIME_3 0x165667B19E3779F9ULL
+#define CTE_XXH_PRIME_4 0x85EBCA77C2B2AE63ULL
+#define CTE_XXH_PRIME_5 0x27D4EB2F165667C5ULL
+
+
+// ---------------------------------------------------------------------------
+// xxHash64 stripe length
+// ---------------------------------------------------------------------------
+
+#define CTE_XXH_STRIPE_LENGTH 32
+
+
+// ---------------------------------------------------------------------------
+// CRC32C lookup table, reflected polynomial 0x82F63B78
+// ---------------------------------------------------------------------------
+
+#if !defined(__SSE4_2__)
+static const uint32_t _crc32c_table[256] = {
+    0x00000000, 0xf26b8303, 0xe13b70f7, 0x1350f3f4,
+    0xc79a971f, 0x35f1141c, 0x26a1e7e8, 0xd4ca64eb,
+    0x8ad958cf, 0x78b2dbcc, 0x6be22838, 0x9989ab3b,
+    0x4d43cfd0, 0xbf284cd3, 0xac78bf27, 0x5e133c24,
+    0x105ec76f, 0xe235446c, 0xf165b798, 0x030e349b,
+    0xd7c45070, 0x25afd373, 0x36ff2087, 0xc494a384,
+    0x9a879fa0, 0x68ec1ca3, 0x7bbcef57, 0x89d76c54,
+    0x5d1d08bf, 0xaf768bbc, 0xbc267848, 0x4e4dfb4b,
+    0x20bd8ede, 0xd2d60ddd, 0xc186fe29, 0x33ed7d2a,
+    0xe72719c1, 0x154c9ac2, 0x061c6936, 0xf477ea35,
+    0xaa64d611, 0x580f5512, 0x4b5fa6e6, 0xb93425e5,
+    0x6dfe410e, 0x9f95c20d, 0x8cc531f9, 0x7eaeb2fa,
+    0x30e349b1, 0xc288cab2, 0xd1d83946, 0x23b3ba45,
+    0xf779deae, 0x05125dad, 0x1642ae59, 0xe4292d5a,
+    0xba3a117e, 0x4851927d, 0x5b016189, 0xa96ae28a,
+    0x7da08661, 0x8fcb0562, 0x9c9bf696, 0x6ef07595,
+    0x417b1dbc, 0xb3109ebf, 0xa0406d4b, 0x522bee48,
+    0x86e18aa3, 0x748a09a0, 0x67dafa54, 0x95b17957,
+    0xcba24573, 0x39c9c670, 0x2a993584, 0xd8f2b687,
+    0x0c38d26c, 0xfe53516f, 0xed03a29b, 0x1f682198,
+    0x5125dad3, 0xa34e59d0, 0xb01eaa24, 0x42752927,
+    0x96bf4dcc, 0x64d4cecf, 0x77843d3b, 0x85efbe38,
+    0xdbfc821c, 0x2997011f, 0x3ac7f2eb, 0xc8ac71e8,
+    0x1c661503, 0xee0d9600, 0xfd5d65f4, 0x0f36e6f7,
+    0x61c69362, 0x93ad1061, 0x80fde395, 0x72966096,
+    0xa65c047d, 0x5437877e, 0x4767748a, 0xb50cf789,
+    0xeb1fcbad, 0x197448ae, 0x0a24bb5a, 0xf84f3859,
+    0x2c855cb2, 0xdeeedfb1, 0xcdbe2c45, 0x3fd5af46,
+    0x7198540d, 0x83f3d70e, 0x90a324fa, 0x62c8a7f9,
+    0xb602c312, 0x44694011, 0x5739b3e5, 0xa55230e6,
+    0xfb410cc2, 0x092a8fc1, 0x1a7a7c35, 0xe811ff36,
+    0x3cdb9bdd, 0xceb018de, 0xdde0eb2a, 0x2f8b6829,
+    0x82f63b78, 0x709db87b, 0x63cd4b8f, 0x91a6c88c,
+    0x456cac67, 0xb7072f64, 0xa457dc90, 0x563c5f93,
+    0x082f63b7, 0xfa44e0b4, 0xe9141340, 0x1b7f9043,
+    0xcfb5f4a8, 0x3dde77ab, 0x2e8e845f, 0xdce5075c,
+    0x92a8fc17, 0x60c37f14, 0x73938ce0, 0x81f80fe3,
+    0x55326b08, 0xa759e80b, 0xb4091bff, 0x466298fc,
+    0x1871a4d8, 0xea1a27db, 0xf94ad42f, 0x0b21572c,
+    0xdfeb33c7, 0x2d80b0c4, 0x3ed04330, 0xccbbc033,
+    0xa24bb5a6, 0x502036a5, 0x4370c551, 0xb11b4652,
+    0x65d122b9, 0x97baa1ba, 0x84ea524e, 0x7681d14d,
+    0x2892ed69, 0xdaf96e6a, 0xc9a99d9e, 0x3bc21e9d,
+    0xef087a76, 0x1d63f975, 0x0e330a81, 0xfc588982,
+    0xb21572c9, 0x407ef1ca, 0x532e023e, 0xa145813d,
+    0x758fe5d6, 0x87e466d5, 0x94b49521, 0x66df1622,
+    0x38cc2a06, 0xcaa7a905, 0xd9f75af1, 0x2b9cd9f2,
+    0xff56bd19, 0x0d3d3e1a, 0x1e6dcdee, 0xec064eed,
+    0xc38d26c4, 0x31e6a5c7, 0x22b65633, 0xd0ddd530,
+    0x0417b1db, 0xf67c32d8, 0xe52cc12c, 0x1747422f,
+    0x49547e0b, 0xbb3ffd08, 0xa86f0efc, 0x5a048dff,
+    0x8ecee914, 0x7ca56a17, 0x6ff599e3, 0x9d9e1ae0,
+    0xd3d3e1ab, 0x21b862a8, 0x32e8915c, 0xc083125f,
+    0x144976b4, 0xe622f5b7, 0xf5720643, 0x07198540,
+    0x590ab964, 0xab613a67, 0xb831c993, 0x4a5a4a90,
+    0x9e902e7b, 0x6cfbad78, 0x7fab5e8c, 0x8dc0dd8f,
+    0xe330a81a, 0x115b2b19, 0x020bd8ed, 0xf0605bee,
+    0x24aa3f05, 0xd6c1bc06, 0xc5914ff2, 0x37faccf1,
+    0x69e9f0d5, 0x9b8273d6, 0x88d28022, 0x7ab90321,
+    0xae7367ca, 0x5c18e4c9, 0x4f48173d, 0xbd23943e,
+    0xf36e6f75, 0x0105ec76, 0x12551f82, 0xe03e9c81,
+    0x34f4f86a, 0xc69f7b69, 0xd5cf889d, 0x27a40b9e,
+    0x79b737ba, 0x8bdcb4b9, 0x988c474d, 0x6ae7c44e,
+    0xbe2da0a5, 0x4c4623a6, 0x5f16d052, 0xad7d5351
+} /* _crc32c_table */ ;
+#endif
+
+
+// ===========================================================================
+// P R I V A T E   F U N C T I O N   P R O T O T Y P E S   A N D   M A C R O S
+// ===========================================================================
+
+static fmacro uint64_t _read64(const uint8_t *p);
+
+static fmacro uint32_t _read32(const uint8_t *p);
+
+static fmacro uint64_t _xxh_round(uint64_t acc, uint64_t input);
+
+static fmacro uint64_t _xxh_merge_round(uint64_t acc, uint64_t value);
+
+static void _xxh_stripes(uint64_t *acc, const uint8_t *p, size_t count);
+
+static uint32_t _crc32c_update(uint32_t crc, const uint8_t *p, size_t length);
+
+#define CTE_ROTL64(_x, _r) (((_x) << (_r)) | ((_x) >> (64 - (_r))))
+
+
+// ===========================================================================
+// P U B L I C   F U N C T I O N   I M P L E M E N T A T I O N S
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// function:  cte_digest_init( state, kinds )
+// ---------------------------------------------------------------------------
+//
+// Initialises digest state <state>  to compute the digests  requested in bit
+// set <kinds>,  a combination of CTE_DIGEST_XXH64 and CTE_DIGEST_CRC32C.
+
+void cte_digest_init(cte_digest_state_t *state, cardinal kinds) {
+    
+    state->kinds = kinds;
+    
+    // seed zero
+    state->acc[0] = CTE_XXH_PRIME_1 + CTE_XXH_PRIME_2;
+    state->acc[1] = CTE_XXH_PRIME_2;
+    state->acc[2] = 0;
+    state->acc[3] = 0 - CTE_XXH_PRIME_1;
+    state->total_length = 0;
+    state->stripe_length = 0;
+    
+    state->crc = 0xFFFFFFFF;
+    
+    return;
+} // end cte_digest_init
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_digest_update( state, data, length )
+// ---------------------------------------------------------------------------
+//
+// Feeds <length> bytes starting at <data> into digest state <state>.  Data may
+// be fed in pieces of any size,  the digests do not depend on how the data is
+// split.
+
+void cte_digest_update(cte_digest_state_t *state,
+                       const void *data,
+                       size_t length) {
+    
+    const uint8_t *p = data;
+    size_t fill;
+    
+    if (state->kinds & CTE_DIGEST_CRC32C)
+        state->crc = _crc32c_update(state->crc, p, length);
+    
+    if (NOT(state->kinds & CTE_DIGEST_XXH64))
+        return;
+    
+    state->total_length = state->total_length + length;
+    
+    // not enough for a stripe, buffer and return
+    if (state->stripe_length + length < CTE_XXH_STRIPE_LENGTH) {
+        memcpy(&state->stripe[state->stripe_length], p, length);
+        state->stripe_length = state->stripe_length + length;
+        return;
+    } // end if
+    
+    // complete buffered stripe
+    if (state->stripe_length > 0) {
+        fill = CTE_XXH_STRIPE_LENGTH - state->stripe_length;
+        memcpy(&state->stripe[state->stripe_length], p, fill);
+        _xxh_stripes(state->acc, state->stripe, 1);
+        p = p + fill;
+        length = length - fill;
+        state->stripe_length = 0;
+    } // end if
+    
+    // process whole stripes in place
+    _xxh_stripes(state->acc, p, length / CTE_XXH_STRIPE_LENGTH);
+    p = p + (length & ~((size_t) CTE_XXH_STRIPE_LENGTH - 1));
+    length = length & (CTE_XXH_STRIPE_LENGTH - 1);
+    
+    // buffer remainder
+    memcpy(state->stripe, p, length);
+    state->stripe_length = length;
+    
+    return;
+} // end cte_digest_update
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_digest_final( state, digest )
+// ---------------------------------------------------------------------------
+//
+// Passes back the digests of all data fed into digest state <state> in <di-
+// gest>.  The state is not modified and more data may be fed into it.
+
+void cte_digest_final(const cte_digest_state_t *state, cte_digest_t *digest) {
+    
+    const uint8_t *p, *end;
+    uint64_t h;
+    
+    digest->xxh64 = 0;
+    digest->crc32c = 0;
+    
+    if (state->kinds & CTE_DIGEST_CRC32C)
+        digest->crc32c = state->crc ^ 0xFFFFFFFF;
+    
+    if (NOT(state->kinds & CTE_DIGEST_XXH64))
+        return;
+    
+    // converge accumulators
+    if (state->total_length >= CTE_XXH_STRIPE_LENGTH) {
+        h = CTE_ROTL64(state->acc[0], 1) + CTE_ROTL64(state->acc[1], 7) +
+            CTE_ROTL64(state->acc[2], 12) + CTE_ROTL64(state->acc[3], 18);
+        h = _xxh_merge_round(h, state->acc[0]);
+        h = _xxh_merge_round(h, state->acc[1]);
+        h = _xxh_merge_round(h, state->acc[2]);
+        h = _xxh_merge_round(h, state->acc[3]);
+    }
+    else /* short input, seed zero */ {
+        h = CTE_XXH_PRIME_5;
+    } // end if
+    
+    h = h + state->total_length;
+    
+    // consume buffered remainder
+    p = state->stripe;
+    end = p + state->stripe_length;
+    
+    while (p + 8 <= end) {
+        h = h ^ _xxh_round(0, _read64(p));
+        h = CTE_ROTL64(h, 27) * CTE_XXH_PRIME_1 + CTE_XXH_PRIME_4;
+        p = p + 8;
+    } // end while
+    
+    if (p + 4 <= end) {
+        h = h ^ ((uint64_t) _read32(p) * CTE_XXH_PRIME_1);
+        h = CTE_ROTL64(h, 23) * CTE_XXH_PRIME_2 + CTE_XXH_PRIME_3;
+        p = p + 4;
+    } // end if
+    
+    while (p < end) {
+        h = h ^ (*p * CTE_XXH_PRIME_5);
+        h = CTE_ROTL64(h, 11) * CTE_XXH_PRIME_1;
+        p++;
+    } // end while
+    
+    // avalanche
+    h = h ^ (h >> 33);
+    h = h * CTE_XXH_PRIME_2;
+    h = h ^ (h >> 29);
+    h = h * CTE_XXH_PRIME_3;
+    h = h ^ (h >> 32);
+    
+    digest->xxh64 = h;
+    
+    return;
+} // end cte_digest_final
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_digest_of( data, length, kinds, digest )
+// ---------------------------------------------------------------------------
+//
+// Computes the digests requested in bit set <kinds>  of the <length> bytes
+// starting at <data> and passes them back in <digest>.
+
+void cte_digest_of(const void *data,
+                   size_t length,
+                   cardinal kinds,
+                   cte_digest_t *digest) {
+    
+    cte_digest_state_t state;
+    
+    cte_digest_init(&state, kinds);
+    cte_digest_update(&state, data, length);
+    cte_digest_final(&state, digest);
+    
+    return;
+} // end cte_digest_of
+
+
+// ===========================================================================
+// P R I V A T E   F U N C T I O N   I M P L E M E N T A T I O N S
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// private function:  _read64( p )
+// ---------------------------------------------------------------------------
+//
+// Returns the little endian 64 bit value at <p>,  which need not be aligned.
+
+static fmacro uint64_t _read64(const uint8_t *p) {
+    uint64_t value;
+    
+    memcpy(&value, p, sizeof(value));
+    
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    value = __builtin_bswap64(value);
+#endif
+    
+    return value;
+} // _read64
+
+
+// ---------------------------------------------------------------------------
+// private function:  _read32( p )
+// ---------------------------------------------------------------------------
+//
+// Returns the little endian 32 bit value at <p>,  which need not be aligned.
+
+static fmacro uint32_t _read32(const uint8_t *p) {
+    uint32_t value;
+    
+    memcpy(&value, p, sizeof(value));
+    
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    value = __builtin_bswap32(value);
+#endif
+    
+    return value;
+} // _read32
+
+
+// ---------------------------------------------------------------------------
+// private function:  _xxh_round( acc, input )
+// ---------------------------------------------------------------------------
+//
+// Returns accumulator <acc> after mixing in 64 bit lane <input>.
+
+static fmacro uint64_t _xxh_round(uint64_t acc, uint64_t input) {
+    
+    acc = acc + input * CTE_XXH_PRIME_2;
+    acc = CTE_ROTL64(acc, 31);
+    
+    return acc * CTE_XXH_PRIME_1;
+} // _xxh_round
+
+
+// ---------------------------------------------------------------------------
+// private function:  _xxh_merge_round( acc, value )
+// ---------------------------------------------------------------------------
+//
+// Returns hash <acc> after merging in lane accumulator <value>.
+
+static fmacro uint64_t _xxh_merge_round(uint64_t acc, uint64_t value) {
+    
+    acc = acc ^ _xxh_round(0, value);
+    
+    return acc * CTE_XXH_PRIME_1 + CTE_XXH_PRIME_4;
+} // _xxh_merge_round
+
+
+// ---------------------------------------------------------------------------
+// private function:  _xxh_stripes( acc, p, count )
+// ---------------------------------------------------------------------------
+//
+// Mixes <count> consecutive 32 byte stripes starting at <p>  into the four
+// lane accumulators <acc>.
+
+static void _xxh_stripes(uint64_t *acc, const uint8_t *p, size_t count) {
+    uint64_t a0 = acc[0], a1 = acc[1], a2 = acc[2], a3 = acc[3];
+    
+    while (count > 0) {
+        a0 = _xxh_round(a0, _read64(p));
+        a1 = _xxh_round(a1, _read64(p + 8));
+        a2 = _xxh_round(a2, _read64(p + 16));
+        a3 = _xxh_round(a3, _read64(p + 24));
+        p = p + CTE_XXH_STRIPE_LENGTH;
+        count--;
+    } // end while
+    
+    acc[0] = a0; acc[1] = a1; acc[2] = a2; acc[3] = a3;
+    
+    return;
+} // _xxh_stripes
+
+
+// ---------------------------------------------------------------------------
+// private function:  _crc32c_update( crc, p, length )
+// ---------------------------------------------------------------------------
+//
+// Returns running CRC32C <crc>  after feeding it <length> bytes starting at
+// <p>.  Uses the SSE4.2 CRC32 instruction where available, eight bytes at a
+// time,  otherwise a byte wise table lookup.
+
+static uint32_t _crc32c_update(uint32_t crc, const uint8_t *p, size_t length) {
+    
+#if defined(__SSE4_2__)
+#if defined(__x86_64__)
+    uint64_t crc64 = crc;
+    
+    while (length >= 8) {
+        crc64 = _mm_crc32_u64(crc64, _read64(p));
+        p = p + 8;
+        length = length - 8;
+    } // end while
+    
+    crc = (uint32_t) crc64;
+#endif
+    
+    while (length > 0) {
+        crc = _mm_crc32_u8(crc, *p);
+        p++;
+        length--;
+    } // end while
+#else
+    while (length > 0) {
+        crc = _crc32c_table[(crc ^ *p) & 0xFF] ^ (crc >> 8);
+        p++;
+        length--;
+    } // end while
+#endif
+    
+    return crc;
+} // _crc32c_update
+
+
+// END OF FILE
@@ -0,0 +1,154 @@
+/* C Template Engine
+ *
+ *  @file cte_digest.h
+ *  CTE content digest interface
+ *
+ *  Incremental xxHash64 and CRC32C digests of rendered output
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#ifndef CTE_DIGEST_H
+#define CTE_DIGEST_H
+
+
+#include <stddef.h>
+
+#include "common.h"
+
+
+// ---------------------------------------------------------------------------
+// Digest kinds
+// ---------------------------------------------------------------------------
+//
+// Digest kinds may be combined,  all requested digests are computed in a
+// single pass.
+
+typedef enum /* cte_digest_kind_t */ {
+    CTE_DIGEST_NONE = 0,
+    CTE_DIGEST_XXH64 = 1,
+    CTE_DIGEST_CRC32C = 2
+} cte_digest_kind_t;
+
+
+// ---------------------------------------------------------------------------
+// Digest result type
+// ---------------------------------------------------------------------------
+//
+// Holds the xxHash64 digest  (seed zero)  and the CRC32C digest  of the data
+// fed to a digest state.  Digests that were not requested are zero.
+
+typedef struct /* cte_digest_t */ {
+    uint64_t xxh64;
+    uint32_t crc32c;
+} cte_digest_t;
+
+
+// ---------------------------------------------------------------------------
+// Digest state type
+// ---------------------------------------------------------------------------
+//
+// WARNING:  The fields of this type are  HIDDEN  and  MAY CHANGE at any time
+// WITHOUT NOTICE.  The type is only exposed so that digest states can be de-
+// clared without allocation.  Objects of this type should only be accessed
+// through the functions in this public interface.
+
+typedef struct /* cte_digest_state_t */ {
+    cardinal kinds;
+    uint64_t acc[4];
+    uint64_t total_length;
+     uint8_t stripe[32];
+    cardinal stripe_length;
+    uint32_t crc;
+} cte_digest_state_t;
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_digest_init( state, kinds )
+// ---------------------------------------------------------------------------
+//
+// Initialises digest state <state>  to compute the digests  requested in bit
+// set <kinds>,  a combination of CTE_DIGEST_XXH64 and CTE_DIGEST_CRC32C.
+
+void cte_digest_init(cte_digest_state_t *state, cardinal kinds);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_digest_update( state, data, length )
+// ---------------------------------------------------------------------------
+//
+// Feeds <length> bytes starting at <data> into digest state <state>.  Data may
+// be fed in pieces of any size,  the digests do not depend on how the data is
+// split.
+
+void cte_digest_update(cte_digest_state_t *state,
+                               const void *data,
+                                   size_t length);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_digest_final( state, digest )
+// ---------------------------------------------------------------------------
+//
+// Passes back the digests of all data fed into digest state <state> in <di-
+// gest>.  The state is not modified and more data may be fed into it.
+
+void cte_digest_final(const cte_digest_state_t *state, cte_digest_t *digest);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_digest_of( data, length, kinds, digest )
+// ---------------------------------------------------------------------------
+//
+// Computes the digests requested in bit set <kinds>  of the <length> bytes
+// starting at <data> and passes them back in <digest>.
+
+void cte_digest_of(const void *data,
+                       size_t length,
+                     cardinal kinds,
+                 cte_digest_t *digest);
+
+
+#endif /* CTE_DIGEST_H */
+
+// END OF FILE
@@ -0,0 +1,474 @@
+/* C Template Engine
+ *
+ *  @file cte_escape.c
+ *  CTE escape implementation
+ *
+ *  Output escaping kernels for HTML, JSON and URL escaping
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include <string.h>
+
+#include "ASCII.h"
+#include "alloc.h"
+#include "cte_escape.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+
+// ---------------------------------------------------------------------------
+// Characters needing escaping per escaping mode
+// ---------------------------------------------------------------------------
+//
+// Non-zero entries mark characters that need escaping.  URL escaping leaves
+// letters, digits and - . _ ~ as they are and escapes all other characters.
+
+static const uint8_t _cte_escape_needed[][256] = {
+    
+    /* CTE_ESCAPE_NONE */ { 0 },
+    
+    /* CTE_ESCAPE_HTML */ {
+        ['&'] = 1, ['<'] = 1, ['>'] = 1, ['"'] = 1, ['\''] = 1
+    },
+    
+    /* CTE_ESCAPE_JSON */ {
+        [0x00 ... 0x1F] = 1, ['"'] = 1, ['\\'] = 1
+    },
+    
+    /* CTE_ESCAPE_URL */ {
+        [0x00 ... 0x2C] = 1, [0x2F] = 1, [0x3A ... 0x40] = 1,
+        [0x5B ... 0x5E] = 1, [0x60] = 1, [0x7B ... 0x7D] = 1,
+        [0x7F ... 0xFF] = 1
+    }
+} /* _cte_escape_needed */ ;
+
+
+// ---------------------------------------------------------------------------
+// Hexadecimal digits
+// ---------------------------------------------------------------------------
+
+static const char _cte_hex_digit[] = "0123456789ABCDEF";
+
+
+// ===========================================================================
+// P R I V A T E   F U N C T I O N   P R O T O T Y P E S
+// ===========================================================================
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+static fmacro cardinal _first_to_escape(cte_escape_t escape, const char *str);
+#endif
+
+
+// ===========================================================================
+// P U B L I C   F U N C T I O N   I M P L E M E N T A T I O N S
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// function:  cte_escape_scan( escape, str, length )
+// ---------------------------------------------------------------------------
+//
+// Returns the index of the first of the <length> characters at <str>  which
+// needs escaping in escaping mode <escape>,  or <length> if none does.  Where
+// SSE2 or NEON is available,  sixteen characters are examined at a time.  The
+// characters need not be terminated.  Mode <escape> must not be NONE.
+
+size_t cte_escape_scan(cte_escape_t escape, const char *str, size_t length) {
+    size_t index = 0;
+    
+#if defined(__SSE2__) || defined(__ARM_NEON)
+    cardinal first;
+    
+    // examine sixteen characters at a time
+    while (index + 16 <= length) {
+        first = _first_to_escape(escape, &str[index]);
+        
+        if (first < 16)
+            return index + first;
+        
+        index = index + 16;
+    } // end while
+#endif
+    
+    // examine remaining characters one at a time
+    while ((index < length) &&
+           (_cte_escape_needed[escape][(uint8_t) str[index]] == 0))
+        index++;
+    
+    return index;
+} // end cte_escape_scan
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_escape_char( escape, ch, sequence )
+// ---------------------------------------------------------------------------
+//
+// Writes the escape sequence for character <ch>  in escaping mode <escape> to
+// <sequence>,  which must hold at least CTE_ESCAPE_MAX_LENGTH characters,  and
+// returns its length.  The sequence is not terminated.  Character <ch> must be
+// one that needs escaping in mode <escape>.
+
+cardinal cte_escape_char(cte_escape_t escape, char ch, char *sequence) {
+    const char *entity;
+    cardinal length;
+    
+    switch (escape) {
+        
+        // entity reference
+        case CTE_ESCAPE_HTML :
+            switch (ch) {
+                case '&' : entity = "&amp;"; break;
+                case '<' : entity = "&lt;"; break;
+                case '>' : entity = "&gt;"; break;
+                case '"' : entity = "&quot;"; break;
+                default : entity = "&#39;";
+            } // end switch
+            
+            length = 0;
+            while (entity[length] != CSTRING_TERMINATOR) {
+                sequence[length] = entity[length];
+                length++;
+            } // end while
+            
+            return length;
+        
+        // backslash escape, unicode escape for other control characters
+        case CTE_ESCAPE_JSON :
+            sequence[0] = BACKSLASH;
+            
+            switch (ch) {
+                case '"' : sequence[1] = '"'; return 2;
+                case '\\' : sequence[1] = '\\'; return 2;
+                case '\b' : sequence[1] = 'b'; return 2;
+                case '\f' : sequence[1] = 'f'; return 2;
+                case '\n' : sequence[1] = 'n'; return 2;
+                case '\r' : sequence[1] = 'r'; return 2;
+                case '\t' : sequence[1] = 't'; return 2;
+            } // end switch
+            
+            sequence[1] = 'u';
+            sequence[2] = '0';
+            sequence[3] = '0';
+            sequence[4] = _cte_hex_digit[((uint8_t) ch) >> 4];
+            sequence[5] = _cte_hex_digit[((uint8_t) ch) & 0x0F];
+            return 6;
+        
+        // percent encoding
+        case CTE_ESCAPE_URL :
+            sequence[0] = '%';
+            sequence[1] = _cte_hex_digit[((uint8_t) ch) >> 4];
+            sequence[2] = _cte_hex_digit[((uint8_t) ch) & 0x0F];
+            return 3;
+        
+        default :
+            sequence[0] = ch;
+            return 1;
+    } // end switch
+} // end cte_escape_char
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_escaped_length( escape, str, length )
+// ---------------------------------------------------------------------------
+//
+// Returns the length of the <length> characters at <str>  once escaped in es-
+// caping mode <escape>,  not counting a terminator.  The characters need not
+// be terminated.  Modes other than HTML, JSON and URL leave them unchanged.
+
+size_t cte_escaped_length(cte_escape_t escape,
+                          const char *str,
+                          size_t length) {
+    char sequence[CTE_ESCAPE_MAX_LENGTH];
+    size_t index, run, e_length;
+    
+    // modes that do not escape leave length unchanged
+    if ((escape == CTE_ESCAPE_NONE) || (escape > CTE_ESCAPE_URL))
+        return length;
+    
+    e_length = 0;
+    index = 0;
+    
+    loop {
+        // count run of characters needing no escaping
+        run = cte_escape_scan(escape, &str[index], length - index);
+        e_length = e_length + run;
+        index = index + run;
+        
+        if (index == length)
+            break;
+        
+        // count escape sequence
+        e_length = e_length + cte_escape_char(escape, str[index], sequence);
+        index++;
+    } // end loop
+    
+    return e_length;
+} // end cte_escaped_length
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_escape_into( escape, buffer, capacity, str, length )
+// ---------------------------------------------------------------------------
+//
+// Escapes the <length> characters at <str>  in escaping mode <escape>  into
+// caller owned buffer <buffer> of <capacity> bytes  and returns the length of
+// the escaped characters,  not counting the terminator.  At most <capacity>-1
+// characters are written,  followed by a terminator,  an escape sequence that
+// does not fit is left out as a whole.  If the returned length is not less
+// than <capacity>,  the result was truncated.  Nothing is written if zero is
+// passed in for <capacity>.  Runs of characters that need no escaping are
+// found sixteen at a time by cte_escape_scan() and copied in one piece.
+// Modes other than HTML, JSON and URL leave the characters unchanged.
+
+size_t cte_escape_into(cte_escape_t escape,
+                               char *buffer,
+                             size_t capacity,
+                         const char *str,
+                             size_t length) {
+    
+    char sequence[CTE_ESCAPE_MAX_LENGTH];
+    size_t index, run, b_index, b_size, e_length;
+    cardinal seq_length;
+    
+    // reserve room for terminator
+    b_size = (capacity > 0) ? capacity - 1 : 0;
+    b_index = 0;
+    e_length = 0;
+    index = 0;
+    
+    while (index < length) {
+        
+        // find run of characters needing no escaping
+        if ((escape == CTE_ESCAPE_NONE) || (escape > CTE_ESCAPE_URL))
+            run = length - index;
+        else
+            run = cte_escape_scan(escape, &str[index], length - index);
+        
+        // copy as much of the run as fits
+        if (b_index < b_size) {
+            memcpy(&buffer[b_index], &str[index], MIN(run, b_size - b_index));
+            b_index = b_index + MIN(run, b_size - b_index);
+        } // end if
+        
+        e_length = e_length + run;
+        index = index + run;
+        
+        if (index == length)
+            break;
+        
+        // append escape sequence if it fits as a whole
+        seq_length = cte_escape_char(escape, str[index], sequence);
+        
+        if (b_index + seq_length <= b_size) {
+            memcpy(&buffer[b_index], sequence, seq_length);
+            b_index = b_index + seq_length;
+        }
+        else /* sequence does not fit, stop writing */ {
+            b_size = b_index;
+        } // end if
+        
+        e_length = e_length + seq_length;
+        index++;
+    } // end while
+    
+    if (capacity > 0)
+        buffer[b_index] = CSTRING_TERMINATOR;
+    
+    return e_length;
+} // end cte_escape_into
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_escaped_string( escape, str, length, e_length )
+// ---------------------------------------------------------------------------
+//
+// Escapes the <length> characters at <str>  in escaping mode <escape>  and
+// returns a pointer to a new dynamically allocated terminated string holding
+// the result.  The length of the result  is passed back in <e_length>,  unless
+// NULL was passed in for <e_length>.  Returns NULL if NULL was passed in for
+// <str> or if allocation failed.  Modes other than HTML, JSON and URL leave
+// the characters unchanged.
+
+char *cte_escaped_string(cte_escape_t escape,
+                           const char *str,
+                               size_t length,
+                               size_t *e_length) {
+    char *result;
+    size_t size;
+    
+    // bail out if string is NULL
+    if (str == NULL)
+        return NULL;
+    
+    size = cte_escaped_length(escape, str, length) + 1;
+    result = ALLOCATE(size);
+    
+    // bail out if allocation failed
+    if (result == NULL)
+        return NULL;
+    
+    cte_escape_into(escape, result, size, str, length);
+    
+    ASSIGN_BY_REF(e_length, size - 1);
+    return result;
+} // end cte_escaped_string
+
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+
+// ===========================================================================
+// P R I V A T E   F U N C T I O N   I M P L E M E N T A T I O N S
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// private function:  _first_to_escape( escape, str )
+// ---------------------------------------------------------------------------
+//
+// Returns the index of the first of the sixteen characters at <str>  which
+// needs escaping in escaping mode <escape>,  or sixteen if none does.  Ranges
+// are tested by comparing unsigned,  control characters are those not above
+// 0x1F.
+
+static fmacro cardinal _first_to_escape(cte_escape_t escape, const char *str) {
+    
+#if defined(__SSE2__)
+    __m128i chars, needed;
+    int mask;
+    
+    #define CTE_EQUAL(_ch) _mm_cmpeq_epi8(chars, _mm_set1_epi8(_ch))
+    #define CTE_IN_RANGE(_low, _high) _mm_cmpeq_epi8(chars, \
+        _mm_min_epu8(_mm_max_epu8(chars, _mm_set1_epi8(_low)), \
+                     _mm_set1_epi8(_high)))
+    
+    chars = _mm_loadu_si128((const __m128i *) str);
+    
+    switch (escape) {
+        case CTE_ESCAPE_HTML :
+            needed = _mm_or_si128(_mm_or_si128(CTE_EQUAL('&'), CTE_EQUAL('<')),
+                     _mm_or_si128(_mm_or_si128(CTE_EQUAL('>'), CTE_EQUAL('"')),
+                                  CTE_EQUAL('\'')));
+            mask = _mm_movemask_epi8(needed);
+            break;
+        
+        case CTE_ESCAPE_JSON :
+            needed = _mm_or_si128(_mm_or_si128(CTE_EQUAL('"'), CTE_EQUAL('\\')),
+                                  CTE_IN_RANGE(0x00, 0x1F));
+            mask = _mm_movemask_epi8(needed);
+            break;
+        
+        case CTE_ESCAPE_URL :
+            needed = _mm_or_si128(
+                     _mm_or_si128(_mm_or_si128(CTE_IN_RANGE('0', '9'),
+                                               CTE_IN_RANGE('A', 'Z')),
+                                  _mm_or_si128(CTE_IN_RANGE('a', 'z'),
+                                               CTE_EQUAL('-'))),
+                     _mm_or_si128(_mm_or_si128(CTE_EQUAL('.'), CTE_EQUAL('_')),
+                                  CTE_EQUAL('~')));
+            mask = (~_mm_movemask_epi8(needed)) & 0xFFFF;
+            break;
+        
+        default :
+            return 16;
+    } // end switch
+    
+    #undef CTE_EQUAL
+    #undef CTE_IN_RANGE
+    
+    return (mask != 0) ? __builtin_ctz(mask) : 16;
+    
+#elif defined(__ARM_NEON)
+    uint8x16_t chars, needed;
+    uint64_t mask;
+    
+    #define CTE_EQUAL(_ch) vceqq_u8(chars, vdupq_n_u8(_ch))
+    #define CTE_IN_RANGE(_low, _high) \
+        vandq_u8(vcgeq_u8(chars, vdupq_n_u8(_low)), \
+                 vcleq_u8(chars, vdupq_n_u8(_high)))
+    
+    chars = vld1q_u8((const uint8_t *) str);
+    
+    switch (escape) {
+        case CTE_ESCAPE_HTML :
+            needed = vorrq_u8(vorrq_u8(CTE_EQUAL('&'), CTE_EQUAL('<')),
+                     vorrq_u8(vorrq_u8(CTE_EQUAL('>'), CTE_EQUAL('"')),
+                              CTE_EQUAL('\'')));
+            break;
+        
+        case CTE_ESCAPE_JSON :
+            needed = vorrq_u8(vorrq_u8(CTE_EQUAL('"'), CTE_EQUAL('\\')),
+                              vcleq_u8(chars, vdupq_n_u8(0x1F)));
+            break;
+        
+        case CTE_ESCAPE_URL :
+            needed = vmvnq_u8(vorrq_u8(
+                     vorrq_u8(vorrq_u8(CTE_IN_RANGE('0', '9'),
+                                       CTE_IN_RANGE('A', 'Z')),
+                              vorrq_u8(CTE_IN_RANGE('a', 'z'),
+                                       CTE_EQUAL('-'))),
+                     vorrq_u8(vorrq_u8(CTE_EQUAL('.'), CTE_EQUAL('_')),
+                              CTE_EQUAL('~'))));
+            break;
+        
+        default :
+            return 16;
+    } // end switch
+    
+    #undef CTE_EQUAL
+    #undef CTE_IN_RANGE
+    
+    // narrow to four bits per character
+    mask = vget_lane_u64(vreinterpret_u64_u8(
+               vshrn_n_u16(vreinterpretq_u16_u8(needed), 4)), 0);
+    
+    return (mask != 0) ? (__builtin_ctzll(mask) >> 2) : 16;
+#endif
+} // _first_to_escape
+
+#endif /* __SSE2__ || __ARM_NEON */
+
+
+// END OF FILE
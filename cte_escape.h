@@ -0,0 +1,164 @@
+/* C Template Engine
+ *
+ *  @file cte_escape.h
+ *  CTE escape interface
+ *
+ *  Output escaping kernels for HTML, JSON and URL escaping
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#ifndef CTE_ESCAPE_H
+#define CTE_ESCAPE_H
+
+
+#include <stddef.h>
+
+#include "common.h"
+
+
+// ---------------------------------------------------------------------------
+// Output escaping modes
+// ---------------------------------------------------------------------------
+//
+// HTML escaping replaces the characters & < > " and ' by entity references,
+// JSON escaping replaces " and backslash and control characters by escape
+// sequences for use within JSON strings,  URL escaping percent-encodes all
+// characters other than letters, digits and - . _ ~ for use within URLs.
+//
+// Placeholder values stored without an escaping mode of their own  have mode
+// DEFAULT and are escaped in the mode of the render,  renders in mode DEFAULT
+// escape in the mode of their template syntax.
+
+typedef enum /* cte_escape_t */ {
+    CTE_ESCAPE_NONE,
+    CTE_ESCAPE_HTML,
+    CTE_ESCAPE_JSON,
+    CTE_ESCAPE_URL,
+    CTE_ESCAPE_DEFAULT
+} cte_escape_t;
+
+
+// ---------------------------------------------------------------------------
+// Maximum length of an escape sequence
+// ---------------------------------------------------------------------------
+
+#define CTE_ESCAPE_MAX_LENGTH 6 /* JSON \u00XX */
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_escape_scan( escape, str, length )
+// ---------------------------------------------------------------------------
+//
+// Returns the index of the first of the <length> characters at <str>  which
+// needs escaping in escaping mode <escape>,  or <length> if none does.  Where
+// SSE2 or NEON is available,  sixteen characters are examined at a time.  The
+// characters need not be terminated.  Mode <escape> must not be NONE.
+
+size_t cte_escape_scan(cte_escape_t escape, const char *str, size_t length);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_escape_char( escape, ch, sequence )
+// ---------------------------------------------------------------------------
+//
+// Writes the escape sequence for character <ch>  in escaping mode <escape> to
+// <sequence>,  which must hold at least CTE_ESCAPE_MAX_LENGTH characters,  and
+// returns its length.  The sequence is not terminated.  Character <ch> must be
+// one that needs escaping in mode <escape>.
+
+cardinal cte_escape_char(cte_escape_t escape, char ch, char *sequence);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_escaped_length( escape, str, length )
+// ---------------------------------------------------------------------------
+//
+// Returns the length of the <length> characters at <str>  once escaped in es-
+// caping mode <escape>,  not counting a terminator.  The characters need not
+// be terminated.  Modes other than HTML, JSON and URL leave them unchanged.
+
+size_t cte_escaped_length(cte_escape_t escape, const char *str, size_t length);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_escape_into( escape, buffer, capacity, str, length )
+// ---------------------------------------------------------------------------
+//
+// Escapes the <length> characters at <str>  in escaping mode <escape>  into
+// caller owned buffer <buffer> of <capacity> bytes  and returns the length of
+// the escaped characters,  not counting the terminator.  At most <capacity>-1
+// characters are written,  followed by a terminator,  an escape sequence that
+// does not fit is left out as a whole.  If the returned length is not less
+// than <capacity>,  the result was truncated.  Nothing is written if zero is
+// passed in for <capacity>.  Runs of characters that need no escaping are
+// found sixteen at a time by cte_escape_scan() and copied in one piece.
+// Modes other than HTML, JSON and URL leave the characters unchanged.
+
+size_t cte_escape_into(cte_escape_t escape,
+                               char *buffer,
+                             size_t capacity,
+                         const char *str,
+                             size_t length);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_escaped_string( escape, str, length, e_length )
+// ---------------------------------------------------------------------------
+//
+// Escapes the <length> characters at <str>  in escaping mode <escape>  and
+// returns a pointer to a new dynamically allocated terminated string holding
+// the result.  The length of the result  is passed back in <e_length>,  unless
+// NULL was passed in for <e_length>.  Returns NULL if NULL was passed in for
+// <str> or if allocation failed.  Modes other than HTML, JSON and URL leave
+// the characters unchanged.
+
+char *cte_escaped_string(cte_escape_t escape,
+                           const char *str,
+                               size_t length,
+                               size_t *e_length);
+
+
+#endif /* CTE_ESCAPE_H */
+
+// END OF FILE
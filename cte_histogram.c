@@ -0,0 +1,636 @@
+/* C Template Engine
+ *
+ *  @file cte_histogram.c
+ *  CTE histogram implementation
+ *
+ *  Per-template render latency and output size histograms
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "cte_clock.h"
+#include "cte_histogram.h"
+
+
+#ifdef CTE_WITH_HISTOGRAMS
+
+// ---------------------------------------------------------------------------
+// Thread local storage class
+// ---------------------------------------------------------------------------
+
+#ifndef CTE_NO_THREADS
+#define CTE_HISTOGRAM_THREAD_LOCAL __thread
+#else
+#define CTE_HISTOGRAM_THREAD_LOCAL
+#endif
+
+
+// ---------------------------------------------------------------------------
+// Thread local block cache size, must be a power of two
+// ---------------------------------------------------------------------------
+
+#define CTE_HISTOGRAM_CACHE_SIZE 8 /* entries */
+
+
+// ---------------------------------------------------------------------------
+// Histogram block type
+// ---------------------------------------------------------------------------
+//
+// The histograms of one thread in a histogram set.  A block is only written by
+// the thread that owns it.  Blocks are linked into the list of their set when
+// they are created and are only deallocated when the set is disposed of.
+
+typedef struct _cte_histogram_block_s *cte_histogram_block_p;
+
+struct _cte_histogram_block_s {
+    cte_histogram_block_p next;
+                 cardinal thread;
+          cte_histogram_t latency;
+          cte_histogram_t size;
+};
+
+typedef struct _cte_histogram_block_s cte_histogram_block_s;
+
+
+// ---------------------------------------------------------------------------
+// Histogram set type
+// ---------------------------------------------------------------------------
+//
+// The identity of a set is unique among all sets created by the process,  it
+// keys the thread local block cache  so that an entry left over from a set
+// that has been disposed of is never mistaken for a block of a new set.
+
+typedef struct /* cte_histogram_set_s */ {
+                          uint64_t identity;
+    cte_histogram_block_s *volatile blocks;
+} cte_histogram_set_s;
+
+
+// ---------------------------------------------------------------------------
+// Thread local block cache entry type
+// ---------------------------------------------------------------------------
+
+typedef struct /* cte_histogram_cache_entry_s */ {
+                 uint64_t identity;
+    cte_histogram_block_s *block;
+} cte_histogram_cache_entry_s;
+
+
+// ---------------------------------------------------------------------------
+// Last set identity and thread number issued,  number of the current thread
+// ---------------------------------------------------------------------------
+
+static uint64_t _cte_histogram_set_identity = 0;
+
+static cardinal _cte_histogram_thread_count = 0;
+
+static CTE_HISTOGRAM_THREAD_LOCAL cardinal _cte_histogram_thread = 0;
+
+
+// ---------------------------------------------------------------------------
+// Thread local block cache
+// ---------------------------------------------------------------------------
+
+static CTE_HISTOGRAM_THREAD_LOCAL
+cte_histogram_cache_entry_s _cte_histogram_cache[CTE_HISTOGRAM_CACHE_SIZE];
+
+
+// ===========================================================================
+// P R I V A T E   F U N C T I O N   P R O T O T Y P E S
+// ===========================================================================
+
+static cte_histogram_block_s *_block_for_thread(cte_histogram_set_s *set);
+
+static void _reset(cte_histogram_t *histogram);
+
+static fmacro void _add(cte_histogram_t *histogram, uint64_t value);
+
+static void _merge(cte_histogram_t *into, const cte_histogram_t *histogram);
+
+static fmacro cardinal _bucket_of(uint64_t value);
+
+#endif /* CTE_WITH_HISTOGRAMS */
+
+static fmacro uint64_t _bucket_limit(cardinal index);
+
+static size_t _format_line(char *buffer, size_t size, const char *name,
+                           const cte_histogram_t *histogram);
+
+
+// ===========================================================================
+// P U B L I C   F U N C T I O N   I M P L E M E N T A T I O N S
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// function:  cte_new_histogram_set( status )
+// ---------------------------------------------------------------------------
+//
+// Creates and returns a new empty histogram set.  The function fails if memory
+// could not be allocated  or if the library was built without histograms.  It
+// returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_histogram_set_t cte_new_histogram_set(cte_histogram_status_t *status) {
+#ifdef CTE_WITH_HISTOGRAMS
+    cte_histogram_set_s *set;
+    
+    set = ALLOCATE(sizeof(cte_histogram_set_s));
+    
+    // bail out if allocation failed
+    if (set == NULL) {
+        ASSIGN_BY_REF(status, CTE_HISTOGRAM_STATUS_ALLOCATION_FAILED);
+        return NULL;
+    } // end if
+    
+    set->identity = __sync_add_and_fetch(&_cte_histogram_set_identity, 1);
+    set->blocks = NULL;
+    
+    ASSIGN_BY_REF(status, CTE_HISTOGRAM_STATUS_SUCCESS);
+    return (cte_histogram_set_t) set;
+#else
+    ASSIGN_BY_REF(status, CTE_HISTOGRAM_STATUS_UNAVAILABLE);
+    return NULL;
+#endif
+} // end cte_new_histogram_set
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_histogram_record( set, latency, size )
+// ---------------------------------------------------------------------------
+//
+// Records a render with a latency of <latency> nanoseconds and an output size
+// of <size> bytes  into the histograms of the calling thread in histogram set
+// <set>.  The histograms of a thread are allocated when the thread records
+// into the set for the first time,  if allocation fails the render is not
+// recorded.  Does nothing if NULL is passed in for <set>.
+
+void cte_histogram_record(cte_histogram_set_t set,
+                          uint64_t latency, uint64_t size) {
+#ifdef CTE_WITH_HISTOGRAMS
+    cte_histogram_block_s *block;
+    
+    if (set == NULL)
+        return;
+    
+    block = _block_for_thread((cte_histogram_set_s *) set);
+    
+    // bail out if allocation failed
+    if (block == NULL)
+        return;
+    
+    _add(&block->latency, latency);
+    _add(&block->size, size);
+#else
+    (void) set;
+    (void) latency;
+    (void) size;
+#endif
+    return;
+} // end cte_histogram_record
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_histogram_snapshot( set, snapshot, status )
+// ---------------------------------------------------------------------------
+//
+// Merges the histograms of all threads  in histogram set <set>  and passes the
+// result back in <snapshot>.  A snapshot may be taken while other threads are
+// recording,  renders recorded during the snapshot may be left out.  The func-
+// tion fails if NULL is passed in for <set> or <snapshot>  or if the library
+// was built without histograms,  in which case an empty snapshot is passed
+// back unless NULL was passed in for <snapshot>.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_histogram_snapshot(cte_histogram_set_t set,
+                            cte_histogram_snapshot_t *snapshot,
+                            cte_histogram_status_t *status) {
+#ifdef CTE_WITH_HISTOGRAMS
+    cte_histogram_block_s *block;
+#endif
+    
+    // bail out if snapshot is NULL
+    if (snapshot == NULL) {
+        ASSIGN_BY_REF(status, CTE_HISTOGRAM_STATUS_INVALID_SNAPSHOT);
+        return;
+    } // end if
+    
+    memset(snapshot, 0, sizeof(cte_histogram_snapshot_t));
+    
+#ifdef CTE_WITH_HISTOGRAMS
+    // bail out if set is NULL
+    if (set == NULL) {
+        ASSIGN_BY_REF(status, CTE_HISTOGRAM_STATUS_INVALID_SET);
+        return;
+    } // end if
+    
+    _reset(&snapshot->latency);
+    _reset(&snapshot->size);
+    
+    __sync_synchronize();
+    block = ((cte_histogram_set_s *) set)->blocks;
+    
+    while (block != NULL) {
+        _merge(&snapshot->latency, &block->latency);
+        _merge(&snapshot->size, &block->size);
+        block = block->next;
+    } // end while
+    
+    // smallest value is zero if nothing was recorded
+    if (snapshot->latency.count == 0) {
+        snapshot->latency.min = 0;
+        snapshot->size.min = 0;
+    } // end if
+    
+    ASSIGN_BY_REF(status, CTE_HISTOGRAM_STATUS_SUCCESS);
+    return;
+#else
+    (void) set;
+    
+    ASSIGN_BY_REF(status, CTE_HISTOGRAM_STATUS_UNAVAILABLE);
+    return;
+#endif
+} // end cte_histogram_snapshot
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_histogram_value_at( histogram, percentile )
+// ---------------------------------------------------------------------------
+//
+// Returns the value  below or at which  <percentile> percent of the values in
+// histogram <histogram> lie,  rounded up to the upper bound of its bucket but
+// not above the largest value recorded.  Percentiles outside of the range 0
+// to 100 are clamped to the range.  Returns zero if the histogram is empty or
+// if NULL is passed in for <histogram>.
+
+uint64_t cte_histogram_value_at(const cte_histogram_t *histogram,
+                                double percentile) {
+    
+    uint64_t rank, seen;
+    cardinal index;
+    
+    if ((histogram == NULL) || (histogram->count == 0))
+        return 0;
+    
+    // rank of the value within all values recorded, counting from one
+    if (NOT(percentile > 0.0))
+        rank = 1;
+    else if (percentile >= 100.0)
+        rank = histogram->count;
+    else {
+        rank = (uint64_t) (percentile / 100.0 * (double) histogram->count);
+        if ((double) rank < percentile / 100.0 * (double) histogram->count)
+            rank++;
+        rank = MAX(MIN(rank, histogram->count), 1);
+    } // end if
+    
+    seen = 0;
+    
+    for (index = 0; index < CTE_HISTOGRAM_BUCKET_COUNT; index++) {
+        seen = seen + histogram->bucket[index];
+        
+        if (seen >= rank)
+            return MIN(_bucket_limit(index), histogram->max);
+    } // end for
+    
+    return histogram->max;
+} // end cte_histogram_value_at
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_histogram_format( snapshot, buffer, size )
+// ---------------------------------------------------------------------------
+//
+// Writes a text dump of histogram snapshot <snapshot>  into buffer <buffer> of
+// <size> bytes  and returns the length of the text.  The dump consists of the
+// number of renders, and of the smallest value, the 50th, 90th, 99th and 99.9th
+// percentile,  the largest value and the mean  of render latency and output
+// size,  one line each.  Like snprintf(),  the text is truncated to fit and
+// terminated unless <size> is zero,  the length returned is that of the entire
+// text.  A buffer of CTE_HISTOGRAM_TEXT_SIZE bytes is always large enough.
+// Returns zero if NULL is passed in for <snapshot>.
+
+size_t cte_histogram_format(const cte_histogram_snapshot_t *snapshot,
+                            char *buffer, size_t size) {
+    
+    size_t length;
+    int count;
+    
+    if (snapshot == NULL)
+        return 0;
+    
+    if (buffer == NULL)
+        size = 0;
+    
+    count = snprintf(buffer, size, "renders %llu\n",
+                     (unsigned long long) snapshot->latency.count);
+    length = (size_t) MAX(count, 0);
+    
+    length = length + _format_line((length < size) ? buffer + length : NULL,
+                                   (length < size) ? size - length : 0,
+                                   "latency_ns", &snapshot->latency);
+    
+    length = length + _format_line((length < size) ? buffer + length : NULL,
+                                   (length < size) ? size - length : 0,
+                                   "size_bytes", &snapshot->size);
+    
+    return length;
+} // end cte_histogram_format
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_histogram_clock()
+// ---------------------------------------------------------------------------
+//
+// Returns the time of the monotonic clock in nanoseconds.  This is the clock
+// of function cte_clock().
+
+uint64_t cte_histogram_clock(void) {
+    return cte_clock();
+} // end cte_histogram_clock
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_dispose_histogram_set( set )
+// ---------------------------------------------------------------------------
+//
+// Disposes of histogram set <set>  and the histograms of all threads recorded
+// into it.  No thread may record into the set while it is disposed of.  Re-
+// turns NULL.
+
+cte_histogram_set_t cte_dispose_histogram_set(cte_histogram_set_t set) {
+#ifdef CTE_WITH_HISTOGRAMS
+    cte_histogram_block_s *block, *next;
+    
+    if (set == NULL)
+        return NULL;
+    
+    __sync_synchronize();
+    block = ((cte_histogram_set_s *) set)->blocks;
+    
+    while (block != NULL) {
+        next = block->next;
+        DEALLOCATE(block);
+        block = next;
+    } // end while
+    
+    DEALLOCATE(set);
+#else
+    (void) set;
+#endif
+    return NULL;
+} // end cte_dispose_histogram_set
+
+
+// ===========================================================================
+// P R I V A T E   F U N C T I O N   I M P L E M E N T A T I O N S
+// ===========================================================================
+
+#ifdef CTE_WITH_HISTOGRAMS
+
+// ---------------------------------------------------------------------------
+// private function:  _block_for_thread( set )
+// ---------------------------------------------------------------------------
+//
+// Returns the block of the calling thread in histogram set <set>.  The block
+// is looked up in the thread local block cache first,  then in the list of
+// blocks of the set.  If the thread has no block in the set yet,  a new block
+// is allocated and linked into the list without locking.  Returns NULL if
+// allocation failed.
+
+static cte_histogram_block_s *_block_for_thread(cte_histogram_set_s *set) {
+    cte_histogram_cache_entry_s *entry;
+    cte_histogram_block_s *block;
+    
+    entry = &_cte_histogram_cache[set->identity &
+                                  (CTE_HISTOGRAM_CACHE_SIZE - 1)];
+    
+    if (entry->identity == set->identity)
+        return entry->block;
+    
+    // number threads on their first use of any set
+    if (_cte_histogram_thread == 0)
+        _cte_histogram_thread =
+            __sync_add_and_fetch(&_cte_histogram_thread_count, 1);
+    
+    // look for a block of this thread in the list
+    __sync_synchronize();
+    block = set->blocks;
+    
+    while ((block != NULL) && (block->thread != _cte_histogram_thread))
+        block = block->next;
+    
+    // allocate a new block if there is none
+    if (block == NULL) {
+        block = ALLOCATE(sizeof(cte_histogram_block_s));
+        
+        // bail out if allocation failed
+        if (block == NULL)
+            return NULL;
+        
+        block->thread = _cte_histogram_thread;
+        _reset(&block->latency);
+        _reset(&block->size);
+        
+        // link block into list of set
+        repeat {
+            block->next = set->blocks;
+        } until (__sync_bool_compare_and_swap(&set->blocks,
+                                              block->next, block));
+    } // end if
+    
+    entry->identity = set->identity;
+    entry->block = block;
+    
+    return block;
+} // _block_for_thread
+
+
+// ---------------------------------------------------------------------------
+// private function:  _reset( histogram )
+// ---------------------------------------------------------------------------
+//
+// Resets histogram <histogram> to empty.  The smallest value is set to the
+// largest 64-bit value so that any value recorded replaces it.
+
+static void _reset(cte_histogram_t *histogram) {
+    
+    memset(histogram, 0, sizeof(cte_histogram_t));
+    histogram->min = UINT64_MAX;
+    
+    return;
+} // _reset
+
+
+// ---------------------------------------------------------------------------
+// private function:  _add( histogram, value )
+// ---------------------------------------------------------------------------
+//
+// Adds value <value> to histogram <histogram>.  Only the owner of the histo-
+// gram may add to it,  readers may observe the fields updated one by one.
+
+static fmacro void _add(cte_histogram_t *histogram, uint64_t value) {
+    
+    histogram->bucket[_bucket_of(value)]++;
+    histogram->sum = histogram->sum + value;
+    
+    if (value < histogram->min)
+        histogram->min = value;
+    
+    if (value > histogram->max)
+        histogram->max = value;
+    
+    histogram->count++;
+    
+    return;
+} // _add
+
+
+// ---------------------------------------------------------------------------
+// private function:  _merge( into, histogram )
+// ---------------------------------------------------------------------------
+//
+// Adds the values of histogram <histogram>  to histogram <into>.  The count
+// is taken from the buckets  so that it is consistent with them  even if the
+// histogram is being added to while it is merged.
+
+static void _merge(cte_histogram_t *into, const cte_histogram_t *histogram) {
+    
+    const volatile cte_histogram_t *source = histogram;
+    uint64_t count;
+    cardinal index;
+    
+    for (index = 0; index < CTE_HISTOGRAM_BUCKET_COUNT; index++) {
+        count = source->bucket[index];
+        into->bucket[index] = into->bucket[index] + count;
+        into->count = into->count + count;
+    } // end for
+    
+    into->sum = into->sum + source->sum;
+    into->min = MIN(into->min, source->min);
+    into->max = MAX(into->max, source->max);
+    
+    return;
+} // _merge
+
+
+// ---------------------------------------------------------------------------
+// private function:  _bucket_of( value )
+// ---------------------------------------------------------------------------
+//
+// Returns the index of the bucket that counts value <value>.  Values below
+// CTE_HISTOGRAM_SUB_BUCKETS have a bucket each,  larger values are located by
+// their most significant bit and the four bits that follow it.
+
+static fmacro cardinal _bucket_of(uint64_t value) {
+    
+    cardinal msb;
+    
+    if (value < CTE_HISTOGRAM_SUB_BUCKETS)
+        return (cardinal) value;
+    
+    msb = 63 - (cardinal) __builtin_clzll(value);
+    
+    return (msb - 3) * CTE_HISTOGRAM_SUB_BUCKETS +
+           (cardinal) ((value >> (msb - 4)) & (CTE_HISTOGRAM_SUB_BUCKETS - 1));
+} // _bucket_of
+
+#endif /* CTE_WITH_HISTOGRAMS */
+
+
+// ---------------------------------------------------------------------------
+// private function:  _bucket_limit( index )
+// ---------------------------------------------------------------------------
+//
+// Returns the largest value counted by the bucket with index <index>.
+
+static fmacro uint64_t _bucket_limit(cardinal index) {
+    
+    cardinal msb, sub;
+    
+    if (index < CTE_HISTOGRAM_SUB_BUCKETS)
+        return index;
+    
+    msb = index / CTE_HISTOGRAM_SUB_BUCKETS + 3;
+    sub = index % CTE_HISTOGRAM_SUB_BUCKETS;
+    
+    return ((uint64_t) (CTE_HISTOGRAM_SUB_BUCKETS + sub) << (msb - 4)) +
+           (((uint64_t) 1 << (msb - 4)) - 1);
+} // _bucket_limit
+
+
+// ---------------------------------------------------------------------------
+// private function:  _format_line( buffer, size, name, histogram )
+// ---------------------------------------------------------------------------
+//
+// Writes the summary line of histogram <histogram> named <name>  into buffer
+// <buffer> of <size> bytes  like snprintf() and returns the length of the line.
+
+static size_t _format_line(char *buffer, size_t size, const char *name,
+                           const cte_histogram_t *histogram) {
+    int count;
+    
+    count = snprintf(buffer, size,
+        "%s min %llu p50 %llu p90 %llu p99 %llu p999 %llu max %llu "
+        "mean %llu\n", name,
+        (unsigned long long) histogram->min,
+        (unsigned long long) cte_histogram_value_at(histogram, 50.0),
+        (unsigned long long) cte_histogram_value_at(histogram, 90.0),
+        (unsigned long long) cte_histogram_value_at(histogram, 99.0),
+        (unsigned long long) cte_histogram_value_at(histogram, 99.9),
+        (unsigned long long) histogram->max,
+        (unsigned long long) ((histogram->count > 0) ?
+                              histogram->sum / histogram->count : 0));
+    
+    return (size_t) MAX(count, 0);
+} // _format_line
+
+
+// END OF FILE
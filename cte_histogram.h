@@ -0,0 +1,253 @@
+/* C Template Engine
+ *
+ *  @file cte_histogram.h
+ *  CTE histogram interface
+ *
+ *  Per-template render latency and output size histograms
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#ifndef CTE_HISTOGRAM_H
+#define CTE_HISTOGRAM_H
+
+
+#include <stddef.h>
+
+#include "common.h"
+
+
+// ---------------------------------------------------------------------------
+// Availability
+// ---------------------------------------------------------------------------
+//
+// Histograms are only recorded  if the library is built with CTE_WITH_HISTO-
+// GRAMS defined.  Otherwise no histogram sets are created,  nothing is record-
+// ed and every attempt to take a snapshot fails with status UNAVAILABLE.
+//
+// Each thread records into its own histograms  without locking  and  without
+// atomic read-modify-write operations.  The histograms of all threads are
+// merged when a snapshot is taken.
+
+
+// ---------------------------------------------------------------------------
+// Bucket layout
+// ---------------------------------------------------------------------------
+//
+// Values below CTE_HISTOGRAM_SUB_BUCKETS are counted exactly.  Every power of
+// two range above is divided into CTE_HISTOGRAM_SUB_BUCKETS buckets of equal
+// width,  the relative error of a reported value is therefore below 1/16.
+// The buckets cover the entire range of 64-bit values.
+
+#define CTE_HISTOGRAM_SUB_BUCKETS 16
+
+#define CTE_HISTOGRAM_BUCKET_COUNT 976
+
+
+// ---------------------------------------------------------------------------
+// Maximum length of a text dump
+// ---------------------------------------------------------------------------
+
+#define CTE_HISTOGRAM_TEXT_SIZE 512 /* bytes */
+
+
+// ---------------------------------------------------------------------------
+// Histogram type
+// ---------------------------------------------------------------------------
+//
+// Number, sum,  smallest and largest of the values recorded  and  the number
+// of values recorded in each bucket.  The smallest and largest values are
+// zero if no values have been recorded.
+
+typedef struct /* cte_histogram_t */ {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+    uint64_t bucket[CTE_HISTOGRAM_BUCKET_COUNT];
+} cte_histogram_t;
+
+
+// ---------------------------------------------------------------------------
+// Histogram snapshot type
+// ---------------------------------------------------------------------------
+//
+// Histograms of the render latency in nanoseconds  and  of the output size in
+// bytes of all renders recorded into a histogram set.
+
+typedef struct /* cte_histogram_snapshot_t */ {
+    cte_histogram_t latency;
+    cte_histogram_t size;
+} cte_histogram_snapshot_t;
+
+
+// ---------------------------------------------------------------------------
+// Opaque histogram set handle type
+// ---------------------------------------------------------------------------
+//
+// WARNING:  Objects of this opaque type should  only be accessed through this
+// public interface.  DO NOT EVER attempt to bypass the public interface.
+//
+// The internal data structure of this opaque type is  HIDDEN  and  MAY CHANGE
+// at any time WITHOUT NOTICE.  Accessing the internal data structure directly
+// other than  through the  functions  in this public interface is  UNSAFE and
+// may result in an inconsistent program state or a crash.
+
+typedef opaque_t cte_histogram_set_t;
+
+
+// ---------------------------------------------------------------------------
+// Status codes
+// ---------------------------------------------------------------------------
+
+typedef enum /* cte_histogram_status_t */ {
+    CTE_HISTOGRAM_STATUS_SUCCESS = 1,
+    CTE_HISTOGRAM_STATUS_INVALID_SET,
+    CTE_HISTOGRAM_STATUS_INVALID_SNAPSHOT,
+    CTE_HISTOGRAM_STATUS_ALLOCATION_FAILED,
+    CTE_HISTOGRAM_STATUS_UNAVAILABLE
+} cte_histogram_status_t;
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_new_histogram_set( status )
+// ---------------------------------------------------------------------------
+//
+// Creates and returns a new empty histogram set.  The function fails if memory
+// could not be allocated  or if the library was built without histograms.  It
+// returns NULL if it fails.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_histogram_set_t cte_new_histogram_set(cte_histogram_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_histogram_record( set, latency, size )
+// ---------------------------------------------------------------------------
+//
+// Records a render with a latency of <latency> nanoseconds and an output size
+// of <size> bytes  into the histograms of the calling thread in histogram set
+// <set>.  The histograms of a thread are allocated when the thread records
+// into the set for the first time,  if allocation fails the render is not
+// recorded.  Does nothing if NULL is passed in for <set>.
+
+void cte_histogram_record(cte_histogram_set_t set,
+                          uint64_t latency, uint64_t size);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_histogram_snapshot( set, snapshot, status )
+// ---------------------------------------------------------------------------
+//
+// Merges the histograms of all threads  in histogram set <set>  and passes the
+// result back in <snapshot>.  A snapshot may be taken while other threads are
+// recording,  renders recorded during the snapshot may be left out.  The func-
+// tion fails if NULL is passed in for <set> or <snapshot>  or if the library
+// was built without histograms,  in which case an empty snapshot is passed
+// back unless NULL was passed in for <snapshot>.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_histogram_snapshot(cte_histogram_set_t set,
+                       cte_histogram_snapshot_t *snapshot,
+                         cte_histogram_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_histogram_value_at( histogram, percentile )
+// ---------------------------------------------------------------------------
+//
+// Returns the value  below or at which  <percentile> percent of the values in
+// histogram <histogram> lie,  rounded up to the upper bound of its bucket but
+// not above the largest value recorded.  Percentiles outside of the range 0
+// to 100 are clamped to the range.  Returns zero if the histogram is empty or
+// if NULL is passed in for <histogram>.
+
+uint64_t cte_histogram_value_at(const cte_histogram_t *histogram,
+                                double percentile);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_histogram_format( snapshot, buffer, size )
+// ---------------------------------------------------------------------------
+//
+// Writes a text dump of histogram snapshot <snapshot>  into buffer <buffer> of
+// <size> bytes  and returns the length of the text.  The dump consists of the
+// number of renders, and of the smallest value, the 50th, 90th, 99th and 99.9th
+// percentile,  the largest value and the mean  of render latency and output
+// size,  one line each.  Like snprintf(),  the text is truncated to fit and
+// terminated unless <size> is zero,  the length returned is that of the entire
+// text.  A buffer of CTE_HISTOGRAM_TEXT_SIZE bytes is always large enough.
+// Returns zero if NULL is passed in for <snapshot>.
+
+size_t cte_histogram_format(const cte_histogram_snapshot_t *snapshot,
+                            char *buffer, size_t size);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_histogram_clock()
+// ---------------------------------------------------------------------------
+//
+// Returns the time of the monotonic clock in nanoseconds.  This is the clock
+// of function cte_clock().
+
+uint64_t cte_histogram_clock(void);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_dispose_histogram_set( set )
+// ---------------------------------------------------------------------------
+//
+// Disposes of histogram set <set>  and the histograms of all threads recorded
+// into it.  No thread may record into the set while it is disposed of.  Re-
+// turns NULL.
+
+cte_histogram_set_t cte_dispose_histogram_set(cte_histogram_set_t set);
+
+
+#endif /* CTE_HISTOGRAM_H */
+
+// END OF FILE
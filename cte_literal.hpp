@@ -0,0 +1,490 @@
+/* C Template Engine
+ *
+ *  @file cte_literal.hpp
+ *  CTE literal template interface
+ *
+ *  Compile time parsing of string literal templates for C++20
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#ifndef CTE_LITERAL_HPP
+#define CTE_LITERAL_HPP
+
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "CTE.h"
+
+
+namespace cte {
+
+
+// ---------------------------------------------------------------------------
+// Fixed string type
+// ---------------------------------------------------------------------------
+//
+// Holds a copy of a string literal  so that it can be passed as a template
+// argument.  The string ends at its first terminator.
+
+template <std::size_t N>
+struct fixed_string {
+    char chars[N] {};
+    
+    consteval fixed_string(const char (&str)[N]) {
+        for (std::size_t index = 0; index < N; index++)
+            chars[index] = str[index];
+    } // end fixed_string
+    
+    constexpr std::string_view view() const {
+        return std::string_view(chars);
+    } // end view
+}; // fixed_string
+
+
+// ---------------------------------------------------------------------------
+// Placeholder value type
+// ---------------------------------------------------------------------------
+//
+// Associates value <text>  with the placeholder whose identifier is passed as
+// template argument <Name>,  as in  cte::value<"name">("World").  The value is
+// not copied,  it must remain valid until the render it is passed to returns.
+
+template <fixed_string Name>
+struct value {
+    std::string_view text;
+    
+    constexpr value(std::string_view text) : text(text) { }
+}; // value
+
+
+namespace detail {
+
+
+// ---------------------------------------------------------------------------
+// Literal template segment type
+// ---------------------------------------------------------------------------
+//
+// The offset of a literal segment indexes the text of its layout,  the offset
+// of a placeholder segment is the index of the placeholder's value slot.
+
+struct segment {
+    bool placeholder;
+    std::size_t offset;
+    std::size_t length;
+}; // segment
+
+
+// ---------------------------------------------------------------------------
+// Literal template placeholder type
+// ---------------------------------------------------------------------------
+//
+// Offset and length of the first occurrence of a placeholder's identifier in
+// the template string.
+
+struct identifier {
+    std::size_t offset;
+    std::size_t length;
+}; // identifier
+
+
+// ---------------------------------------------------------------------------
+// Literal template layout type
+// ---------------------------------------------------------------------------
+//
+// Holds the segments of a template,  the text of its literal segments with
+// comments removed and escape sequences resolved,  and its distinct place-
+// holders in order of first occurrence.  Arrays are sized by a counting pass,
+// only the first <identifier_count> identifiers are used.
+
+template <std::size_t Segments, std::size_t TextLength, std::size_t Occurrences>
+struct layout {
+    std::array<segment, Segments> segments {};
+    std::array<char, TextLength> text {};
+    std::array<identifier, Occurrences> identifiers {};
+    std::size_t identifier_count = 0;
+}; // layout
+
+
+// ---------------------------------------------------------------------------
+// Layout size type
+// ---------------------------------------------------------------------------
+
+struct layout_size {
+    std::size_t segments = 0;
+    std::size_t text_length = 0;
+    std::size_t occurrences = 0;
+}; // layout_size
+
+
+// ---------------------------------------------------------------------------
+// function:  is_letter( ch ), is_identifier_char( ch )
+// ---------------------------------------------------------------------------
+
+constexpr bool is_letter(char ch) {
+    return ((ch >= 'a') && (ch <= 'z')) || ((ch >= 'A') && (ch <= 'Z'));
+} // end is_letter
+
+constexpr bool is_identifier_char(char ch) {
+    return is_letter(ch) || ((ch >= '0') && (ch <= '9')) || (ch == '_');
+} // end is_identifier_char
+
+
+// ---------------------------------------------------------------------------
+// function:  scan( source, visitor )
+// ---------------------------------------------------------------------------
+//
+// Scans template string <source>  according to the grammar and static seman-
+// tics described for function cte_string_from_template() in CTE.h,  using the
+// built-in delimiter "@@" and ignore prefix "%%".  Calls visitor.literal(ch)
+// for every character of literal text  and  visitor.placeholder(offset, len)
+// for every placeholder,  passing the offset and length of its identifier.
+
+template <typename Visitor>
+consteval void scan(std::string_view source, Visitor &visitor) {
+    std::size_t index = 0;
+    std::size_t length;
+    char ch;
+    
+    auto char_at = [&](std::size_t at) {
+        return (at < source.size()) ? source[at] : '\0';
+    };
+    
+    auto start_of_line = [&](std::size_t at) {
+        return (at == 0) || (source[at - 1] == '\n');
+    };
+    
+    while (index < source.size()) {
+        ch = source[index];
+        
+        // backslash may indicate escaped delimiter
+        if (ch == '\\') {
+            if (char_at(index + 1) == '\\') {
+                visitor.literal('\\');
+                index++;
+            }
+            else if ((char_at(index + 1) == '@') ||
+                     ((char_at(index + 1) == '%') && start_of_line(index))) {
+                index++;
+            } // end if
+            
+            visitor.literal(source[index]);
+            index++;
+        }
+        // delimiter char may indicate placeholder
+        else if ((ch == '@') && (char_at(index + 1) == '@') &&
+                 is_letter(char_at(index + 2))) {
+            length = 0;
+            do {
+                length++;
+            } while (is_identifier_char(char_at(index + 2 + length)) &&
+                     (length <= CTE_MAX_PLACEHOLDER_LENGTH));
+            
+            // check if identifier is properly delimited
+            if ((length <= CTE_MAX_PLACEHOLDER_LENGTH) &&
+                (char_at(index + 2 + length) == '@') &&
+                (char_at(index + 3 + length) == '@')) {
+                visitor.placeholder(index + 2, length);
+                index = index + length + 4;
+            }
+            else /* not a placeholder */ {
+                visitor.literal(ch);
+                index++;
+            } // end if
+        }
+        // prefix char may indicate comment line
+        else if ((ch == '%') && (char_at(index + 1) == '%') &&
+                 start_of_line(index)) {
+            while ((index < source.size()) && (source[index] != '\n'))
+                index++;
+        }
+        else /* ordinary character */ {
+            visitor.literal(ch);
+            index++;
+        } // end if
+    } // end while
+} // end scan
+
+
+// ---------------------------------------------------------------------------
+// function:  size_of_layout( source )
+// ---------------------------------------------------------------------------
+//
+// Returns the array sizes required for the layout of template <source>.
+
+consteval layout_size size_of_layout(std::string_view source) {
+    struct counter {
+        layout_size size;
+        bool in_literal = false;
+        
+        constexpr void literal(char) {
+            if (!in_literal)
+                size.segments++;
+            size.text_length++;
+            in_literal = true;
+        } // end literal
+        
+        constexpr void placeholder(std::size_t, std::size_t) {
+            size.segments++;
+            size.occurrences++;
+            in_literal = false;
+        } // end placeholder
+    } visitor;
+    
+    scan(source, visitor);
+    return visitor.size;
+} // end size_of_layout
+
+
+// ---------------------------------------------------------------------------
+// function:  layout_of<Size>( source )
+// ---------------------------------------------------------------------------
+//
+// Returns the layout of template <source>,  whose sizes must have been deter-
+// mined by size_of_layout().
+
+template <layout_size Size>
+consteval auto layout_of(std::string_view source) {
+    using layout_t = layout<Size.segments, Size.text_length, Size.occurrences>;
+    
+    struct builder {
+        std::string_view source;
+        layout_t result {};
+        std::size_t segment_count = 0;
+        std::size_t text_length = 0;
+        bool in_literal = false;
+        
+        constexpr void literal(char ch) {
+            if (!in_literal) {
+                result.segments[segment_count] = { false, text_length, 0 };
+                segment_count++;
+            } // end if
+            result.segments[segment_count - 1].length++;
+            result.text[text_length] = ch;
+            text_length++;
+            in_literal = true;
+        } // end literal
+        
+        constexpr void placeholder(std::size_t offset, std::size_t length) {
+            std::string_view name = source.substr(offset, length);
+            std::size_t slot = 0;
+            
+            // find slot of identifier, add new identifier
+            while ((slot < result.identifier_count) &&
+                   (source.substr(result.identifiers[slot].offset,
+                                  result.identifiers[slot].length) != name))
+                slot++;
+            
+            if (slot == result.identifier_count) {
+                result.identifiers[slot] = { offset, length };
+                result.identifier_count++;
+            } // end if
+            
+            result.segments[segment_count] = { true, slot, 0 };
+            segment_count++;
+            in_literal = false;
+        } // end placeholder
+    } visitor { source };
+    
+    scan(source, visitor);
+    return visitor.result;
+} // end layout_of
+
+
+} // namespace detail
+
+
+// ---------------------------------------------------------------------------
+// Literal template type
+// ---------------------------------------------------------------------------
+//
+// A literal template is parsed at compile time from the string literal passed
+// as template argument <Source>,  as in  cte::literal<"Hello @@name@@!">.  The
+// template is recognised according to the grammar  and  static semantics  de-
+// scribed for function cte_string_from_template() in CTE.h,  using the built-
+// in delimiter "@@" and ignore prefix "%%".
+//
+// Rendering copies precomputed literal text and the values passed for place-
+// holders  into the result,  it does not scan the template  nor calculate any
+// keys.  Every placeholder must be given exactly one value and no value may be
+// given for an identifier that is not a placeholder of the template,  which is
+// checked at compile time.
+//
+// Unlike cte_string_from_template(),  values are inserted as they are,  they
+// are not expanded as templates themselves.  Templates whose values contain
+// placeholders must be rendered by the functions in CTE.h.
+
+template <fixed_string Source>
+class literal {
+    static constexpr detail::layout_size size =
+        detail::size_of_layout(Source.view());
+    
+    static constexpr auto layout =
+        detail::layout_of<size>(Source.view());
+    
+    static constexpr std::size_t slot_count = layout.identifier_count;
+    
+    static constexpr std::size_t not_found = ~std::size_t(0);
+    
+    // returns value slot of identifier <name>, not_found if none
+    static consteval std::size_t slot_of(std::string_view name) {
+        for (std::size_t slot = 0; slot < slot_count; slot++)
+            if (placeholder(slot) == name)
+                return slot;
+        return not_found;
+    } // end slot_of
+    
+    // returns true if no identifier occurs twice in <names>
+    template <std::size_t N>
+    static consteval bool are_distinct(
+            const std::array<std::string_view, N> &names) {
+        for (std::size_t index = 0; index < N; index++)
+            for (std::size_t other = index + 1; other < N; other++)
+                if (names[index] == names[other])
+                    return false;
+        return true;
+    } // end are_distinct
+    
+public:
+    
+    // -----------------------------------------------------------------------
+    // function:  literal::placeholder_count()
+    // -----------------------------------------------------------------------
+    //
+    // Returns the number of distinct placeholders of the template.
+    
+    static constexpr std::size_t placeholder_count() {
+        return slot_count;
+    } // end placeholder_count
+    
+    
+    // -----------------------------------------------------------------------
+    // function:  literal::placeholder( index )
+    // -----------------------------------------------------------------------
+    //
+    // Returns the identifier of the placeholder  with index <index>  in order
+    // of first occurrence in the template.
+    
+    static constexpr std::string_view placeholder(std::size_t index) {
+        return Source.view().substr(layout.identifiers[index].offset,
+                                    layout.identifiers[index].length);
+    } // end placeholder
+    
+    
+    // -----------------------------------------------------------------------
+    // function:  literal::has_placeholder( name )
+    // -----------------------------------------------------------------------
+    //
+    // Returns true if <name> is the identifier of a placeholder  of the tem-
+    // plate,  otherwise false.
+    
+    static consteval bool has_placeholder(std::string_view name) {
+        return slot_of(name) != not_found;
+    } // end has_placeholder
+    
+    
+    // -----------------------------------------------------------------------
+    // function:  literal::append_to( target, values... )
+    // -----------------------------------------------------------------------
+    //
+    // Renders the template with placeholder values <values> and appends the
+    // result to string <target>,  which is enlarged at most once.
+    
+    template <fixed_string... Names>
+    static void append_to(std::string &target,
+                          const value<Names> &... values) {
+        
+        static_assert((has_placeholder(Names.view()) && ...),
+            "value given for an identifier that is not a placeholder");
+        static_assert(are_distinct(std::array<std::string_view,
+                                   sizeof...(Names)> { Names.view()... }),
+            "more than one value given for a placeholder");
+        static_assert(sizeof...(Names) == slot_count,
+            "no value given for a placeholder of the template");
+        
+        std::array<std::string_view, slot_count> slot;
+        std::size_t length = size.text_length;
+        
+        ((slot[slot_of(Names.view())] = values.text), ...);
+        
+        for (const detail::segment &segment : layout.segments)
+            if (segment.placeholder)
+                length += slot[segment.offset].size();
+        
+        target.reserve(target.size() + length);
+        
+        for (const detail::segment &segment : layout.segments)
+            if (segment.placeholder)
+                target.append(slot[segment.offset]);
+            else
+                target.append(layout.text.data() + segment.offset,
+                              segment.length);
+    } // end append_to
+    
+    
+    // -----------------------------------------------------------------------
+    // function:  literal::render( values... )
+    // -----------------------------------------------------------------------
+    //
+    // Renders the template with placeholder values <values> and returns the
+    // result as a new string.
+    
+    template <fixed_string... Names>
+    static std::string render(const value<Names> &... values) {
+        std::string target;
+        
+        append_to(target, values...);
+        return target;
+    } // end render
+}; // literal
+
+
+} // namespace cte
+
+
+#endif /* CTE_LITERAL_HPP */
+
+// END OF FILE
@@ -0,0 +1,398 @@
+/* C Template Engine
+ *
+ *  @file cte_metrics.c
+ *  CTE metrics implementation
+ *
+ *  Optional engine counters with Prometheus text format export
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#define _POSIX_C_SOURCE 200112L /* posix_memalign */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "ASCII.h"
+#include "cte_metrics.h"
+
+
+#ifdef CTE_WITH_METRICS
+
+// ---------------------------------------------------------------------------
+// Thread local storage class
+// ---------------------------------------------------------------------------
+
+#ifndef CTE_NO_THREADS
+#define CTE_METRICS_THREAD_LOCAL __thread
+#else
+#define CTE_METRICS_THREAD_LOCAL
+#endif
+
+
+// ---------------------------------------------------------------------------
+// Cache line size
+// ---------------------------------------------------------------------------
+
+#define CTE_METRICS_CACHE_LINE_SIZE 64 /* bytes */
+
+
+// ---------------------------------------------------------------------------
+// Counter block type
+// ---------------------------------------------------------------------------
+//
+// The counters of one thread.  A block is only written by its own thread.
+// Blocks are linked into a global list when they are created  and  are never
+// deallocated,  so that the counts of threads that have ended are kept.  The
+// type is aligned and padded to a multiple of the cache line size  and blocks
+// are allocated on a cache line boundary,  so that the counters of different
+// threads never share a cache line.
+
+typedef struct _cte_metrics_block_s *cte_metrics_block_p;
+
+struct _cte_metrics_block_s {
+    cte_metrics_block_p next;
+      volatile uint64_t counter[CTE_METRIC_COUNT];
+} __attribute__((aligned(CTE_METRICS_CACHE_LINE_SIZE)));
+
+typedef struct _cte_metrics_block_s cte_metrics_block_s;
+
+
+// ---------------------------------------------------------------------------
+// Counter blocks of all threads and of the current thread
+// ---------------------------------------------------------------------------
+
+static cte_metrics_block_s *volatile _cte_metrics_blocks = NULL;
+
+static CTE_METRICS_THREAD_LOCAL cte_metrics_block_s *_cte_metrics_block = NULL;
+
+
+// ===========================================================================
+// P R I V A T E   F U N C T I O N   P R O T O T Y P E S
+// ===========================================================================
+
+static cte_metrics_block_s *_new_block(void);
+
+#endif /* CTE_WITH_METRICS */
+
+
+// ---------------------------------------------------------------------------
+// Metric names and descriptions in Prometheus text format
+// ---------------------------------------------------------------------------
+
+static const char *_cte_metric_name[] = {
+    "cte_renders_total",
+    "cte_output_bytes_total",
+    "cte_placeholders_expanded_total",
+    "cte_undefined_placeholders_total",
+    "cte_nesting_limit_failures_total",
+    "cte_allocation_failures_total",
+    "cte_cache_hits_total",
+    "cte_budget_failures_total"
+};
+
+static const char *_cte_metric_help[] = {
+    "Renders completed successfully.",
+    "Bytes of output produced by renders.",
+    "Placeholders whose values were expanded.",
+    "Placeholders and sections left unexpanded because they were undefined.",
+    "Failures because the template nesting limit was exceeded.",
+    "Failures because memory could not be allocated.",
+    "Renders served from a render cache.",
+    "Renders aborted because they exceeded their budget."
+};
+
+
+// ===========================================================================
+// P U B L I C   F U N C T I O N   I M P L E M E N T A T I O N S
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// function:  cte_metrics_add( metric, amount )
+// ---------------------------------------------------------------------------
+//
+// Adds <amount> to the counter of metric <metric>  of the calling thread.  The
+// counters of a thread are allocated when the thread counts for the first
+// time,  if allocation fails nothing is counted.  Does nothing if the library
+// was built without metrics.
+
+void cte_metrics_add(cte_metric_t metric, uint64_t amount) {
+#ifdef CTE_WITH_METRICS
+    cte_metrics_block_s *block = _cte_metrics_block;
+    
+    // create counter block on first count of thread
+    if (block == NULL) {
+        block = _new_block();
+        
+        // bail out if allocation failed
+        if (block == NULL)
+            return;
+    } // end if
+    
+    block->counter[metric] = block->counter[metric] + amount;
+#else
+    (void) metric;
+    (void) amount;
+#endif
+    return;
+} // end cte_metrics_add
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_metrics_notify( notification )
+// ---------------------------------------------------------------------------
+//
+// Counts an undefined placeholder  if <notification> is CTE_NOTIFICATION_UN-
+// DEFINED_PLACEHOLDER,  a nesting limit failure  if it is CTE_NOTIFICATION_
+// NESTING_LIMIT_EXCEEDED,  a budget failure  if it is CTE_NOTIFICATION_BUDGET_
+// EXCEEDED  and an allocation failure if it is one of the allocation or en-
+// largement failure notifications.  Other notifications are not counted.  Does
+// nothing if the library was built without metrics.
+
+void cte_metrics_notify(cte_notification_t notification) {
+#ifdef CTE_WITH_METRICS
+    switch (notification) {
+        case CTE_NOTIFICATION_UNDEFINED_PLACEHOLDER :
+            cte_metrics_add(CTE_METRIC_UNDEFINED_PLACEHOLDERS, 1);
+            break;
+        case CTE_NOTIFICATION_NESTING_LIMIT_EXCEEDED :
+            cte_metrics_add(CTE_METRIC_NESTING_LIMIT_FAILURES, 1);
+            break;
+        case CTE_NOTIFICATION_BUDGET_EXCEEDED :
+            cte_metrics_add(CTE_METRIC_BUDGET_FAILURES, 1);
+            break;
+        case CTE_NOTIFICATION_TARGET_ALLOCATION_FAILED :
+        case CTE_NOTIFICATION_TARGET_ENLARGEMENT_FAILED :
+        case CTE_NOTIFICATION_STACK_ALLOCATION_FAILED :
+        case CTE_NOTIFICATION_STACK_ENLARGEMENT_FAILED :
+            cte_metrics_add(CTE_METRIC_ALLOCATION_FAILURES, 1);
+            break;
+        default :
+            break;
+    } // end switch
+#else
+    (void) notification;
+#endif
+    return;
+} // end cte_metrics_notify
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_metrics_get( metrics, status )
+// ---------------------------------------------------------------------------
+//
+// Passes back the sum of the counters of all threads in <metrics>.  Counters
+// may be read while other threads are counting,  the sum includes any count
+// completed before it was read.  The function fails if NULL is passed in for
+// <metrics>  or if the library was built without metrics,  in which case all
+// counters are passed back as zero.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_metrics_get(cte_metrics_t *metrics, cte_metrics_status_t *status) {
+#ifdef CTE_WITH_METRICS
+    cte_metrics_block_s *block;
+    cardinal index;
+#endif
+    
+    // bail out if metrics is NULL
+    if (metrics == NULL) {
+        ASSIGN_BY_REF(status, CTE_METRICS_STATUS_INVALID_METRICS);
+        return;
+    } // end if
+    
+    memset(metrics, 0, sizeof(cte_metrics_t));
+    
+#ifdef CTE_WITH_METRICS
+    __sync_synchronize();
+    block = _cte_metrics_blocks;
+    
+    while (block != NULL) {
+        for (index = 0; index < CTE_METRIC_COUNT; index++)
+            metrics->counter[index] =
+                metrics->counter[index] + block->counter[index];
+        
+        block = block->next;
+    } // end while
+    
+    ASSIGN_BY_REF(status, CTE_METRICS_STATUS_SUCCESS);
+    return;
+#else
+    ASSIGN_BY_REF(status, CTE_METRICS_STATUS_UNAVAILABLE);
+    return;
+#endif
+} // end cte_metrics_get
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_metrics_export( buffer, size, status )
+// ---------------------------------------------------------------------------
+//
+// Writes the sum of the counters of all threads  in Prometheus text exposi-
+// tion format,  with HELP and TYPE lines for each counter,  into buffer
+// <buffer> of <size> bytes  and returns the length of the text,  excluding
+// the terminator.  If the text and its terminator do not fit,  the empty
+// string is written  unless <size> is zero,  the length of the text is re-
+// turned and the function fails with status BUFFER_TOO_SMALL,  so that NULL
+// and zero may be passed in to determine the required size.  The function
+// also fails if NULL is passed in for <buffer> with a non-zero <size>  or if
+// the library was built without metrics,  in which case zero is returned.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_metrics_export(char *buffer,
+                          size_t size,
+                          cte_metrics_status_t *status) {
+    
+    cte_metrics_t metrics;
+    cte_metrics_status_t m_status;
+    size_t length;
+    cardinal index;
+    int count;
+    
+    // bail out if buffer is NULL but size is not zero
+    if ((buffer == NULL) && (size > 0)) {
+        ASSIGN_BY_REF(status, CTE_METRICS_STATUS_INVALID_BUFFER);
+        return 0;
+    } // end if
+    
+    cte_metrics_get(&metrics, &m_status);
+    
+    // bail out if metrics are unavailable
+    if (m_status != CTE_METRICS_STATUS_SUCCESS) {
+        if (size > 0)
+            buffer[0] = CSTRING_TERMINATOR;
+        
+        ASSIGN_BY_REF(status, m_status);
+        return 0;
+    } // end if
+    
+    length = 0;
+    
+    for (index = 0; index < CTE_METRIC_COUNT; index++) {
+        count = snprintf((length < size) ? &buffer[length] : NULL,
+                         (length < size) ? size - length : 0,
+                         "# HELP %s %s\n# TYPE %s counter\n%s %llu\n",
+                         _cte_metric_name[index], _cte_metric_help[index],
+                         _cte_metric_name[index], _cte_metric_name[index],
+                         (unsigned long long) metrics.counter[index]);
+        length = length + (size_t) MAX(count, 0);
+    } // end for
+    
+    // bail out if text and terminator did not fit
+    if (length >= size) {
+        if (size > 0)
+            buffer[0] = CSTRING_TERMINATOR;
+        
+        ASSIGN_BY_REF(status, CTE_METRICS_STATUS_BUFFER_TOO_SMALL);
+        return length;
+    } // end if
+    
+    ASSIGN_BY_REF(status, CTE_METRICS_STATUS_SUCCESS);
+    return length;
+} // end cte_metrics_export
+
+
+#ifdef CTE_WITH_METRICS
+
+// ===========================================================================
+// P R I V A T E   F U N C T I O N   I M P L E M E N T A T I O N S
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// private function:  _new_block()
+// ---------------------------------------------------------------------------
+//
+// Allocates a counter block  aligned on a cache line boundary  for the calling
+// thread and links it into the global list of counter blocks without locking.
+// If the library is built with CTE_NO_POSIX_MEMALIGN defined,  the block is
+// aligned within an over-allocated memory area instead.  Returns NULL if
+// allocation failed.
+
+static cte_metrics_block_s *_new_block(void) {
+    cte_metrics_block_s *block;
+    void *memory;
+    cardinal index;
+    
+#ifndef CTE_NO_POSIX_MEMALIGN
+    if (posix_memalign(&memory, CTE_METRICS_CACHE_LINE_SIZE,
+                       sizeof(cte_metrics_block_s)) != 0)
+        return NULL;
+    
+    block = memory;
+#else
+    memory = ALLOCATE(sizeof(cte_metrics_block_s) +
+                      CTE_METRICS_CACHE_LINE_SIZE - 1);
+    
+    // bail out if allocation failed
+    if (memory == NULL)
+        return NULL;
+    
+    // blocks are never deallocated,  the unaligned address need not be kept
+    block = (cte_metrics_block_s *)
+        (((uintptr_t) memory + CTE_METRICS_CACHE_LINE_SIZE - 1) &
+         ~((uintptr_t) CTE_METRICS_CACHE_LINE_SIZE - 1));
+#endif
+    
+    for (index = 0; index < CTE_METRIC_COUNT; index++)
+        block->counter[index] = 0;
+    
+    // link counter block into global list
+    repeat {
+        block->next = _cte_metrics_blocks;
+    } until (__sync_bool_compare_and_swap(&_cte_metrics_blocks,
+                                          block->next, block));
+    
+    _cte_metrics_block = block;
+    return block;
+} // _new_block
+
+#endif /* CTE_WITH_METRICS */
+
+
+// END OF FILE
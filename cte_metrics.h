@@ -0,0 +1,211 @@
+/* C Template Engine
+ *
+ *  @file cte_metrics.h
+ *  CTE metrics interface
+ *
+ *  Optional engine counters with Prometheus text format export
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#ifndef CTE_METRICS_H
+#define CTE_METRICS_H
+
+
+#include <stddef.h>
+
+#include "CTE.h"
+#include "common.h"
+
+
+// ---------------------------------------------------------------------------
+// Availability
+// ---------------------------------------------------------------------------
+//
+// Metrics are only counted if the library is built with CTE_WITH_METRICS de-
+// fined.  Otherwise the metrics macros expand to nothing,  nothing is counted
+// and every attempt to read or export the counters fails with status UNAVAIL-
+// ABLE.
+//
+// Counters are kept per thread  without locking  and  without atomic read-
+// modify-write operations,  so that counting does not contend for shared
+// cache lines.  The counters of all threads are summed when they are read.
+// Counters of threads that have ended are kept.
+
+
+// ---------------------------------------------------------------------------
+// Metrics
+// ---------------------------------------------------------------------------
+//
+// The number of renders completed successfully,  the number of bytes of out-
+// put produced by renders,  the number of placeholders whose values were ex-
+// panded,  the number of placeholders and sections left unexpanded because
+// they were undefined,  the number of failures because the nesting limit was
+// exceeded or because allocation failed,  the number of render cache hits
+// and the number of renders aborted because they exceeded their budget.
+// Internal passes that only determine the size of the output are not counted.
+
+typedef enum /* cte_metric_t */ {
+    CTE_METRIC_RENDERS,
+    CTE_METRIC_BYTES_OUT,
+    CTE_METRIC_PLACEHOLDERS_EXPANDED,
+    CTE_METRIC_UNDEFINED_PLACEHOLDERS,
+    CTE_METRIC_NESTING_LIMIT_FAILURES,
+    CTE_METRIC_ALLOCATION_FAILURES,
+    CTE_METRIC_CACHE_HITS,
+    CTE_METRIC_BUDGET_FAILURES,
+    CTE_METRIC_COUNT /* number of metrics */
+} cte_metric_t;
+
+
+// ---------------------------------------------------------------------------
+// Metrics type
+// ---------------------------------------------------------------------------
+//
+// Counter values of all metrics,  indexed by cte_metric_t.
+
+typedef struct /* cte_metrics_t */ {
+    uint64_t counter[CTE_METRIC_COUNT];
+} cte_metrics_t;
+
+
+// ---------------------------------------------------------------------------
+// Status codes
+// ---------------------------------------------------------------------------
+
+typedef enum /* cte_metrics_status_t */ {
+    CTE_METRICS_STATUS_SUCCESS = 1,
+    CTE_METRICS_STATUS_INVALID_METRICS,
+    CTE_METRICS_STATUS_INVALID_BUFFER,
+    CTE_METRICS_STATUS_BUFFER_TOO_SMALL,
+    CTE_METRICS_STATUS_UNAVAILABLE
+} cte_metrics_status_t;
+
+
+// ---------------------------------------------------------------------------
+// Metrics macros
+// ---------------------------------------------------------------------------
+//
+// CTE_METRIC_ADD adds <_amount> to the counter of metric <_metric>  of the
+// calling thread.  CTE_METRIC_NOTIFY counts the failure or undefined place-
+// holder reported by notification <_notification>.  Both expand to nothing
+// unless the library is built with CTE_WITH_METRICS defined.
+
+#ifdef CTE_WITH_METRICS
+#define CTE_METRIC_ADD(_metric, _amount) cte_metrics_add(_metric, _amount)
+
+#define CTE_METRIC_NOTIFY(_notification) cte_metrics_notify(_notification)
+#else
+#define CTE_METRIC_ADD(_metric, _amount) ((void) 0)
+
+#define CTE_METRIC_NOTIFY(_notification) ((void) 0)
+#endif
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_metrics_add( metric, amount )
+// ---------------------------------------------------------------------------
+//
+// Adds <amount> to the counter of metric <metric>  of the calling thread.  The
+// counters of a thread are allocated when the thread counts for the first
+// time,  if allocation fails nothing is counted.  Does nothing if the library
+// was built without metrics.
+
+void cte_metrics_add(cte_metric_t metric, uint64_t amount);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_metrics_notify( notification )
+// ---------------------------------------------------------------------------
+//
+// Counts an undefined placeholder  if <notification> is CTE_NOTIFICATION_UN-
+// DEFINED_PLACEHOLDER,  a nesting limit failure  if it is CTE_NOTIFICATION_
+// NESTING_LIMIT_EXCEEDED,  a budget failure  if it is CTE_NOTIFICATION_BUDGET_
+// EXCEEDED  and an allocation failure if it is one of the allocation or en-
+// largement failure notifications.  Other notifications are not counted.  Does
+// nothing if the library was built without metrics.
+
+void cte_metrics_notify(cte_notification_t notification);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_metrics_get( metrics, status )
+// ---------------------------------------------------------------------------
+//
+// Passes back the sum of the counters of all threads in <metrics>.  Counters
+// may be read while other threads are counting,  the sum includes any count
+// completed before it was read.  The function fails if NULL is passed in for
+// <metrics>  or if the library was built without metrics,  in which case all
+// counters are passed back as zero.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_metrics_get(cte_metrics_t *metrics, cte_metrics_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_metrics_export( buffer, size, status )
+// ---------------------------------------------------------------------------
+//
+// Writes the sum of the counters of all threads  in Prometheus text exposi-
+// tion format,  with HELP and TYPE lines for each counter,  into buffer
+// <buffer> of <size> bytes  and returns the length of the text,  excluding
+// the terminator.  If the text and its terminator do not fit,  the empty
+// string is written  unless <size> is zero,  the length of the text is re-
+// turned and the function fails with status BUFFER_TOO_SMALL,  so that NULL
+// and zero may be passed in to determine the required size.  The function
+// also fails if NULL is passed in for <buffer> with a non-zero <size>  or if
+// the library was built without metrics,  in which case zero is returned.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_metrics_export(char *buffer,
+                          size_t size,
+            cte_metrics_status_t *status);
+
+
+#endif /* CTE_METRICS_H */
+
+// END OF FILE
@@ -49,6 +49,7 @@
 
 
 #include "cte_stack.h"
+#include "cte_alloc.h"
 #include "alloc.h"
 
 
@@ -74,8 +75,9 @@
 // ---------------------------------------------------------------------------
 
 typedef struct /* cte_context_s */ {
-        char *str;
-    cardinal index;
+      char *str;
+    size_t length;
+    size_t index;
 } cte_context_s;
 
 
@@ -108,6 +110,7 @@ typedef struct /* cte_stack_s */ {
     cte_stack_entry_s *overflow;
      cte_stack_size_t entry_count;
      cte_stack_size_t array_size;
+                 bool in_storage;
         cte_context_s context[0];
 } cte_stack_s;
 
@@ -144,8 +147,8 @@ cte_stack_t cte_new_stack(cte_stack_size_t initial_size,
     } // end if
     
     // allocate new stack
-    stack =
-        ALLOCATE(sizeof(cte_stack_s) + initial_size * sizeof(cte_context_s));
+    stack = ALLOCATE_AT(CTE_ALLOC_SITE_STACK,
+                sizeof(cte_stack_s) + initial_size * sizeof(cte_context_s));
     
     // bail out if allocation failed
     if (stack == NULL) {
@@ -157,6 +160,7 @@ cte_stack_t cte_new_stack(cte_stack_size_t initial_size,
     stack->array_size = initial_size;
     stack->entry_count = 0;
     stack->overflow = NULL;
+    stack->in_storage = false;
         
     // pass status and new stack to caller
     ASSIGN_BY_REF(status, CTE_STACK_STATUS_SUCCESS);
@@ -165,13 +169,67 @@ cte_stack_t cte_new_stack(cte_stack_size_t initial_size,
 
 
 // ---------------------------------------------------------------------------
-// function:  cte_stack_push_context( stack, template, index, status )
+// function:  cte_new_stack_in_storage( storage, storage_size, status )
+// ---------------------------------------------------------------------------
+//
+// Creates and returns a new CTE template context stack object  in the caller
+// supplied storage passed in <storage>  whose size in bytes is passed in <sto-
+// rage_size>.  The initial capacity of the stack is the number of entries that
+// fit into the storage.  No memory is allocated  unless the number of entries
+// exceeds the initial capacity.  The function fails if NULL is passed in for
+// <storage>  or  if the storage is too small to hold at least one entry.  The
+// storage must be pointer aligned and remain valid until the stack has been
+// disposed of.  CTE_STACK_STORAGE_SIZE() may be used to size the storage.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_stack_t cte_new_stack_in_storage(void *storage,
+                                     size_t storage_size,
+                                     cte_stack_status_t *status) {
+    #define this_stack ((cte_stack_s *)storage)
+    size_t capacity;
+    
+    // bail out if storage is NULL
+    if (storage == NULL) {
+        ASSIGN_BY_REF(status, CTE_STACK_STATUS_INVALID_DATA);
+        return NULL;
+    } // end if
+    
+    // bail out if storage cannot hold at least one entry
+    if (storage_size < sizeof(cte_stack_s) + sizeof(cte_context_s)) {
+        ASSIGN_BY_REF(status, CTE_STACK_STATUS_INVALID_SIZE);
+        return NULL;
+    } // end if
+    
+    capacity = (storage_size - sizeof(cte_stack_s)) / sizeof(cte_context_s);
+    
+    // limit capacity to maximum stack size
+    if (capacity > CTE_MAXIMUM_STACK_SIZE)
+        capacity = CTE_MAXIMUM_STACK_SIZE;
+    
+    // initialise meta data
+    this_stack->array_size = (cte_stack_size_t) capacity;
+    this_stack->entry_count = 0;
+    this_stack->overflow = NULL;
+    this_stack->in_storage = true;
+    
+    // pass status and new stack to caller
+    ASSIGN_BY_REF(status, CTE_STACK_STATUS_SUCCESS);
+    return (cte_stack_t) storage;
+    
+    #undef this_stack
+} // end cte_new_stack_in_storage
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_stack_push_context( stack, template, length, index, status )
 // ---------------------------------------------------------------------------
 //
 // Saves a template context to the stack passed in <stack>.  The context para-
-// meters are passed in  <template_str>  and <index>.  The operation will fail
-// if NULL is passed in for <stack> or <template_str> or if the stack size has
-// reached CTE_MAXIMUM_STACK_SIZE.
+// meters are passed in <template_str>, <length> and <index>.  The operation
+// will fail if NULL is passed in for <stack> or <template_str>  or if the
+// stack size has reached CTE_MAXIMUM_STACK_SIZE.
 //
 // New entries are allocated dynamically  if the number of entries exceeds the
 // initial capacity of the stack.
@@ -181,7 +239,8 @@ cte_stack_t cte_new_stack(cte_stack_size_t initial_size,
 
 void cte_stack_push_context(cte_stack_t stack,
                                    char *template_str,
-                               cardinal index,
+                                 size_t length,
+                                 size_t index,
                      cte_stack_status_t *status) {
     
     #define this_stack ((cte_stack_s *)stack)
@@ -210,12 +269,14 @@ void cte_stack_push_context(cte_stack_t stack,
         
         // store context in arr array segment
         this_stack->context[this_stack->entry_count].str = template_str;
+        this_stack->context[this_stack->entry_count].length = length;
         this_stack->context[this_stack->entry_count].index = index;
     }
     else /* index falls within overflow segment */ {
         
         // allocate new entry slot
-        new_entry = ALLOCATE(sizeof(cte_stack_entry_s));
+        new_entry = ALLOCATE_AT(CTE_ALLOC_SITE_STACK_ENTRY,
+                                sizeof(cte_stack_entry_s));
         
         // bail out if allocation failed
         if (new_entry == NULL) {
@@ -225,6 +286,7 @@ void cte_stack_push_context(cte_stack_t stack,
         
         // store context in new_entry
         new_entry->context.str = template_str;
+        new_entry->context.length = length;
         new_entry->context.index = index;
         
         // link new entry into overflow list
@@ -243,12 +305,13 @@ void cte_stack_push_context(cte_stack_t stack,
 
 
 // ---------------------------------------------------------------------------
-// function:  cte_stack_pop_context( stack, index, status )
+// function:  cte_stack_pop_context( stack, length, index, status )
 // ---------------------------------------------------------------------------
 //
 // Removes the top most template context from the stack passed in <stack>  and
-// returns its  template pointer.  Its index  is passed back  in <index>.  The
-// operation fails if NULL is passed in for <stack> or <index>.
+// returns its  template pointer.  Its length and index  are passed back  in
+// <length> and <index>.  The operation fails if NULL is passed in for <stack>,
+// <length> or <index>.
 //
 // Entries which were allocated dynamically  (above the initial capacity)  are
 // deallocated when their values are popped.
@@ -257,7 +320,8 @@ void cte_stack_push_context(cte_stack_t stack,
 // passed in for <status>.
 
 char *cte_stack_pop_context(cte_stack_t stack,
-                               cardinal *index,
+                                 size_t *length,
+                                 size_t *index,
                      cte_stack_status_t *status) {
     
     #define this_stack ((cte_stack_s *)stack)
@@ -270,8 +334,8 @@ char *cte_stack_pop_context(cte_stack_t stack,
         return NULL;
     } // end if
 
-    // bail out if index is NULL
-    if (index == NULL) {
+    // bail out if length or index is NULL
+    if ((length == NULL) || (index == NULL)) {
         ASSIGN_BY_REF(status, CTE_STACK_STATUS_INVALID_INDEX);
         return NULL;
     } // end if
@@ -288,6 +352,7 @@ char *cte_stack_pop_context(cte_stack_t stack,
         
         // return value and status to caller
         ASSIGN_BY_REF(status, CTE_STACK_STATUS_SUCCESS);
+        *length = this_stack->context[this_stack->entry_count].length;
         *index = this_stack->context[this_stack->entry_count].index;
         return this_stack->context[this_stack->entry_count].str;
         
@@ -296,6 +361,7 @@ char *cte_stack_pop_context(cte_stack_t stack,
         
         // get context from first entry in overflow list
         template_str = this_stack->overflow->context.str;
+        *length = this_stack->overflow->context.length;
         *index = this_stack->overflow->context.index;
         
         // remember first entry in overflow list
@@ -303,7 +369,8 @@ char *cte_stack_pop_context(cte_stack_t stack,
         this_stack->overflow = this_stack->overflow->next;
         
         // remove the entry
-        DEALLOCATE(this_entry);
+        DEALLOCATE_AT(CTE_ALLOC_SITE_STACK_ENTRY,
+                      this_entry, sizeof(cte_stack_entry_s));
         
         ASSIGN_BY_REF(status, CTE_STACK_STATUS_SUCCESS);
         return template_str;
@@ -313,6 +380,70 @@ char *cte_stack_pop_context(cte_stack_t stack,
 } // end cte_stack_pop_context
 
 
+// ---------------------------------------------------------------------------
+// function:  cte_stack_context_at( stack, position, length, index, status )
+// ---------------------------------------------------------------------------
+//
+// Returns the template pointer  of the context  at position <position>  of
+// the stack passed in <stack>  without removing it,  position zero being the
+// bottom most context.  Its length and index are passed back in <length> and
+// <index>.  The operation fails if NULL is passed in for <stack>, <length> or
+// <index>,  or if <position> is not less than the number of entries.  Contexts
+// above the initial capacity are found by walking the overflow list,  which is
+// intended for diagnostics, not for use on every push and pop.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_stack_context_at(cte_stack_t stack,
+                           cte_stack_size_t position,
+                           size_t *length,
+                           size_t *index,
+                           cte_stack_status_t *status) {
+    
+    #define this_stack ((cte_stack_s *)stack)
+    cte_stack_entry_s *this_entry;
+    cte_stack_size_t distance;
+    
+    // bail out if stack is NULL
+    if (stack == NULL) {
+        ASSIGN_BY_REF(status, CTE_STACK_STATUS_INVALID_STACK);
+        return NULL;
+    } // end if
+    
+    // bail out if length or index is NULL or position is out of range
+    if ((length == NULL) || (index == NULL) ||
+        (position >= this_stack->entry_count)) {
+        ASSIGN_BY_REF(status, CTE_STACK_STATUS_INVALID_INDEX);
+        return NULL;
+    } // end if
+    
+    // check if position falls within array segment
+    if (position < this_stack->array_size) {
+        ASSIGN_BY_REF(status, CTE_STACK_STATUS_SUCCESS);
+        *length = this_stack->context[position].length;
+        *index = this_stack->context[position].index;
+        return this_stack->context[position].str;
+    } // end if
+    
+    // overflow list holds the top most context first
+    this_entry = this_stack->overflow;
+    distance = this_stack->entry_count - 1 - position;
+    
+    while (distance > 0) {
+        this_entry = this_entry->next;
+        distance--;
+    } // end while
+    
+    ASSIGN_BY_REF(status, CTE_STACK_STATUS_SUCCESS);
+    *length = this_entry->context.length;
+    *index = this_entry->context.index;
+    return this_entry->context.str;
+    
+    #undef this_stack
+} // end cte_stack_context_at
+
+
 // ---------------------------------------------------------------------------
 // function:  cte_stack_size( stack )
 // ---------------------------------------------------------------------------
@@ -360,7 +491,9 @@ cte_stack_size_t cte_stack_number_of_entries(cte_stack_t stack) {
 // function:  cte_dispose_stack( stack )
 // ---------------------------------------------------------------------------
 //
-// Disposes of stack object <stack>.  Returns NULL.
+// Disposes of stack object <stack>.  If the stack was created in caller sup-
+// plied storage,  only entries allocated above its initial capacity are deal-
+// located.  Returns NULL.
 
 cte_stack_t cte_dispose_stack(cte_stack_t stack) {
     #define this_stack ((cte_stack_s *)stack)
@@ -378,11 +511,15 @@ cte_stack_t cte_dispose_stack(cte_stack_t stack) {
         this_stack->overflow = this_stack->overflow->next;
         
         // deallocate the entry
-        DEALLOCATE(this_entry);
+        DEALLOCATE_AT(CTE_ALLOC_SITE_STACK_ENTRY,
+                      this_entry, sizeof(cte_stack_entry_s));
     } // end while
     
-    // deallocate stack object and pass NULL to caller
-    DEALLOCATE(stack);
+    // deallocate stack object unless in caller storage, pass NULL to caller
+    if (NOT(this_stack->in_storage))
+        DEALLOCATE_AT(CTE_ALLOC_SITE_STACK, stack, sizeof(cte_stack_s) +
+                      this_stack->array_size * sizeof(cte_context_s));
+    
     return NULL;
     
     #undef this_stack
@@ -52,6 +52,8 @@
 #define CTE_STACK_H
 
 
+#include <stddef.h>
+
 #include "common.h"
 
 
@@ -69,6 +71,18 @@
 #define CTE_MAXIMUM_STACK_SIZE 0xffffffff  /* more than 2 billion entries */
 
 
+// ---------------------------------------------------------------------------
+// Storage size for stacks in caller supplied storage
+// ---------------------------------------------------------------------------
+//
+// Yields the number of bytes  of caller supplied storage  sufficient to hold
+// a stack with a capacity of <_capacity> entries.  The figure is conservative
+// and assumes that type size_t is not wider than a pointer.
+
+#define CTE_STACK_STORAGE_SIZE(_capacity) \
+    ((4 + 3 * (_capacity)) * sizeof(void *))
+
+
 // ---------------------------------------------------------------------------
 // Determine type to hold stack size values
 // ---------------------------------------------------------------------------
@@ -145,13 +159,34 @@ cte_stack_t cte_new_stack(cte_stack_size_t initial_size,
 
 
 // ---------------------------------------------------------------------------
-// function:  cte_stack_push_context( stack, template, index, status )
+// function:  cte_new_stack_in_storage( storage, storage_size, status )
+// ---------------------------------------------------------------------------
+//
+// Creates and returns a new CTE template context stack object  in the caller
+// supplied storage passed in <storage>  whose size in bytes is passed in <sto-
+// rage_size>.  The initial capacity of the stack is the number of entries that
+// fit into the storage.  No memory is allocated  unless the number of entries
+// exceeds the initial capacity.  The function fails if NULL is passed in for
+// <storage>  or  if the storage is too small to hold at least one entry.  The
+// storage must be pointer aligned and remain valid until the stack has been
+// disposed of.  CTE_STACK_STORAGE_SIZE() may be used to size the storage.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_stack_t cte_new_stack_in_storage(void *storage,
+                                   size_t storage_size,
+                       cte_stack_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_stack_push_context( stack, template, length, index, status )
 // ---------------------------------------------------------------------------
 //
 // Saves a template context to the stack passed in <stack>.  The context para-
-// meters are passed in  <template_str>  and <index>.  The operation will fail
-// if NULL is passed in for <stack> or <template_str> or if the stack size has
-// reached CTE_MAXIMUM_STACK_SIZE.
+// meters are passed in <template_str>, <length> and <index>.  The operation
+// will fail if NULL is passed in for <stack> or <template_str>  or if the
+// stack size has reached CTE_MAXIMUM_STACK_SIZE.
 //
 // New entries are allocated dynamically  if the number of entries exceeds the
 // initial capacity of the stack.
@@ -161,17 +196,19 @@ cte_stack_t cte_new_stack(cte_stack_size_t initial_size,
 
 void cte_stack_push_context(cte_stack_t stack,
                                    char *template_str,
-                               cardinal index,
+                                 size_t length,
+                                 size_t index,
                      cte_stack_status_t *status);
 
 
 // ---------------------------------------------------------------------------
-// function:  cte_stack_pop_context( stack, index, status )
+// function:  cte_stack_pop_context( stack, length, index, status )
 // ---------------------------------------------------------------------------
 //
 // Removes the top most template context from the stack passed in <stack>  and
-// returns its  template pointer.  Its index  is passed back  in <index>.  The
-// operation fails if NULL is passed in for <stack> or <index>.
+// returns its  template pointer.  Its length and index  are passed back  in
+// <length> and <index>.  The operation fails if NULL is passed in for <stack>,
+// <length> or <index>.
 //
 // Entries which were allocated dynamically  (above the initial capacity)  are
 // deallocated when their values are popped.
@@ -180,10 +217,33 @@ void cte_stack_push_context(cte_stack_t stack,
 // passed in for <status>.
 
 char *cte_stack_pop_context(cte_stack_t stack,
-                               cardinal *index,
+                                 size_t *length,
+                                 size_t *index,
                      cte_stack_status_t *status);
 
 
+// ---------------------------------------------------------------------------
+// function:  cte_stack_context_at( stack, position, length, index, status )
+// ---------------------------------------------------------------------------
+//
+// Returns the template pointer  of the context  at position <position>  of
+// the stack passed in <stack>  without removing it,  position zero being the
+// bottom most context.  Its length and index are passed back in <length> and
+// <index>.  The operation fails if NULL is passed in for <stack>, <length> or
+// <index>,  or if <position> is not less than the number of entries.  Contexts
+// above the initial capacity are found by walking the overflow list,  which is
+// intended for diagnostics, not for use on every push and pop.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+char *cte_stack_context_at(cte_stack_t stack,
+                     cte_stack_size_t position,
+                               size_t *length,
+                               size_t *index,
+                   cte_stack_status_t *status);
+
+
 // ---------------------------------------------------------------------------
 // function:  cte_stack_size( stack )
 // ---------------------------------------------------------------------------
@@ -208,7 +268,9 @@ cte_stack_size_t cte_stack_number_of_entries(cte_stack_t stack);
 // function:  cte_dispose_stack( stack )
 // ---------------------------------------------------------------------------
 //
-// Disposes of stack object <stack>.  Returns NULL.
+// Disposes of stack object <stack>.  If the stack was created in caller sup-
+// plied storage,  only entries allocated above its initial capacity are deal-
+// located.  Returns NULL.
 
 cte_stack_t cte_dispose_stack(cte_stack_t stack);
 
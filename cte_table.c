@@ -0,0 +1,859 @@
+/* C Template Engine
+ *
+ *  @file cte_table.c
+ *  CTE table implementation
+ *
+ *  Placeholder table optimised for few entries and cheap construction
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include <string.h>
+
+#include "CTE.h"
+#include "ASCII.h"
+#include "hash.h"
+#include "alloc.h"
+#include "cte_table.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+
+// ---------------------------------------------------------------------------
+// Range checks
+// ---------------------------------------------------------------------------
+
+#if (CTE_DEFAULT_TABLE_SIZE < 1)
+#error CTE_DEFAULT_TABLE_SIZE must not be zero, recommended minimum is 8
+#endif
+
+#if (CTE_TABLE_SCAN_LIMIT < 4)
+#warning CTE_TABLE_SCAN_LIMIT is unreasonably low, factory setting is 16
+#elif (CTE_TABLE_SCAN_LIMIT > 64)
+#warning CTE_TABLE_SCAN_LIMIT is unreasonably high, factory setting is 16
+#endif
+
+
+// ---------------------------------------------------------------------------
+// Minimum size of hash index, must be a power of two
+// ---------------------------------------------------------------------------
+
+#define CTE_TABLE_INDEX_SIZE_MINIMUM 64 /* slots */
+
+
+// ---------------------------------------------------------------------------
+// Entry index returned when a key is not found
+// ---------------------------------------------------------------------------
+
+#define CTE_TABLE_NOT_FOUND (~((cardinal) 0))
+
+
+// ---------------------------------------------------------------------------
+// Table entry kinds
+// ---------------------------------------------------------------------------
+
+typedef enum /* cte_table_entry_kind_t */ {
+    CTE_TABLE_ENTRY_VALUE = 0,
+    CTE_TABLE_ENTRY_ROWS
+} cte_table_entry_kind_t;
+
+
+// ---------------------------------------------------------------------------
+// Pending value
+// ---------------------------------------------------------------------------
+
+const char cte_pending_value[1] = { CSTRING_TERMINATOR };
+
+
+// ---------------------------------------------------------------------------
+// Row array stored for sections without rows
+// ---------------------------------------------------------------------------
+
+static const cte_table_t _cte_table_no_rows[1] = { NULL };
+
+
+// ---------------------------------------------------------------------------
+// Placeholder table type
+// ---------------------------------------------------------------------------
+//
+// Keys,  value pointers,  value lengths,  entry kinds and escaping modes are
+// kept in separate arrays within a single allocation.  For row entries,  the
+// value pointer holds the row array and the length holds the number of rows.
+// The key array is padded to a multiple of four entries  so that it can be
+// compared four keys at a time.  The hash index  is built
+// on demand once the table holds more than CTE_TABLE_SCAN_LIMIT entries, its
+// slots hold an entry index plus one, zero if the slot is empty.
+
+typedef struct /* cte_table_s */ {
+      kvs_key_t *key;
+    const char **value;
+         size_t *length;
+        uint8_t *kind;
+        uint8_t *escape;
+       cardinal *index;
+       cardinal index_size;
+           bool index_valid;
+       cardinal entry_count;
+       cardinal array_size;
+} cte_table_s;
+
+
+// ===========================================================================
+// P R I V A T E   F U N C T I O N   P R O T O T Y P E S
+// ===========================================================================
+
+static fmacro cardinal _index_of_key(cte_table_s *table, kvs_key_t key);
+
+static fmacro cardinal _scan_for_key(cte_table_s *table, kvs_key_t key);
+
+static void _build_index(cte_table_s *table);
+
+static void _store_entry(cte_table_s *table, const char *identifier,
+                         const char *value, size_t length, uint8_t kind,
+                         uint8_t escape, cte_table_status_t *status);
+
+static bool _allocate_arrays(cte_table_s *table, cardinal array_size);
+
+
+// ===========================================================================
+// P U B L I C   F U N C T I O N   I M P L E M E N T A T I O N S
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// function:  cte_new_table( initial_size, status )
+// ---------------------------------------------------------------------------
+//
+// Creates  and  returns  a new  empty placeholder table  with  an  initial
+// capacity of <initial_size> entries.  If zero is passed in for <initial_size>
+// then it will be created with an initial capacity of CTE_DEFAULT_TABLE_SIZE.
+// The function fails if memory could not be allocated.
+//
+// A placeholder table  stores keys,  value pointers  and  value lengths  in
+// contiguous arrays.  It does not copy values,  it is therefore cheap to fill
+// and may be reused for any number of renders by calling cte_table_reset().
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_table_t cte_new_table(cardinal initial_size,
+                          cte_table_status_t *status) {
+    cte_table_s *table;
+    
+    // zero size means default
+    if (initial_size == 0) {
+        initial_size = CTE_DEFAULT_TABLE_SIZE;
+    } // end if
+    
+    // allocate new table
+    table = ALLOCATE(sizeof(cte_table_s));
+    
+    // bail out if allocation failed
+    if (table == NULL) {
+        ASSIGN_BY_REF(status, CTE_TABLE_STATUS_ALLOCATION_FAILED);
+        return NULL;
+    } // end if
+    
+    table->key = NULL;
+    
+    // allocate entry arrays, bail out if allocation failed
+    if (NOT(_allocate_arrays(table, initial_size))) {
+        DEALLOCATE(table);
+        ASSIGN_BY_REF(status, CTE_TABLE_STATUS_ALLOCATION_FAILED);
+        return NULL;
+    } // end if
+    
+    // initialise meta data
+    table->index = NULL;
+    table->index_size = 0;
+    table->index_valid = false;
+    table->entry_count = 0;
+    
+    // pass status and new table to caller
+    ASSIGN_BY_REF(status, CTE_TABLE_STATUS_SUCCESS);
+    return (cte_table_t) table;
+} // end cte_new_table
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_table_store_value( table, identifier, value, length, status )
+// ---------------------------------------------------------------------------
+//
+// Stores value <value>  of length <length>  for placeholder  <identifier>  in
+// table <table>,  replacing any value previously stored for the same place-
+// holder.  The value need not be terminated.  The table stores the pointer, it
+// does not copy the value, which must therefore remain valid while the table
+// is used.  The operation fails if NULL is passed in for <table> or <value>,
+// if <identifier> is not a valid placeholder identifier  or if the table is
+// full and could not be enlarged.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_table_store_value(cte_table_t table,
+                           const char *identifier,
+                           const char *value,
+                           size_t length,
+                           cte_table_status_t *status) {
+    
+    // bail out if table is NULL
+    if (table == NULL) {
+        ASSIGN_BY_REF(status, CTE_TABLE_STATUS_INVALID_TABLE);
+        return;
+    } // end if
+    
+    // bail out if value is NULL
+    if (value == NULL) {
+        ASSIGN_BY_REF(status, CTE_TABLE_STATUS_INVALID_VALUE);
+        return;
+    } // end if
+    
+    _store_entry((cte_table_s *) table, identifier, value, length,
+                 CTE_TABLE_ENTRY_VALUE, CTE_ESCAPE_DEFAULT, status);
+    return;
+} // end cte_table_store_value
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_table_store_escaped_value( table, identifier, value, length, escape,
+//                                 status )
+// ---------------------------------------------------------------------------
+//
+// Stores value <value> of length <length> for placeholder <identifier> in
+// table <table>  exactly like cte_table_store_value(),  except that the value
+// is escaped in escaping mode <escape>  instead of the mode of the render when
+// it is expanded.  Mode CTE_ESCAPE_NONE exempts the value from escaping,  for
+// values that have been escaped before they were stored.  The operation fails
+// for the same reasons as cte_table_store_value()  and if <escape> is not a
+// valid escaping mode.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_table_store_escaped_value(cte_table_t table,
+                                   const char *identifier,
+                                   const char *value,
+                                   size_t length,
+                                   cte_escape_t escape,
+                                   cte_table_status_t *status) {
+    
+    // bail out if table is NULL
+    if (table == NULL) {
+        ASSIGN_BY_REF(status, CTE_TABLE_STATUS_INVALID_TABLE);
+        return;
+    } // end if
+    
+    // bail out if value is NULL or escaping mode is invalid
+    if ((value == NULL) || (escape > CTE_ESCAPE_DEFAULT)) {
+        ASSIGN_BY_REF(status, CTE_TABLE_STATUS_INVALID_VALUE);
+        return;
+    } // end if
+    
+    _store_entry((cte_table_s *) table, identifier, value, length,
+                 CTE_TABLE_ENTRY_VALUE, escape, status);
+    return;
+} // end cte_table_store_escaped_value
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_table_store_pending( table, identifier, status )
+// ---------------------------------------------------------------------------
+//
+// Marks the value of placeholder <identifier>  in table <table>  as pending,
+// replacing any value or rows previously stored for the same identifier.  The
+// value is completed by storing it with cte_table_store_value().  Until then,
+// cte_table_value_for_key() returns CTE_PENDING_VALUE for the placeholder.
+// The operation fails if NULL is passed in for <table>,  if <identifier> is
+// not a valid placeholder identifier  or if the table is full and could not
+// be enlarged.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_table_store_pending(cte_table_t table,
+                             const char *identifier,
+                             cte_table_status_t *status) {
+    
+    // bail out if table is NULL
+    if (table == NULL) {
+        ASSIGN_BY_REF(status, CTE_TABLE_STATUS_INVALID_TABLE);
+        return;
+    } // end if
+    
+    _store_entry((cte_table_s *) table, identifier, CTE_PENDING_VALUE, 0,
+                 CTE_TABLE_ENTRY_VALUE, CTE_ESCAPE_DEFAULT, status);
+    return;
+} // end cte_table_store_pending
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_table_store_rows( table, identifier, rows, count, status )
+// ---------------------------------------------------------------------------
+//
+// Stores the array of <count> row tables  passed in <rows>  for the section
+// named <identifier> in table <table>,  replacing any value or rows previously
+// stored for the same identifier.  When a template section of that name is
+// expanded,  its body is expanded once per row,  looking up placeholders and
+// nested sections in the row's table first  and then in the enclosing scopes,
+// as described for cte_string_from_template() in CTE.h.  The table stores the
+// pointer,  it does not copy the array,  which must therefore remain valid
+// while the table is used.  NULL entries in the array are treated as empty
+// rows.  The operation fails if NULL is passed in for <table>,  if NULL is
+// passed in for <rows> with a non-zero <count>,  if <identifier> is not a
+// valid placeholder identifier  or if the table is full and could not be
+// enlarged.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_table_store_rows(cte_table_t table,
+                          const char *identifier,
+                          const cte_table_t *rows,
+                          cardinal count,
+                          cte_table_status_t *status) {
+    
+    // bail out if table is NULL
+    if (table == NULL) {
+        ASSIGN_BY_REF(status, CTE_TABLE_STATUS_INVALID_TABLE);
+        return;
+    } // end if
+    
+    // bail out if rows are missing
+    if ((rows == NULL) && (count != 0)) {
+        ASSIGN_BY_REF(status, CTE_TABLE_STATUS_INVALID_ROWS);
+        return;
+    } // end if
+    
+    // an empty section must still be found, store a non-NULL array
+    if (rows == NULL)
+        rows = _cte_table_no_rows;
+    
+    _store_entry((cte_table_s *) table, identifier, (const char *) rows,
+                 count, CTE_TABLE_ENTRY_ROWS, CTE_ESCAPE_DEFAULT, status);
+    return;
+} // end cte_table_store_rows
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_table_entry_exists( table, key )
+// ---------------------------------------------------------------------------
+//
+// Returns true if a value or rows are stored for key <key> in table <table>,
+// returns false otherwise or if NULL is passed in for <table>.
+
+bool cte_table_entry_exists(cte_table_t table, kvs_key_t key) {
+    
+    if (table == NULL)
+        return false;
+    
+    return (_index_of_key((cte_table_s *) table, key) != CTE_TABLE_NOT_FOUND);
+} // end cte_table_entry_exists
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_table_value_for_key( table, key, length )
+// ---------------------------------------------------------------------------
+//
+// Returns the value stored for key <key> in table <table>  and passes back its
+// length in <length>  unless NULL was passed in for <length>.  Returns NULL if
+// no value is stored for <key>,  if rows are stored for <key>  or if NULL is
+// passed in for <table>.  Returns CTE_PENDING_VALUE with a length of zero if
+// the value for <key> is pending.
+
+const char *cte_table_value_for_key(cte_table_t table,
+                                    kvs_key_t key,
+                                    size_t *length) {
+    
+    #define this_table ((cte_table_s *)table)
+    cardinal index;
+    
+    // bail out if table is NULL
+    if (table == NULL)
+        return NULL;
+    
+    index = _index_of_key(this_table, key);
+    
+    // bail out if key is not present or holds rows
+    if ((index == CTE_TABLE_NOT_FOUND) ||
+        (this_table->kind[index] != CTE_TABLE_ENTRY_VALUE))
+        return NULL;
+    
+    ASSIGN_BY_REF(length, this_table->length[index]);
+    return this_table->value[index];
+    
+    #undef this_table
+} // end cte_table_value_for_key
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_table_escaped_value_for_key( table, key, length, escape )
+// ---------------------------------------------------------------------------
+//
+// Returns the value stored for key <key> in table <table>  exactly like func-
+// tion cte_table_value_for_key()  and passes back its escaping mode in <es-
+// cape>  unless NULL was passed in for <escape>.  The mode of values stored
+// without a mode of their own is CTE_ESCAPE_DEFAULT.
+
+const char *cte_table_escaped_value_for_key(cte_table_t table,
+                                            kvs_key_t key,
+                                            size_t *length,
+                                            cte_escape_t *escape) {
+    
+    #define this_table ((cte_table_s *)table)
+    cardinal index;
+    
+    // bail out if table is NULL
+    if (table == NULL)
+        return NULL;
+    
+    index = _index_of_key(this_table, key);
+    
+    // bail out if key is not present or holds rows
+    if ((index == CTE_TABLE_NOT_FOUND) ||
+        (this_table->kind[index] != CTE_TABLE_ENTRY_VALUE))
+        return NULL;
+    
+    ASSIGN_BY_REF(length, this_table->length[index]);
+    ASSIGN_BY_REF(escape, this_table->escape[index]);
+    return this_table->value[index];
+    
+    #undef this_table
+} // end cte_table_escaped_value_for_key
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_table_rows_for_key( table, key, count )
+// ---------------------------------------------------------------------------
+//
+// Returns the array of row tables stored for key <key> in table <table>  and
+// passes back the number of rows in <count>  unless NULL was passed in for
+// <count>.  Returns NULL if no rows are stored for <key>,  if a value is stored
+// for <key> or if NULL is passed in for <table>.
+
+const cte_table_t *cte_table_rows_for_key(cte_table_t table,
+                                          kvs_key_t key,
+                                          cardinal *count) {
+    
+    #define this_table ((cte_table_s *)table)
+    cardinal index;
+    
+    // bail out if table is NULL
+    if (table == NULL)
+        return NULL;
+    
+    index = _index_of_key(this_table, key);
+    
+    // bail out if key is not present or holds a value
+    if ((index == CTE_TABLE_NOT_FOUND) ||
+        (this_table->kind[index] != CTE_TABLE_ENTRY_ROWS))
+        return NULL;
+    
+    ASSIGN_BY_REF(count, (cardinal) this_table->length[index]);
+    return (const cte_table_t *) this_table->value[index];
+    
+    #undef this_table
+} // end cte_table_rows_for_key
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_table_number_of_entries( table )
+// ---------------------------------------------------------------------------
+//
+// Returns  the number of  entries  stored in table <table>,  returns zero if
+// NULL is passed in for <table>.
+
+cardinal cte_table_number_of_entries(cte_table_t table) {
+    
+    // bail out if table is NULL
+    if (table == NULL)
+        return 0;
+    
+    return ((cte_table_s *) table)->entry_count;
+} // end cte_table_number_of_entries
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_table_reset( table )
+// ---------------------------------------------------------------------------
+//
+// Removes all entries from table <table>  without deallocating its storage,
+// so that the table can be refilled for another render without allocation.
+
+void cte_table_reset(cte_table_t table) {
+    #define this_table ((cte_table_s *)table)
+    
+    // bail out if table is NULL
+    if (table == NULL)
+        return;
+    
+    this_table->entry_count = 0;
+    this_table->index_valid = false;
+    
+    return;
+    
+    #undef this_table
+} // end cte_table_reset
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_dispose_table( table )
+// ---------------------------------------------------------------------------
+//
+// Disposes of table object <table>.  Returns NULL.
+
+cte_table_t cte_dispose_table(cte_table_t table) {
+    #define this_table ((cte_table_s *)table)
+    
+    // bail out if table is NULL
+    if (table == NULL)
+        return NULL;
+    
+    DEALLOCATE(this_table->index);
+    DEALLOCATE(this_table->key);
+    DEALLOCATE(table);
+    return NULL;
+    
+    #undef this_table
+} // end cte_dispose_table
+
+
+// ===========================================================================
+// P R I V A T E   F U N C T I O N   I M P L E M E N T A T I O N S
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// private function:  _index_of_key( table, key )
+// ---------------------------------------------------------------------------
+//
+// Returns the index of the entry for key <key> in table <table>,  or returns
+// CTE_TABLE_NOT_FOUND if there is no such entry.  Tables with no more than
+// CTE_TABLE_SCAN_LIMIT entries are scanned,  larger tables are looked up in
+// their hash index,  which is built first if it is not valid.  If the index
+// cannot be allocated, the table is scanned instead.
+
+static fmacro cardinal _index_of_key(cte_table_s *table, kvs_key_t key) {
+    cardinal mask, slot;
+    
+    // scan small tables
+    if (table->entry_count <= CTE_TABLE_SCAN_LIMIT)
+        return _scan_for_key(table, key);
+    
+    // build hash index if necessary
+    if (NOT(table->index_valid)) {
+        _build_index(table);
+        
+        if (NOT(table->index_valid))
+            return _scan_for_key(table, key);
+    } // end if
+    
+    // probe hash index
+    mask = table->index_size - 1;
+    slot = key & mask;
+    
+    while (table->index[slot] != 0) {
+        if (table->key[table->index[slot] - 1] == key)
+            return table->index[slot] - 1;
+        
+        slot = (slot + 1) & mask;
+    } // end while
+    
+    return CTE_TABLE_NOT_FOUND;
+} // _index_of_key
+
+
+// ---------------------------------------------------------------------------
+// private function:  _scan_for_key( table, key )
+// ---------------------------------------------------------------------------
+//
+// Returns the index of the entry for key <key> in table <table>,  or returns
+// CTE_TABLE_NOT_FOUND if there is no such entry,  by comparing all keys in
+// sequence.  Where SSE2 or NEON is available,  four keys are compared at a
+// time.  The key array is padded to a multiple of four, matches in padding
+// beyond the last entry are ignored.
+
+static fmacro cardinal _scan_for_key(cte_table_s *table, kvs_key_t key) {
+    cardinal index;
+    
+#if defined(__SSE2__)
+    __m128i needle, keys;
+    int mask;
+    
+    needle = _mm_set1_epi32((int) key);
+    
+    for (index = 0; index < table->entry_count; index += 4) {
+        keys = _mm_load_si128((const __m128i *) &table->key[index]);
+        mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(keys, needle)));
+        
+        if (mask != 0) {
+            index = index + __builtin_ctz(mask);
+            return (index < table->entry_count) ? index : CTE_TABLE_NOT_FOUND;
+        } // end if
+    } // end for
+    
+#elif defined(__ARM_NEON)
+    uint32x4_t needle, equal;
+    uint64_t mask;
+    
+    needle = vdupq_n_u32((uint32_t) key);
+    
+    for (index = 0; index < table->entry_count; index += 4) {
+        equal = vceqq_u32(vld1q_u32((const uint32_t *) &table->key[index]),
+                          needle);
+        mask = vget_lane_u64(vreinterpret_u64_u16(vmovn_u32(equal)), 0);
+        
+        if (mask != 0) {
+            index = index + (__builtin_ctzll(mask) >> 4);
+            return (index < table->entry_count) ? index : CTE_TABLE_NOT_FOUND;
+        } // end if
+    } // end for
+    
+#else
+    for (index = 0; index < table->entry_count; index++) {
+        if (table->key[index] == key)
+            return index;
+    } // end for
+#endif
+    
+    return CTE_TABLE_NOT_FOUND;
+} // _scan_for_key
+
+
+// ---------------------------------------------------------------------------
+// private function:  _build_index( table )
+// ---------------------------------------------------------------------------
+//
+// Builds the hash index  of table <table>.  The index is sized to a power of
+// two of at least twice the number of entries  and reused for rebuilding as
+// long as it is large enough.  If allocation fails,  the index remains invalid.
+
+static void _build_index(cte_table_s *table) {
+    cardinal index, mask, slot, size;
+    
+    size = CTE_TABLE_INDEX_SIZE_MINIMUM;
+    while (size < 2 * table->entry_count)
+        size = 2 * size;
+    
+    // allocate index if there is none or if it is too small
+    if (table->index_size < size) {
+        DEALLOCATE(table->index);
+        table->index = ALLOCATE(size * sizeof(cardinal));
+        
+        if (table->index == NULL) {
+            table->index_size = 0;
+            return;
+        } // end if
+        
+        table->index_size = size;
+    } // end if
+    
+    memset(table->index, 0, table->index_size * sizeof(cardinal));
+    mask = table->index_size - 1;
+    
+    for (index = 0; index < table->entry_count; index++) {
+        slot = table->key[index] & mask;
+        while (table->index[slot] != 0)
+            slot = (slot + 1) & mask;
+        table->index[slot] = index + 1;
+    } // end for
+    
+    table->index_valid = true;
+    return;
+} // _build_index
+
+
+// ---------------------------------------------------------------------------
+// private function:  _store_entry( table, identifier, value, length, kind, s )
+// ---------------------------------------------------------------------------
+//
+// Stores an entry of kind <kind>  with value pointer <value>,  length <length>
+// and escaping mode <escape>  for placeholder <identifier> in table <table>,
+// replacing any entry previously stored for the same placeholder.  The sta-
+// tus of the operation is passed back in <status>,  unless NULL was passed in
+// for <status>.
+
+static void _store_entry(cte_table_s *table,
+                         const char *identifier,
+                         const char *value,
+                         size_t length,
+                         uint8_t kind,
+                         uint8_t escape,
+                         cte_table_status_t *status) {
+    
+    cardinal index, ident_len, mask, slot;
+    kvs_key_t key;
+    
+    // bail out if identifier does not start with a letter
+    if ((identifier == NULL) || (IS_NOT_LETTER(identifier[0]))) {
+        ASSIGN_BY_REF(status, CTE_TABLE_STATUS_INVALID_IDENTIFIER);
+        return;
+    } // end if
+    
+    // calculate key of identifier
+    key = HASH_INITIAL;
+    ident_len = 0;
+    while ((identifier[ident_len] != CSTRING_TERMINATOR) &&
+           (ident_len <= CTE_MAX_PLACEHOLDER_LENGTH)) {
+        
+        // bail out if identifier contains illegal characters
+        if (IS_NOT_UNDERSCORE_NOR_ALPHANUM(identifier[ident_len])) {
+            ASSIGN_BY_REF(status, CTE_TABLE_STATUS_INVALID_IDENTIFIER);
+            return;
+        } // end if
+        
+        key = HASH_NEXT_CHAR(key, identifier[ident_len]);
+        ident_len++;
+    } // end while
+    key = HASH_FINAL(key);
+    
+    // bail out if identifier is too long
+    if (ident_len > CTE_MAX_PLACEHOLDER_LENGTH) {
+        ASSIGN_BY_REF(status, CTE_TABLE_STATUS_INVALID_IDENTIFIER);
+        return;
+    } // end if
+    
+    index = _index_of_key(table, key);
+    
+    // replace value if key is already present
+    if (index != CTE_TABLE_NOT_FOUND) {
+        table->value[index] = value;
+        table->length[index] = length;
+        table->kind[index] = kind;
+        table->escape[index] = escape;
+        ASSIGN_BY_REF(status, CTE_TABLE_STATUS_SUCCESS);
+        return;
+    } // end if
+    
+    // enlarge arrays if table is full
+    if (table->entry_count == table->array_size) {
+        
+        // bail out if enlargement failed
+        if (NOT(_allocate_arrays(table, 2 * table->array_size))) {
+            ASSIGN_BY_REF(status, CTE_TABLE_STATUS_ALLOCATION_FAILED);
+            return;
+        } // end if
+    } // end if
+    
+    // append new entry
+    index = table->entry_count;
+    table->key[index] = key;
+    table->value[index] = value;
+    table->length[index] = length;
+    table->kind[index] = kind;
+    table->escape[index] = escape;
+    table->entry_count++;
+    
+    // enter into hash index if it has room, otherwise let it be rebuilt
+    if ((table->index_valid) &&
+        (2 * table->entry_count <= table->index_size)) {
+        mask = table->index_size - 1;
+        slot = key & mask;
+        while (table->index[slot] != 0)
+            slot = (slot + 1) & mask;
+        table->index[slot] = index + 1;
+    }
+    else {
+        table->index_valid = false;
+    } // end if
+    
+    ASSIGN_BY_REF(status, CTE_TABLE_STATUS_SUCCESS);
+    return;
+} // _store_entry
+
+
+// ---------------------------------------------------------------------------
+// private function:  _allocate_arrays( table, array_size )
+// ---------------------------------------------------------------------------
+//
+// Allocates entry arrays for <array_size> entries,  rounded up to a multiple
+// of four,  copies any existing entries of table <table> into them and then
+// replaces the table's arrays.  Returns true if successful,  returns false if
+// allocation failed, in which case the table is left unmodified.
+
+static bool _allocate_arrays(cte_table_s *table, cardinal array_size) {
+    kvs_key_t *key;
+    
+    array_size = (array_size + 3) & ~((cardinal) 3);
+    
+    // one block holding keys, value pointers, value lengths, kinds and modes
+    key = ALLOCATE(array_size * (sizeof(kvs_key_t) + sizeof(const char *) +
+                                 sizeof(size_t) + 2 * sizeof(uint8_t)));
+    
+    // bail out if allocation failed
+    if (key == NULL)
+        return false;
+    
+    // clear padding beyond the last entry
+    memset(key, 0, array_size * sizeof(kvs_key_t));
+    
+    // copy existing entries
+    if (table->key != NULL) {
+        memcpy(key, table->key, table->entry_count * sizeof(kvs_key_t));
+        memcpy((const char **) (key + array_size), table->value,
+               table->entry_count * sizeof(const char *));
+        memcpy((size_t *) ((const char **) (key + array_size) + array_size),
+               table->length, table->entry_count * sizeof(size_t));
+        memcpy((uint8_t *) ((size_t *) ((const char **)
+               (key + array_size) + array_size) + array_size),
+               table->kind, table->entry_count * sizeof(uint8_t));
+        memcpy((uint8_t *) ((size_t *) ((const char **)
+               (key + array_size) + array_size) + array_size) + array_size,
+               table->escape, table->entry_count * sizeof(uint8_t));
+        DEALLOCATE(table->key);
+    } // end if
+    
+    table->key = key;
+    table->value = (const char **) (key + array_size);
+    table->length = (size_t *) (table->value + array_size);
+    table->kind = (uint8_t *) (table->length + array_size);
+    table->escape = table->kind + array_size;
+    table->array_size = array_size;
+    
+    return true;
+} // _allocate_arrays
+
+
+// END OF FILE
@@ -0,0 +1,318 @@
+/* C Template Engine
+ *
+ *  @file cte_table.h
+ *  CTE table interface
+ *
+ *  Placeholder table optimised for few entries and cheap construction
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#ifndef CTE_TABLE_H
+#define CTE_TABLE_H
+
+
+#include "../KVS/KVS.h"
+#include "common.h"
+#include "cte_escape.h"
+
+
+// ---------------------------------------------------------------------------
+// Default table size
+// ---------------------------------------------------------------------------
+
+#define CTE_DEFAULT_TABLE_SIZE 16
+
+
+// ---------------------------------------------------------------------------
+// Scan limit
+// ---------------------------------------------------------------------------
+//
+// Tables with up to this number of entries are searched by comparing all keys
+// in sequence,  several keys at a time where SIMD instructions are available.
+// Larger tables are searched using a hash index  which is built on demand.
+
+#define CTE_TABLE_SCAN_LIMIT 16
+
+
+// ---------------------------------------------------------------------------
+// Pending value
+// ---------------------------------------------------------------------------
+//
+// Value of placeholders whose value has been announced  but is not available
+// yet.  It is identified by its address,  not by its contents.
+
+extern const char cte_pending_value[];
+
+#define CTE_PENDING_VALUE (cte_pending_value)
+
+
+// ---------------------------------------------------------------------------
+// Opaque table handle type
+// ---------------------------------------------------------------------------
+//
+// WARNING:  Objects of this opaque type should  only be accessed through this
+// public interface.  DO NOT EVER attempt to bypass the public interface.
+//
+// The internal data structure of this opaque type is  HIDDEN  and  MAY CHANGE
+// at any time WITHOUT NOTICE.  Accessing the internal data structure directly
+// other than  through the  functions  in this public interface is  UNSAFE and
+// may result in an inconsistent program state or a crash.
+
+typedef opaque_t cte_table_t;
+
+
+// ---------------------------------------------------------------------------
+// Status codes
+// ---------------------------------------------------------------------------
+
+typedef enum /* cte_table_status_t */ {
+    CTE_TABLE_STATUS_SUCCESS = 1,
+    CTE_TABLE_STATUS_INVALID_TABLE,
+    CTE_TABLE_STATUS_INVALID_IDENTIFIER,
+    CTE_TABLE_STATUS_INVALID_VALUE,
+    CTE_TABLE_STATUS_INVALID_ROWS,
+    CTE_TABLE_STATUS_ALLOCATION_FAILED
+} cte_table_status_t;
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_new_table( initial_size, status )
+// ---------------------------------------------------------------------------
+//
+// Creates  and  returns  a new  empty placeholder table  with  an  initial
+// capacity of <initial_size> entries.  If zero is passed in for <initial_size>
+// then it will be created with an initial capacity of CTE_DEFAULT_TABLE_SIZE.
+// The function fails if memory could not be allocated.
+//
+// A placeholder table  stores keys,  value pointers  and  value lengths  in
+// contiguous arrays.  It does not copy values,  it is therefore cheap to fill
+// and may be reused for any number of renders by calling cte_table_reset().
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+cte_table_t cte_new_table(cardinal initial_size,
+                cte_table_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_table_store_value( table, identifier, value, length, status )
+// ---------------------------------------------------------------------------
+//
+// Stores value <value>  of length <length>  for placeholder  <identifier>  in
+// table <table>,  replacing any value previously stored for the same place-
+// holder.  The value need not be terminated.  The table stores the pointer, it
+// does not copy the value, which must therefore remain valid while the table
+// is used.  The operation fails if NULL is passed in for <table> or <value>,
+// if <identifier> is not a valid placeholder identifier  or if the table is
+// full and could not be enlarged.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_table_store_value(cte_table_t table,
+                            const char *identifier,
+                            const char *value,
+                                size_t length,
+                    cte_table_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:
+//  cte_table_store_escaped_value( table, identifier, value, length, escape,
+//                                 status )
+// ---------------------------------------------------------------------------
+//
+// Stores value <value> of length <length> for placeholder <identifier> in
+// table <table>  exactly like cte_table_store_value(),  except that the value
+// is escaped in escaping mode <escape>  instead of the mode of the render when
+// it is expanded.  Mode CTE_ESCAPE_NONE exempts the value from escaping,  for
+// values that have been escaped before they were stored.  The operation fails
+// for the same reasons as cte_table_store_value()  and if <escape> is not a
+// valid escaping mode.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_table_store_escaped_value(cte_table_t table,
+                                    const char *identifier,
+                                    const char *value,
+                                        size_t length,
+                                  cte_escape_t escape,
+                            cte_table_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_table_store_pending( table, identifier, status )
+// ---------------------------------------------------------------------------
+//
+// Marks the value of placeholder <identifier>  in table <table>  as pending,
+// replacing any value or rows previously stored for the same identifier.  The
+// value is completed by storing it with cte_table_store_value().  Until then,
+// cte_table_value_for_key() returns CTE_PENDING_VALUE for the placeholder.
+// The operation fails if NULL is passed in for <table>,  if <identifier> is
+// not a valid placeholder identifier  or if the table is full and could not
+// be enlarged.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_table_store_pending(cte_table_t table,
+                              const char *identifier,
+                      cte_table_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_table_store_rows( table, identifier, rows, count, status )
+// ---------------------------------------------------------------------------
+//
+// Stores the array of <count> row tables  passed in <rows>  for the section
+// named <identifier> in table <table>,  replacing any value or rows previously
+// stored for the same identifier.  When a template section of that name is
+// expanded,  its body is expanded once per row,  looking up placeholders and
+// nested sections in the row's table first  and then in the enclosing scopes,
+// as described for cte_string_from_template() in CTE.h.  The table stores the
+// pointer,  it does not copy the array,  which must therefore remain valid
+// while the table is used.  NULL entries in the array are treated as empty
+// rows.  The operation fails if NULL is passed in for <table>,  if NULL is
+// passed in for <rows> with a non-zero <count>,  if <identifier> is not a
+// valid placeholder identifier  or if the table is full and could not be
+// enlarged.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+void cte_table_store_rows(cte_table_t table,
+                           const char *identifier,
+                    const cte_table_t *rows,
+                             cardinal count,
+                   cte_table_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_table_entry_exists( table, key )
+// ---------------------------------------------------------------------------
+//
+// Returns true if a value or rows are stored for key <key> in table <table>,
+// returns false otherwise or if NULL is passed in for <table>.
+
+bool cte_table_entry_exists(cte_table_t table, kvs_key_t key);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_table_value_for_key( table, key, length )
+// ---------------------------------------------------------------------------
+//
+// Returns the value stored for key <key> in table <table>  and passes back its
+// length in <length>  unless NULL was passed in for <length>.  Returns NULL if
+// no value is stored for <key>,  if rows are stored for <key>  or if NULL is
+// passed in for <table>.  Returns CTE_PENDING_VALUE with a length of zero if
+// the value for <key> is pending.
+
+const char *cte_table_value_for_key(cte_table_t table,
+                                      kvs_key_t key,
+                                         size_t *length);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_table_escaped_value_for_key( table, key, length, escape )
+// ---------------------------------------------------------------------------
+//
+// Returns the value stored for key <key> in table <table>  exactly like func-
+// tion cte_table_value_for_key()  and passes back its escaping mode in <es-
+// cape>  unless NULL was passed in for <escape>.  The mode of values stored
+// without a mode of their own is CTE_ESCAPE_DEFAULT.
+
+const char *cte_table_escaped_value_for_key(cte_table_t table,
+                                              kvs_key_t key,
+                                                 size_t *length,
+                                           cte_escape_t *escape);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_table_rows_for_key( table, key, count )
+// ---------------------------------------------------------------------------
+//
+// Returns the array of row tables stored for key <key> in table <table>  and
+// passes back the number of rows in <count>  unless NULL was passed in for
+// <count>.  Returns NULL if no rows are stored for <key>,  if a value is stored
+// for <key> or if NULL is passed in for <table>.
+
+const cte_table_t *cte_table_rows_for_key(cte_table_t table,
+                                            kvs_key_t key,
+                                             cardinal *count);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_table_number_of_entries( table )
+// ---------------------------------------------------------------------------
+//
+// Returns  the number of  entries  stored in table <table>,  returns zero if
+// NULL is passed in for <table>.
+
+cardinal cte_table_number_of_entries(cte_table_t table);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_table_reset( table )
+// ---------------------------------------------------------------------------
+//
+// Removes all entries from table <table>  without deallocating its storage,
+// so that the table can be refilled for another render without allocation.
+
+void cte_table_reset(cte_table_t table);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_dispose_table( table )
+// ---------------------------------------------------------------------------
+//
+// Disposes of table object <table>.  Returns NULL.
+
+cte_table_t cte_dispose_table(cte_table_t table);
+
+
+#endif /* CTE_TABLE_H */
+
+// END OF FILE
@@ -0,0 +1,485 @@
+/* C Template Engine
+ *
+ *  @file cte_trace.c
+ *  CTE tracing implementation
+ *
+ *  Optional render tracing with Chrome trace event output
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#define _POSIX_C_SOURCE 199309L /* clock_gettime */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "alloc.h"
+#include "bailout.h"
+#include "cte_trace.h"
+
+
+// ---------------------------------------------------------------------------
+// Range checks
+// ---------------------------------------------------------------------------
+
+#if ((CTE_TRACE_RING_SIZE < 16) || \
+     ((CTE_TRACE_RING_SIZE & (CTE_TRACE_RING_SIZE - 1)) != 0))
+#error CTE_TRACE_RING_SIZE must be a power of two, minimum 16
+#endif
+
+
+#ifdef CTE_WITH_TRACING
+
+// ---------------------------------------------------------------------------
+// Thread local storage class
+// ---------------------------------------------------------------------------
+
+#ifndef CTE_NO_THREADS
+#define CTE_TRACE_THREAD_LOCAL __thread
+#else
+#define CTE_TRACE_THREAD_LOCAL
+#endif
+
+
+// ---------------------------------------------------------------------------
+// Maximum size of a formatted event
+// ---------------------------------------------------------------------------
+
+#define CTE_TRACE_EVENT_TEXT_SIZE (CTE_MAX_PLACEHOLDER_LENGTH + 128)
+
+
+// ---------------------------------------------------------------------------
+// Event phases
+// ---------------------------------------------------------------------------
+
+#define CTE_TRACE_PHASE_BEGIN 'B'
+#define CTE_TRACE_PHASE_END 'E'
+
+
+// ---------------------------------------------------------------------------
+// Event type
+// ---------------------------------------------------------------------------
+//
+// The timestamp is in nanoseconds of the monotonic clock.  The name is only
+// recorded for begin events, it is not terminated.
+
+typedef struct /* cte_trace_event_s */ {
+    uint64_t timestamp;
+     uint8_t kind;
+        char phase;
+     uint8_t length;
+        char name[CTE_MAX_PLACEHOLDER_LENGTH];
+} cte_trace_event_s;
+
+
+// ---------------------------------------------------------------------------
+// Ring buffer type
+// ---------------------------------------------------------------------------
+//
+// A ring buffer is only written by its own thread.  The number of events ever
+// recorded is <head>,  the event with sequence number n is held in slot n mod
+// CTE_TRACE_RING_SIZE.  Events with a sequence number below <start> have been
+// cleared.  Ring buffers are linked into a global list when they are created
+// and are never deallocated.
+
+typedef struct _cte_trace_ring_s *cte_trace_ring_p;
+
+struct _cte_trace_ring_s {
+             cte_trace_ring_p next;
+                     cardinal thread;
+            volatile uint64_t head;
+            volatile uint64_t start;
+            cte_trace_event_s event[CTE_TRACE_RING_SIZE];
+};
+
+typedef struct _cte_trace_ring_s cte_trace_ring_s;
+
+
+// ---------------------------------------------------------------------------
+// Ring buffers of all threads and of the current thread
+// ---------------------------------------------------------------------------
+
+static cte_trace_ring_s *volatile _cte_trace_rings = NULL;
+
+static cardinal _cte_trace_thread_count = 0;
+
+static CTE_TRACE_THREAD_LOCAL cte_trace_ring_s *_cte_trace_ring = NULL;
+
+
+// ---------------------------------------------------------------------------
+// Event kind names
+// ---------------------------------------------------------------------------
+
+static const char *_cte_trace_kind_name[] = {
+    "render", "remainder", "segments", "placeholder", "lookup", "section",
+    "enlargement"
+};
+
+
+// ===========================================================================
+// P R I V A T E   F U N C T I O N   P R O T O T Y P E S
+// ===========================================================================
+
+static cte_trace_ring_s *_new_ring(void);
+
+static fmacro uint64_t _timestamp(void);
+
+static fmacro void _record(cte_trace_ring_s *ring, uint64_t timestamp,
+                         char phase, cte_trace_kind_t kind,
+                         const char *name, cardinal length);
+
+static bool _emit(cte_sink_f sink, void *context,
+                         const char *text, size_t length, size_t *emitted);
+
+#endif /* CTE_WITH_TRACING */
+
+
+// ===========================================================================
+// P U B L I C   F U N C T I O N   I M P L E M E N T A T I O N S
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// function:  cte_trace_begin( kind, name, length )
+// ---------------------------------------------------------------------------
+//
+// Records the beginning of an event of kind <kind>  in the ring buffer of the
+// calling thread.  The event is named by the <length> characters at <name>,
+// of which at most CTE_MAX_PLACEHOLDER_LENGTH are recorded,  or by its kind if
+// <length> is zero.  Does nothing if the library was built without tracing.
+
+void cte_trace_begin(cte_trace_kind_t kind, const char *name, cardinal length) {
+#ifdef CTE_WITH_TRACING
+    cte_trace_ring_s *ring = _cte_trace_ring;
+    
+    // create ring buffer on first event of thread
+    if (ring == NULL) {
+        ring = _new_ring();
+        
+        // bail out if allocation failed
+        if (ring == NULL)
+            return;
+    } // end if
+    
+    _record(ring, _timestamp(), CTE_TRACE_PHASE_BEGIN, kind, name,
+            MIN(length, CTE_MAX_PLACEHOLDER_LENGTH));
+#else
+    (void) kind;
+    (void) name;
+    (void) length;
+#endif
+    return;
+} // end cte_trace_begin
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_trace_end( count )
+// ---------------------------------------------------------------------------
+//
+// Records the end of the <count> innermost events  in the ring buffer of the
+// calling thread.  Does nothing if the library was built without tracing.
+
+void cte_trace_end(cardinal count) {
+#ifdef CTE_WITH_TRACING
+    cte_trace_ring_s *ring = _cte_trace_ring;
+    uint64_t timestamp;
+    
+    // nothing to end if thread has not recorded any event
+    if (ring == NULL)
+        return;
+    
+    timestamp = _timestamp();
+    
+    while (count > 0) {
+        _record(ring, timestamp, CTE_TRACE_PHASE_END, 0, NULL, 0);
+        count--;
+    } // end while
+#else
+    (void) count;
+#endif
+    return;
+} // end cte_trace_end
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_trace_dump( sink, context, status )
+// ---------------------------------------------------------------------------
+//
+// Writes the events recorded by all threads  in Chrome trace event format to
+// sink <sink>,  passing <context> to the sink.  The output is a JSON object
+// that may be loaded into chrome://tracing or Perfetto.  Events may be dumped
+// while other threads are recording,  events overwritten during the dump are
+// left out.  Returns the number of bytes passed to the sink.  The function
+// fails if NULL is passed in for <sink>,  if the sink fails or if the library
+// was built without tracing.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_trace_dump(cte_sink_f sink,
+                      void *context,
+                      cte_trace_status_t *status) {
+#ifdef CTE_WITH_TRACING
+    cte_trace_ring_s *ring;
+    cte_trace_event_s event;
+    char text[CTE_TRACE_EVENT_TEXT_SIZE];
+    uint64_t index, head;
+    size_t emitted = 0;
+    const char *separator = "\n";
+    int length, pid;
+    
+    // bail out if sink is NULL
+    if (sink == NULL) {
+        ASSIGN_BY_REF(status, CTE_TRACE_STATUS_INVALID_SINK);
+        return 0;
+    } // end if
+    
+    if (NOT(_emit(sink, context, "{\"traceEvents\":[", 16, &emitted)))
+        BAILOUT(sink_failed);
+    
+    pid = getpid();
+    __sync_synchronize();
+    ring = _cte_trace_rings;
+    
+    while (ring != NULL) {
+        head = ring->head;
+        __sync_synchronize();
+        
+        // oldest event still held in the ring buffer
+        index = MAX(ring->start,
+                    (head > CTE_TRACE_RING_SIZE) ?
+                    head - CTE_TRACE_RING_SIZE : 0);
+        
+        while (index < head) {
+            event = ring->event[index & (CTE_TRACE_RING_SIZE - 1)];
+            __sync_synchronize();
+            
+            // skip event if its slot has been overwritten while copying
+            if (ring->head >= index + CTE_TRACE_RING_SIZE) {
+                index++;
+                continue;
+            } // end if
+            
+            if (event.phase == CTE_TRACE_PHASE_BEGIN)
+                length = snprintf(text, sizeof(text),
+                    "%s{\"name\":\"%.*s\",\"cat\":\"%s\",\"ph\":\"B\","
+                    "\"ts\":%llu.%03u,\"pid\":%d,\"tid\":%u}", separator,
+                    (event.length > 0) ? (int) event.length :
+                    (int) strlen(_cte_trace_kind_name[event.kind]),
+                    (event.length > 0) ? event.name :
+                    _cte_trace_kind_name[event.kind],
+                    _cte_trace_kind_name[event.kind],
+                    (unsigned long long) (event.timestamp / 1000),
+                    (unsigned) (event.timestamp % 1000), pid, ring->thread);
+            else
+                length = snprintf(text, sizeof(text),
+                    "%s{\"ph\":\"E\",\"ts\":%llu.%03u,\"pid\":%d,\"tid\":%u}",
+                    separator, (unsigned long long) (event.timestamp / 1000),
+                    (unsigned) (event.timestamp % 1000), pid, ring->thread);
+            
+            if (NOT(_emit(sink, context, text, length, &emitted)))
+                BAILOUT(sink_failed);
+            
+            separator = ",\n";
+            index++;
+        } // end while
+        
+        ring = ring->next;
+    } // end while
+    
+    if (NOT(_emit(sink, context, "\n]}\n", 4, &emitted)))
+        BAILOUT(sink_failed);
+    
+    /* NORMAL TERMINATION */
+    
+    ASSIGN_BY_REF(status, CTE_TRACE_STATUS_SUCCESS);
+    return emitted;
+    
+    /* ERROR HANDLING */
+    
+    ON_ERROR(sink_failed) :
+        ASSIGN_BY_REF(status, CTE_TRACE_STATUS_SINK_FAILED);
+        return emitted;
+#else
+    (void) sink;
+    (void) context;
+    
+    ASSIGN_BY_REF(status, CTE_TRACE_STATUS_UNAVAILABLE);
+    return 0;
+#endif
+} // end cte_trace_dump
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_trace_clear()
+// ---------------------------------------------------------------------------
+//
+// Discards the events recorded by all threads so far.  Subsequent dumps only
+// contain events recorded after the call.
+
+void cte_trace_clear(void) {
+#ifdef CTE_WITH_TRACING
+    cte_trace_ring_s *ring;
+    
+    __sync_synchronize();
+    ring = _cte_trace_rings;
+    
+    while (ring != NULL) {
+        ring->start = ring->head;
+        ring = ring->next;
+    } // end while
+#endif
+    return;
+} // end cte_trace_clear
+
+
+#ifdef CTE_WITH_TRACING
+
+// ===========================================================================
+// P R I V A T E   F U N C T I O N   I M P L E M E N T A T I O N S
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// private function:  _new_ring()
+// ---------------------------------------------------------------------------
+//
+// Allocates a ring buffer for the calling thread  and links it into the glo-
+// bal list of ring buffers without locking.  Returns NULL if allocation failed.
+
+static cte_trace_ring_s *_new_ring(void) {
+    cte_trace_ring_s *ring;
+    
+    ring = ALLOCATE(sizeof(cte_trace_ring_s));
+    
+    // bail out if allocation failed
+    if (ring == NULL)
+        return NULL;
+    
+    ring->thread = __sync_add_and_fetch(&_cte_trace_thread_count, 1);
+    ring->head = 0;
+    ring->start = 0;
+    
+    // link ring buffer into global list
+    repeat {
+        ring->next = _cte_trace_rings;
+    } until (__sync_bool_compare_and_swap(&_cte_trace_rings,
+                                          ring->next, ring));
+    
+    _cte_trace_ring = ring;
+    return ring;
+} // _new_ring
+
+
+// ---------------------------------------------------------------------------
+// private function:  _timestamp()
+// ---------------------------------------------------------------------------
+//
+// Returns the time of the monotonic clock in nanoseconds.
+
+static fmacro uint64_t _timestamp(void) {
+    struct timespec now;
+    
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+} // _timestamp
+
+
+// ---------------------------------------------------------------------------
+// private function:
+//  _record( ring, timestamp, phase, kind, name, length )
+// ---------------------------------------------------------------------------
+//
+// Records an event  with timestamp <timestamp>,  phase <phase>,  kind <kind>
+// and the <length> characters at <name> as its name  in ring buffer <ring>,
+// overwriting the oldest event if the ring buffer is full.  The event is
+// published by advancing the head after it has been written.
+
+static fmacro void _record(cte_trace_ring_s *ring,
+                           uint64_t timestamp,
+                           char phase,
+                           cte_trace_kind_t kind,
+                           const char *name,
+                           cardinal length) {
+    
+    cte_trace_event_s *event =
+        &ring->event[ring->head & (CTE_TRACE_RING_SIZE - 1)];
+    
+    event->timestamp = timestamp;
+    event->kind = kind;
+    event->phase = phase;
+    event->length = length;
+    
+    if (length > 0)
+        memcpy(event->name, name, length);
+    
+    __sync_synchronize();
+    ring->head = ring->head + 1;
+    
+    return;
+} // _record
+
+
+// ---------------------------------------------------------------------------
+// private function:  _emit( sink, context, text, length, emitted )
+// ---------------------------------------------------------------------------
+//
+// Passes the <length> characters at <text> to sink <sink>  and adds <length>
+// to the byte count at <emitted>.  Returns false if the sink failed.
+
+static bool _emit(cte_sink_f sink, void *context,
+                  const char *text, size_t length, size_t *emitted) {
+    
+    if (NOT(sink(text, length, context)))
+        return false;
+    
+    *emitted = *emitted + length;
+    
+    return true;
+} // _emit
+
+#endif /* CTE_WITH_TRACING */
+
+
+// END OF FILE
@@ -0,0 +1,189 @@
+/* C Template Engine
+ *
+ *  @file cte_trace.h
+ *  CTE tracing interface
+ *
+ *  Optional render tracing with Chrome trace event output
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#ifndef CTE_TRACE_H
+#define CTE_TRACE_H
+
+
+#include <stddef.h>
+
+#include "CTE.h"
+#include "common.h"
+
+
+// ---------------------------------------------------------------------------
+// Availability
+// ---------------------------------------------------------------------------
+//
+// Tracing is only functional if the library is built with CTE_WITH_TRACING
+// defined.  Otherwise the tracing macros expand to nothing,  no events are
+// recorded and every attempt to dump events fails with status UNAVAILABLE.
+
+
+// ---------------------------------------------------------------------------
+// Ring buffer size, must be a power of two
+// ---------------------------------------------------------------------------
+//
+// Each thread records events into its own ring buffer of this many events.
+// When the buffer is full,  the oldest events are overwritten.
+
+#define CTE_TRACE_RING_SIZE 4096 /* events */
+
+
+// ---------------------------------------------------------------------------
+// Event kinds
+// ---------------------------------------------------------------------------
+//
+// A render event covers the expansion of a template,  a remainder event the
+// expansion of a compiled template from its source past an undefined place-
+// holder,  a segments event a range of segments expanded by a worker thread.
+// A placeholder event covers the expansion of a placeholder's value,  a look-
+// up event the lookup of its value,  a section event the expansion of all rows
+// of a section and an enlargement event the enlargement of a target string.
+
+typedef enum /* cte_trace_kind_t */ {
+    CTE_TRACE_RENDER,
+    CTE_TRACE_REMAINDER,
+    CTE_TRACE_SEGMENTS,
+    CTE_TRACE_PLACEHOLDER,
+    CTE_TRACE_LOOKUP,
+    CTE_TRACE_SECTION,
+    CTE_TRACE_ENLARGEMENT
+} cte_trace_kind_t;
+
+
+// ---------------------------------------------------------------------------
+// Status codes
+// ---------------------------------------------------------------------------
+
+typedef enum /* cte_trace_status_t */ {
+    CTE_TRACE_STATUS_SUCCESS = 1,
+    CTE_TRACE_STATUS_INVALID_SINK,
+    CTE_TRACE_STATUS_SINK_FAILED,
+    CTE_TRACE_STATUS_UNAVAILABLE
+} cte_trace_status_t;
+
+
+// ---------------------------------------------------------------------------
+// Tracing macros
+// ---------------------------------------------------------------------------
+//
+// CTE_TRACE_BEGIN records the beginning of an event of kind <_kind>  named by
+// the <_length> characters at <_name>,  or by its kind if <_length> is zero.
+// CTE_TRACE_END records the end of the <_count> innermost events.  Both expand
+// to nothing unless the library is built with CTE_WITH_TRACING defined.
+
+#ifdef CTE_WITH_TRACING
+#define CTE_TRACE_BEGIN(_kind, _name, _length) \
+    cte_trace_begin(_kind, _name, _length)
+
+#define CTE_TRACE_END(_count) cte_trace_end(_count)
+#else
+#define CTE_TRACE_BEGIN(_kind, _name, _length) ((void) 0)
+
+#define CTE_TRACE_END(_count) ((void) 0)
+#endif
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_trace_begin( kind, name, length )
+// ---------------------------------------------------------------------------
+//
+// Records the beginning of an event of kind <kind>  in the ring buffer of the
+// calling thread.  The event is named by the <length> characters at <name>,
+// of which at most CTE_MAX_PLACEHOLDER_LENGTH are recorded,  or by its kind if
+// <length> is zero.  Does nothing if the library was built without tracing.
+
+void cte_trace_begin(cte_trace_kind_t kind, const char *name, cardinal length);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_trace_end( count )
+// ---------------------------------------------------------------------------
+//
+// Records the end of the <count> innermost events  in the ring buffer of the
+// calling thread.  Does nothing if the library was built without tracing.
+
+void cte_trace_end(cardinal count);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_trace_dump( sink, context, status )
+// ---------------------------------------------------------------------------
+//
+// Writes the events recorded by all threads  in Chrome trace event format to
+// sink <sink>,  passing <context> to the sink.  The output is a JSON object
+// that may be loaded into chrome://tracing or Perfetto.  Events may be dumped
+// while other threads are recording,  events overwritten during the dump are
+// left out.  Returns the number of bytes passed to the sink.  The function
+// fails if NULL is passed in for <sink>,  if the sink fails or if the library
+// was built without tracing.
+//
+// The status of the operation  is passed back in <status>,  unless  NULL  was
+// passed in for <status>.
+
+size_t cte_trace_dump(cte_sink_f sink,
+                            void *context,
+              cte_trace_status_t *status);
+
+
+// ---------------------------------------------------------------------------
+// function:  cte_trace_clear()
+// ---------------------------------------------------------------------------
+//
+// Discards the events recorded by all threads so far.  Subsequent dumps only
+// contain events recorded after the call.
+
+void cte_trace_clear(void);
+
+
+#endif /* CTE_TRACE_H */
+
+// END OF FILE
@@ -0,0 +1,199 @@
+/* C Template Engine
+ *
+ *  @file tests/cte_test.h
+ *  CTE test harness
+ *
+ *  Check macros and helpers shared by the tests
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#ifndef CTE_TEST_H
+#define CTE_TEST_H
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CTE.h"
+#include "hash.h"
+
+
+// ---------------------------------------------------------------------------
+// Exit codes
+// ---------------------------------------------------------------------------
+//
+// A test exits with SKIPPED if the library was built without the feature it
+// tests,  CTest reports such tests as skipped rather than passed.
+
+#define CTE_TEST_EXIT_PASSED 0
+#define CTE_TEST_EXIT_FAILED 1
+#define CTE_TEST_EXIT_SKIPPED 77
+
+
+// ---------------------------------------------------------------------------
+// Failure count of the running test
+// ---------------------------------------------------------------------------
+
+static cardinal cte_test_failures = 0;
+
+
+// ---------------------------------------------------------------------------
+// macro:  CHECK( condition )
+// ---------------------------------------------------------------------------
+//
+// Reports a failure  with the source position and text of <condition>  if
+// <condition> is false.
+
+#define CHECK(_condition) \
+    { if (!(_condition)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", \
+                __FILE__, __LINE__, #_condition); \
+        cte_test_failures++; } }
+
+
+// ---------------------------------------------------------------------------
+// macro:  CHECK_STRING( actual, expected )
+// ---------------------------------------------------------------------------
+//
+// Reports a failure  with the source position  and both strings  if string
+// <actual> is NULL or differs from string <expected>.  Does not deallocate
+// <actual>.
+
+#define CHECK_STRING(_actual, _expected) \
+    { const char *_a = (_actual), *_e = (_expected); \
+      if ((_a == NULL) || (strcmp(_a, _e) != 0)) { \
+        fprintf(stderr, "%s:%d: expected \"%s\", got \"%s\"\n", \
+                __FILE__, __LINE__, _e, (_a != NULL) ? _a : "(null)"); \
+        cte_test_failures++; } }
+
+
+// ---------------------------------------------------------------------------
+// macro:  CHECK_RENDER( result, expected )
+// ---------------------------------------------------------------------------
+//
+// Checks  that dynamically allocated render result <result>  is string <ex-
+// pected> like CHECK_STRING  and  deallocates the result.
+
+#define CHECK_RENDER(_result, _expected) \
+    { char *_r = (_result); \
+      CHECK_STRING(_r, _expected); \
+      free(_r); }
+
+
+// ---------------------------------------------------------------------------
+// macro:  TEST_RESULT()
+// ---------------------------------------------------------------------------
+//
+// Evaluates to the exit code of the running test.
+
+#define TEST_RESULT() \
+    ((cte_test_failures == 0) ? CTE_TEST_EXIT_PASSED : CTE_TEST_EXIT_FAILED)
+
+
+// ---------------------------------------------------------------------------
+// function:  test_key( ident )
+// ---------------------------------------------------------------------------
+//
+// Returns the key the engine calculates for placeholder identifier <ident>.
+
+static inline kvs_key_t test_key(const char *ident) {
+    
+    kvs_key_t key = HASH_INITIAL;
+    
+    while (*ident != '\0') {
+        key = HASH_NEXT_CHAR(key, *ident);
+        ident++;
+    } // end while
+    
+    return HASH_FINAL(key);
+} // end test_key
+
+
+// ---------------------------------------------------------------------------
+// function:  test_store( placeholders, ident, value )
+// ---------------------------------------------------------------------------
+//
+// Stores terminated string <value>  as the value of placeholder <ident>  in
+// placeholder table <placeholders>.  Reports a failure if the store fails.
+
+static inline void test_store(kvs_table_t placeholders,
+                              const char *ident,
+                              const char *value) {
+    
+    kvs_status_t status;
+    
+    kvs_store_value(placeholders, test_key(ident), (kvs_data_t) value,
+                    (cardinal) strlen(value) + 1, true, &status);
+    CHECK(status == KVS_STATUS_SUCCESS);
+    
+    return;
+} // end test_store
+
+
+// ---------------------------------------------------------------------------
+// function:  test_new_placeholders()
+// ---------------------------------------------------------------------------
+//
+// Returns a new empty placeholder table.  Aborts the test if it fails.
+
+static inline kvs_table_t test_new_placeholders(void) {
+    
+    kvs_table_t placeholders;
+    kvs_status_t status;
+    
+    placeholders = kvs_new_table(0, &status);
+    
+    if ((placeholders == NULL) || (status != KVS_STATUS_SUCCESS)) {
+        fprintf(stderr, "placeholder table could not be created\n");
+        exit(CTE_TEST_EXIT_FAILED);
+    } // end if
+    
+    return placeholders;
+} // end test_new_placeholders
+
+
+#endif /* CTE_TEST_H */
+
+// END OF FILE
@@ -0,0 +1,130 @@
+/* C Template Engine
+ *
+ *  @file tests/test_alloc.c
+ *  CTE allocation accounting tests
+ *
+ *  Tests of allocation statistics kept per allocation site
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include "cte_test.h"
+#include "cte_alloc.h"
+
+
+// ---------------------------------------------------------------------------
+// test:  allocation accounting
+// ---------------------------------------------------------------------------
+
+int main(void) {
+    
+    kvs_table_t placeholders = test_new_placeholders();
+    cte_alloc_statistics_t statistics;
+    cte_alloc_site_statistics_t *target;
+    cte_alloc_status_t a_status;
+    cte_status_t status;
+    void *block;
+    
+    target = &statistics.site[CTE_ALLOC_SITE_TARGET];
+    
+#ifdef CTE_WITH_ALLOC_ACCOUNTING
+    // direct calls are counted against their site
+    cte_alloc_reset_statistics();
+    block = cte_alloc_allocate(CTE_ALLOC_SITE_STACK, 100);
+    block = cte_alloc_reallocate(CTE_ALLOC_SITE_STACK, block, 100, 300);
+    
+    cte_alloc_get_statistics(&statistics, &a_status);
+    CHECK(a_status == CTE_ALLOC_STATUS_SUCCESS);
+    CHECK(statistics.site[CTE_ALLOC_SITE_STACK].allocations == 1);
+    CHECK(statistics.site[CTE_ALLOC_SITE_STACK].reallocations == 1);
+    CHECK(statistics.site[CTE_ALLOC_SITE_STACK].current_bytes == 300);
+    CHECK(statistics.site[CTE_ALLOC_SITE_STACK].peak_bytes == 300);
+    CHECK(statistics.current_bytes == 300);
+    
+    cte_alloc_deallocate(CTE_ALLOC_SITE_STACK, block, 300);
+    block = cte_alloc_allocate(CTE_ALLOC_SITE_TARGET, 50);
+    cte_alloc_release(CTE_ALLOC_SITE_TARGET, 50);
+    free(block);
+    
+    cte_alloc_get_statistics(&statistics, &a_status);
+    CHECK(statistics.site[CTE_ALLOC_SITE_STACK].deallocations == 1);
+    CHECK(statistics.site[CTE_ALLOC_SITE_STACK].current_bytes == 0);
+    CHECK((target->allocations == 1) && (target->deallocations == 1));
+    CHECK(target->current_bytes == 0);
+    CHECK(statistics.current_bytes == 0);
+    CHECK(statistics.peak_bytes == 300);
+    
+    // resetting keeps current bytes and lowers peaks to them
+    cte_alloc_reset_statistics();
+    cte_alloc_get_statistics(&statistics, &a_status);
+    CHECK((statistics.peak_bytes == 0) && (target->allocations == 0));
+    
+    // results of renders are released to the caller
+    test_store(placeholders, "name", "World");
+    CHECK_RENDER(cte_string_from_template("Hello @@name@@!", placeholders,
+        &status), "Hello World!");
+    
+    cte_alloc_get_statistics(&statistics, &a_status);
+    CHECK(target->allocations >= 1);
+    CHECK(target->deallocations == target->allocations);
+    CHECK(target->current_bytes == 0);
+    CHECK(target->peak_bytes > 0);
+#else
+    (void) placeholders;
+    (void) status;
+    (void) block;
+    
+    // without accounting no statistics are available
+    cte_alloc_get_statistics(&statistics, &a_status);
+    CHECK(a_status == CTE_ALLOC_STATUS_UNAVAILABLE);
+    CHECK((statistics.peak_bytes == 0) && (target->allocations == 0));
+#endif
+    
+    cte_alloc_get_statistics(NULL, &a_status);
+    CHECK(a_status != CTE_ALLOC_STATUS_SUCCESS);
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
@@ -0,0 +1,177 @@
+/* C Template Engine
+ *
+ *  @file tests/test_budget.c
+ *  CTE budget tests
+ *
+ *  Tests of renders limited in output, expansions and time
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include "cte_test.h"
+
+
+// ---------------------------------------------------------------------------
+// Expansions of the deadline template
+// ---------------------------------------------------------------------------
+
+#define TEST_EXPANSIONS (4 * CTE_DEADLINE_CHECK_INTERVAL)
+
+
+// ---------------------------------------------------------------------------
+// Budget exceeded notification count
+// ---------------------------------------------------------------------------
+
+static cardinal test_exceeded = 0;
+
+
+// ---------------------------------------------------------------------------
+// function:  test_notify( notification, tmplate, index )
+// ---------------------------------------------------------------------------
+
+static void test_notify(cte_notification_t notification,
+                        const char *tmplate,
+                        size_t index) {
+    
+    (void) tmplate;
+    (void) index;
+    
+    if (notification == CTE_NOTIFICATION_BUDGET_EXCEEDED)
+        test_exceeded++;
+    
+    return;
+} // end test_notify
+
+
+// ---------------------------------------------------------------------------
+// test:  render budgets
+// ---------------------------------------------------------------------------
+
+int main(void) {
+    
+    cte_budget_t budget = { 0, 0, 0 };
+    kvs_table_t placeholders;
+    cte_template_t compiled;
+    cte_status_t status;
+    cardinal index;
+    char *tmplate;
+    
+    placeholders = test_new_placeholders();
+    test_store(placeholders, "greeting", "Hello @@name@@");
+    test_store(placeholders, "name", "World");
+    compiled = cte_compile_template("@@greeting@@!", &status);
+    cte_install_notification_handler(test_notify);
+    
+    // zero limits and no budget are unlimited
+    CHECK_RENDER(cte_string_from_template_with_budget("@@greeting@@!",
+        placeholders, &budget, &status), "Hello World!");
+    CHECK(status == CTE_STATUS_SUCCESS);
+    CHECK_RENDER(cte_string_from_compiled_with_budget(compiled,
+        placeholders, NULL, &status), "Hello World!");
+    CHECK(status == CTE_STATUS_SUCCESS);
+    
+    // output may reach the limit but not exceed it
+    budget.max_output = 12;
+    CHECK_RENDER(cte_string_from_template_with_budget("@@greeting@@!",
+        placeholders, &budget, &status), "Hello World!");
+    CHECK_RENDER(cte_string_from_compiled_with_budget(compiled,
+        placeholders, &budget, &status), "Hello World!");
+    
+    budget.max_output = 11;
+    CHECK(cte_string_from_template_with_budget("@@greeting@@!",
+          placeholders, &budget, &status) == NULL);
+    CHECK(status == CTE_STATUS_OUTPUT_LIMIT_EXCEEDED);
+    CHECK(cte_string_from_compiled_with_budget(compiled, placeholders,
+          &budget, &status) == NULL);
+    CHECK(status == CTE_STATUS_OUTPUT_LIMIT_EXCEEDED);
+    CHECK(test_exceeded == 2);
+    
+    // nested values count as expansions
+    budget.max_output = 0;
+    budget.max_expansions = 2;
+    CHECK_RENDER(cte_string_from_compiled_with_budget(compiled,
+        placeholders, &budget, &status), "Hello World!");
+    
+    budget.max_expansions = 1;
+    CHECK(cte_string_from_template_with_budget("@@greeting@@!",
+          placeholders, &budget, &status) == NULL);
+    CHECK(status == CTE_STATUS_EXPANSION_LIMIT_EXCEEDED);
+    CHECK(cte_string_from_compiled_with_budget(compiled, placeholders,
+          &budget, &status) == NULL);
+    CHECK(status == CTE_STATUS_EXPANSION_LIMIT_EXCEEDED);
+    CHECK(test_exceeded == 4);
+    
+    // the deadline is checked at intervals of expansions
+    tmplate = malloc(TEST_EXPANSIONS * 8 + 1);
+    tmplate[0] = '\0';
+    
+    for (index = 0; index < TEST_EXPANSIONS; index++)
+        strcat(tmplate, "@@name@@");
+    
+    budget.max_expansions = 0;
+    budget.time_limit = 1;
+    CHECK(cte_string_from_template_with_budget(tmplate, placeholders,
+          &budget, &status) == NULL);
+    CHECK(status == CTE_STATUS_DEADLINE_EXCEEDED);
+    
+    budget.time_limit = 60000000000ULL;
+    CHECK_RENDER(cte_string_from_template_with_budget("@@name@@",
+        placeholders, &budget, &status), "World");
+    free(tmplate);
+    
+    // invalid arguments
+    CHECK(cte_string_from_template_with_budget(NULL, placeholders, NULL,
+          &status) == NULL);
+    CHECK(status == CTE_STATUS_INVALID_TEMPLATE);
+    CHECK(cte_string_from_compiled_with_budget(NULL, placeholders, NULL,
+          &status) == NULL);
+    CHECK(status == CTE_STATUS_INVALID_TEMPLATE);
+    
+    cte_install_notification_handler(NULL);
+    cte_dispose_template(compiled);
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
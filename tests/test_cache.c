@@ -0,0 +1,135 @@
+/* C Template Engine
+ *
+ *  @file tests/test_cache.c
+ *  CTE output cache tests
+ *
+ *  Tests of caching rendered outputs by template and values
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include "cte_test.h"
+#include "cte_cache.h"
+
+
+// ---------------------------------------------------------------------------
+// test:  output caches
+// ---------------------------------------------------------------------------
+
+int main(void) {
+    
+    kvs_table_t placeholders = test_new_placeholders();
+    cte_template_t compiled, other;
+    cte_output_t first, second;
+    cte_cache_stats_t stats;
+    cte_status_t status;
+    cte_cache_t cache;
+    
+    test_store(placeholders, "a", "<@@b@@>");
+    test_store(placeholders, "b", "beta");
+    
+    cache = cte_new_cache(2, 0, &status);
+    CHECK(cache != NULL);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    
+    compiled = cte_compile_template("A=@@a@@", &status);
+    other = cte_compile_template("B=@@b@@", &status);
+    CHECK(cte_template_identity(compiled) != cte_template_identity(other));
+    
+    // the first render misses,  the second returns the same output
+    first = cte_cache_render(cache, compiled, placeholders, &status);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    CHECK_STRING(cte_output_string(first), "A=<beta>");
+    CHECK(cte_output_length(first) == 8);
+    
+    second = cte_cache_render(cache, compiled, placeholders, &status);
+    CHECK(second == first);
+    cte_release_output(second);
+    
+    cte_cache_get_stats(cache, &stats);
+    CHECK((stats.hits == 1) && (stats.misses == 1) && (stats.entries == 1));
+    
+    // a changed nested value of the same length is not mistaken for a hit
+    test_store(placeholders, "b", "bets");
+    second = cte_cache_render(cache, compiled, placeholders, &status);
+    CHECK(second != first);
+    CHECK_STRING(cte_output_string(second), "A=<bets>");
+    cte_release_output(second);
+    
+    // outputs held by callers survive eviction and clearing
+    cte_release_output(cte_cache_render(cache, other, placeholders, &status));
+    cte_release_output(cte_cache_render(cache, other, placeholders, &status));
+    
+    cte_cache_get_stats(cache, &stats);
+    CHECK((stats.hits == 2) && (stats.misses == 3));
+    CHECK((stats.evictions == 1) && (stats.entries == 2));
+    
+    cte_retain_output(first);
+    cte_cache_clear(cache);
+    cte_cache_get_stats(cache, &stats);
+    CHECK((stats.entries == 0) && (stats.memory == 0));
+    CHECK_STRING(cte_output_string(first), "A=<beta>");
+    CHECK(cte_release_output(first) == NULL);
+    CHECK_STRING(cte_output_string(first), "A=<beta>");
+    CHECK(cte_release_output(first) == NULL);
+    
+    // without a cache the template is expanded every time
+    first = cte_cache_render(NULL, compiled, placeholders, &status);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    CHECK_STRING(cte_output_string(first), "A=<bets>");
+    cte_release_output(first);
+    
+    CHECK(cte_cache_render(cache, NULL, placeholders, &status) == NULL);
+    CHECK(status == CTE_STATUS_INVALID_TEMPLATE);
+    CHECK(cte_output_string(NULL) == NULL);
+    CHECK(cte_output_length(NULL) == 0);
+    
+    CHECK(cte_dispose_cache(cache) == NULL);
+    cte_dispose_template(compiled);
+    cte_dispose_template(other);
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
@@ -0,0 +1,312 @@
+/* C Template Engine
+ *
+ *  @file tests/test_capture.c
+ *  CTE capture tests
+ *
+ *  Tests of capturing renders into a log and replaying the log
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include "cte_test.h"
+#include "cte_capture.h"
+
+#include <unistd.h>
+
+
+// ---------------------------------------------------------------------------
+// Capture logs
+// ---------------------------------------------------------------------------
+//
+// The log of the renders captured is kept in the working directory,  where
+// it is replayed by the replay tool test.
+
+#define TEST_LOG_PATH "test_capture.log"
+#define TEST_TRUNCATED_PATH "test_capture_truncated.log"
+#define TEST_RECORD_COUNT 8
+
+
+#ifdef CTE_WITH_CAPTURE
+// ---------------------------------------------------------------------------
+// function:  test_difference( record, tmplate, captured_size, replayed_size,
+//                             output, context )
+// ---------------------------------------------------------------------------
+//
+// Difference handler that reports the difference  and counts it in <context>.
+
+static void test_difference(cardinal record,
+                            const char *tmplate,
+                            size_t captured_size,
+                            size_t replayed_size,
+                            const char *output,
+                            void *context) {
+    
+    fprintf(stderr, "record %u differs: %s (%zu, %zu bytes): %s\n",
+            record, tmplate, captured_size, replayed_size, output);
+    (*(cardinal *) context)++;
+    
+    return;
+} // end test_difference
+
+
+// ---------------------------------------------------------------------------
+// function:  test_discard( chunk, length, context )
+// ---------------------------------------------------------------------------
+//
+// Sink that accepts and discards all chunks.
+
+static bool test_discard(const char *chunk, size_t length, void *context) {
+    
+    (void) chunk;
+    (void) length;
+    (void) context;
+    
+    return true;
+} // end test_discard
+
+
+// ---------------------------------------------------------------------------
+// function:  test_resolve( ident, key, context )
+// ---------------------------------------------------------------------------
+//
+// Resolver with a value for placeholder name only.
+
+static const char *test_resolve(const char *ident,
+                                kvs_key_t key,
+                                void *context) {
+    
+    (void) key;
+    (void) context;
+    
+    return (strcmp(ident, "name") == 0) ? "Resolved" : NULL;
+} // end test_resolve
+
+
+// ---------------------------------------------------------------------------
+// function:  test_truncate( source, target, removed )
+// ---------------------------------------------------------------------------
+//
+// Copies the file at <source> to <target>  without its last <removed> bytes.
+
+static void test_truncate(const char *source,
+                          const char *target,
+                          size_t removed) {
+    
+    char buffer[4096];
+    FILE *file;
+    size_t length;
+    
+    file = fopen(source, "rb");
+    length = fread(buffer, 1, sizeof(buffer), file);
+    fclose(file);
+    CHECK((length > removed) && (length < sizeof(buffer)));
+    
+    file = fopen(target, "wb");
+    CHECK(fwrite(buffer, 1, length - removed, file) == length - removed);
+    fclose(file);
+    
+    return;
+} // end test_truncate
+
+
+// ---------------------------------------------------------------------------
+// function:  test_capture_replay( placeholders, table, rows )
+// ---------------------------------------------------------------------------
+//
+// Captures renders with values from <placeholders>,  <table> and section
+// table <rows>  and replays the log.
+
+static void test_capture_replay(kvs_table_t placeholders,
+                                cte_table_t table,
+                                cte_table_t rows) {
+    
+    char buffer[CTE_REPLAY_TEXT_SIZE];
+    cte_capture_status_t c_status;
+    cte_replay_report_t report;
+    cte_template_t compiled;
+    cardinal differences = 0;
+    cte_status_t status;
+    size_t length;
+    
+    // renders of every kind are captured,  escaped and section renders not
+    cte_capture_start(TEST_LOG_PATH, 0, &c_status);
+    CHECK(c_status == CTE_CAPTURE_STATUS_SUCCESS);
+    cte_capture_start(TEST_LOG_PATH, 0, &c_status);
+    CHECK(c_status == CTE_CAPTURE_STATUS_ALREADY_ACTIVE);
+    
+    compiled = cte_compile_template("[@@greeting@@ @@missing@@]", &status);
+    
+    CHECK_RENDER(cte_string_from_template("@@greeting@@, @@missing@@!",
+        placeholders, &status), "Hello World, @@missing@@!");
+    CHECK_RENDER(cte_string_from_table("@@greeting@@ @@name@@", table,
+        &status), "Hi table table");
+    cte_render_into(buffer, 8, "into @@greeting@@", placeholders, &status);
+    cte_render_to_sink("sink @@name@@", placeholders, test_discard, NULL, 1,
+                       &status);
+    CHECK_RENDER(cte_string_from_resolver("@@name@@ @@other@@",
+        test_resolve, NULL, &status), "Resolved @@other@@");
+    CHECK_RENDER(cte_string_from_compiled(compiled, placeholders, &status),
+        "[Hello World @@missing@@]");
+    CHECK_RENDER(cte_string_from_compiled_table(compiled, table, &status),
+        "[Hi table @@missing@@]");
+    CHECK_RENDER(cte_string_from_table("@@#r@@ has no rows", table,
+        &status), "@@#r@@ has no rows");
+    
+    CHECK_RENDER(cte_string_from_template_escaped("@@name@@", placeholders,
+        CTE_ESCAPE_HTML, &status), "World");
+    CHECK_RENDER(cte_string_from_table("@@html@@", table, &status),
+        "&lt;b&gt;");
+    CHECK_RENDER(cte_string_from_table("@@#r@@<@@x@@>@@/r@@", rows,
+        &status), "<1>");
+    
+    cte_capture_stop(&c_status);
+    CHECK(c_status == CTE_CAPTURE_STATUS_SUCCESS);
+    cte_capture_stop(&c_status);
+    CHECK(c_status == CTE_CAPTURE_STATUS_NOT_ACTIVE);
+    
+    // the replayed output matches the captured output
+    cte_replay(TEST_LOG_PATH, 3, test_difference, &differences, &report,
+               &c_status);
+    CHECK(c_status == CTE_CAPTURE_STATUS_SUCCESS);
+    CHECK(report.records == TEST_RECORD_COUNT);
+    CHECK(report.renders == 3 * TEST_RECORD_COUNT);
+    CHECK(report.failures == 0);
+    CHECK(report.differences == 0);
+    CHECK(differences == 0);
+    CHECK(report.bytes > 0);
+    CHECK(report.latency_min <= report.latency_p50);
+    CHECK(report.latency_p50 <= report.latency_max);
+    
+    // the report text is truncated like snprintf()
+    length = cte_replay_format(&report, buffer, sizeof(buffer));
+    CHECK((length > 0) && (length == strlen(buffer)));
+    CHECK(strncmp(buffer, "records 8 renders 24 failures 0 differences 0\n",
+                  46) == 0);
+    CHECK(cte_replay_format(&report, buffer, 4) == length);
+    CHECK(strlen(buffer) == 3);
+    CHECK(cte_replay_format(NULL, buffer, sizeof(buffer)) == 0);
+    
+    // records before an invalid record are replayed
+    test_truncate(TEST_LOG_PATH, TEST_TRUNCATED_PATH, 1);
+    cte_replay(TEST_TRUNCATED_PATH, 1, NULL, NULL, &report, &c_status);
+    CHECK(c_status == CTE_CAPTURE_STATUS_INVALID_LOG);
+    CHECK(report.records == TEST_RECORD_COUNT - 1);
+    unlink(TEST_TRUNCATED_PATH);
+    
+    // one in every <interval> renders of a thread is captured
+    cte_capture_start(TEST_TRUNCATED_PATH, 2, &c_status);
+    
+    for (length = 0; length < 5; length++)
+        free(cte_string_from_template("@@name@@", placeholders, &status));
+    
+    cte_capture_stop(&c_status);
+    cte_replay(TEST_TRUNCATED_PATH, 1, NULL, NULL, &report, &c_status);
+    CHECK(c_status == CTE_CAPTURE_STATUS_SUCCESS);
+    CHECK(report.records == 3);
+    unlink(TEST_TRUNCATED_PATH);
+    
+    cte_dispose_template(compiled);
+    
+    return;
+} // end test_capture_replay
+#endif
+
+
+// ---------------------------------------------------------------------------
+// test:  capture and replay
+// ---------------------------------------------------------------------------
+
+int main(void) {
+    
+    cte_capture_status_t c_status;
+    cte_table_t table, row, rows;
+    cte_table_status_t t_status;
+    cte_replay_report_t report;
+    kvs_table_t placeholders;
+    
+    placeholders = test_new_placeholders();
+    test_store(placeholders, "greeting", "Hello @@name@@");
+    test_store(placeholders, "name", "World");
+    
+    table = cte_new_table(0, &t_status);
+    row = cte_new_table(0, &t_status);
+    rows = cte_new_table(0, &t_status);
+    cte_table_store_value(table, "greeting", "Hi @@name@@", 11, &t_status);
+    cte_table_store_value(table, "name", "table", 5, &t_status);
+    cte_table_store_escaped_value(table, "html", "<b>", 3, CTE_ESCAPE_HTML,
+                                  &t_status);
+    cte_table_store_value(row, "x", "1", 1, &t_status);
+    cte_table_store_rows(rows, "r", &row, 1, &t_status);
+    CHECK(t_status == CTE_TABLE_STATUS_SUCCESS);
+    
+#ifndef CTE_WITH_CAPTURE
+    // nothing is captured without capture
+    cte_capture_start(TEST_LOG_PATH, 0, &c_status);
+    CHECK(c_status == CTE_CAPTURE_STATUS_UNAVAILABLE);
+    cte_capture_stop(&c_status);
+    CHECK(c_status != CTE_CAPTURE_STATUS_SUCCESS);
+#else
+    test_capture_replay(placeholders, table, rows);
+#endif
+    
+    // invalid arguments and logs
+    cte_capture_start(NULL, 0, &c_status);
+    CHECK(c_status != CTE_CAPTURE_STATUS_SUCCESS);
+    cte_replay(NULL, 1, NULL, NULL, &report, &c_status);
+    CHECK(c_status == CTE_CAPTURE_STATUS_INVALID_PATH);
+    cte_replay(TEST_LOG_PATH, 1, NULL, NULL, NULL, &c_status);
+    CHECK(c_status == CTE_CAPTURE_STATUS_INVALID_REPORT);
+    cte_replay("no/such/capture.log", 1, NULL, NULL, &report, &c_status);
+    CHECK(c_status == CTE_CAPTURE_STATUS_FILE_FAILED);
+    cte_replay(__FILE__, 1, NULL, NULL, &report, &c_status);
+    CHECK(c_status == CTE_CAPTURE_STATUS_INVALID_LOG);
+    
+    cte_dispose_table(row);
+    cte_dispose_table(rows);
+    cte_dispose_table(table);
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
@@ -0,0 +1,241 @@
+/* C Template Engine
+ *
+ *  @file tests/test_chunked.c
+ *  CTE chunked render tests
+ *
+ *  Tests of renders of templates passed in chunks of arbitrary size
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include "cte_test.h"
+
+
+// ---------------------------------------------------------------------------
+// Templates
+// ---------------------------------------------------------------------------
+
+static const char *test_template[] = {
+    "Hello @@name@@!",
+    "@@greeting@@, @@missing@@ @ @@ @@@@name@@@@",
+    "%% comment line\n<@@name@@>\n%% last line",
+    "\\@@name@@ \\\\@@name@@ \\x",
+    "<@@#r@@[@@x@@ @@name@@]@@/r@@> @@#none@@x@@/none@@",
+    NULL
+}; /* test_template */
+
+
+// ---------------------------------------------------------------------------
+// Collecting sink context
+// ---------------------------------------------------------------------------
+
+#define TEST_OUTPUT_SIZE 1024
+
+typedef struct /* test_output_s */ {
+    char data[TEST_OUTPUT_SIZE];
+    size_t length;
+    bool fail;
+} test_output_s;
+
+
+// ---------------------------------------------------------------------------
+// function:  test_collect( chunk, length, context )
+// ---------------------------------------------------------------------------
+//
+// Sink that appends the chunks to the output in <context>,  or fails if the
+// output is marked to fail.
+
+static bool test_collect(const char *chunk, size_t length, void *context) {
+    
+    test_output_s *output = context;
+    
+    if ((output->fail) || (output->length + length >= TEST_OUTPUT_SIZE))
+        return false;
+    
+    memcpy(output->data + output->length, chunk, length);
+    output->length = output->length + length;
+    output->data[output->length] = '\0';
+    
+    return true;
+} // end test_collect
+
+
+// ---------------------------------------------------------------------------
+// function:  test_feed( render, tmplate, chunk_size, output )
+// ---------------------------------------------------------------------------
+//
+// Feeds template <tmplate> to chunked render <render>  in chunks of <chunk_
+// size> bytes,  finishes and disposes of the render  and reports a failure
+// unless all steps succeed  and the returned size matches <output>.
+
+static void test_feed(cte_chunked_render_t render,
+                      const char *tmplate,
+                      size_t chunk_size,
+                      test_output_s *output) {
+    
+    size_t length = strlen(tmplate), offset, size;
+    cte_status_t status;
+    
+    for (offset = 0; offset < length; offset = offset + size) {
+        size = (length - offset < chunk_size) ? length - offset : chunk_size;
+        cte_chunked_render_feed(render, tmplate + offset, size, &status);
+        CHECK(status == CTE_STATUS_SUCCESS);
+    } // end for
+    
+    CHECK(cte_chunked_render_finish(render, &status) == output->length);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    CHECK(cte_dispose_chunked_render(render) == NULL);
+    
+    return;
+} // end test_feed
+
+
+// ---------------------------------------------------------------------------
+// test:  chunked renders
+// ---------------------------------------------------------------------------
+
+int main(void) {
+    
+    cte_chunked_render_t render;
+    cte_table_status_t t_status;
+    kvs_table_t placeholders;
+    cte_table_t row[2], table;
+    test_output_s output;
+    cte_status_t status;
+    size_t chunk_size;
+    cardinal index;
+    char *expected;
+    
+    placeholders = test_new_placeholders();
+    test_store(placeholders, "greeting", "Hello @@name@@");
+    test_store(placeholders, "name", "World");
+    
+    table = cte_new_table(0, &t_status);
+    row[0] = cte_new_table(0, &t_status);
+    row[1] = cte_new_table(0, &t_status);
+    cte_table_store_value(table, "greeting", "Hello @@name@@", 14, &t_status);
+    cte_table_store_value(table, "name", "World", 5, &t_status);
+    cte_table_store_value(row[0], "x", "A", 1, &t_status);
+    cte_table_store_value(row[1], "x", "B", 1, &t_status);
+    cte_table_store_value(row[1], "name", "row", 3, &t_status);
+    cte_table_store_rows(table, "r", row, 2, &t_status);
+    CHECK(t_status == CTE_TABLE_STATUS_SUCCESS);
+    
+    // any chunking yields the output of the one-shot render,  down to
+    // single bytes that split delimiters,  escapes and comment prefixes
+    for (index = 0; test_template[index] != NULL; index++) {
+        expected = cte_string_from_table(test_template[index], table,
+                                         &status);
+        CHECK(status == CTE_STATUS_SUCCESS);
+        
+        for (chunk_size = 1;
+             chunk_size <= strlen(test_template[index]); chunk_size++) {
+            output.data[0] = '\0';
+            output.length = 0;
+            output.fail = false;
+            render = cte_new_chunked_render_with_table(table, test_collect,
+                                                       &output, &status);
+            test_feed(render, test_template[index], chunk_size, &output);
+            CHECK_STRING(output.data, expected);
+        } // end for
+        
+        free(expected);
+    } // end for
+    
+    CHECK_RENDER(cte_string_from_table(test_template[4], table, &status),
+        "<[A World][B row]> @@#none@@x@@/none@@");
+    
+    // placeholder tables are looked up alike
+    output.length = 0;
+    output.fail = false;
+    render = cte_new_chunked_render(placeholders, test_collect, &output,
+                                    &status);
+    test_feed(render, test_template[1], 1, &output);
+    CHECK_STRING(output.data, "Hello World, @@missing@@ @ @@ @@World@@");
+    
+    // an empty template produces no output
+    output.length = 0;
+    render = cte_new_chunked_render(placeholders, test_collect, &output,
+                                    &status);
+    CHECK(cte_chunked_render_finish(render, &status) == 0);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    
+    // a finished render accepts no further input
+    cte_chunked_render_feed(render, "x", 1, &status);
+    CHECK(status != CTE_STATUS_SUCCESS);
+    cte_chunked_render_finish(render, &status);
+    CHECK(status != CTE_STATUS_SUCCESS);
+    cte_dispose_chunked_render(render);
+    
+    // a failing sink fails the render for good
+    output.length = 0;
+    output.fail = true;
+    render = cte_new_chunked_render(placeholders, test_collect, &output,
+                                    &status);
+    cte_chunked_render_feed(render, "text", 4, &status);
+    cte_chunked_render_finish(render, &status);
+    CHECK(status != CTE_STATUS_SUCCESS);
+    output.fail = false;
+    cte_chunked_render_finish(render, &status);
+    CHECK(status != CTE_STATUS_SUCCESS);
+    cte_dispose_chunked_render(render);
+    
+    // invalid arguments
+    CHECK(cte_new_chunked_render(NULL, test_collect, &output, &status)
+          == NULL);
+    CHECK(status == CTE_STATUS_INVALID_PLACEHOLDERS);
+    CHECK(cte_new_chunked_render_with_table(table, NULL, &output, &status)
+          == NULL);
+    CHECK(status != CTE_STATUS_SUCCESS);
+    cte_chunked_render_feed(NULL, "x", 1, &status);
+    CHECK(status != CTE_STATUS_SUCCESS);
+    
+    cte_dispose_table(row[0]);
+    cte_dispose_table(row[1]);
+    cte_dispose_table(table);
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
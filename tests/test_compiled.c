@@ -0,0 +1,134 @@
+/* C Template Engine
+ *
+ *  @file tests/test_compiled.c
+ *  CTE compiled template tests
+ *
+ *  Tests of compiled templates and placeholder dependency extraction
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include "cte_test.h"
+
+
+// ---------------------------------------------------------------------------
+// Templates
+// ---------------------------------------------------------------------------
+
+#define TEST_TEMPLATE \
+    "%% comment line\n" \
+    "<@@title@@> \\@ @@body@@ @@undefined@@ @@title@@\n"
+
+#define TEST_RESULT_STRING \
+    "\n<The @@name@@ page> @ Text by Ann @@undefined@@ The @@name@@ page\n"
+
+
+// ---------------------------------------------------------------------------
+// test:  compiled templates and placeholder sets
+// ---------------------------------------------------------------------------
+
+int main(void) {
+    
+    kvs_table_t placeholders = test_new_placeholders();
+    cte_placeholder_set_t set;
+    cte_template_t compiled;
+    cte_status_t status;
+    
+    test_store(placeholders, "title", "The \\@@name@@ page");
+    test_store(placeholders, "body", "Text by @@author@@");
+    test_store(placeholders, "author", "Ann");
+    
+    compiled = cte_compile_template(TEST_TEMPLATE, &status);
+    CHECK(compiled != NULL);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    
+    // compiled and source renders agree
+    CHECK_RENDER(cte_string_from_template(TEST_TEMPLATE,
+        placeholders, &status), TEST_RESULT_STRING);
+    CHECK_RENDER(cte_string_from_compiled(compiled,
+        placeholders, &status), TEST_RESULT_STRING);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    
+    // dependencies are followed into defined values in first use order
+    set = cte_placeholders_in_template(TEST_TEMPLATE, placeholders, &status);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    CHECK(cte_placeholder_set_count(set) == 4);
+    CHECK_STRING(cte_placeholder_set_identifier(set, 0), "title");
+    CHECK_STRING(cte_placeholder_set_identifier(set, 1), "body");
+    CHECK_STRING(cte_placeholder_set_identifier(set, 2), "author");
+    CHECK_STRING(cte_placeholder_set_identifier(set, 3), "undefined");
+    CHECK(cte_placeholder_set_key(set, 2) == test_key("author"));
+    CHECK(cte_placeholder_set_identifier(set, 4) == NULL);
+    CHECK(cte_placeholder_set_key(set, 4) == 0);
+    CHECK(cte_dispose_placeholder_set(set) == NULL);
+    
+    // compiled templates yield the same set
+    set = cte_placeholders_in_compiled(compiled, placeholders, &status);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    CHECK(cte_placeholder_set_count(set) == 4);
+    CHECK_STRING(cte_placeholder_set_identifier(set, 2), "author");
+    cte_dispose_placeholder_set(set);
+    
+    // without a table only the template itself is scanned
+    set = cte_placeholders_in_compiled(compiled, NULL, &status);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    CHECK(cte_placeholder_set_count(set) == 3);
+    CHECK_STRING(cte_placeholder_set_identifier(set, 1), "body");
+    cte_dispose_placeholder_set(set);
+    
+    CHECK(cte_placeholder_set_count(NULL) == 0);
+    CHECK(cte_placeholder_set_identifier(NULL, 0) == NULL);
+    
+    CHECK(cte_compile_template(NULL, &status) == NULL);
+    CHECK(status == CTE_STATUS_INVALID_TEMPLATE);
+    
+    CHECK(cte_string_from_compiled(NULL, placeholders, &status) == NULL);
+    CHECK(status != CTE_STATUS_SUCCESS);
+    
+    CHECK(cte_dispose_template(compiled) == NULL);
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
@@ -0,0 +1,197 @@
+/* C Template Engine
+ *
+ *  @file tests/test_diagnostic.c
+ *  CTE diagnostic tests
+ *
+ *  Tests of line, coloumn and nesting information in diagnostics
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include "cte_test.h"
+#include "cte_stack.h"
+
+
+// ---------------------------------------------------------------------------
+// Last diagnostic received
+// ---------------------------------------------------------------------------
+
+typedef struct /* test_received_s */ {
+    cardinal count;
+    long_file_pos_t position;
+    long_file_pos_t template_position;
+    cardinal nesting_level;
+    char names[64];
+} test_received_s;
+
+static test_received_s test_received;
+
+
+// ---------------------------------------------------------------------------
+// function:  test_diagnose( diagnostic )
+// ---------------------------------------------------------------------------
+//
+// Diagnostic handler  that records diagnostics of undefined placeholders  and
+// the names of the placeholders being expanded,  separated by slashes.
+
+static void test_diagnose(const cte_diagnostic_t *diagnostic) {
+    
+    const char *name;
+    cardinal level, length;
+    
+    if (diagnostic->notification != CTE_NOTIFICATION_UNDEFINED_PLACEHOLDER)
+        return;
+    
+    test_received.count++;
+    test_received.position = diagnostic->position;
+    test_received.template_position = diagnostic->template_position;
+    test_received.nesting_level = diagnostic->nesting_level;
+    test_received.names[0] = '\0';
+    
+    for (level = 1; level <= diagnostic->nesting_level; level++) {
+        name = cte_diagnostic_placeholder(diagnostic, level, &length);
+        
+        if (level > 1)
+            strcat(test_received.names, "/");
+        
+        strncat(test_received.names, name, length);
+    } // end for
+    
+    CHECK(cte_diagnostic_placeholder(diagnostic,
+          diagnostic->nesting_level + 1, &length) == NULL);
+    CHECK(cte_diagnostic_placeholder(diagnostic, 0, &length) == NULL);
+    
+    return;
+} // end test_diagnose
+
+
+// ---------------------------------------------------------------------------
+// function:  test_check_received()
+// ---------------------------------------------------------------------------
+//
+// Checks that one diagnostic was received  and that it describes the undefined placeholder in the
+// test template.
+
+static void test_check_received(void) {
+    
+    CHECK(test_received.count == 1);
+    CHECK((test_received.position.line == 2) &&
+          (test_received.position.col == 5));
+    CHECK((test_received.template_position.line == 3) &&
+          (test_received.template_position.col == 3));
+    CHECK(test_received.nesting_level == 2);
+    CHECK_STRING(test_received.names, "outer/inner");
+    
+    test_received.count = 0;
+    
+    return;
+} // end test_check_received
+
+
+// ---------------------------------------------------------------------------
+// test:  diagnostics
+// ---------------------------------------------------------------------------
+
+int main(void) {
+    
+    kvs_table_t placeholders = test_new_placeholders();
+    const char *tmplate = "line one\nline two\n  @@outer@@ end\n";
+    char storage[CTE_STACK_STORAGE_SIZE(1)];
+    char contexts[] = "abc";
+    cte_stack_status_t s_status;
+    cte_template_t compiled;
+    cte_status_t status;
+    size_t length, index;
+    cte_stack_t stack;
+    cardinal position;
+    
+    test_store(placeholders, "outer", "a\nb @@inner@@");
+    test_store(placeholders, "inner", "x\nyyy @@missing@@");
+    
+    cte_install_diagnostic_handler(test_diagnose);
+    
+    // positions are those of the event and of the outermost placeholder
+    free(cte_string_from_template(tmplate, placeholders, &status));
+    test_check_received();
+    
+    compiled = cte_compile_template(tmplate, &status);
+    free(cte_string_from_compiled(compiled, placeholders, &status));
+    test_check_received();
+    cte_dispose_template(compiled);
+    
+    // events in the template itself are at nesting level zero
+    free(cte_string_from_template("\n @@missing@@", placeholders, &status));
+    CHECK(test_received.count == 1);
+    CHECK(test_received.nesting_level == 0);
+    CHECK((test_received.position.line == 2) &&
+          (test_received.position.col == 2));
+    CHECK((test_received.template_position.line == 2) &&
+          (test_received.template_position.col == 2));
+    
+    cte_install_diagnostic_handler(NULL);
+    
+    // contexts above the initial capacity are found in the overflow list
+    stack = cte_new_stack_in_storage(storage, sizeof(storage), &s_status);
+    
+    for (position = 0; position < 3; position++)
+        cte_stack_push_context(stack, contexts + position, position,
+                               position * 2, &s_status);
+    
+    for (position = 0; position < 3; position++) {
+        CHECK(cte_stack_context_at(stack, position, &length, &index,
+              &s_status) == contexts + position);
+        CHECK(s_status == CTE_STACK_STATUS_SUCCESS);
+        CHECK((length == position) && (index == position * 2));
+    } // end for
+    
+    CHECK(cte_stack_context_at(stack, 3, &length, &index, &s_status)
+          == NULL);
+    CHECK(s_status == CTE_STACK_STATUS_INVALID_INDEX);
+    
+    cte_dispose_stack(stack);
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
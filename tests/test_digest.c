@@ -0,0 +1,134 @@
+/* C Template Engine
+ *
+ *  @file tests/test_digest.c
+ *  CTE digest tests
+ *
+ *  Tests of digests computed while rendering
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include "cte_test.h"
+
+
+// ---------------------------------------------------------------------------
+// Both digest kinds
+// ---------------------------------------------------------------------------
+
+#define TEST_KINDS (CTE_DIGEST_XXH64 | CTE_DIGEST_CRC32C)
+
+
+// ---------------------------------------------------------------------------
+// test:  digests
+// ---------------------------------------------------------------------------
+
+int main(void) {
+    
+    kvs_table_t placeholders = test_new_placeholders();
+    cte_digest_t digest, expected;
+    cte_digest_state_t state;
+    cte_template_t compiled;
+    cte_status_t status;
+    char data[100];
+    cardinal index;
+    char *result;
+    
+    // reference values
+    cte_digest_of("", 0, TEST_KINDS, &digest);
+    CHECK(digest.xxh64 == 0xEF46DB3751D8E999ULL);
+    CHECK(digest.crc32c == 0);
+    
+    cte_digest_of("abc", 3, CTE_DIGEST_XXH64, &digest);
+    CHECK(digest.xxh64 == 0x44BC2CF5AD770999ULL);
+    CHECK(digest.crc32c == 0);
+    
+    cte_digest_of("123456789", 9, CTE_DIGEST_CRC32C, &digest);
+    CHECK(digest.crc32c == 0xE3069283);
+    CHECK(digest.xxh64 == 0);
+    
+    // digests do not depend on how the data is split
+    for (index = 0; index < sizeof(data); index++)
+        data[index] = (char) (index * 7);
+    
+    cte_digest_of(data, sizeof(data), TEST_KINDS, &expected);
+    cte_digest_init(&state, TEST_KINDS);
+    
+    for (index = 0; index < sizeof(data); index = index + 3)
+        cte_digest_update(&state, data + index,
+                          (sizeof(data) - index < 3) ?
+                          sizeof(data) - index : 3);
+    
+    cte_digest_final(&state, &digest);
+    CHECK((digest.xxh64 == expected.xxh64) &&
+          (digest.crc32c == expected.crc32c));
+    
+    // renders pass back the digests of their result
+    test_store(placeholders, "a", "a value with @@b@@ nested in it");
+    test_store(placeholders, "b", "another value");
+    
+    result = cte_string_and_digest_from_template("x @@a@@ y @@a@@ z",
+        placeholders, TEST_KINDS, &digest, &status);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    CHECK(result != NULL);
+    cte_digest_of(result, strlen(result), TEST_KINDS, &expected);
+    CHECK((digest.xxh64 == expected.xxh64) &&
+          (digest.crc32c == expected.crc32c));
+    
+    compiled = cte_compile_template("x @@a@@ y @@a@@ z", &status);
+    CHECK_RENDER(cte_string_and_digest_from_compiled(compiled,
+        placeholders, TEST_KINDS, &digest, &status), result);
+    CHECK((digest.xxh64 == expected.xxh64) &&
+          (digest.crc32c == expected.crc32c));
+    free(result);
+    
+    CHECK(cte_string_and_digest_from_compiled(compiled, placeholders,
+          TEST_KINDS, NULL, &status) == NULL);
+    CHECK(status != CTE_STATUS_SUCCESS);
+    
+    cte_dispose_template(compiled);
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
@@ -0,0 +1,192 @@
+/* C Template Engine
+ *
+ *  @file tests/test_escape.c
+ *  CTE escaping tests
+ *
+ *  Tests of escaping kernels and of renders escaping their output
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include "cte_test.h"
+
+
+// ---------------------------------------------------------------------------
+// Collecting sink buffer
+// ---------------------------------------------------------------------------
+
+static char test_output[256];
+static size_t test_output_length = 0;
+
+
+// ---------------------------------------------------------------------------
+// function:  test_collect( chunk, length, context )
+// ---------------------------------------------------------------------------
+
+static bool test_collect(const char *chunk, size_t length, void *context) {
+    
+    (void) context;
+    
+    if (test_output_length + length >= sizeof(test_output))
+        return false;
+    
+    memcpy(test_output + test_output_length, chunk, length);
+    test_output_length = test_output_length + length;
+    test_output[test_output_length] = '\0';
+    
+    return true;
+} // end test_collect
+
+
+// ---------------------------------------------------------------------------
+// test:  escaping
+// ---------------------------------------------------------------------------
+
+int main(void) {
+    
+    kvs_table_t placeholders = test_new_placeholders();
+    const char *html = "<a href=\"x\">&'";
+    char plain[40], buffer[8], sequence[CTE_ESCAPE_MAX_LENGTH];
+    cte_table_status_t t_status;
+    cte_template_t compiled;
+    cte_escape_t escape;
+    cte_syntax_t syntax;
+    cte_status_t status;
+    cte_table_t table;
+    size_t length;
+    
+    // runs are scanned past several vector widths
+    memset(plain, 'a', sizeof(plain));
+    CHECK(cte_escape_scan(CTE_ESCAPE_HTML, plain, sizeof(plain))
+          == sizeof(plain));
+    plain[37] = '<';
+    CHECK(cte_escape_scan(CTE_ESCAPE_HTML, plain, sizeof(plain)) == 37);
+    CHECK(cte_escape_scan(CTE_ESCAPE_JSON, plain, sizeof(plain))
+          == sizeof(plain));
+    
+    CHECK(cte_escape_char(CTE_ESCAPE_JSON, '\001', sequence) == 6);
+    CHECK(strncmp(sequence, "\\u0001", 6) == 0);
+    
+    // each mode escapes its own characters
+    CHECK_RENDER(cte_escaped_string(CTE_ESCAPE_HTML, html, strlen(html),
+        &length), "&lt;a href=&quot;x&quot;&gt;&amp;&#39;");
+    CHECK(length == cte_escaped_length(CTE_ESCAPE_HTML, html, strlen(html)));
+    CHECK_RENDER(cte_escaped_string(CTE_ESCAPE_JSON, "q\"b\\\n\001", 6,
+        NULL), "q\\\"b\\\\\\n\\u0001");
+    CHECK_RENDER(cte_escaped_string(CTE_ESCAPE_URL, "a b/c?d=e&f~-_.Z9",
+        17, NULL), "a%20b%2Fc%3Fd%3De%26f~-_.Z9");
+    
+    // truncation leaves out a sequence that does not fit as a whole
+    CHECK(cte_escape_into(CTE_ESCAPE_HTML, buffer, sizeof(buffer),
+                          "ab<cd", 5) == 8);
+    CHECK_STRING(buffer, "ab&lt;c");
+    CHECK(cte_escape_into(CTE_ESCAPE_HTML, buffer, 5, "ab<cd", 5) == 8);
+    CHECK_STRING(buffer, "ab");
+    
+    // only output originating from values is escaped,  nested values too
+    test_store(placeholders, "v", "<@@w@@>");
+    test_store(placeholders, "w", "&");
+    
+    CHECK_RENDER(cte_string_from_template_escaped("<p>@@v@@</p>",
+        placeholders, CTE_ESCAPE_HTML, &status), "<p>&lt;&amp;&gt;</p>");
+    CHECK(status == CTE_STATUS_SUCCESS);
+    
+    compiled = cte_compile_template("{\"v\":\"@@v@@\"}", &status);
+    CHECK_RENDER(cte_string_from_compiled_escaped(compiled, placeholders,
+        CTE_ESCAPE_URL, &status), "{\"v\":\"%3C%26%3E\"}");
+    
+    test_output_length = 0;
+    CHECK(cte_render_to_sink_escaped("[@@v@@]", placeholders, test_collect,
+          NULL, 0, CTE_ESCAPE_HTML, &status) == 15);
+    CHECK_STRING(test_output, "[&lt;&amp;&gt;]");
+    
+    CHECK(cte_string_from_template_escaped("@@v@@", placeholders,
+          (cte_escape_t) 99, &status) == NULL);
+    CHECK(status == CTE_STATUS_INVALID_SYNTAX);
+    
+    // renders in the default mode escape in the mode of their syntax
+    syntax = cte_new_syntax(NULL, NULL, NULL, &status);
+    cte_syntax_set_escape(syntax, CTE_ESCAPE_URL, &status);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    CHECK_RENDER(cte_string_from_template_with_syntax("?q=@@v@@", syntax,
+        placeholders, &status), "?q=%3C%26%3E");
+    
+    cte_syntax_set_escape(syntax, CTE_ESCAPE_DEFAULT, &status);
+    CHECK(status == CTE_STATUS_INVALID_SYNTAX);
+    cte_dispose_syntax(syntax);
+    
+    // values stored with a mode of their own are escaped in that mode
+    table = cte_new_table(0, &t_status);
+    cte_table_store_value(table, "text", "a<b", 3, &t_status);
+    cte_table_store_escaped_value(table, "raw", "<b>", 3, CTE_ESCAPE_NONE,
+                                  &t_status);
+    CHECK(t_status == CTE_TABLE_STATUS_SUCCESS);
+    cte_table_store_escaped_value(table, "json", "\"<", 2, CTE_ESCAPE_JSON,
+                                  &t_status);
+    
+    CHECK(cte_table_escaped_value_for_key(table, test_key("raw"), &length,
+          &escape) != NULL);
+    CHECK((length == 3) && (escape == CTE_ESCAPE_NONE));
+    cte_table_escaped_value_for_key(table, test_key("text"), NULL, &escape);
+    CHECK(escape == CTE_ESCAPE_DEFAULT);
+    
+    CHECK_RENDER(cte_string_from_table_escaped("@@text@@ @@raw@@ @@json@@",
+        table, CTE_ESCAPE_HTML, &status), "a&lt;b <b> \\\"<");
+    
+    cte_dispose_template(compiled);
+    compiled = cte_compile_template("@@raw@@@@text@@", &status);
+    CHECK_RENDER(cte_string_from_compiled_table_escaped(compiled, table,
+        CTE_ESCAPE_URL, &status), "<b>a%3Cb");
+    
+    cte_table_store_escaped_value(table, "bad", "x", 1, (cte_escape_t) 99,
+                                  &t_status);
+    CHECK(t_status != CTE_TABLE_STATUS_SUCCESS);
+    
+    cte_dispose_template(compiled);
+    cte_dispose_table(table);
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
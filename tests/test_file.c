@@ -0,0 +1,164 @@
+/* C Template Engine
+ *
+ *  @file tests/test_file.c
+ *  CTE file render tests
+ *
+ *  Tests of rendering into regular files and pipes
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include "cte_test.h"
+#include <unistd.h>
+#include <sys/stat.h>
+
+
+// ---------------------------------------------------------------------------
+// Output large enough to be rendered into a mapping
+// ---------------------------------------------------------------------------
+
+#define TEST_VALUE_LENGTH 1000
+#define TEST_REPETITIONS 1000
+
+
+// ---------------------------------------------------------------------------
+// function:  test_read_back( fd, offset, length )
+// ---------------------------------------------------------------------------
+//
+// Returns a new terminated string  with the <length> bytes  at offset <off-
+// set> of the file open with file descriptor <fd>.
+
+static char *test_read_back(int fd, off_t offset, size_t length) {
+    
+    char *data = malloc(length + 1);
+    
+    CHECK(pread(fd, data, length, offset) == (ssize_t) length);
+    data[length] = '\0';
+    
+    return data;
+} // end test_read_back
+
+
+// ---------------------------------------------------------------------------
+// test:  cte_render_to_file() and cte_render_compiled_to_file()
+// ---------------------------------------------------------------------------
+
+int main(void) {
+    
+    kvs_table_t placeholders = test_new_placeholders();
+    char path[] = "/tmp/cte_test_file_XXXXXX";
+    char value[TEST_VALUE_LENGTH + 1];
+    char *tmplate, *expected, *data;
+    cte_template_t compiled;
+    cte_status_t status;
+    size_t size, small;
+    struct stat info;
+    int fd, pipe_fd[2];
+    char buffer[32];
+    cardinal index;
+    
+    memset(value, 'v', TEST_VALUE_LENGTH);
+    value[TEST_VALUE_LENGTH] = '\0';
+    test_store(placeholders, "big", value);
+    test_store(placeholders, "small", "small value");
+    
+    tmplate = malloc(TEST_REPETITIONS * 8 + 1);
+    tmplate[0] = '\0';
+    
+    for (index = 0; index < TEST_REPETITIONS; index++)
+        strcat(tmplate, "@@big@@\n");
+    
+    expected = cte_string_from_template(tmplate, placeholders, &status);
+    
+    fd = mkstemp(path);
+    CHECK(fd >= 0);
+    unlink(path);
+    CHECK(write(fd, "head\n", 5) == 5);
+    
+    // large output is rendered at the current offset,  which is advanced
+    size = cte_render_to_file(fd, tmplate, placeholders, &status);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    CHECK(size == strlen(expected));
+    CHECK(lseek(fd, 0, SEEK_CUR) == (off_t) (5 + size));
+    CHECK((fstat(fd, &info) == 0) && (info.st_size == (off_t) (5 + size)));
+    
+    data = test_read_back(fd, 5, size);
+    CHECK(strcmp(data, expected) == 0);
+    free(data);
+    
+    // small output is appended through a chunk buffer
+    compiled = cte_compile_template("[@@small@@]", &status);
+    small = cte_render_compiled_to_file(fd, compiled, placeholders, &status);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    CHECK(small == 13);
+    
+    data = test_read_back(fd, (off_t) (5 + size), small);
+    CHECK_STRING(data, "[small value]");
+    free(data);
+    
+    CHECK((fstat(fd, &info) == 0) &&
+          (info.st_size == (off_t) (5 + size + small)));
+    close(fd);
+    
+    // files that cannot be mapped are written to
+    CHECK(pipe(pipe_fd) == 0);
+    CHECK(cte_render_compiled_to_file(pipe_fd[1], compiled, placeholders,
+          &status) == 13);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    close(pipe_fd[1]);
+    CHECK(read(pipe_fd[0], buffer, sizeof(buffer)) == 13);
+    CHECK(strncmp(buffer, "[small value]", 13) == 0);
+    close(pipe_fd[0]);
+    
+    CHECK(cte_render_to_file(-1, "x", placeholders, &status) == 0);
+    CHECK(status != CTE_STATUS_SUCCESS);
+    
+    cte_dispose_template(compiled);
+    free(expected);
+    free(tmplate);
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
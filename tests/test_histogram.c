@@ -0,0 +1,252 @@
+/* C Template Engine
+ *
+ *  @file tests/test_histogram.c
+ *  CTE histogram tests
+ *
+ *  Tests of render latency and output size histograms
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include "cte_test.h"
+#include "cte_histogram.h"
+
+#ifndef CTE_NO_THREADS
+#include <pthread.h>
+#endif
+
+
+// ---------------------------------------------------------------------------
+// Recording threads and renders
+// ---------------------------------------------------------------------------
+
+#define TEST_THREAD_COUNT 4
+#define TEST_RECORD_COUNT 1000
+
+
+// ---------------------------------------------------------------------------
+// Snapshot,  too large to be held on the stack
+// ---------------------------------------------------------------------------
+
+static cte_histogram_snapshot_t test_snapshot;
+
+
+// ---------------------------------------------------------------------------
+// function:  test_collect( chunk, length, context )
+// ---------------------------------------------------------------------------
+//
+// Sink that appends the chunks to the terminated string buffer at <context>.
+
+static bool test_collect(const char *chunk, size_t length, void *context) {
+    
+    strncat(context, chunk, length);
+    
+    return true;
+} // end test_collect
+
+
+#ifdef CTE_WITH_HISTOGRAMS
+// ---------------------------------------------------------------------------
+// function:  test_record( set )
+// ---------------------------------------------------------------------------
+//
+// Records latencies from one to the record count into histogram set <set>,
+// each with an output size of ten bytes.
+
+static void *test_record(void *set) {
+    
+    uint64_t value;
+    
+    for (value = 1; value <= TEST_RECORD_COUNT; value++)
+        cte_histogram_record(set, value, 10);
+    
+    return NULL;
+} // end test_record
+
+
+// ---------------------------------------------------------------------------
+// function:  test_histogram_set()
+// ---------------------------------------------------------------------------
+//
+// Records into a histogram set from several threads  and checks the merged
+// snapshot,  its percentiles and its text dump.
+
+static void test_histogram_set(void) {
+    
+    cte_histogram_status_t h_status;
+    char text[CTE_HISTOGRAM_TEXT_SIZE];
+    cte_histogram_set_t set;
+    uint64_t value;
+    cardinal index;
+    size_t length;
+#ifndef CTE_NO_THREADS
+    pthread_t thread[TEST_THREAD_COUNT];
+#endif
+    
+    // histograms of all threads are merged
+    set = cte_new_histogram_set(&h_status);
+    CHECK(h_status == CTE_HISTOGRAM_STATUS_SUCCESS);
+    
+#ifndef CTE_NO_THREADS
+    for (index = 0; index < TEST_THREAD_COUNT; index++)
+        pthread_create(&thread[index], NULL, test_record, set);
+    
+    for (index = 0; index < TEST_THREAD_COUNT; index++)
+        pthread_join(thread[index], NULL);
+#else
+    for (index = 0; index < TEST_THREAD_COUNT; index++)
+        test_record(set);
+#endif
+    
+    cte_histogram_snapshot(set, &test_snapshot, &h_status);
+    CHECK(h_status == CTE_HISTOGRAM_STATUS_SUCCESS);
+    CHECK(test_snapshot.latency.count ==
+          TEST_THREAD_COUNT * TEST_RECORD_COUNT);
+    CHECK(test_snapshot.latency.sum == TEST_THREAD_COUNT *
+          (uint64_t) TEST_RECORD_COUNT * (TEST_RECORD_COUNT + 1) / 2);
+    CHECK(test_snapshot.latency.min == 1);
+    CHECK(test_snapshot.latency.max == TEST_RECORD_COUNT);
+    CHECK((test_snapshot.size.min == 10) && (test_snapshot.size.max == 10));
+    
+    // percentiles are exact for small values  and within 1/16 above them
+    CHECK(cte_histogram_value_at(&test_snapshot.latency, 0.0) == 1);
+    CHECK(cte_histogram_value_at(&test_snapshot.latency, 1.0) == 10);
+    CHECK(cte_histogram_value_at(&test_snapshot.latency, 100.0)
+          == TEST_RECORD_COUNT);
+    value = cte_histogram_value_at(&test_snapshot.latency, 50.0);
+    CHECK((value >= 500) && (value < 500 + 500 / 16));
+    CHECK(cte_histogram_value_at(&test_snapshot.size, 99.9) == 10);
+    CHECK(cte_histogram_value_at(NULL, 50.0) == 0);
+    
+    // the text dump is truncated like snprintf()
+    length = cte_histogram_format(&test_snapshot, text, sizeof(text));
+    CHECK((length > 0) && (length == strlen(text)));
+    CHECK(strncmp(text, "renders 4000\nlatency_ns min 1 p50 ", 34) == 0);
+    CHECK(strstr(text, "\nsize_bytes min 10 p50 10 ") != NULL);
+    CHECK(cte_histogram_format(&test_snapshot, text, 8) == length);
+    CHECK_STRING(text, "renders");
+    CHECK(cte_histogram_format(&test_snapshot, NULL, 0) == length);
+    CHECK(cte_histogram_format(NULL, text, sizeof(text)) == 0);
+    
+    CHECK(cte_dispose_histogram_set(set) == NULL);
+    
+    return;
+} // end test_histogram_set
+#endif
+
+
+// ---------------------------------------------------------------------------
+// test:  histograms
+// ---------------------------------------------------------------------------
+
+int main(void) {
+    
+    char text[CTE_HISTOGRAM_TEXT_SIZE];
+    kvs_table_t placeholders;
+    cte_template_t compiled;
+    cte_status_t status;
+    cardinal index;
+#ifdef CTE_WITH_HISTOGRAMS
+    size_t length;
+#else
+    cte_histogram_status_t h_status;
+#endif
+    
+    placeholders = test_new_placeholders();
+    test_store(placeholders, "name", "World");
+    compiled = cte_compile_template("Hello @@name@@!", &status);
+    
+    for (index = 0; index < 3; index++)
+        CHECK_RENDER(cte_string_from_compiled(compiled, placeholders,
+            &status), "Hello World!");
+    
+    text[0] = '\0';
+    
+#ifndef CTE_WITH_HISTOGRAMS
+    // nothing is recorded without histograms
+    CHECK(cte_new_histogram_set(&h_status) == NULL);
+    CHECK(h_status == CTE_HISTOGRAM_STATUS_UNAVAILABLE);
+    
+    cte_histogram_snapshot(NULL, &test_snapshot, &h_status);
+    CHECK(h_status != CTE_HISTOGRAM_STATUS_SUCCESS);
+    CHECK(test_snapshot.latency.count == 0);
+    
+    cte_template_histograms(compiled, &test_snapshot, &status);
+    CHECK(status == CTE_STATUS_UNAVAILABLE);
+    CHECK(test_snapshot.size.count == 0);
+    
+    CHECK(cte_template_histograms_dump(compiled, test_collect, text,
+                                       &status) == 0);
+    CHECK(status == CTE_STATUS_UNAVAILABLE);
+#else
+    test_histogram_set();
+    
+    // successful renders of compiled templates are recorded
+    cte_template_histograms(compiled, &test_snapshot, &status);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    CHECK(test_snapshot.latency.count == 3);
+    CHECK(test_snapshot.size.count == 3);
+    CHECK((test_snapshot.size.min == 12) && (test_snapshot.size.max == 12));
+    
+    length = cte_template_histograms_dump(compiled, test_collect, text,
+                                          &status);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    CHECK((length > 0) && (length == strlen(text)));
+    CHECK(strncmp(text, "renders 3\n", 10) == 0);
+#endif
+    
+    // invalid arguments
+    cte_template_histograms(NULL, &test_snapshot, &status);
+    CHECK(status == CTE_STATUS_INVALID_TEMPLATE);
+    cte_template_histograms(compiled, NULL, &status);
+    CHECK(status == CTE_STATUS_INVALID_TARGET);
+    CHECK(cte_template_histograms_dump(compiled, NULL, NULL, &status) == 0);
+    CHECK(status == CTE_STATUS_INVALID_TARGET);
+    
+    cte_dispose_template(compiled);
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
@@ -0,0 +1,189 @@
+/* C Template Engine
+ *
+ *  @file tests/test_large.c
+ *  CTE large output tests
+ *
+ *  Tests of expansions and values larger than 4 GB
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include "cte_test.h"
+#include <stdint.h>
+
+#ifndef CTE_NO_MMAP
+#include <sys/mman.h>
+#endif
+
+
+// ---------------------------------------------------------------------------
+// Sizes
+// ---------------------------------------------------------------------------
+//
+// The expansion repeats a 1 MB value often enough to exceed 4 GB,  the large
+// value exceeds 4 GB by itself.  The large value is mapped but never read,  it
+// occupies no memory.
+
+#define TEST_VALUE_SIZE (1024 * 1024)
+#define TEST_REPEAT_COUNT 4100
+#define TEST_LARGE_VALUE_SIZE (((size_t) 1 << 32) + 3)
+
+
+// ---------------------------------------------------------------------------
+// Counting sink context
+// ---------------------------------------------------------------------------
+
+typedef struct /* test_count_s */ {
+    size_t bytes;
+    size_t mismatches;
+} test_count_s;
+
+
+// ---------------------------------------------------------------------------
+// function:  test_count( chunk, length, context )
+// ---------------------------------------------------------------------------
+//
+// Sink that counts the bytes passed to it  and the chunks that do not start
+// and end with the repeated value byte,  in <context>.
+
+static bool test_count(const char *chunk, size_t length, void *context) {
+    
+    test_count_s *count = context;
+    
+    if ((length == 0) || (chunk[0] != 'v') || (chunk[length - 1] != 'v'))
+        count->mismatches++;
+    
+    count->bytes = count->bytes + length;
+    
+    return true;
+} // end test_count
+
+
+#ifndef CTE_NO_MMAP
+// ---------------------------------------------------------------------------
+// function:  test_large_value()
+// ---------------------------------------------------------------------------
+//
+// Stores and looks up a value larger than 4 GB in a placeholder table.
+
+static void test_large_value(void) {
+    
+    cte_table_status_t t_status;
+    cte_table_t table;
+    size_t length;
+    char *large;
+    
+    large = mmap(NULL, TEST_LARGE_VALUE_SIZE, PROT_READ,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    
+    // bail out if the address space is too small
+    if (large == MAP_FAILED)
+        return;
+    
+    table = cte_new_table(0, &t_status);
+    cte_table_store_value(table, "large", large, TEST_LARGE_VALUE_SIZE,
+                          &t_status);
+    CHECK(t_status == CTE_TABLE_STATUS_SUCCESS);
+    CHECK(cte_table_value_for_key(table, test_key("large"), &length)
+          == large);
+    CHECK(length == TEST_LARGE_VALUE_SIZE);
+    
+    cte_dispose_table(table);
+    munmap(large, TEST_LARGE_VALUE_SIZE);
+    
+    return;
+} // end test_large_value
+#endif
+
+
+// ---------------------------------------------------------------------------
+// test:  expansions larger than 4 GB
+// ---------------------------------------------------------------------------
+
+int main(void) {
+    
+    test_count_s count = { 0, 0 };
+    kvs_table_t placeholders;
+    char *value, *tmplate;
+    cte_status_t status;
+    cardinal index;
+    size_t length;
+    
+    // lengths are only limited by the address space
+    if (SIZE_MAX <= UINT32_MAX)
+        return CTE_TEST_EXIT_SKIPPED;
+    
+    value = malloc(TEST_VALUE_SIZE + 1);
+    memset(value, 'v', TEST_VALUE_SIZE);
+    value[TEST_VALUE_SIZE] = '\0';
+    
+    tmplate = malloc(TEST_REPEAT_COUNT * 5 + 1);
+    
+    for (index = 0; index < TEST_REPEAT_COUNT; index++)
+        memcpy(tmplate + index * 5, "@@v@@", 5);
+    
+    tmplate[TEST_REPEAT_COUNT * 5] = '\0';
+    
+    // the size passed back counts every byte passed to the sink
+    placeholders = test_new_placeholders();
+    test_store(placeholders, "v", value);
+    length = cte_render_to_sink(tmplate, placeholders, test_count, &count,
+                                0, &status);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    CHECK(length == (size_t) TEST_REPEAT_COUNT * TEST_VALUE_SIZE);
+    CHECK(length > UINT32_MAX);
+    CHECK(count.bytes == length);
+    CHECK(count.mismatches == 0);
+    
+    free(tmplate);
+    free(value);
+    
+#ifndef CTE_NO_MMAP
+    test_large_value();
+#endif
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
@@ -0,0 +1,109 @@
+/* C Template Engine
+ *
+ *  @file tests/test_literal.cpp
+ *  CTE literal template tests
+ *
+ *  Tests of C++20 string literal templates parsed at compile time
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include <string>
+
+#include "cte_literal.hpp"
+#include "cte_test.h"
+
+
+// ---------------------------------------------------------------------------
+// Literal templates
+// ---------------------------------------------------------------------------
+
+#define TEST_SOURCE \
+    "%% comment\n<@@title@@> \\@ @@body@@ @@title@@\\\\"
+
+using test_page = cte::literal<TEST_SOURCE>;
+
+static_assert(test_page::placeholder_count() == 2);
+static_assert(test_page::placeholder(0) == "title");
+static_assert(test_page::placeholder(1) == "body");
+static_assert(test_page::has_placeholder("body"));
+static_assert(!test_page::has_placeholder("other"));
+
+static_assert(cte::literal<"no placeholders">::placeholder_count() == 0);
+
+
+// ---------------------------------------------------------------------------
+// test:  cte::literal
+// ---------------------------------------------------------------------------
+
+int main() {
+    
+    kvs_table_t placeholders = test_new_placeholders();
+    cte_status_t status;
+    std::string result;
+    
+    test_store(placeholders, "title", "Title");
+    test_store(placeholders, "body", "Body");
+    
+    // literal renders agree with the engine for values without placeholders
+    result = test_page::render(cte::value<"body">("Body"),
+                               cte::value<"title">("Title"));
+    CHECK_RENDER(cte_string_from_template(TEST_SOURCE, placeholders,
+        &status), result.c_str());
+    CHECK(status == CTE_STATUS_SUCCESS);
+    
+    // values are inserted as they are
+    result = cte::literal<"[@@v@@]">::render(cte::value<"v">("@@v@@"));
+    CHECK_STRING(result.c_str(), "[@@v@@]");
+    
+    // results are appended to existing strings
+    result = "head ";
+    cte::literal<"@@a@@-@@b@@">::append_to(result,
+        cte::value<"a">("1"), cte::value<"b">("2"));
+    CHECK_STRING(result.c_str(), "head 1-2");
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
@@ -0,0 +1,224 @@
+/* C Template Engine
+ *
+ *  @file tests/test_metrics.c
+ *  CTE metrics tests
+ *
+ *  Tests of engine event counters and their export
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include "cte_test.h"
+#include "cte_metrics.h"
+
+#ifndef CTE_NO_THREADS
+#include <pthread.h>
+#endif
+
+
+// ---------------------------------------------------------------------------
+// Export buffer size
+// ---------------------------------------------------------------------------
+
+#define TEST_EXPORT_SIZE 4096
+
+
+#ifdef CTE_WITH_METRICS
+// ---------------------------------------------------------------------------
+// function:  test_count( context )
+// ---------------------------------------------------------------------------
+//
+// Counts three cache hits  and an allocation failure  on the calling thread.
+
+static void *test_count(void *context) {
+    
+    (void) context;
+    
+    cte_metrics_add(CTE_METRIC_CACHE_HITS, 3);
+    cte_metrics_notify(CTE_NOTIFICATION_STACK_ALLOCATION_FAILED);
+    
+    return NULL;
+} // end test_count
+
+
+// ---------------------------------------------------------------------------
+// function:  test_delta( before, after, metric )
+// ---------------------------------------------------------------------------
+//
+// Returns the increase of the counter of <metric> from <before> to <after>.
+
+static uint64_t test_delta(const cte_metrics_t *before,
+                           const cte_metrics_t *after,
+                           cte_metric_t metric) {
+    
+    return after->counter[metric] - before->counter[metric];
+} // end test_delta
+
+
+// ---------------------------------------------------------------------------
+// function:  test_counting( placeholders )
+// ---------------------------------------------------------------------------
+//
+// Renders with values from <placeholders>  and checks the events counted and
+// their export.
+
+static void test_counting(kvs_table_t placeholders) {
+    
+    cte_metrics_status_t m_status;
+    cte_metrics_t before, after;
+    char text[TEST_EXPORT_SIZE];
+    cte_status_t status;
+    size_t length;
+#ifndef CTE_NO_THREADS
+    pthread_t thread;
+#endif
+    
+    // renders count their events once,  sizing passes are not counted
+    cte_metrics_get(&before, &m_status);
+    CHECK(m_status == CTE_METRICS_STATUS_SUCCESS);
+    
+    CHECK_RENDER(cte_string_from_template("Hello @@name@@ @@missing@@",
+        placeholders, &status), "Hello World @@missing@@");
+    
+    cte_metrics_get(&after, &m_status);
+    CHECK(test_delta(&before, &after, CTE_METRIC_RENDERS) == 1);
+    CHECK(test_delta(&before, &after, CTE_METRIC_BYTES_OUT) == 23);
+    CHECK(test_delta(&before, &after, CTE_METRIC_PLACEHOLDERS_EXPANDED)
+          == 1);
+    CHECK(test_delta(&before, &after, CTE_METRIC_UNDEFINED_PLACEHOLDERS)
+          == 1);
+    
+    // failed renders count their failure but not a render
+    before = after;
+    CHECK(cte_string_from_template("@@loop@@", placeholders, &status)
+          == NULL);
+    CHECK(status == CTE_STATUS_NESTING_LIMIT_EXCEEDED);
+    
+    cte_metrics_get(&after, &m_status);
+    CHECK(test_delta(&before, &after, CTE_METRIC_NESTING_LIMIT_FAILURES)
+          == 1);
+    CHECK(test_delta(&before, &after, CTE_METRIC_RENDERS) == 0);
+    
+    // counters of threads that have ended are kept
+    before = after;
+#ifndef CTE_NO_THREADS
+    pthread_create(&thread, NULL, test_count, NULL);
+    pthread_join(thread, NULL);
+#else
+    test_count(NULL);
+#endif
+    cte_metrics_notify(CTE_NOTIFICATION_BUDGET_EXCEEDED);
+    cte_metrics_notify(CTE_NOTIFICATION_TARGET_SIZE_INFO);
+    
+    cte_metrics_get(&after, &m_status);
+    CHECK(test_delta(&before, &after, CTE_METRIC_CACHE_HITS) == 3);
+    CHECK(test_delta(&before, &after, CTE_METRIC_ALLOCATION_FAILURES) == 1);
+    CHECK(test_delta(&before, &after, CTE_METRIC_BUDGET_FAILURES) == 1);
+    CHECK(test_delta(&before, &after, CTE_METRIC_RENDERS) == 0);
+    
+    // the export determines its size first
+    length = cte_metrics_export(NULL, 0, &m_status);
+    CHECK((length > 0) && (length < sizeof(text)));
+    CHECK(m_status == CTE_METRICS_STATUS_BUFFER_TOO_SMALL);
+    
+    CHECK(cte_metrics_export(text, length + 1, &m_status) == length);
+    CHECK(m_status == CTE_METRICS_STATUS_SUCCESS);
+    CHECK(strlen(text) == length);
+    CHECK(strncmp(text, "# HELP cte_renders_total ", 25) == 0);
+    CHECK(strstr(text, "\n# TYPE cte_budget_failures_total counter\n"
+                       "cte_budget_failures_total ") != NULL);
+    
+    CHECK(cte_metrics_export(text, length, &m_status) == length);
+    CHECK(m_status == CTE_METRICS_STATUS_BUFFER_TOO_SMALL);
+    CHECK_STRING(text, "");
+    
+    return;
+} // end test_counting
+#endif
+
+
+// ---------------------------------------------------------------------------
+// test:  metrics
+// ---------------------------------------------------------------------------
+
+int main(void) {
+    
+    cte_metrics_status_t m_status;
+    char text[TEST_EXPORT_SIZE];
+    kvs_table_t placeholders;
+#ifndef CTE_WITH_METRICS
+    cte_metrics_t after;
+    cardinal index;
+    size_t length;
+#endif
+    
+    placeholders = test_new_placeholders();
+    test_store(placeholders, "name", "World");
+    test_store(placeholders, "loop", "@@loop@@");
+    
+#ifndef CTE_WITH_METRICS
+    // nothing is counted without metrics
+    cte_metrics_add(CTE_METRIC_RENDERS, 1);
+    cte_metrics_get(&after, &m_status);
+    CHECK(m_status == CTE_METRICS_STATUS_UNAVAILABLE);
+    
+    for (index = 0; index < CTE_METRIC_COUNT; index++)
+        CHECK(after.counter[index] == 0);
+    
+    length = cte_metrics_export(text, sizeof(text), &m_status);
+    CHECK((length == 0) && (m_status == CTE_METRICS_STATUS_UNAVAILABLE));
+#else
+    test_counting(placeholders);
+#endif
+    
+    // invalid arguments
+    cte_metrics_get(NULL, &m_status);
+    CHECK(m_status != CTE_METRICS_STATUS_SUCCESS);
+    CHECK(cte_metrics_export(NULL, sizeof(text), &m_status) == 0);
+    CHECK(m_status != CTE_METRICS_STATUS_SUCCESS);
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
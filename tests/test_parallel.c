@@ -0,0 +1,154 @@
+/* C Template Engine
+ *
+ *  @file tests/test_parallel.c
+ *  CTE parallel render tests
+ *
+ *  Tests of rendering compiled templates on multiple threads
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include "cte_test.h"
+
+
+// ---------------------------------------------------------------------------
+// Number of template lines
+// ---------------------------------------------------------------------------
+
+#define TEST_LINES 5000
+
+
+// ---------------------------------------------------------------------------
+// Undefined placeholder notification count
+// ---------------------------------------------------------------------------
+
+static volatile cardinal test_undefined = 0;
+
+
+// ---------------------------------------------------------------------------
+// function:  test_notify( notification, tmplate, index )
+// ---------------------------------------------------------------------------
+//
+// Notification handler  that counts undefined placeholders,  it may be called
+// from several threads at once.
+
+static void test_notify(cte_notification_t notification,
+                        const char *tmplate,
+                        size_t index) {
+    
+    (void) tmplate;
+    (void) index;
+    
+    if (notification == CTE_NOTIFICATION_UNDEFINED_PLACEHOLDER)
+        __sync_fetch_and_add(&test_undefined, 1);
+    
+    return;
+} // end test_notify
+
+
+// ---------------------------------------------------------------------------
+// test:  cte_string_from_compiled_parallel()
+// ---------------------------------------------------------------------------
+
+int main(void) {
+    
+    kvs_table_t placeholders = test_new_placeholders();
+    cardinal threads[] = { 1, 2, 4, 0 };
+    char *tmplate, *expected, *result;
+    cte_template_t compiled;
+    cardinal line, index, undefined;
+    cte_status_t status;
+    size_t length;
+    
+    test_store(placeholders, "a", "alpha @@b@@");
+    test_store(placeholders, "b", "beta");
+    
+    // many lines of different expanded size,  one undefined placeholder
+    tmplate = malloc(TEST_LINES * 32);
+    length = 0;
+    
+    for (line = 0; line < TEST_LINES; line++) {
+        if (line == TEST_LINES / 2)
+            length += sprintf(tmplate + length, "@@undefined@@\n");
+        else if ((line % 3) == 0)
+            length += sprintf(tmplate + length, "%u @@a@@ @@b@@\n", line);
+        else
+            length += sprintf(tmplate + length, "%u @@b@@\n", line);
+    } // end for
+    
+    compiled = cte_compile_template(tmplate, &status);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    
+    cte_install_notification_handler(test_notify);
+    
+    expected = cte_string_from_compiled(compiled, placeholders, &status);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    undefined = test_undefined;
+    CHECK(undefined == 1);
+    
+    // any number of threads yields the same result and notifications
+    for (index = 0; index < sizeof(threads) / sizeof(threads[0]); index++) {
+        test_undefined = 0;
+        result = cte_string_from_compiled_parallel(compiled, placeholders,
+                                                   threads[index], &status);
+        CHECK(status == CTE_STATUS_SUCCESS);
+        CHECK_STRING(result, expected);
+        CHECK(test_undefined == undefined);
+        free(result);
+    } // end for
+    
+    cte_install_notification_handler(NULL);
+    
+    CHECK(cte_string_from_compiled_parallel(compiled, NULL, 2, &status)
+          == NULL);
+    CHECK(status == CTE_STATUS_INVALID_PLACEHOLDERS);
+    
+    free(expected);
+    free(tmplate);
+    cte_dispose_template(compiled);
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
@@ -0,0 +1,193 @@
+/* C Template Engine
+ *
+ *  @file tests/test_pending.c
+ *  CTE pending value tests
+ *
+ *  Tests of resuming step renders at values that are completed later
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include "cte_test.h"
+
+
+// ---------------------------------------------------------------------------
+// function:  test_step( state, expected, pending )
+// ---------------------------------------------------------------------------
+//
+// Steps render state <state> once  and reports a failure  unless the output
+// is <expected>  and the step stopped at pending placeholder <pending>,  or
+// did not stop at a pending value if NULL is passed in for <pending>.
+
+static void test_step(cte_render_state_t state,
+                      const char *expected,
+                      const char *pending) {
+    
+    const char *ident;
+    cte_status_t status;
+    cardinal length;
+    char buffer[64];
+    size_t written;
+    
+    written = cte_render_step(state, buffer, sizeof(buffer) - 1, &status);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    buffer[written] = '\0';
+    CHECK_STRING(buffer, expected);
+    
+    ident = cte_render_state_pending(state, &length);
+    
+    if (pending == NULL) {
+        CHECK(ident == NULL);
+    }
+    else {
+        CHECK((ident != NULL) && (length == strlen(pending)) &&
+              (strncmp(ident, pending, length) == 0));
+    } // end if
+    
+    return;
+} // end test_step
+
+
+// ---------------------------------------------------------------------------
+// function:  test_resolve( ident, key, context )
+// ---------------------------------------------------------------------------
+//
+// Resolver whose value for placeholder late is pending  until the boolean at
+// <context> is set.
+
+static const char *test_resolve(const char *ident,
+                                kvs_key_t key,
+                                void *context) {
+    
+    (void) key;
+    
+    if (strcmp(ident, "late") != 0)
+        return NULL;
+    else if (*(bool *) context)
+        return "on time";
+    
+    return CTE_PENDING_VALUE;
+} // end test_resolve
+
+
+// ---------------------------------------------------------------------------
+// test:  pending values
+// ---------------------------------------------------------------------------
+
+int main(void) {
+    
+    cte_table_status_t t_status;
+    cte_render_state_t state;
+    cte_status_t status;
+    bool ready = false;
+    cte_table_t table;
+    cardinal length;
+    size_t v_length;
+    
+    table = cte_new_table(0, &t_status);
+    cte_table_store_value(table, "a", "A", 1, &t_status);
+    cte_table_store_pending(table, "b", &t_status);
+    CHECK(t_status == CTE_TABLE_STATUS_SUCCESS);
+    cte_table_store_pending(table, "c", &t_status);
+    CHECK(cte_table_value_for_key(table, test_key("b"), &v_length)
+          == CTE_PENDING_VALUE);
+    CHECK(v_length == 0);
+    
+    // the step stops at the first pending value
+    state = cte_new_render_state_with_table("1@@a@@2@@b@@3@@c@@4", table,
+                                            &status);
+    test_step(state, "1A2", "b");
+    test_step(state, "", "b");
+    
+    // values completed out of order are written once preceding output is
+    cte_table_store_value(table, "c", "C", 1, &t_status);
+    test_step(state, "", "b");
+    cte_table_store_value(table, "b", "B@@a@@", 6, &t_status);
+    CHECK(cte_table_value_for_key(table, test_key("b"), &v_length)
+          != CTE_PENDING_VALUE);
+    test_step(state, "BA3C4", NULL);
+    CHECK(cte_render_state_done(state));
+    cte_dispose_render_state(state);
+    
+    // a pending value may replace a stored value
+    cte_table_store_pending(table, "a", &t_status);
+    state = cte_new_render_state_with_table("<@@a@@>", table, &status);
+    test_step(state, "<", "a");
+    CHECK(NOT(cte_render_state_done(state)));
+    cte_table_store_value(table, "a", "again", 5, &t_status);
+    test_step(state, "again>", NULL);
+    cte_dispose_render_state(state);
+    
+    // renders that cannot resume treat pending values as undefined
+    cte_table_store_pending(table, "b", &t_status);
+    CHECK_RENDER(cte_string_from_table("@@a@@ @@b@@", table, &status),
+        "again @@b@@");
+    CHECK(status == CTE_STATUS_SUCCESS);
+    
+    // resolvers are called again for pending values
+    state = cte_new_render_state_with_resolver("[@@late@@]", test_resolve,
+                                               &ready, &status);
+    test_step(state, "[", "late");
+    test_step(state, "", "late");
+    ready = true;
+    test_step(state, "on time]", NULL);
+    cte_dispose_render_state(state);
+    
+    ready = false;
+    CHECK_RENDER(cte_string_from_resolver("[@@late@@]", test_resolve,
+        &ready, &status), "[@@late@@]");
+    
+    // invalid arguments
+    cte_table_store_pending(NULL, "x", &t_status);
+    CHECK(t_status == CTE_TABLE_STATUS_INVALID_TABLE);
+    cte_table_store_pending(table, "9", &t_status);
+    CHECK(t_status == CTE_TABLE_STATUS_INVALID_IDENTIFIER);
+    CHECK(cte_render_state_pending(NULL, &length) == NULL);
+    
+    cte_dispose_table(table);
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
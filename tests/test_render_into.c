@@ -0,0 +1,158 @@
+/* C Template Engine
+ *
+ *  @file tests/test_render_into.c
+ *  CTE bounded render tests
+ *
+ *  Tests of rendering into caller supplied buffers and stack storage
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include "cte_test.h"
+#include "cte_stack.h"
+
+
+// ---------------------------------------------------------------------------
+// Nesting depth exceeding the render stack storage
+// ---------------------------------------------------------------------------
+
+#define TEST_DEPTH (CTE_RENDER_STACK_SIZE + 4)
+
+
+// ---------------------------------------------------------------------------
+// test:  cte_render_into() and cte_new_stack_in_storage()
+// ---------------------------------------------------------------------------
+
+int main(void) {
+    
+    kvs_table_t placeholders = test_new_placeholders();
+    char ident[TEST_DEPTH][8], value[TEST_DEPTH][16];
+    void *storage[CTE_STACK_STORAGE_SIZE(2) / sizeof(void *)];
+    cte_stack_status_t s_status;
+    cte_status_t status;
+    char buffer[16];
+    cte_stack_t stack;
+    size_t length, index;
+    cardinal level;
+    
+    test_store(placeholders, "name", "World");
+    
+    // the full length is returned and the buffer is always terminated
+    CHECK(cte_render_into(buffer, sizeof(buffer), "Hello @@name@@!",
+                          placeholders, &status) == 12);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    CHECK_STRING(buffer, "Hello World!");
+    
+    CHECK(cte_render_into(buffer, 6, "Hello @@name@@!",
+                          placeholders, &status) == 12);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    CHECK_STRING(buffer, "Hello");
+    
+    CHECK(cte_render_into(buffer, 13, "Hello @@name@@!",
+                          placeholders, &status) == 12);
+    CHECK_STRING(buffer, "Hello World!");
+    
+    CHECK(cte_render_into(buffer, 12, "Hello @@name@@!",
+                          placeholders, &status) == 12);
+    CHECK_STRING(buffer, "Hello World");
+    
+    // a zero capacity only sizes the result
+    CHECK(cte_render_into(NULL, 0, "Hello @@name@@!",
+                          placeholders, &status) == 12);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    
+    // nesting beyond the render stack storage still renders
+    for (level = 0; level < TEST_DEPTH; level++) {
+        sprintf(ident[level], "n%u", level);
+        
+        if (level + 1 < TEST_DEPTH)
+            sprintf(value[level], "<@@n%u@@>", level + 1);
+        else
+            strcpy(value[level], "x");
+        
+        test_store(placeholders, ident[level], value[level]);
+    } // end for
+    
+    CHECK(cte_render_into(buffer, sizeof(buffer), "@@n0@@",
+                          placeholders, &status) == 2 * TEST_DEPTH - 1);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    CHECK_STRING(buffer, "<<<<<<<<<<<<<<<");
+    
+    // failed renders leave the empty string
+    CHECK(cte_render_into(buffer, sizeof(buffer), NULL,
+                          placeholders, &status) == 0);
+    CHECK(status == CTE_STATUS_INVALID_TEMPLATE);
+    CHECK_STRING(buffer, "");
+    
+    CHECK(cte_render_into(NULL, 4, "x", placeholders, &status) == 0);
+    CHECK(status == CTE_STATUS_INVALID_TARGET);
+    
+    // stacks in caller storage enlarge beyond their initial capacity
+    stack = cte_new_stack_in_storage(storage, sizeof(storage), &s_status);
+    CHECK(stack != NULL);
+    CHECK(s_status == CTE_STACK_STATUS_SUCCESS);
+    CHECK(cte_stack_size(stack) >= 2);
+    
+    for (level = 0; level < 4; level++) {
+        cte_stack_push_context(stack, ident[level], level, level + 1,
+                               &s_status);
+        CHECK(s_status == CTE_STACK_STATUS_SUCCESS);
+    } // end for
+    
+    for (level = 4; level > 0; level--) {
+        CHECK(cte_stack_pop_context(stack, &length, &index, &s_status)
+              == ident[level - 1]);
+        CHECK((length == level - 1) && (index == level));
+    } // end for
+    
+    cte_dispose_stack(stack);
+    
+    CHECK(cte_new_stack_in_storage(storage, sizeof(void *), &s_status)
+          == NULL);
+    CHECK(s_status != CTE_STACK_STATUS_SUCCESS);
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
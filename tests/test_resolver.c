@@ -0,0 +1,135 @@
+/* C Template Engine
+ *
+ *  @file tests/test_resolver.c
+ *  CTE resolver tests
+ *
+ *  Tests of rendering with placeholder values obtained from a resolver
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include "cte_test.h"
+
+
+// ---------------------------------------------------------------------------
+// Resolver call counts by placeholder
+// ---------------------------------------------------------------------------
+
+typedef struct /* test_calls_s */ {
+    cardinal greeting;
+    cardinal name;
+    cardinal missing;
+} test_calls_s;
+
+
+// ---------------------------------------------------------------------------
+// function:  test_resolve( ident, key, context )
+// ---------------------------------------------------------------------------
+//
+// Resolver that counts its calls in <context>.  Placeholder greeting has a
+// nested placeholder,  placeholder missing is undefined.
+
+static const char *test_resolve(const char *ident,
+                                kvs_key_t key,
+                                void *context) {
+    
+    test_calls_s *calls = context;
+    
+    CHECK(key == test_key(ident));
+    
+    if (strcmp(ident, "greeting") == 0) {
+        calls->greeting++;
+        return "Hello @@name@@";
+    }
+    else if (strcmp(ident, "name") == 0) {
+        calls->name++;
+        return "World";
+    }
+    else if (strcmp(ident, "missing") == 0) {
+        calls->missing++;
+    } // end if
+    
+    return NULL;
+} // end test_resolve
+
+
+// ---------------------------------------------------------------------------
+// test:  cte_string_from_resolver()
+// ---------------------------------------------------------------------------
+
+int main(void) {
+    
+    test_calls_s calls = { 0, 0, 0 };
+    cte_status_t status;
+    
+    // nested values are expanded,  undefined placeholders are copied
+    CHECK_RENDER(cte_string_from_resolver(
+        "@@greeting@@, @@name@@ @@missing@@ @@missing@@!",
+        test_resolve, &calls, &status), "Hello World, World @@missing@@ "
+        "@@missing@@!");
+    CHECK(status == CTE_STATUS_SUCCESS);
+    
+    // the resolver is called once per identifier and render
+    CHECK(calls.greeting == 1);
+    CHECK(calls.name == 1);
+    CHECK(calls.missing == 1);
+    
+    // placeholders that are not encountered are not resolved
+    calls.name = 0;
+    CHECK_RENDER(cte_string_from_resolver("no placeholders",
+        test_resolve, &calls, &status), "no placeholders");
+    CHECK(calls.name == 0);
+    
+    CHECK(cte_string_from_resolver(NULL, test_resolve, &calls, &status)
+          == NULL);
+    CHECK(status == CTE_STATUS_INVALID_TEMPLATE);
+    
+    CHECK(cte_string_from_resolver("@@name@@", NULL, &calls, &status)
+          == NULL);
+    CHECK(status == CTE_STATUS_INVALID_PLACEHOLDERS);
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
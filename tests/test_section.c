@@ -0,0 +1,173 @@
+/* C Template Engine
+ *
+ *  @file tests/test_section.c
+ *  CTE section tests
+ *
+ *  Tests of repeating sections expanded from row tables
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include "cte_test.h"
+
+
+// ---------------------------------------------------------------------------
+// Templates
+// ---------------------------------------------------------------------------
+
+#define TEST_NESTED "@@#r@@(@@x@@@@#r@@{@@x@@}@@/r@@)@@/r@@"
+
+
+// ---------------------------------------------------------------------------
+// function:  test_nested_sections( depth )
+// ---------------------------------------------------------------------------
+//
+// Returns a new template string of <depth> nested sections named s around x.
+
+static char *test_nested_sections(cardinal depth) {
+    
+    char *tmplate = malloc(depth * 14 + 2);
+    cardinal level;
+    
+    tmplate[0] = '\0';
+    
+    for (level = 0; level < depth; level++)
+        strcat(tmplate, "@@#s@@");
+    
+    strcat(tmplate, "x");
+    
+    for (level = 0; level < depth; level++)
+        strcat(tmplate, "@@/s@@");
+    
+    return tmplate;
+} // end test_nested_sections
+
+
+// ---------------------------------------------------------------------------
+// test:  sections
+// ---------------------------------------------------------------------------
+
+int main(void) {
+    
+    cte_table_t row[3], table, single[1], *found;
+    cte_table_status_t t_status;
+    cte_template_t compiled;
+    cte_status_t status;
+    cardinal index, count;
+    char *tmplate;
+    
+    for (index = 0; index < 2; index++)
+        row[index] = cte_new_table(0, &t_status);
+    
+    row[2] = NULL;
+    table = cte_new_table(0, &t_status);
+    cte_table_store_value(row[0], "x", "A", 1, &t_status);
+    cte_table_store_value(row[1], "x", "B", 1, &t_status);
+    cte_table_store_value(row[1], "y", "b", 1, &t_status);
+    cte_table_store_value(table, "y", "top", 3, &t_status);
+    cte_table_store_rows(table, "r", row, 2, &t_status);
+    CHECK(t_status == CTE_TABLE_STATUS_SUCCESS);
+    
+    found = (cte_table_t *) cte_table_rows_for_key(table, test_key("r"),
+                                                   &count);
+    CHECK((found == row) && (count == 2));
+    CHECK(cte_table_value_for_key(table, test_key("r"), NULL) == NULL);
+    CHECK(cte_table_rows_for_key(table, test_key("y"), &count) == NULL);
+    
+    // the body is expanded per row,  values fall back to enclosing scopes
+    CHECK_RENDER(cte_string_from_table("<@@#r@@[@@x@@ @@y@@]@@/r@@>",
+        table, &status), "<[A top][B b]>");
+    CHECK(status == CTE_STATUS_SUCCESS);
+    
+    // sections fall back to enclosing scopes like values
+    CHECK_RENDER(cte_string_from_table(TEST_NESTED, table, &status),
+        "(A{A}{B})(B{A}{B})");
+    
+    single[0] = row[1];
+    cte_table_store_rows(table, "s", single, 1, &t_status);
+    CHECK_RENDER(cte_string_from_table(
+        "@@#s@@(@@x@@@@#r@@{@@x@@}@@/r@@)@@/s@@", table, &status),
+        "(B{A}{B})");
+    
+    compiled = cte_compile_template(TEST_NESTED, &status);
+    CHECK_RENDER(cte_string_from_compiled_table(compiled, table, &status),
+        "(A{A}{B})(B{A}{B})");
+    cte_dispose_template(compiled);
+    
+    // sections without rows are copied,  empty ones produce no output
+    CHECK_RENDER(cte_string_from_table("@@#none@@x@@/none@@|@@#r@@x",
+        table, &status), "@@#none@@x@@/none@@|@@#r@@x");
+    
+    cte_table_store_rows(table, "e", NULL, 0, &t_status);
+    CHECK(t_status == CTE_TABLE_STATUS_SUCCESS);
+    CHECK_RENDER(cte_string_from_table("[@@#e@@x@@/e@@]", table, &status),
+        "[]");
+    
+    // NULL rows are empty rows
+    cte_table_store_rows(table, "n", row + 1, 2, &t_status);
+    CHECK_RENDER(cte_string_from_table("@@#n@@<@@y@@>@@/n@@", table,
+        &status), "<b><top>");
+    
+    cte_table_store_rows(table, "bad", NULL, 1, &t_status);
+    CHECK(t_status == CTE_TABLE_STATUS_INVALID_ROWS);
+    
+    // sections are nested up to the section depth limit
+    tmplate = test_nested_sections(CTE_MAX_SECTION_DEPTH);
+    CHECK_RENDER(cte_string_from_table(tmplate, table, &status), "x");
+    free(tmplate);
+    
+    tmplate = test_nested_sections(CTE_MAX_SECTION_DEPTH + 1);
+    CHECK(cte_string_from_table(tmplate, table, &status) == NULL);
+    CHECK(status == CTE_STATUS_NESTING_LIMIT_EXCEEDED);
+    free(tmplate);
+    
+    for (index = 0; index < 2; index++)
+        cte_dispose_table(row[index]);
+    
+    cte_dispose_table(table);
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
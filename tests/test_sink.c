@@ -0,0 +1,246 @@
+/* C Template Engine
+ *
+ *  @file tests/test_sink.c
+ *  CTE sink tests
+ *
+ *  Tests of rendering to sinks and of the streaming deflate sink
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include "cte_test.h"
+#include "cte_deflate.h"
+
+#ifdef CTE_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+
+// ---------------------------------------------------------------------------
+// Chunk size and output limits
+// ---------------------------------------------------------------------------
+
+#define TEST_CHUNK_SIZE 8
+#define TEST_OUTPUT_SIZE 4096
+
+
+// ---------------------------------------------------------------------------
+// Collecting sink context
+// ---------------------------------------------------------------------------
+
+typedef struct /* test_output_s */ {
+    char data[TEST_OUTPUT_SIZE];
+    size_t length;
+    cardinal chunks;
+    cardinal limit;
+} test_output_s;
+
+
+// ---------------------------------------------------------------------------
+// function:  test_collect( chunk, length, context )
+// ---------------------------------------------------------------------------
+//
+// Sink that appends the chunks to the output in <context>  and fails once it
+// has accepted the limit number of chunks.
+
+static bool test_collect(const char *chunk, size_t length, void *context) {
+    
+    test_output_s *output = context;
+    
+    if ((output->chunks == output->limit) ||
+        (output->length + length >= TEST_OUTPUT_SIZE))
+        return false;
+    
+    memcpy(output->data + output->length, chunk, length);
+    output->length = output->length + length;
+    output->data[output->length] = '\0';
+    output->chunks++;
+    
+    return true;
+} // end test_collect
+
+
+// ---------------------------------------------------------------------------
+// function:  test_init_output( output, limit )
+// ---------------------------------------------------------------------------
+
+static void test_init_output(test_output_s *output, cardinal limit) {
+    
+    output->data[0] = '\0';
+    output->length = 0;
+    output->chunks = 0;
+    output->limit = limit;
+    
+    return;
+} // end test_init_output
+
+
+#ifdef CTE_WITH_ZLIB
+// ---------------------------------------------------------------------------
+// function:  test_inflate( data, length, result, size )
+// ---------------------------------------------------------------------------
+//
+// Decompresses the gzip stream of <length> bytes at <data>  into <result> of
+// <size> bytes,  terminates it  and returns its length,  or -1 on failure.
+
+static long test_inflate(const char *data, size_t length,
+                         char *result, size_t size) {
+    
+    z_stream stream;
+    long inflated;
+    
+    memset(&stream, 0, sizeof(stream));
+    
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK)
+        return -1;
+    
+    stream.next_in = (Bytef *) data;
+    stream.avail_in = (uInt) length;
+    stream.next_out = (Bytef *) result;
+    stream.avail_out = (uInt) size - 1;
+    
+    if (inflate(&stream, Z_FINISH) == Z_STREAM_END)
+        inflated = (long) stream.total_out;
+    else
+        inflated = -1;
+    
+    inflateEnd(&stream);
+    
+    if (inflated >= 0)
+        result[inflated] = '\0';
+    
+    return inflated;
+} // end test_inflate
+#endif
+
+
+// ---------------------------------------------------------------------------
+// test:  sinks
+// ---------------------------------------------------------------------------
+
+int main(void) {
+    
+    kvs_table_t placeholders = test_new_placeholders();
+    test_output_s output, compressed;
+    cte_deflate_status_t d_status;
+    cte_deflate_sink_t deflate;
+    cte_template_t compiled;
+    cte_status_t status;
+#ifdef CTE_WITH_ZLIB
+    cardinal index;
+#endif
+    
+    test_store(placeholders, "short", "abc");
+    test_store(placeholders, "long", "a value longer than one chunk");
+    
+    // output is passed on in chunks as it is produced
+    test_init_output(&output, 1000);
+    CHECK(cte_render_to_sink("<@@short@@|@@long@@|@@short@@>", placeholders,
+          test_collect, &output, TEST_CHUNK_SIZE, &status) == 39);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    CHECK_STRING(output.data, "<abc|a value longer than one chunk|abc>");
+    CHECK(output.chunks > 1);
+    
+    compiled = cte_compile_template("<@@short@@|@@long@@|@@short@@>",
+                                    &status);
+    test_init_output(&output, 1000);
+    CHECK(cte_render_compiled_to_sink(compiled, placeholders, test_collect,
+          &output, TEST_CHUNK_SIZE, &status) == 39);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    CHECK_STRING(output.data, "<abc|a value longer than one chunk|abc>");
+    
+    // output accepted before a sink failure is not retracted
+    test_init_output(&output, 1);
+    cte_render_compiled_to_sink(compiled, placeholders, test_collect,
+                                &output, TEST_CHUNK_SIZE, &status);
+    CHECK(status == CTE_STATUS_SINK_FAILED);
+    CHECK(output.chunks == 1);
+    
+    CHECK(cte_render_to_sink("x", placeholders, NULL, NULL, 0, &status)
+          == 0);
+    CHECK(status != CTE_STATUS_SUCCESS);
+    
+    // deflate sinks compress renders into a gzip stream
+    test_init_output(&compressed, 1000);
+    deflate = cte_new_deflate_sink(-1, 64, test_collect, &compressed,
+                                   &d_status);
+    
+#ifdef CTE_WITH_ZLIB
+    CHECK(d_status == CTE_DEFLATE_STATUS_SUCCESS);
+    
+    for (index = 0; index < 20; index++)
+        cte_render_compiled_to_sink(compiled, placeholders,
+                                    cte_deflate_sink_write, deflate,
+                                    TEST_CHUNK_SIZE, &status);
+    
+    CHECK(status == CTE_STATUS_SUCCESS);
+    cte_deflate_sink_finish(deflate, &d_status);
+    CHECK(d_status == CTE_DEFLATE_STATUS_SUCCESS);
+    CHECK(cte_deflate_sink_total_in(deflate) == 20 * 39);
+    CHECK(cte_deflate_sink_total_out(deflate) == compressed.length);
+    CHECK(compressed.length < 20 * 39);
+    
+    CHECK(test_inflate(compressed.data, compressed.length,
+                       output.data, sizeof(output.data)) == 20 * 39);
+    CHECK(strncmp(output.data + 19 * 39,
+                  "<abc|a value longer than one chunk|abc>", 39) == 0);
+    
+    // no data is accepted after finishing
+    CHECK(NOT(cte_deflate_sink_write("x", 1, deflate)));
+    
+    CHECK(cte_new_deflate_sink(10, 0, test_collect, NULL, &d_status)
+          == NULL);
+    CHECK(d_status == CTE_DEFLATE_STATUS_INVALID_LEVEL);
+#else
+    CHECK(deflate == NULL);
+    CHECK(d_status == CTE_DEFLATE_STATUS_UNAVAILABLE);
+#endif
+    
+    CHECK(cte_dispose_deflate_sink(deflate) == NULL);
+    cte_dispose_template(compiled);
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
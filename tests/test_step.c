@@ -0,0 +1,212 @@
+/* C Template Engine
+ *
+ *  @file tests/test_step.c
+ *  CTE step render tests
+ *
+ *  Tests of resumable renders into caller owned buffers
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include "cte_test.h"
+
+
+// ---------------------------------------------------------------------------
+// Templates
+// ---------------------------------------------------------------------------
+
+#define TEST_TEMPLATE \
+    "%% comment\n<@@greeting@@> \\@@@@#r@@[@@x@@]@@/r@@ @@missing@@!"
+
+#define TEST_EXPANSION "\n<Hello World> @@[A][B] @@missing@@!"
+
+
+// ---------------------------------------------------------------------------
+// function:  test_drain( state, capacity, status )
+// ---------------------------------------------------------------------------
+//
+// Steps render state <state> to completion  with buffers of <capacity> bytes,
+// disposes of the state  and returns the concatenated output as a new string.
+// The status of the last step is passed back in <status>.
+
+static char *test_drain(cte_render_state_t state,
+                        size_t capacity,
+                        cte_status_t *status) {
+    
+    char *result = malloc(1024), *buffer = malloc(capacity);
+    size_t length = 0, written;
+    
+    *status = CTE_STATUS_SUCCESS;
+    
+    while (NOT(cte_render_state_done(state))) {
+        written = cte_render_step(state, buffer, capacity, status);
+        CHECK(written <= capacity);
+        
+        // bail out if the step failed or made no progress
+        if ((*status != CTE_STATUS_SUCCESS) || (written == 0))
+            break;
+        
+        CHECK(length + written < 1024);
+        memcpy(result + length, buffer, written);
+        length = length + written;
+    } // end while
+    
+    result[length] = '\0';
+    free(buffer);
+    cte_dispose_render_state(state);
+    
+    return result;
+} // end test_drain
+
+
+// ---------------------------------------------------------------------------
+// function:  test_resolve( ident, key, context )
+// ---------------------------------------------------------------------------
+//
+// Resolver with values for greeting and name,  counts its calls in <context>.
+
+static const char *test_resolve(const char *ident,
+                                kvs_key_t key,
+                                void *context) {
+    
+    (void) key;
+    (*(cardinal *) context)++;
+    
+    if (strcmp(ident, "greeting") == 0)
+        return "Hello @@name@@";
+    else if (strcmp(ident, "name") == 0)
+        return "World";
+    
+    return NULL;
+} // end test_resolve
+
+
+// ---------------------------------------------------------------------------
+// test:  resumable step renders
+// ---------------------------------------------------------------------------
+
+int main(void) {
+    
+    cte_table_t row[2], table;
+    cte_table_status_t t_status;
+    cte_render_state_t state;
+    cte_template_t compiled;
+    kvs_table_t placeholders;
+    cte_status_t status;
+    cardinal calls = 0;
+    size_t capacity;
+    char buffer[4];
+    
+    placeholders = test_new_placeholders();
+    test_store(placeholders, "greeting", "Hello @@name@@");
+    test_store(placeholders, "name", "World");
+    
+    table = cte_new_table(0, &t_status);
+    row[0] = cte_new_table(0, &t_status);
+    row[1] = cte_new_table(0, &t_status);
+    cte_table_store_value(table, "greeting", "Hello @@name@@", 14, &t_status);
+    cte_table_store_value(table, "name", "World", 5, &t_status);
+    cte_table_store_value(row[0], "x", "A", 1, &t_status);
+    cte_table_store_value(row[1], "x", "B", 1, &t_status);
+    cte_table_store_rows(table, "r", row, 2, &t_status);
+    CHECK(t_status == CTE_TABLE_STATUS_SUCCESS);
+    
+    CHECK_RENDER(cte_string_from_table(TEST_TEMPLATE, table, &status),
+        TEST_EXPANSION);
+    
+    // any buffer size yields the output of the one-shot render
+    for (capacity = 1; capacity <= 64; capacity++) {
+        CHECK_RENDER(test_drain(cte_new_render_state_with_table(
+            TEST_TEMPLATE, table, &status), capacity, &status),
+            TEST_EXPANSION);
+        CHECK(status == CTE_STATUS_SUCCESS);
+    } // end for
+    
+    // placeholder tables,  resolvers and compiled templates step alike
+    CHECK_RENDER(test_drain(cte_new_render_state(
+        "@@greeting@@ @@missing@@", placeholders, &status), 1, &status),
+        "Hello World @@missing@@");
+    
+    CHECK_RENDER(test_drain(cte_new_render_state_with_resolver(
+        "@@greeting@@ @@name@@ @@missing@@", test_resolve, &calls, &status),
+        3, &status), "Hello World World @@missing@@");
+    CHECK(calls == 3);
+    
+    compiled = cte_compile_template(TEST_TEMPLATE, &status);
+    CHECK_RENDER(test_drain(cte_new_compiled_render_state(compiled, table,
+        &status), 2, &status), TEST_EXPANSION);
+    cte_dispose_template(compiled);
+    
+    // a complete state returns no further output
+    state = cte_new_render_state_with_table("ab", table, &status);
+    CHECK(NOT(cte_render_state_done(state)));
+    CHECK(cte_render_step(state, buffer, 0, &status) == 0);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    CHECK(cte_render_step(state, buffer, sizeof(buffer), &status) == 2);
+    CHECK(memcmp(buffer, "ab", 2) == 0);
+    CHECK(cte_render_state_done(state));
+    CHECK(cte_render_step(state, buffer, sizeof(buffer), &status) == 0);
+    CHECK(cte_render_state_pending(state, NULL) == NULL);
+    CHECK(cte_dispose_render_state(state) == NULL);
+    
+    // invalid arguments
+    CHECK(cte_new_render_state(NULL, placeholders, &status) == NULL);
+    CHECK(status == CTE_STATUS_INVALID_TEMPLATE);
+    CHECK(cte_new_render_state_with_table("x", NULL, &status) == NULL);
+    CHECK(status == CTE_STATUS_INVALID_PLACEHOLDERS);
+    CHECK(cte_new_render_state_with_resolver("x", NULL, NULL, &status)
+          == NULL);
+    CHECK(status == CTE_STATUS_INVALID_PLACEHOLDERS);
+    CHECK(cte_render_step(NULL, buffer, sizeof(buffer), &status) == 0);
+    CHECK(status != CTE_STATUS_SUCCESS);
+    CHECK(NOT(cte_render_state_done(NULL)));
+    
+    cte_dispose_table(row[0]);
+    cte_dispose_table(row[1]);
+    cte_dispose_table(table);
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
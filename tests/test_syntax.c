@@ -0,0 +1,115 @@
+/* C Template Engine
+ *
+ *  @file tests/test_syntax.c
+ *  CTE syntax tests
+ *
+ *  Tests of templates in runtime configured syntaxes
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include "cte_test.h"
+
+
+// ---------------------------------------------------------------------------
+// test:  template syntaxes
+// ---------------------------------------------------------------------------
+
+int main(void) {
+    
+    kvs_table_t placeholders = test_new_placeholders();
+    cte_template_t compiled;
+    cte_syntax_t syntax;
+    cte_status_t status;
+    
+    CHECK_STRING(cte_delimiter(), "@@");
+    CHECK_STRING(cte_ignore_prefix(), "%%");
+    
+    test_store(placeholders, "name", "<{{inner}}>");
+    test_store(placeholders, "inner", "World");
+    
+    syntax = cte_new_syntax("{{", "}}", "##", &status);
+    CHECK(syntax != NULL);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    
+    // values are recognised in the syntax of the template
+    CHECK_RENDER(cte_string_from_template_with_syntax(
+        "## comment\nHi {{name}}! @@name@@ \\{{name}}", syntax,
+        placeholders, &status), "\nHi <World>! @@name@@ {{name}}");
+    CHECK(status == CTE_STATUS_SUCCESS);
+    
+    // the built-in syntax is used without a syntax
+    CHECK_RENDER(cte_string_from_template_with_syntax("@@inner@@ {{inner}}",
+        NULL, placeholders, &status), "World {{inner}}");
+    
+    // compiled templates keep their own copy of the syntax
+    compiled = cte_compile_template_with_syntax("[{{name}}]", syntax,
+                                                &status);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    CHECK(cte_dispose_syntax(syntax) == NULL);
+    CHECK_RENDER(cte_string_from_compiled(compiled, placeholders, &status),
+        "[<World>]");
+    cte_dispose_template(compiled);
+    
+    // a closing delimiter defaults to the opening delimiter
+    syntax = cte_new_syntax("$$", NULL, NULL, &status);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    CHECK_RENDER(cte_string_from_template_with_syntax("$$inner$$",
+        syntax, placeholders, &status), "World");
+    cte_dispose_syntax(syntax);
+    
+    // invalid delimiters and prefixes are rejected
+    CHECK(cte_new_syntax("{", "}", NULL, &status) == NULL);
+    CHECK(status == CTE_STATUS_INVALID_SYNTAX);
+    CHECK(cte_new_syntax("ab", NULL, NULL, &status) == NULL);
+    CHECK(status == CTE_STATUS_INVALID_SYNTAX);
+    CHECK(cte_new_syntax("__", NULL, NULL, &status) == NULL);
+    CHECK(status == CTE_STATUS_INVALID_SYNTAX);
+    CHECK(cte_new_syntax("##", NULL, "#!", &status) == NULL);
+    CHECK(status == CTE_STATUS_INVALID_SYNTAX);
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
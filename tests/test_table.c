@@ -0,0 +1,143 @@
+/* C Template Engine
+ *
+ *  @file tests/test_table.c
+ *  CTE table tests
+ *
+ *  Tests of the small placeholder table and of rendering from it
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include "cte_test.h"
+
+
+// ---------------------------------------------------------------------------
+// Number of entries stored to exceed the scan limit
+// ---------------------------------------------------------------------------
+
+#define TEST_ENTRIES (CTE_TABLE_SCAN_LIMIT * 4)
+
+
+// ---------------------------------------------------------------------------
+// test:  small placeholder tables
+// ---------------------------------------------------------------------------
+
+int main(void) {
+    
+    char ident[TEST_ENTRIES][8], value[TEST_ENTRIES][8];
+    cte_table_status_t t_status;
+    cte_template_t compiled;
+    cte_status_t status;
+    cte_table_t table;
+    const char *found;
+    cardinal index;
+    size_t length;
+    
+    table = cte_new_table(2, &t_status);
+    CHECK(table != NULL);
+    CHECK(t_status == CTE_TABLE_STATUS_SUCCESS);
+    
+    // values need not be terminated,  their length is taken from the table
+    cte_table_store_value(table, "name", "Worldwide", 5, &t_status);
+    CHECK(t_status == CTE_TABLE_STATUS_SUCCESS);
+    cte_table_store_value(table, "greeting", "Hello @@name@@", 14, &t_status);
+    
+    found = cte_table_value_for_key(table, test_key("name"), &length);
+    CHECK((found != NULL) && (length == 5));
+    CHECK(cte_table_entry_exists(table, test_key("greeting")));
+    CHECK(NOT(cte_table_entry_exists(table, test_key("missing"))));
+    CHECK(cte_table_value_for_key(table, test_key("missing"), NULL) == NULL);
+    
+    // a later store replaces the value
+    cte_table_store_value(table, "name", "Earth", 5, &t_status);
+    CHECK(cte_table_number_of_entries(table) == 2);
+    
+    CHECK_RENDER(cte_string_from_table("@@greeting@@!", table, &status),
+        "Hello Earth!");
+    CHECK(status == CTE_STATUS_SUCCESS);
+    
+    compiled = cte_compile_template("[@@greeting@@ @@other@@]", &status);
+    CHECK_RENDER(cte_string_from_compiled_table(compiled, table, &status),
+        "[Hello Earth @@other@@]");
+    CHECK(status == CTE_STATUS_SUCCESS);
+    
+    // invalid identifiers and values are rejected
+    cte_table_store_value(table, "9lives", "x", 1, &t_status);
+    CHECK(t_status == CTE_TABLE_STATUS_INVALID_IDENTIFIER);
+    cte_table_store_value(table, "other", NULL, 0, &t_status);
+    CHECK(t_status == CTE_TABLE_STATUS_INVALID_VALUE);
+    
+    // larger tables are enlarged and searched by their hash index
+    cte_table_reset(table);
+    CHECK(cte_table_number_of_entries(table) == 0);
+    
+    for (index = 0; index < TEST_ENTRIES; index++) {
+        sprintf(ident[index], "p%u", index);
+        sprintf(value[index], "v%u", index);
+        cte_table_store_value(table, ident[index], value[index],
+                              strlen(value[index]), &t_status);
+        CHECK(t_status == CTE_TABLE_STATUS_SUCCESS);
+    } // end for
+    
+    CHECK(cte_table_number_of_entries(table) == TEST_ENTRIES);
+    
+    for (index = 0; index < TEST_ENTRIES; index++) {
+        found = cte_table_value_for_key(table, test_key(ident[index]),
+                                        &length);
+        CHECK((found == value[index]) && (length == strlen(value[index])));
+    } // end for
+    
+    CHECK_RENDER(cte_string_from_table("@@p0@@ @@p17@@ @@p63@@", table,
+        &status), "v0 v17 v63");
+    
+    CHECK(cte_string_from_table("@@p0@@", NULL, &status) == NULL);
+    CHECK(status == CTE_STATUS_INVALID_PLACEHOLDERS);
+    
+    cte_dispose_template(compiled);
+    CHECK(cte_dispose_table(table) == NULL);
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
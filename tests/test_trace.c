@@ -0,0 +1,168 @@
+/* C Template Engine
+ *
+ *  @file tests/test_trace.c
+ *  CTE tracing tests
+ *
+ *  Tests of render tracing and of the Chrome trace event output
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include "cte_test.h"
+#include "cte_trace.h"
+
+
+// ---------------------------------------------------------------------------
+// Dump buffer size
+// ---------------------------------------------------------------------------
+
+#define TEST_DUMP_SIZE 65536
+
+
+// ---------------------------------------------------------------------------
+// Dump buffer
+// ---------------------------------------------------------------------------
+
+static char test_dump[TEST_DUMP_SIZE];
+static size_t test_dump_length = 0;
+
+
+// ---------------------------------------------------------------------------
+// function:  test_collect( chunk, length, context )
+// ---------------------------------------------------------------------------
+//
+// Sink that appends to the dump buffer,  it fails if <context> is not NULL.
+
+static bool test_collect(const char *chunk, size_t length, void *context) {
+    
+    if ((context != NULL) ||
+        (test_dump_length + length >= TEST_DUMP_SIZE))
+        return false;
+    
+    memcpy(test_dump + test_dump_length, chunk, length);
+    test_dump_length = test_dump_length + length;
+    test_dump[test_dump_length] = '\0';
+    
+    return true;
+} // end test_collect
+
+
+#ifdef CTE_WITH_TRACING
+// ---------------------------------------------------------------------------
+// function:  test_occurrences( text )
+// ---------------------------------------------------------------------------
+//
+// Returns the number of occurrences of <text> in the dump buffer.
+
+static cardinal test_occurrences(const char *text) {
+    
+    const char *found = test_dump;
+    cardinal count = 0;
+    
+    while ((found = strstr(found, text)) != NULL) {
+        count++;
+        found = found + strlen(text);
+    } // end while
+    
+    return count;
+} // end test_occurrences
+#endif
+
+
+// ---------------------------------------------------------------------------
+// test:  tracing
+// ---------------------------------------------------------------------------
+
+int main(void) {
+    
+    kvs_table_t placeholders = test_new_placeholders();
+    cte_trace_status_t t_status;
+    cte_status_t status;
+    size_t size;
+    
+    test_store(placeholders, "outer", "<@@inner@@>");
+    test_store(placeholders, "inner", "value");
+    
+    cte_trace_clear();
+    free(cte_string_from_template("@@outer@@ @@undefined@@", placeholders,
+                                  &status));
+    cte_trace_begin(CTE_TRACE_RENDER, "own event", 9);
+    cte_trace_end(1);
+    
+    size = cte_trace_dump(test_collect, NULL, &t_status);
+    
+#ifdef CTE_WITH_TRACING
+    // every placeholder is looked up,  defined ones are expanded
+    CHECK(t_status == CTE_TRACE_STATUS_SUCCESS);
+    CHECK(size == test_dump_length);
+    CHECK(strncmp(test_dump, "{\"traceEvents\":[", 16) == 0);
+    CHECK(test_occurrences("\"cat\":\"lookup\"") == 3);
+    CHECK(test_occurrences("\"name\":\"outer\",\"cat\":\"placeholder\"") == 1);
+    CHECK(test_occurrences("\"name\":\"inner\",\"cat\":\"placeholder\"") == 1);
+    CHECK(test_occurrences("\"name\":\"own event\",\"cat\":\"render\"") == 1);
+    CHECK(test_occurrences("\"ph\":\"B\"") == 7);
+    CHECK(test_occurrences("\"ph\":\"E\"") == 7);
+    
+    // cleared events are not dumped
+    cte_trace_clear();
+    test_dump_length = 0;
+    cte_trace_dump(test_collect, NULL, &t_status);
+    CHECK(t_status == CTE_TRACE_STATUS_SUCCESS);
+    CHECK(test_occurrences("\"ph\":") == 0);
+    
+    cte_trace_dump(test_collect, test_dump, &t_status);
+    CHECK(t_status == CTE_TRACE_STATUS_SINK_FAILED);
+    
+    cte_trace_dump(NULL, NULL, &t_status);
+    CHECK(t_status == CTE_TRACE_STATUS_INVALID_SINK);
+#else
+    // without tracing nothing is recorded or dumped
+    CHECK(t_status == CTE_TRACE_STATUS_UNAVAILABLE);
+    CHECK((size == 0) && (test_dump_length == 0));
+#endif
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
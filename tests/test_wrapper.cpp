@@ -0,0 +1,191 @@
+/* C Template Engine
+ *
+ *  @file tests/test_wrapper.cpp
+ *  CTE C++ wrapper tests
+ *
+ *  Tests of the C++ wrapper and of rendering unterminated templates
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+#include "CTE.hpp"
+#include "cte_test.h"
+
+
+// ---------------------------------------------------------------------------
+// Notification count
+// ---------------------------------------------------------------------------
+
+static cardinal test_notifications = 0;
+
+
+// ---------------------------------------------------------------------------
+// function:  test_notify( notification, tmplate, index )
+// ---------------------------------------------------------------------------
+
+static void test_notify(cte_notification_t notification,
+                        const char *tmplate,
+                        std::size_t index) {
+    
+    (void) notification;
+    (void) tmplate;
+    (void) index;
+    
+    test_notifications++;
+    
+    return;
+} // end test_notify
+
+
+// ---------------------------------------------------------------------------
+// test:  C++ wrapper
+// ---------------------------------------------------------------------------
+
+int main() {
+    
+    std::map<std::string_view, std::string_view> map =
+        { { "a", "alpha" }, { "b", "[@@a@@]" } };
+    cte::values values = { { "name", "World" }, { "b", "@@name@@!" } };
+    std::string_view source = "Hello @@b@@ and more";
+    cte_status_t status;
+    std::string target;
+    char buffer[16];
+    
+    // unterminated templates and values are rendered with their lengths
+    CHECK(cte_render_table_length(source.data(), 11, values.table(),
+                                  &status) == 12);
+    CHECK(status == CTE_STATUS_SUCCESS);
+    CHECK(cte_render_table_into(buffer, sizeof(buffer), source.data(), 11,
+                                values.table(), &status) == 12);
+    CHECK_STRING(buffer, "Hello World!");
+    CHECK(cte_render_table_into(buffer, 6, source.data(), 11,
+                                values.table(), &status) == 12);
+    CHECK_STRING(buffer, "Hello");
+    
+    // targets are replaced and their capacity is reused
+    target.reserve(64);
+    const char *storage = target.data();
+    cte::render_into(target, source, values);
+    CHECK_STRING(target.c_str(), "Hello World! and more");
+    cte::render_into(target, "@@name@@", values);
+    CHECK_STRING(target.c_str(), "World");
+    CHECK(target.data() == storage);
+    
+    // buffers are moved in and out
+    target = cte::render("<@@b@@>", values, std::move(target));
+    CHECK_STRING(target.c_str(), "<World!>");
+    
+    // any allocator may be used
+    std::pmr::monotonic_buffer_resource resource;
+    std::pmr::string pmr_target(&resource);
+    cte::render_into(pmr_target, "@@b@@", cte::values(map));
+    CHECK_STRING(pmr_target.c_str(), "[alpha]");
+    
+    // events of the sizing render are not reported
+    cte_install_notification_handler(test_notify);
+    cte::render_into(target, "@@undefined@@", values);
+    CHECK(test_notifications == 1);
+    cte_install_notification_handler(nullptr);
+    
+    // values may be moved,  cleared and refilled
+    cte::values moved = std::move(values);
+    CHECK(moved.size() == 2);
+    moved.clear();
+    CHECK(moved.size() == 0);
+    moved.set("name", "again");
+    target = cte::render("@@name@@", moved);
+    CHECK_STRING(target.c_str(), "again");
+    
+    // render states stop at pending values until they are completed
+    cte::values later = { { "a", "A" } };
+    later.set_pending("b");
+    cte::render_state state("<@@a@@@@b@@>", later);
+    std::size_t length = state.step(buffer, sizeof(buffer));
+    CHECK((length == 2) && (std::string_view(buffer, 2) == "<A"));
+    CHECK(state.pending() == "b");
+    
+    bool completed = false;
+    state.on_completion([&completed] { completed = true; });
+    CHECK(NOT(completed));
+    later.complete("b", "B");
+    CHECK(completed);
+    length = state.step(buffer, sizeof(buffer));
+    CHECK((length == 2) && (std::string_view(buffer, 2) == "B>"));
+    CHECK(state.pending().empty());
+    CHECK(state.done());
+    
+    // failures are reported by exceptions
+    bool thrown = false;
+    
+    try {
+        moved.set("9", "x");
+    }
+    catch (const cte::error &error) {
+        thrown = (error.status() == CTE_STATUS_INVALID_PLACEHOLDERS);
+    } // end try
+    
+    CHECK(thrown);
+    
+    thrown = false;
+    moved.set("loop", "@@loop@@");
+    
+    try {
+        cte::render_into(target, "@@loop@@", moved);
+    }
+    catch (const cte::error &error) {
+        thrown = (error.status() == CTE_STATUS_NESTING_LIMIT_EXCEEDED);
+    } // end try
+    
+    CHECK(thrown);
+    CHECK(target.empty());
+    
+    return TEST_RESULT();
+} // end main
+
+
+// END OF FILE
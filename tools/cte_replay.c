@@ -0,0 +1,208 @@
+/* C Template Engine
+ *
+ *  @file tools/cte_replay.c
+ *  CTE capture replay driver
+ *
+ *  Replays a capture log against the engine as built and reports the result
+ *
+ *  Author: Benjamin Kowarsch
+ *
+ *  Copyright (C) 2009 Benjamin Kowarsch. All rights reserved.
+ *
+ *  License:
+ *
+ *  Redistribution  and  use  in source  and  binary forms,  with  or  without
+ *  modification, are permitted provided that the following conditions are met
+ *
+ *  1) NO FEES may be charged for the provision of the software.  The software
+ *     may  NOT  be published  on websites  that contain  advertising,  unless
+ *     specific  prior  written  permission has been obtained.
+ *
+ *  2) Redistributions  of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  3) Redistributions  in binary form  must  reproduce  the  above  copyright
+ *     notice,  this list of conditions  and  the following disclaimer  in the
+ *     documentation and other materials provided with the distribution.
+ *
+ *  4) Neither the author's name nor the names of any contributors may be used
+ *     to endorse  or  promote  products  derived  from this software  without
+ *     specific prior written permission.
+ *
+ *  5) Where this list of conditions  or  the following disclaimer, in part or
+ *     as a whole is overruled  or  nullified by applicable law, no permission
+ *     is granted to use the software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY  AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+ * CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT  LIMITED  TO,  PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA,  OR PROFITS; OR BUSINESS
+ * INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY THEORY OF LIABILITY,  WHETHER IN
+ * CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *  
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cte_capture.h"
+
+
+// ---------------------------------------------------------------------------
+// Exit codes
+// ---------------------------------------------------------------------------
+//
+// The driver exits with REPLAYED if every record was replayed  and its output
+// matched the captured output,  with DIFFERENT if any render failed or its
+// output differed,  and with FAILED if the log could not be replayed at all.
+
+#define CTE_REPLAY_EXIT_REPLAYED 0
+#define CTE_REPLAY_EXIT_DIFFERENT 1
+#define CTE_REPLAY_EXIT_FAILED 2
+
+
+// ---------------------------------------------------------------------------
+// Difference report length
+// ---------------------------------------------------------------------------
+//
+// The number of characters of a template and of its replayed output that are
+// printed for a record whose output differs.
+
+#define CTE_REPLAY_EXCERPT_LENGTH 60
+
+
+// ===========================================================================
+// P R I V A T E   F U N C T I O N   P R O T O T Y P E S
+// ===========================================================================
+
+static void _print_difference(cardinal record, const char *tmplate,
+                              size_t captured_size, size_t replayed_size,
+                              const char *output, void *context);
+
+static const char *_status_text(cte_capture_status_t status);
+
+
+// ===========================================================================
+// P U B L I C   F U N C T I O N   I M P L E M E N T A T I O N S
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// function:  main( argc, argv )
+// ---------------------------------------------------------------------------
+//
+// Usage:  cte_replay log [repetitions]
+//
+// Replays the capture log at path <log>,  rendering each record <repetitions>
+// times,  or once if no repetition count is given,  prints one line for each
+// record whose replayed output differs from the captured output  and  prints
+// the replay report.
+
+int main(int argc, char *argv[]) {
+    
+    cte_replay_report_t report;
+    cte_capture_status_t status;
+    char text[CTE_REPLAY_TEXT_SIZE];
+    unsigned long repetitions;
+    char *end;
+    
+    // bail out if arguments are missing or surplus
+    if ((argc < 2) || (argc > 3)) {
+        fprintf(stderr, "usage: %s log [repetitions]\n", argv[0]);
+        return CTE_REPLAY_EXIT_FAILED;
+    } // end if
+    
+    repetitions = 1;
+    
+    if (argc == 3) {
+        repetitions = strtoul(argv[2], &end, 10);
+        
+        // bail out if repetition count is not a positive number
+        if ((*end != '\0') || (repetitions == 0) ||
+            (repetitions > (cardinal) -1)) {
+            fprintf(stderr, "%s: invalid repetition count: %s\n",
+                    argv[0], argv[2]);
+            return CTE_REPLAY_EXIT_FAILED;
+        } // end if
+    } // end if
+    
+    cte_replay(argv[1], (cardinal) repetitions,
+               _print_difference, NULL, &report, &status);
+    
+    // bail out if log could not be replayed
+    if (status != CTE_CAPTURE_STATUS_SUCCESS) {
+        fprintf(stderr, "%s: %s: %s\n",
+                argv[0], argv[1], _status_text(status));
+        return CTE_REPLAY_EXIT_FAILED;
+    } // end if
+    
+    cte_replay_format(&report, text, sizeof(text));
+    fputs(text, stdout);
+    
+    if ((report.failures > 0) || (report.differences > 0))
+        return CTE_REPLAY_EXIT_DIFFERENT;
+    
+    return CTE_REPLAY_EXIT_REPLAYED;
+} // end main
+
+
+// ===========================================================================
+// P R I V A T E   F U N C T I O N   I M P L E M E N T A T I O N S
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// private function:  _print_difference( record, tmplate, captured_size,
+//                                       replayed_size, output, context )
+// ---------------------------------------------------------------------------
+//
+// Difference handler  that prints the index of record <record>,  the captured
+// and replayed output size  and  the beginning of template <tmplate>  and of
+// replayed output <output>,  if any,  on one line.
+
+static void _print_difference(cardinal record,
+                              const char *tmplate,
+                              size_t captured_size,
+                              size_t replayed_size,
+                              const char *output,
+                              void *context) {
+    
+    (void) context;
+    
+    printf("record %u differs: captured %llu bytes, replayed %llu bytes, "
+           "template \"%.*s\", output \"%.*s\"\n", record,
+           (unsigned long long) captured_size,
+           (unsigned long long) replayed_size,
+           CTE_REPLAY_EXCERPT_LENGTH, tmplate,
+           CTE_REPLAY_EXCERPT_LENGTH, (output != NULL) ? output : "");
+    
+    return;
+} // _print_difference
+
+
+// ---------------------------------------------------------------------------
+// private function:  _status_text( status )
+// ---------------------------------------------------------------------------
+//
+// Returns a description of capture status <status>.
+
+static const char *_status_text(cte_capture_status_t status) {
+    
+    switch (status) {
+        case CTE_CAPTURE_STATUS_INVALID_LOG :
+            return "not a valid capture log";
+        case CTE_CAPTURE_STATUS_FILE_FAILED :
+            return "log could not be read";
+        case CTE_CAPTURE_STATUS_ALLOCATION_FAILED :
+            return "out of memory";
+        default :
+            return "replay failed";
+    } // end switch
+} // _status_text
+
+
+// END OF FILE